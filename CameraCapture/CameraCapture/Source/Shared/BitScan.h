@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_ARM64)
+#include <intrin.h>
+#define BITSCAN_REVERSE64
+#elif defined(_M_IX86) || defined(_M_ARM)
+#include <intrin.h>
+#define BITSCAN_REVERSE32
+#endif
+
+// index of the highest set bit, value must not be 0. the histograms bucket by it on every
+// record, _BitScanReverse64 only exists for the 64 bit targets, x86 and arm scan the two
+// halves, anything else loops
+inline uint32_t HighestSetBit(uint64_t value)
+{
+    unsigned long index = 0;
+
+#if defined(BITSCAN_REVERSE64)
+    _BitScanReverse64(&index, value);
+#elif defined(BITSCAN_REVERSE32)
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+    {
+        index += 32;
+    }
+    else
+    {
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+    }
+#else
+    while (value >>= 1)
+    {
+        ++index;
+    }
+#endif
+
+    return static_cast<uint32_t>(index);
+}
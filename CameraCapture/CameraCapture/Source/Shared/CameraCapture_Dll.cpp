@@ -6,6 +6,7 @@
 #include "Unity/IUnityGraphics.h"
 #include "PlatformBase.h"
 #include "UnityDeviceResource.h"
+#include "InstanceTable.h"
 
 #include "Plugin.CaptureEngine.h"
 #include "Media.PayloadHandler.h"
@@ -21,26 +22,11 @@ namespace winrt
     using namespace winrt::CameraCapture::Media::Capture;
 }
 
-static INSTANCE_HANDLE s_lastPluginHandleIndex = INSTANCE_HANDLE_INVALID;
-static std::unordered_map<INSTANCE_HANDLE, winrt::Module> s_instances;
+// looked up from the render thread as well, see InstanceTable
+static InstanceTable<winrt::Module> s_instances;
 HRESULT GetModule(INSTANCE_HANDLE id, _Out_ winrt::Module& module)
 {
-    if (id < INSTANCE_HANDLE_START)
-    {
-        IFR(E_INVALIDARG);
-    }
-
-    auto it = s_instances.find(id);
-    if (it == s_instances.end())
-    {
-        IFR(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
-    }
-
-    module = it->second;
-
-    NULL_CHK_HR(module, E_POINTER);
-
-    return S_OK;
+    return s_instances.Get(id, module);
 }
 
 static std::shared_ptr<IUnityDeviceResource> s_deviceResource;
@@ -51,18 +37,7 @@ static winrt::CameraCapture::Media::PayloadHandler s_payloadHandler = nullptr;
 
 HRESULT TrackModule(winrt::Module &module, INSTANCE_HANDLE * handleId)
 {
-    // get the last index value;
-    auto handle = s_lastPluginHandleIndex;
-
-    // add to map
-    auto success = s_instances.emplace(handle, module);
-    if (success.second)
-    {
-        *handleId = handle++;
-        s_lastPluginHandleIndex = handle;
-    }
-
-    return (success.second ? S_OK : E_UNEXPECTED);
+    return s_instances.Add(module, handleId);
 }
 
 // --------------------------------------------------------------------------
@@ -71,9 +46,6 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
 {
-    s_lastPluginHandleIndex = INSTANCE_HANDLE_START;
-    s_instances.clear();
-
     s_unityInterfaces = unityInterfaces;
     s_unityGraphics = s_unityInterfaces->Get<IUnityGraphics>();
     s_unityGraphics->RegisterDeviceEventCallback(OnGraphicsDeviceEvent);
@@ -84,16 +56,16 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnit
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
-    for (auto&& kv : s_instances)
+    for (auto&& module : s_instances.Clear())
     {
-        kv.second.Shutdown();
-        kv.second = nullptr;
+        module.Shutdown();
+        module = nullptr;
     }
-    s_instances.clear();
-
-    s_lastPluginHandleIndex = INSTANCE_HANDLE_INVALID;
 
     s_unityGraphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
+
+    // flush and stop the logger thread before the dll goes away
+    DebugLogger::Instance().Shutdown();
 }
 
 // --------------------------------------------------------------------------
@@ -160,9 +132,8 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseInstance(
     _In_ INSTANCE_HANDLE id)
 {
     winrt::Module module = nullptr;
-    if (SUCCEEDED(GetModule(id, module)))
+    if (SUCCEEDED(s_instances.Remove(id, module)))
     {
-        s_instances.erase(id);
         module.Shutdown();
         module = nullptr;
     }
@@ -280,3 +251,233 @@ extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureSetCoordina
 
     return hr;
 }
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureGetAudioLevels(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ AUDIO_LEVEL_STATE* levels)
+{
+    NULL_CHK_HR(levels, E_INVALIDARG);
+
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->GetAudioLevels(levels);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureSetVoiceActivityParameters(
+    _In_ INSTANCE_HANDLE id,
+    _In_ float thresholdDb,
+    _In_ uint32_t hangoverMs)
+{
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->SetVoiceActivityParameters(thresholdDb, hangoverMs);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureEnableAudioFrames(
+    _In_ INSTANCE_HANDLE id,
+    _In_ boolean enable)
+{
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->EnableAudioFrames(enable);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureGetSubscriberStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_writes_opt_(*count) PAYLOAD_SUBSCRIBER_STATS* stats,
+    _Inout_ uint32_t* count)
+{
+    NULL_CHK_HR(count, E_INVALIDARG);
+
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<winrt::CaptureEngine>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        auto payloadHandler = capture.PayloadHandler();
+        if (payloadHandler == nullptr)
+        {
+            *count = 0;
+
+            return S_OK;
+        }
+
+        hr = winrt::get_self<winrt::CameraCapture::Media::implementation::PayloadHandler>(payloadHandler)->GetSubscriberStats(stats, count);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureGetMetrics(
+    _In_ INSTANCE_HANDLE id,
+    _Out_writes_opt_(*size) char* buffer,
+    _Inout_ uint32_t* size)
+{
+    NULL_CHK_HR(size, E_INVALIDARG);
+
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->GetMetrics(buffer, size);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureGetFrameMetadata(
+    _In_ INSTANCE_HANDLE id,
+    _In_ uint32_t firstSequence,
+    _Out_writes_opt_(*count) FRAME_METADATA* records,
+    _Inout_ uint32_t* count)
+{
+    NULL_CHK_HR(count, E_INVALIDARG);
+
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->GetFrameMetadata(firstSequence, records, count);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureSaveSnapshot(
+    _In_ INSTANCE_HANDLE id,
+    _In_ LPCWSTR path,
+    _In_ SnapshotFormat format,
+    _Out_ uint32_t* requestId)
+{
+    NULL_CHK_HR(path, E_INVALIDARG);
+    NULL_CHK_HR(requestId, E_INVALIDARG);
+
+    *requestId = 0;
+
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->SaveSnapshot(path, format, requestId);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureSetFrameRateRange(
+    _In_ INSTANCE_HANDLE id,
+    _In_ float minFps,
+    _In_ float maxFps)
+{
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->SetFrameRateRange(minFps, maxFps);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureGetFrameRate(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ FRAME_RATE_STATE* state)
+{
+    NULL_CHK_HR(state, E_INVALIDARG);
+
+    winrt::Module module = nullptr;
+    winrt::hresult hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto capture = module.as<ICaptureEnginePriv>();
+        NULL_CHK_HR(capture, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = capture->GetFrameRate(state);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureSetLogLevel(
+    _In_ LogLevel level)
+{
+    if (level < LogLevel::Verbose || level > LogLevel::None)
+    {
+        return E_INVALIDARG;
+    }
+
+    DebugLogger::Level(level);
+
+    return S_OK;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureSetLogFile(
+    _In_opt_z_ const wchar_t* path)
+{
+    return DebugLogger::Instance().SetFile(path);
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CaptureGetLockReport(
+    _Out_writes_opt_(*size) char* buffer,
+    _Inout_ uint32_t* size,
+    _In_ boolean reset)
+{
+#ifdef CRITICAL_SECTION_PROFILING
+    NULL_CHK_HR(size, E_INVALIDARG);
+
+    auto& profiler = LockProfiler::Instance();
+
+    HRESULT hr = profiler.Report(buffer, size);
+    if (SUCCEEDED(hr) && buffer != nullptr && reset)
+    {
+        profiler.Reset();
+    }
+
+    return hr;
+#else
+    UNREFERENCED_PARAMETER(buffer);
+    UNREFERENCED_PARAMETER(size);
+    UNREFERENCED_PARAMETER(reset);
+
+    // only built with CRITICAL_SECTION_PROFILING
+    return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+#endif
+}
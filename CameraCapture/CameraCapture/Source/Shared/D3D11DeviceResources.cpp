@@ -14,7 +14,8 @@ std::shared_ptr<IUnityDeviceResource> __stdcall CreateD3D11DeviceResource()
 }
 
 D3D11DeviceResources::D3D11DeviceResources()
-    : m_unityDevice(nullptr)
+    : m_cs("D3D11DeviceResources")
+    , m_unityDevice(nullptr)
 {
 }
 
@@ -0,0 +1,389 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include <string>
+#include <thread>
+
+using namespace DebugLog;
+
+// power of two, a full ring drops instead of blocking the caller
+static constexpr size_t c_ringSize = 1024;
+
+// how long the logger thread sleeps when nobody wakes it
+static constexpr DWORD c_flushIntervalMs = 50;
+
+std::atomic<LogLevel> DebugLogger::s_level{ LogLevel::Verbose };
+
+struct DebugLogger::Cell
+{
+    std::atomic<size_t> sequence;
+    Record record;
+};
+
+struct DebugLogger::Impl
+{
+    CriticalSection threadCs{ "DebugLog.Thread" };
+    std::atomic<bool> started{ false };
+    std::atomic<bool> stop{ false };
+    std::thread thread;
+    winrt::handle wakeEvent{ CreateEvent(nullptr, false, false, nullptr) };
+
+    CriticalSection fileCs{ "DebugLog.File" };
+    winrt::file_handle file;
+
+    int64_t startTime{ 0 };
+    double ticksPerMs{ 1.0 };
+    uint64_t reportedDropped{ 0 };
+
+    std::wstring text;
+    std::string utf8;
+};
+
+// a wide %s reads a wide string, a char const* argument is printed as %hs whatever the
+// format asked for. the size prefix before the conversion is replaced
+static void NarrowStringSpec(wchar_t* spec, size_t length, size_t capacity)
+{
+    if (length < 2 || (spec[length - 1] != L's' && spec[length - 1] != L'S'))
+    {
+        return;
+    }
+
+    size_t end = length - 1;
+    while (end > 1 && wcschr(L"hlw", spec[end - 1]) != nullptr)
+    {
+        --end;
+    }
+
+    if (end + 3 > capacity)
+    {
+        return;
+    }
+
+    spec[end] = L'h';
+    spec[end + 1] = L's';
+    spec[end + 2] = 0;
+}
+
+_Use_decl_annotations_
+void DebugLog::FormatRecord(
+    Record const& record,
+    std::wstring& text)
+{
+    text.clear();
+
+    uint32_t arg = 0;
+    wchar_t const* current = record.format;
+    while (*current != 0)
+    {
+        if (*current != L'%')
+        {
+            text.push_back(*current++);
+            continue;
+        }
+
+        if (current[1] == L'%')
+        {
+            text.push_back(L'%');
+            current += 2;
+            continue;
+        }
+
+        // flags, width, precision and size prefix, then the conversion
+        wchar_t const* start = current++;
+        while (*current != 0 && wcschr(L"-+ #0123456789.hlLwIjzt", *current) != nullptr)
+        {
+            ++current;
+        }
+        if (*current != 0)
+        {
+            ++current;
+        }
+
+        wchar_t spec[32] = {};
+        size_t specLength = current - start;
+        if (arg >= record.argCount || specLength >= _countof(spec))
+        {
+            text.append(start, specLength);
+            continue;
+        }
+        wmemcpy(spec, start, specLength);
+
+        wchar_t buffer[512] = {};
+        auto const& value = record.values[arg];
+        switch (record.types[arg++])
+        {
+        case ArgType::Int32:
+            StringCchPrintfW(buffer, _countof(buffer), spec, static_cast<int32_t>(value.i));
+            break;
+        case ArgType::UInt32:
+            StringCchPrintfW(buffer, _countof(buffer), spec, static_cast<uint32_t>(value.u));
+            break;
+        case ArgType::Int64:
+            StringCchPrintfW(buffer, _countof(buffer), spec, value.i);
+            break;
+        case ArgType::UInt64:
+            StringCchPrintfW(buffer, _countof(buffer), spec, value.u);
+            break;
+        case ArgType::Double:
+            StringCchPrintfW(buffer, _countof(buffer), spec, value.d);
+            break;
+        case ArgType::Pointer:
+            StringCchPrintfW(buffer, _countof(buffer), spec, value.p);
+            break;
+        case ArgType::WideString:
+            StringCchPrintfW(buffer, _countof(buffer), spec, reinterpret_cast<wchar_t const*>(record.strings + value.u));
+            break;
+        case ArgType::String:
+            NarrowStringSpec(spec, specLength, _countof(spec));
+            StringCchPrintfW(buffer, _countof(buffer), spec, reinterpret_cast<char const*>(record.strings + value.u));
+            break;
+        default:
+            break;
+        }
+
+        text.append(buffer);
+    }
+}
+
+DebugLogger& DebugLogger::Instance()
+{
+    // never destroyed, Log() can still be called while other statics tear down
+    static DebugLogger* instance = new DebugLogger();
+
+    return *instance;
+}
+
+DebugLogger::DebugLogger()
+    : m_cells(new Cell[c_ringSize])
+    , m_mask(c_ringSize - 1)
+    , m_enqueuePos(0)
+    , m_dequeuePos(0)
+    , m_dropped(0)
+    , m_impl(std::make_unique<Impl>())
+{
+    for (size_t i = 0; i < c_ringSize; ++i)
+    {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    LARGE_INTEGER value = {};
+    QueryPerformanceFrequency(&value);
+    m_impl->ticksPerMs = static_cast<double>(value.QuadPart) / 1000.0;
+
+    QueryPerformanceCounter(&value);
+    m_impl->startTime = value.QuadPart;
+}
+
+DebugLogger::~DebugLogger()
+{
+    Shutdown();
+}
+
+_Use_decl_annotations_
+Record* DebugLogger::Claim(
+    size_t* position)
+{
+    *position = 0;
+
+    if (!m_impl->started.load(std::memory_order_acquire))
+    {
+        EnsureStarted();
+    }
+
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = m_cells[pos & m_mask];
+
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+
+            return nullptr;
+        }
+        else
+        {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    *position = pos;
+
+    Record& record = m_cells[pos & m_mask].record;
+
+    LARGE_INTEGER timestamp = {};
+    QueryPerformanceCounter(&timestamp);
+    record.timestamp = timestamp.QuadPart;
+    record.threadId = GetCurrentThreadId();
+
+    return &record;
+}
+
+void DebugLogger::Publish(size_t position, LogLevel level)
+{
+    m_cells[position & m_mask].sequence.store(position + 1, std::memory_order_release);
+
+    // only pay for the wake on errors or when the ring is filling up
+    size_t pending = position - m_dequeuePos.load(std::memory_order_relaxed);
+    if (level >= LogLevel::Error || pending >= (c_ringSize / 2))
+    {
+        SetEvent(m_impl->wakeEvent.get());
+    }
+}
+
+_Use_decl_annotations_
+HRESULT DebugLogger::SetFile(
+    wchar_t const* path)
+{
+    winrt::file_handle file;
+
+    if (path != nullptr && path[0] != 0)
+    {
+        file.attach(CreateFileW(path, FILE_APPEND_DATA, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!file)
+        {
+            IFR(HRESULT_FROM_WIN32(GetLastError()));
+        }
+    }
+
+    auto gurad = m_impl->fileCs.Guard();
+
+    m_impl->file = std::move(file);
+
+    return S_OK;
+}
+
+void DebugLogger::Shutdown()
+{
+    auto gurad = m_impl->threadCs.Guard();
+
+    if (m_impl->thread.joinable())
+    {
+        m_impl->stop = true;
+        SetEvent(m_impl->wakeEvent.get());
+
+        m_impl->thread.join();
+
+        m_impl->stop = false;
+        m_impl->started = false;
+    }
+
+    // anything published after the thread stopped
+    Drain();
+
+    auto fileGuard = m_impl->fileCs.Guard();
+
+    m_impl->file.close();
+}
+
+void DebugLogger::EnsureStarted()
+{
+    auto gurad = m_impl->threadCs.Guard();
+
+    if (m_impl->started)
+    {
+        return;
+    }
+
+    m_impl->thread = std::thread([this]() { ThreadProc(); });
+    m_impl->started = true;
+}
+
+void DebugLogger::ThreadProc()
+{
+    while (!m_impl->stop)
+    {
+        WaitForSingleObject(m_impl->wakeEvent.get(), c_flushIntervalMs);
+
+        Drain();
+    }
+
+    Drain();
+}
+
+size_t DebugLogger::Drain()
+{
+    // single consumer, Shutdown only drains once the thread has been joined
+    size_t count = 0;
+    for (;;)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[pos & m_mask];
+
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0)
+        {
+            break;
+        }
+
+        Output(cell.record);
+
+        m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+
+        ++count;
+    }
+
+    uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped != m_impl->reportedDropped)
+    {
+        wchar_t buffer[128] = {};
+        StringCchPrintfW(buffer, _countof(buffer), L"DebugLog: %I64u messages dropped\n", dropped - m_impl->reportedDropped);
+        OutputDebugStringW(buffer);
+
+        m_impl->reportedDropped = dropped;
+    }
+
+    return count;
+}
+
+void DebugLogger::Output(Record const& record)
+{
+    FormatRecord(record, m_impl->text);
+
+    OutputDebugStringW(m_impl->text.c_str());
+
+    auto gurad = m_impl->fileCs.Guard();
+
+    if (!m_impl->file)
+    {
+        return;
+    }
+
+    static wchar_t const c_levels[] = { L'V', L'I', L'W', L'E', L'N' };
+    wchar_t prefix[64] = {};
+    StringCchPrintfW(prefix, _countof(prefix), L"[%10.3f][%5u][%c] ",
+        static_cast<double>(record.timestamp - m_impl->startTime) / m_impl->ticksPerMs,
+        record.threadId,
+        c_levels[static_cast<uint32_t>(record.level) % _countof(c_levels)]);
+
+    std::wstring line = prefix;
+    line += m_impl->text;
+    if (line.empty() || line.back() != L'\n')
+    {
+        line.push_back(L'\n');
+    }
+
+    int size = WideCharToMultiByte(CP_UTF8, 0, line.c_str(), static_cast<int>(line.size()), nullptr, 0, nullptr, nullptr);
+    if (size <= 0)
+    {
+        return;
+    }
+
+    m_impl->utf8.resize(size);
+    WideCharToMultiByte(CP_UTF8, 0, line.c_str(), static_cast<int>(line.size()), m_impl->utf8.data(), size, nullptr, nullptr);
+
+    DWORD written = 0;
+    WriteFile(m_impl->file.get(), m_impl->utf8.data(), static_cast<DWORD>(size), &written, nullptr);
+}
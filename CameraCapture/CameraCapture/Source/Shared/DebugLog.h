@@ -0,0 +1,254 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+typedef enum class _LogLevel : int32_t
+{
+    Verbose = 0,
+    Info,
+    Warning,
+    Error,
+    None
+} LogLevel;
+
+// a log call only captures the format pointer (the string literal is its id) and the raw
+// arguments into a ring slot, formatting and output happen on the logger thread. the
+// format is read after Log() returns, so it has to be a literal, a buffer does not compile
+namespace DebugLog
+{
+    static constexpr uint32_t MaxArgs = 8;
+    static constexpr uint32_t MaxStringBytes = 256;
+
+    enum class ArgType : uint8_t
+    {
+        None = 0,
+        Int32,
+        UInt32,
+        Int64,
+        UInt64,
+        Double,
+        Pointer,
+        WideString,     // copied into the record, value is the byte offset
+        String          // as WideString, replayed through %hs
+    };
+
+    struct Record
+    {
+        wchar_t const* format;
+        LogLevel level;
+        uint32_t threadId;
+        int64_t timestamp;
+        uint32_t argCount;
+        uint32_t stringBytes;
+        ArgType types[MaxArgs];
+        union
+        {
+            int64_t i;
+            uint64_t u;
+            double d;
+            void const* p;
+        } values[MaxArgs];
+        alignas(wchar_t) uint8_t strings[MaxStringBytes];
+    };
+
+    template <typename T> struct always_false : std::false_type {};
+
+    inline void AddValue(Record& record, ArgType type, int64_t value)
+    {
+        record.types[record.argCount] = type;
+        record.values[record.argCount].i = value;
+        record.argCount++;
+    }
+
+    template <typename TChar>
+    inline void AddString(Record& record, ArgType type, TChar const* value)
+    {
+        if (value == nullptr)
+        {
+            AddValue(record, ArgType::Pointer, 0);
+            return;
+        }
+
+        // keep wide strings aligned and always leave room for the terminator
+        uint32_t offset = (record.stringBytes + sizeof(TChar) - 1) & ~static_cast<uint32_t>(sizeof(TChar) - 1);
+        uint32_t available = (offset < MaxStringBytes) ? (MaxStringBytes - offset) / sizeof(TChar) : 0;
+        if (available == 0)
+        {
+            AddValue(record, ArgType::Pointer, 0);
+            return;
+        }
+
+        size_t length = 0;
+        while (length + 1 < available && value[length] != 0)
+        {
+            ++length;
+        }
+
+        auto dest = reinterpret_cast<TChar*>(record.strings + offset);
+        memcpy(dest, value, length * sizeof(TChar));
+        dest[length] = 0;
+
+        record.stringBytes = offset + static_cast<uint32_t>((length + 1) * sizeof(TChar));
+
+        AddValue(record, type, offset);
+    }
+
+    template <typename T>
+    inline void AddArg(Record& record, T const& value)
+    {
+        using U = std::decay_t<T>;
+
+        if (record.argCount >= MaxArgs)
+        {
+            return;
+        }
+
+        if constexpr (std::is_same_v<U, winrt::hresult>)
+        {
+            AddValue(record, ArgType::Int32, value.value);
+        }
+        else if constexpr (std::is_same_v<U, wchar_t*> || std::is_same_v<U, wchar_t const*>)
+        {
+            AddString(record, ArgType::WideString, static_cast<wchar_t const*>(value));
+        }
+        else if constexpr (std::is_same_v<U, char*> || std::is_same_v<U, char const*>)
+        {
+            AddString(record, ArgType::String, static_cast<char const*>(value));
+        }
+        else if constexpr (std::is_enum_v<U>)
+        {
+            AddArg(record, static_cast<std::underlying_type_t<U>>(value));
+        }
+        else if constexpr (std::is_floating_point_v<U>)
+        {
+            record.types[record.argCount] = ArgType::Double;
+            record.values[record.argCount].d = static_cast<double>(value);
+            record.argCount++;
+        }
+        else if constexpr (std::is_integral_v<U>)
+        {
+            if constexpr (sizeof(U) <= sizeof(int32_t))
+            {
+                AddValue(record, std::is_signed_v<U> ? ArgType::Int32 : ArgType::UInt32, static_cast<int64_t>(value));
+            }
+            else
+            {
+                AddValue(record, std::is_signed_v<U> ? ArgType::Int64 : ArgType::UInt64, static_cast<int64_t>(value));
+            }
+        }
+        else if constexpr (std::is_pointer_v<U>)
+        {
+            record.types[record.argCount] = ArgType::Pointer;
+            record.values[record.argCount].p = value;
+            record.argCount++;
+        }
+        else
+        {
+            static_assert(always_false<U>::value, "unsupported Log() argument type");
+        }
+    }
+
+    // the logger thread's half, the record's format with its arguments
+    void FormatRecord(_In_ Record const& record, _Inout_ std::wstring& text);
+}
+
+struct DebugLogger
+{
+    static DebugLogger& Instance();
+
+    static bool IsEnabled(LogLevel level)
+    {
+        return level >= s_level.load(std::memory_order_relaxed);
+    }
+
+    static void Level(LogLevel level) { s_level.store(level, std::memory_order_relaxed); }
+    static LogLevel Level() { return s_level.load(std::memory_order_relaxed); }
+
+    // null or empty path closes the file, debug output stays on either way
+    HRESULT SetFile(_In_opt_z_ wchar_t const* path);
+
+    // drains what is queued and stops the thread, the next write restarts it
+    void Shutdown();
+
+    // hot path, null when the ring is full and the message is dropped
+    DebugLog::Record* Claim(_Out_ size_t* position);
+    void Publish(size_t position, LogLevel level);
+
+    uint64_t DroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    ~DebugLogger();
+
+private:
+    DebugLogger();
+
+    void EnsureStarted();
+    void ThreadProc();
+    size_t Drain();
+    void Output(DebugLog::Record const& record);
+
+    struct Cell;
+    struct Impl;
+
+private:
+    static std::atomic<LogLevel> s_level;
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+    alignas(64) std::atomic<uint64_t> m_dropped;
+
+    std::unique_ptr<Impl> m_impl;
+};
+
+template <size_t N, typename... Args>
+inline void __stdcall Log(
+    _In_ LogLevel level,
+    _In_z_ _Printf_format_string_ wchar_t const (&format)[N],
+    Args const&... args)
+{
+    if (!DebugLogger::IsEnabled(level))
+    {
+        return;
+    }
+
+    auto& logger = DebugLogger::Instance();
+
+    size_t position = 0;
+    auto record = logger.Claim(&position);
+    if (record == nullptr)
+    {
+        return;
+    }
+
+    record->format = format;
+    record->level = level;
+    record->argCount = 0;
+    record->stringBytes = 0;
+    (DebugLog::AddArg(*record, args), ...);
+
+    logger.Publish(position, level);
+}
+
+template <size_t N, typename... Args>
+inline void __stdcall Log(
+    _In_z_ _Printf_format_string_ wchar_t const (&format)[N],
+    Args const&... args)
+{
+    Log(LogLevel::Verbose, format, args...);
+}
+
+// a writable buffer is a better match than the literal overloads and may be gone, or
+// rewritten, before the logger thread formats the record
+template <size_t N, typename... Args>
+void Log(_In_ LogLevel level, _In_ wchar_t (&format)[N], Args const&... args) = delete;
+
+template <size_t N, typename... Args>
+void Log(_In_ wchar_t (&format)[N], Args const&... args) = delete;
@@ -0,0 +1,251 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static void UpdateMax(std::atomic<uint64_t>& current, uint64_t value, std::atomic<void*>& site, void* callSite)
+{
+    uint64_t previous = current.load(std::memory_order_relaxed);
+    while (value > previous)
+    {
+        if (current.compare_exchange_weak(previous, value, std::memory_order_relaxed))
+        {
+            site.store(callSite, std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+// module+offset so the report can be symbolized against the pdb
+static void AppendCallSite(std::string& text, char const* label, void* callSite)
+{
+    char buffer[MAX_PATH + 64] = {};
+
+    HMODULE module = nullptr;
+    char path[MAX_PATH] = {};
+    if (callSite != nullptr
+        && GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, static_cast<LPCSTR>(callSite), &module)
+        && GetModuleFileNameA(module, path, _countof(path)) > 0)
+    {
+        char const* name = strrchr(path, '\\');
+        name = (name != nullptr) ? name + 1 : path;
+
+        StringCchPrintfA(buffer, _countof(buffer), " %s=%s+0x%I64x", label, name,
+            static_cast<uint64_t>(reinterpret_cast<uintptr_t>(callSite) - reinterpret_cast<uintptr_t>(module)));
+    }
+    else
+    {
+        StringCchPrintfA(buffer, _countof(buffer), " %s=%p", label, callSite);
+    }
+
+    text += buffer;
+}
+
+static void AppendHistogram(std::string& text, char const* label, std::atomic<uint32_t> const (&histogram)[LockHistogramBuckets])
+{
+    char buffer[64] = {};
+
+    StringCchPrintfA(buffer, _countof(buffer), "  %s us:", label);
+    text += buffer;
+
+    for (uint32_t i = 0; i < LockHistogramBuckets; ++i)
+    {
+        uint32_t count = histogram[i].load(std::memory_order_relaxed);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        uint32_t lower = (i == 0) ? 0 : (1u << (i - 1));
+        StringCchPrintfA(buffer, _countof(buffer), " %s%u:%u", (i == LockHistogramBuckets - 1) ? ">=" : "", lower, count);
+        text += buffer;
+    }
+
+    text += "\n";
+}
+
+void LockStats::RecordWait(int64_t ticks, void* callSite, void* owner)
+{
+    contended.fetch_add(1, std::memory_order_relaxed);
+    totalWaitTicks.fetch_add(ticks, std::memory_order_relaxed);
+    UpdateMax(maxWaitTicks, ticks, maxWaitCallSite, callSite);
+    lastBlockingOwner.store(owner, std::memory_order_relaxed);
+    waitHistogram[LockProfiler::Instance().Bucket(ticks)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockStats::RecordHold(int64_t ticks, void* callSite)
+{
+    acquisitions.fetch_add(1, std::memory_order_relaxed);
+    totalHoldTicks.fetch_add(ticks, std::memory_order_relaxed);
+    UpdateMax(maxHoldTicks, ticks, maxHoldCallSite, callSite);
+    holdHistogram[LockProfiler::Instance().Bucket(ticks)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockStats::Reset()
+{
+    acquisitions = 0;
+    contended = 0;
+    totalWaitTicks = 0;
+    totalHoldTicks = 0;
+    maxWaitTicks = 0;
+    maxHoldTicks = 0;
+    maxWaitCallSite = nullptr;
+    maxHoldCallSite = nullptr;
+    lastBlockingOwner = nullptr;
+
+    for (uint32_t i = 0; i < LockHistogramBuckets; ++i)
+    {
+        waitHistogram[i] = 0;
+        holdHistogram[i] = 0;
+    }
+}
+
+struct LockProfiler::Impl
+{
+    // not a CriticalSection, that would profile itself
+    SRWLOCK lock = SRWLOCK_INIT;
+    std::vector<std::unique_ptr<LockStats>> locks;
+};
+
+LockProfiler& LockProfiler::Instance()
+{
+    // never destroyed, locks in other statics can outlive it otherwise
+    static LockProfiler* instance = new LockProfiler();
+
+    return *instance;
+}
+
+LockProfiler::LockProfiler()
+    : m_ticksPerMicrosecond(1.0)
+    , m_impl(new Impl())
+{
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceFrequency(&frequency);
+
+    m_ticksPerMicrosecond = static_cast<double>(frequency.QuadPart) / 1000000.0;
+}
+
+uint32_t LockProfiler::Bucket(int64_t ticks) const
+{
+    uint64_t microseconds = static_cast<uint64_t>(ToMicroseconds(ticks));
+    if (microseconds == 0)
+    {
+        return 0;
+    }
+
+    return std::min<uint32_t>(HighestSetBit(microseconds) + 1, LockHistogramBuckets - 1);
+}
+
+_Use_decl_annotations_
+LockStats* LockProfiler::Register(
+    char const* name)
+{
+    if (name == nullptr)
+    {
+        name = "unnamed";
+    }
+
+    AcquireSRWLockExclusive(&m_impl->lock);
+
+    LockStats* stats = nullptr;
+    for (auto&& current : m_impl->locks)
+    {
+        if (strcmp(current->name, name) == 0)
+        {
+            stats = current.get();
+            break;
+        }
+    }
+
+    if (stats == nullptr)
+    {
+        m_impl->locks.emplace_back(new LockStats());
+        stats = m_impl->locks.back().get();
+        stats->name = name;
+    }
+
+    ReleaseSRWLockExclusive(&m_impl->lock);
+
+    return stats;
+}
+
+_Use_decl_annotations_
+HRESULT LockProfiler::Report(
+    char* buffer,
+    uint32_t* size)
+{
+    NULL_CHK_HR(size, E_INVALIDARG);
+
+    std::string text;
+
+    AcquireSRWLockShared(&m_impl->lock);
+
+    for (auto&& stats : m_impl->locks)
+    {
+        uint64_t acquisitions = stats->acquisitions.load(std::memory_order_relaxed);
+        uint64_t contended = stats->contended.load(std::memory_order_relaxed);
+        if (acquisitions == 0)
+        {
+            continue;
+        }
+
+        char line[512] = {};
+        StringCchPrintfA(line, _countof(line),
+            "%s: acquisitions=%I64u contended=%I64u (%.2f%%) wait avg=%.2fus max=%.2fus hold avg=%.2fus max=%.2fus\n",
+            stats->name,
+            acquisitions,
+            contended,
+            100.0 * static_cast<double>(contended) / static_cast<double>(acquisitions),
+            (contended > 0) ? ToMicroseconds(stats->totalWaitTicks / contended) : 0.0,
+            ToMicroseconds(stats->maxWaitTicks),
+            ToMicroseconds(stats->totalHoldTicks / acquisitions),
+            ToMicroseconds(stats->maxHoldTicks));
+        text += line;
+
+        text += " ";
+        AppendCallSite(text, "maxHold", stats->maxHoldCallSite);
+        if (contended > 0)
+        {
+            AppendCallSite(text, "maxWait", stats->maxWaitCallSite);
+            AppendCallSite(text, "lastOwner", stats->lastBlockingOwner);
+        }
+        text += "\n";
+
+        AppendHistogram(text, "hold", stats->holdHistogram);
+        if (contended > 0)
+        {
+            AppendHistogram(text, "wait", stats->waitHistogram);
+        }
+    }
+
+    ReleaseSRWLockShared(&m_impl->lock);
+
+    uint32_t required = static_cast<uint32_t>(text.size() + 1);
+    if (buffer == nullptr || *size < required)
+    {
+        *size = required;
+
+        return (buffer == nullptr) ? S_OK : HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    memcpy(buffer, text.c_str(), required);
+    *size = required;
+
+    return S_OK;
+}
+
+void LockProfiler::Reset()
+{
+    AcquireSRWLockShared(&m_impl->lock);
+
+    for (auto&& stats : m_impl->locks)
+    {
+        stats->Reset();
+    }
+
+    ReleaseSRWLockShared(&m_impl->lock);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <atomic>
+#include <intrin.h>
+
+#include "BitScan.h"
+
+// per-name lock statistics, recorded by ProfiledCriticalSection, which every lock is when
+// CRITICAL_SECTION_PROFILING is defined
+// bucket 0 is < 1us, bucket n is [2^(n-1), 2^n) us, the last one is open ended
+static constexpr uint32_t LockHistogramBuckets = 16;
+
+struct LockStats
+{
+    char const* name;
+    std::atomic<uint64_t> acquisitions;
+    std::atomic<uint64_t> contended;
+    std::atomic<uint64_t> totalWaitTicks;
+    std::atomic<uint64_t> totalHoldTicks;
+    std::atomic<uint64_t> maxWaitTicks;
+    std::atomic<uint64_t> maxHoldTicks;
+    std::atomic<void*> maxWaitCallSite;
+    std::atomic<void*> maxHoldCallSite;
+    std::atomic<void*> lastBlockingOwner;
+    std::atomic<uint32_t> waitHistogram[LockHistogramBuckets];
+    std::atomic<uint32_t> holdHistogram[LockHistogramBuckets];
+
+    void RecordWait(int64_t ticks, void* callSite, void* owner);
+    void RecordHold(int64_t ticks, void* callSite);
+    void Reset();
+};
+
+struct LockProfiler
+{
+    static LockProfiler& Instance();
+
+    static int64_t Now()
+    {
+        LARGE_INTEGER value;
+        QueryPerformanceCounter(&value);
+        return value.QuadPart;
+    }
+
+    // locks with the same name share one entry, entries live until the process exits
+    LockStats* Register(_In_opt_z_ char const* name);
+
+    // text report, call with a null buffer to get the size including the terminator
+    HRESULT Report(
+        _Out_writes_opt_(*size) char* buffer,
+        _Inout_ uint32_t* size);
+
+    void Reset();
+
+    uint32_t Bucket(int64_t ticks) const;
+    double ToMicroseconds(int64_t ticks) const { return static_cast<double>(ticks) / m_ticksPerMicrosecond; }
+
+private:
+    LockProfiler();
+
+    struct Impl;
+
+private:
+    double m_ticksPerMicrosecond;
+    Impl* m_impl;
+};
@@ -0,0 +1,346 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.AudioMeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIOMETER_SSE2
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define AUDIOMETER_NEON
+#endif
+
+static constexpr float c_silenceDb = -120.0f;
+static constexpr float c_minimumSpeechDb = -60.0f;
+static constexpr float c_noiseFloorAttack = 0.02f;   // slow rise while quiet
+static constexpr float c_noiseFloorRelease = 0.5f;   // fast fall when the room gets quieter
+static constexpr float c_pcm16Scale = 1.0f / 32768.0f;
+
+static inline float ToDecibels(float meanSquare)
+{
+    return (meanSquare > 1e-12f) ? 10.0f * std::log10(meanSquare) : c_silenceDb;
+}
+
+// accumulates sum of squares and peak per channel and counts sign changes between
+// consecutive frames of the same channel. previous holds the last frame of the prior block
+static uint32_t MeasureInterleaved(
+    _In_reads_(sampleCount) float const* samples,
+    _In_ uint32_t sampleCount,
+    _In_ uint32_t channelCount,
+    _In_reads_(channelCount) float const* previous,
+    _Inout_updates_(channelCount) float* sumSquares,
+    _Inout_updates_(channelCount) float* peaks)
+{
+    uint32_t crossings = 0;
+    uint32_t i = 0;
+
+    auto scalarStep = [&](uint32_t index)
+    {
+        uint32_t channel = index % channelCount;
+        float value = samples[index];
+        float prior = (index >= channelCount) ? samples[index - channelCount] : previous[channel];
+
+        sumSquares[channel] += value * value;
+        peaks[channel] = std::max(peaks[channel], std::fabs(value));
+        crossings += (std::signbit(value) != std::signbit(prior)) ? 1 : 0;
+    };
+
+    // the vector path needs every lane to map to a fixed channel
+    bool vectorizable = (channelCount == 1 || channelCount == 2 || channelCount == 4);
+
+#if defined(AUDIOMETER_SSE2) || defined(AUDIOMETER_NEON)
+    if (vectorizable && sampleCount >= 8)
+    {
+        // first vector is handled in scalar so the lookback for crossings is always in the block
+        for (; i < 4; ++i)
+        {
+            scalarStep(i);
+        }
+
+        float laneSquares[4];
+        float lanePeaks[4];
+        uint32_t laneCrossings[4];
+
+#if defined(AUDIOMETER_SSE2)
+        __m128 sumSq = _mm_setzero_ps();
+        __m128 peak = _mm_setzero_ps();
+        __m128i zeroCross = _mm_setzero_si128();
+        __m128 const absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        for (; i + 4 <= sampleCount; i += 4)
+        {
+            __m128 value = _mm_loadu_ps(samples + i);
+            __m128 prior = _mm_loadu_ps(samples + i - channelCount);
+
+            sumSq = _mm_add_ps(sumSq, _mm_mul_ps(value, value));
+            peak = _mm_max_ps(peak, _mm_and_ps(value, absMask));
+
+            __m128i signs = _mm_xor_si128(_mm_castps_si128(value), _mm_castps_si128(prior));
+            zeroCross = _mm_add_epi32(zeroCross, _mm_srli_epi32(signs, 31));
+        }
+
+        _mm_storeu_ps(laneSquares, sumSq);
+        _mm_storeu_ps(lanePeaks, peak);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(laneCrossings), zeroCross);
+#else
+        float32x4_t sumSq = vdupq_n_f32(0.0f);
+        float32x4_t peak = vdupq_n_f32(0.0f);
+        uint32x4_t zeroCross = vdupq_n_u32(0);
+
+        for (; i + 4 <= sampleCount; i += 4)
+        {
+            float32x4_t value = vld1q_f32(samples + i);
+            float32x4_t prior = vld1q_f32(samples + i - channelCount);
+
+            sumSq = vmlaq_f32(sumSq, value, value);
+            peak = vmaxq_f32(peak, vabsq_f32(value));
+
+            uint32x4_t signs = veorq_u32(vreinterpretq_u32_f32(value), vreinterpretq_u32_f32(prior));
+            zeroCross = vaddq_u32(zeroCross, vshrq_n_u32(signs, 31));
+        }
+
+        vst1q_f32(laneSquares, sumSq);
+        vst1q_f32(lanePeaks, peak);
+        vst1q_u32(laneCrossings, zeroCross);
+#endif
+
+        // i started on a multiple of 4, so lane n always carries channel n % channelCount
+        for (uint32_t lane = 0; lane < 4; ++lane)
+        {
+            uint32_t channel = lane % channelCount;
+            sumSquares[channel] += laneSquares[lane];
+            peaks[channel] = std::max(peaks[channel], lanePeaks[lane]);
+            crossings += laneCrossings[lane];
+        }
+    }
+#else
+    UNREFERENCED_PARAMETER(vectorizable);
+#endif
+
+    for (; i < sampleCount; ++i)
+    {
+        scalarStep(i);
+    }
+
+    return crossings;
+}
+
+
+AudioMeter::AudioMeter()
+    : m_cs("AudioMeter")
+    , m_channelCount(0)
+    , m_sampleRate(0)
+    , m_bitsPerSample(0)
+    , m_isFloat(false)
+    , m_thresholdDb(12.0f)
+    , m_maxZeroCrossingRate(0.35f)
+    , m_hangoverMs(300)
+    , m_hangoverFrames(0)
+    , m_noiseFloorDb(c_silenceDb)
+    , m_noiseFloorValid(false)
+    , m_hangoverRemaining(0)
+{
+    ZeroMemory(&m_levels, sizeof(AUDIO_LEVEL_STATE));
+}
+
+_Use_decl_annotations_
+HRESULT AudioMeter::Configure(
+    uint32_t channelCount,
+    uint32_t sampleRate,
+    uint32_t bitsPerSample,
+    bool isFloat)
+{
+    if (channelCount == 0 || sampleRate == 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    if ((isFloat && bitsPerSample != 32) || (!isFloat && bitsPerSample != 16))
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    auto guard = m_cs.Guard();
+
+    if (m_channelCount == channelCount
+        && m_sampleRate == sampleRate
+        && m_bitsPerSample == bitsPerSample
+        && m_isFloat == isFloat)
+    {
+        return S_OK;
+    }
+
+    m_channelCount = channelCount;
+    m_sampleRate = sampleRate;
+    m_bitsPerSample = bitsPerSample;
+    m_isFloat = isFloat;
+    m_hangoverFrames = static_cast<uint32_t>((static_cast<uint64_t>(m_hangoverMs) * m_sampleRate) / 1000);
+
+    m_previous.assign(channelCount, 0.0f);
+    m_sumSquares.assign(channelCount, 0.0f);
+    m_peaks.assign(channelCount, 0.0f);
+
+    m_noiseFloorValid = false;
+    m_hangoverRemaining = 0;
+
+    ZeroMemory(&m_levels, sizeof(AUDIO_LEVEL_STATE));
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT AudioMeter::Process(IMFSample* sample)
+{
+    NULL_CHK_HR(sample, E_INVALIDARG);
+
+    auto guard = m_cs.Guard();
+
+    if (m_channelCount == 0)
+    {
+        IFR(MF_E_NOT_INITIALIZED);
+    }
+
+    LONGLONG timestamp = 0;
+    sample->GetSampleTime(&timestamp);
+
+    winrt::com_ptr<IMFMediaBuffer> buffer = nullptr;
+    IFR(sample->ConvertToContiguousBuffer(buffer.put()));
+
+    BYTE* data = nullptr;
+    DWORD length = 0;
+    IFR(buffer->Lock(&data, nullptr, &length));
+
+    uint32_t bytesPerFrame = m_channelCount * (m_bitsPerSample / 8);
+    uint32_t sampleCount = (length / bytesPerFrame) * m_channelCount;
+    if (sampleCount > 0)
+    {
+        if (m_isFloat)
+        {
+            Measure(reinterpret_cast<float const*>(data), sampleCount, timestamp);
+        }
+        else
+        {
+            // normalize pcm so the thresholds mean the same for both formats
+            if (m_convertBuffer.size() < sampleCount)
+            {
+                m_convertBuffer.resize(sampleCount);
+            }
+
+            auto source = reinterpret_cast<int16_t const*>(data);
+            for (uint32_t i = 0; i < sampleCount; ++i)
+            {
+                m_convertBuffer[i] = static_cast<float>(source[i]) * c_pcm16Scale;
+            }
+
+            Measure(m_convertBuffer.data(), sampleCount, timestamp);
+        }
+    }
+
+    buffer->Unlock();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void AudioMeter::SetVoiceActivityParameters(float thresholdDb, uint32_t hangoverMs)
+{
+    auto guard = m_cs.Guard();
+
+    m_thresholdDb = std::max(0.0f, thresholdDb);
+    m_hangoverMs = hangoverMs;
+
+    // converted again by Configure if the rate is not known yet
+    m_hangoverFrames = static_cast<uint32_t>((static_cast<uint64_t>(m_hangoverMs) * m_sampleRate) / 1000);
+}
+
+_Use_decl_annotations_
+void AudioMeter::GetLevels(AUDIO_LEVEL_STATE* state)
+{
+    NULL_CHK_R(state);
+
+    auto guard = m_cs.Guard();
+
+    *state = m_levels;
+}
+
+void AudioMeter::Reset()
+{
+    auto guard = m_cs.Guard();
+
+    std::fill(m_previous.begin(), m_previous.end(), 0.0f);
+
+    m_noiseFloorValid = false;
+    m_hangoverRemaining = 0;
+
+    uint32_t sequence = m_levels.sequence;
+    ZeroMemory(&m_levels, sizeof(AUDIO_LEVEL_STATE));
+    m_levels.sequence = sequence;
+}
+
+_Use_decl_annotations_
+void AudioMeter::Measure(float const* samples, uint32_t sampleCount, int64_t timestamp)
+{
+    uint32_t frameCount = sampleCount / m_channelCount;
+
+    std::fill(m_sumSquares.begin(), m_sumSquares.end(), 0.0f);
+    std::fill(m_peaks.begin(), m_peaks.end(), 0.0f);
+
+    uint32_t crossings = MeasureInterleaved(samples, sampleCount, m_channelCount, m_previous.data(), m_sumSquares.data(), m_peaks.data());
+
+    // carry the last frame so crossings at the block boundary are counted
+    std::copy(samples + sampleCount - m_channelCount, samples + sampleCount, m_previous.begin());
+
+    // publish per channel levels
+    float totalSquares = 0.0f;
+    for (uint32_t channel = 0; channel < m_channelCount; ++channel)
+    {
+        totalSquares += m_sumSquares[channel];
+
+        if (channel < AUDIO_LEVEL_MAX_CHANNELS)
+        {
+            m_levels.rms[channel] = std::sqrt(m_sumSquares[channel] / frameCount);
+            m_levels.peak[channel] = m_peaks[channel];
+        }
+    }
+
+    float energyDb = ToDecibels(totalSquares / sampleCount);
+    float zeroCrossingRate = static_cast<float>(crossings) / sampleCount;
+
+    if (!m_noiseFloorValid)
+    {
+        m_noiseFloorDb = energyDb;
+        m_noiseFloorValid = true;
+    }
+
+    // energy well above the tracked floor, but not broadband hiss
+    bool isSpeech = energyDb > c_minimumSpeechDb
+        && energyDb > (m_noiseFloorDb + m_thresholdDb)
+        && zeroCrossingRate < m_maxZeroCrossingRate;
+
+    if (isSpeech)
+    {
+        m_hangoverRemaining = m_hangoverFrames + frameCount;
+    }
+    else
+    {
+        // only learn the floor from non speech blocks
+        float rate = (energyDb < m_noiseFloorDb) ? c_noiseFloorRelease : c_noiseFloorAttack;
+        m_noiseFloorDb += (energyDb - m_noiseFloorDb) * rate;
+    }
+
+    bool voiceActive = m_hangoverRemaining > 0;
+    m_hangoverRemaining = (m_hangoverRemaining > frameCount) ? m_hangoverRemaining - frameCount : 0;
+
+    m_levels.timestamp = timestamp;
+    m_levels.sequence++;
+    m_levels.channelCount = std::min<uint32_t>(m_channelCount, AUDIO_LEVEL_MAX_CHANNELS);
+    m_levels.energyDb = energyDb;
+    m_levels.noiseFloorDb = m_noiseFloorDb;
+    m_levels.zeroCrossingRate = zeroCrossingRate;
+    m_levels.voiceActive = voiceActive ? 1 : 0;
+}
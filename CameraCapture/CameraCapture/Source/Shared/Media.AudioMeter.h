@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <mfapi.h>
+#include <vector>
+
+// per-block level metering and energy/zero-crossing voice activity detection
+// for the interleaved audio delivered to the capture sink
+struct AudioMeter
+{
+    AudioMeter();
+
+    // float and 16bit pcm are supported, other formats are ignored
+    HRESULT Configure(
+        _In_ uint32_t channelCount,
+        _In_ uint32_t sampleRate,
+        _In_ uint32_t bitsPerSample,
+        _In_ bool isFloat);
+
+    HRESULT Process(_In_ IMFSample* sample);
+
+    void SetVoiceActivityParameters(_In_ float thresholdDb, _In_ uint32_t hangoverMs);
+
+    void GetLevels(_Out_ AUDIO_LEVEL_STATE* state);
+
+    void Reset();
+
+private:
+    void Measure(_In_reads_(sampleCount) float const* samples, _In_ uint32_t sampleCount, _In_ int64_t timestamp);
+
+private:
+    CriticalSection m_cs;
+
+    uint32_t m_channelCount;
+    uint32_t m_sampleRate;
+    uint32_t m_bitsPerSample;
+    bool m_isFloat;
+
+    // vad settings
+    float m_thresholdDb;
+    float m_maxZeroCrossingRate;
+    uint32_t m_hangoverMs;
+    uint32_t m_hangoverFrames;
+
+    // vad running state
+    float m_noiseFloorDb;
+    bool m_noiseFloorValid;
+    uint32_t m_hangoverRemaining;
+
+    // per block scratch
+    std::vector<float> m_convertBuffer;
+    std::vector<float> m_previous;
+    std::vector<float> m_sumSquares;
+    std::vector<float> m_peaks;
+
+    AUDIO_LEVEL_STATE m_levels;
+};
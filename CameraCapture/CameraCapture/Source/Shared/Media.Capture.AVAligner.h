@@ -0,0 +1,192 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <vector>
+
+// pairs each video frame with the audio that covers its interval. the times of both streams
+// are on one clock, the sink has already rebased them, all times are in 100ns
+template <typename TPayload>
+class AVAligner
+{
+public:
+    static constexpr int64_t DefaultMaxSkew = 1000000; // 100ms
+
+    struct Bundle
+    {
+        TPayload video;                 // empty when audio overflowed without video
+        std::vector<TPayload> audio;
+        int64_t timestamp;              // start of the interval, same as the video payload's
+        int64_t duration;
+        int64_t skew;                   // end of the paired audio minus end of the interval
+    };
+
+    using BundleCallback = std::function<void(Bundle&&)>;
+
+    AVAligner(size_t maxPendingVideo = 8, size_t maxPendingAudio = 64)
+        : m_maxPendingVideo(maxPendingVideo > 0 ? maxPendingVideo : 1)
+        , m_maxPendingAudio(maxPendingAudio > 0 ? maxPendingAudio : 1)
+        , m_maxSkew(DefaultMaxSkew)
+    {
+        Reset();
+    }
+
+    int64_t MaxSkew() const { return m_maxSkew; }
+    void MaxSkew(int64_t value) { m_maxSkew = value > 0 ? value : 0; }
+
+    uint64_t OverflowCount() const { return m_overflowCount; }
+
+    void Reset()
+    {
+        m_video.clear();
+        m_audio.clear();
+        m_audioEnd = InvalidTime;
+        m_lastVideoInterval = 0;
+        m_overflowCount = 0;
+    }
+
+    void PushVideo(TPayload const& payload, int64_t timestamp, int64_t duration, BundleCallback const& emit)
+    {
+        // the next frame is the best measure of the previous frame's interval
+        if (!m_video.empty())
+        {
+            auto& previous = m_video.back();
+            int64_t interval = timestamp - previous.timestamp;
+            if (interval > 0)
+            {
+                m_lastVideoInterval = interval;
+                if (!previous.hasDuration)
+                {
+                    previous.duration = interval;
+                }
+            }
+        }
+
+        bool hasDuration = duration > 0;
+        m_video.push_back({ payload, timestamp, hasDuration ? duration : m_lastVideoInterval, hasDuration });
+
+        Drain(emit, false);
+    }
+
+    void PushAudio(TPayload const& payload, int64_t timestamp, int64_t duration, BundleCallback const& emit)
+    {
+        int64_t end = timestamp + (duration > 0 ? duration : 0);
+
+        m_audio.push_back({ payload, timestamp, end - timestamp, true });
+        if (m_audioEnd == InvalidTime || end > m_audioEnd)
+        {
+            m_audioEnd = end;
+        }
+
+        Drain(emit, false);
+
+        // video stalled, hand the audio on without a frame rather than grow
+        while (m_audio.size() > m_maxPendingAudio)
+        {
+            ++m_overflowCount;
+
+            Bundle bundle{};
+            bundle.timestamp = m_audio.front().timestamp;
+            bundle.duration = m_audio.front().duration;
+            bundle.skew = 0;
+            bundle.audio.push_back(std::move(m_audio.front().payload));
+            m_audio.pop_front();
+
+            emit(std::move(bundle));
+        }
+    }
+
+    // emits everything pending regardless of coverage, used on stop
+    void Flush(BundleCallback const& emit)
+    {
+        Drain(emit, true);
+
+        while (!m_audio.empty())
+        {
+            Bundle bundle{};
+            bundle.timestamp = m_audio.front().timestamp;
+            bundle.duration = m_audio.front().duration;
+            bundle.skew = 0;
+            bundle.audio.push_back(std::move(m_audio.front().payload));
+            m_audio.pop_front();
+
+            emit(std::move(bundle));
+        }
+    }
+
+private:
+    static constexpr int64_t InvalidTime = (std::numeric_limits<int64_t>::min)();
+
+    struct Entry
+    {
+        TPayload payload;
+        int64_t timestamp;
+        int64_t duration;
+        bool hasDuration;
+    };
+
+    void Drain(BundleCallback const& emit, bool force)
+    {
+        while (!m_video.empty())
+        {
+            auto const& front = m_video.front();
+            int64_t frameEnd = front.timestamp + front.duration;
+
+            // an unknown interval can only be closed by the next frame
+            bool intervalKnown = front.hasDuration || m_video.size() > 1;
+
+            bool covered = intervalKnown && m_audioEnd != InvalidTime && m_audioEnd >= frameEnd;
+            bool tooLate = (m_video.back().timestamp - frameEnd) > m_maxSkew;
+            bool overflow = m_video.size() > m_maxPendingVideo;
+
+            if (!(force || covered || tooLate || overflow))
+            {
+                break;
+            }
+
+            if (!covered && !force)
+            {
+                ++m_overflowCount;
+            }
+
+            Bundle bundle{};
+            bundle.video = std::move(m_video.front().payload);
+            bundle.timestamp = front.timestamp;
+            bundle.duration = front.duration;
+
+            // audio that starts before the end of the frame belongs to it, including
+            // late audio that missed the previous bundle, so nothing is dropped
+            int64_t pairedEnd = front.timestamp;
+            while (!m_audio.empty() && m_audio.front().timestamp < frameEnd)
+            {
+                auto& audio = m_audio.front();
+                pairedEnd = (std::max)(pairedEnd, audio.timestamp + audio.duration);
+                bundle.audio.push_back(std::move(audio.payload));
+                m_audio.pop_front();
+            }
+            bundle.skew = pairedEnd - frameEnd;
+
+            m_video.pop_front();
+
+            emit(std::move(bundle));
+        }
+    }
+
+private:
+    size_t m_maxPendingVideo;
+    size_t m_maxPendingAudio;
+    int64_t m_maxSkew;
+
+    std::deque<Entry> m_video;
+    std::deque<Entry> m_audio;
+
+    int64_t m_audioEnd;
+    int64_t m_lastVideoInterval;
+    uint64_t m_overflowCount;
+};
@@ -5,6 +5,8 @@
 #include "Media.Capture.Sink.h"
 #include "Media.Capture.Sink.g.cpp"
 #include "Media.PayloadHandler.g.h"
+#include "Media.Payload.h"
+#include "Media.PayloadBundle.h"
 
 using namespace winrt;
 using namespace CameraCapture::Media::Capture::implementation;
@@ -13,10 +15,18 @@ using namespace Windows::Media::MediaProperties;
 using winrtStreamSink = CameraCapture::Media::Capture::StreamSink;
 
 Sink::Sink(MediaEncodingProfile const& encodingProfile)
-    : m_currentState(State::Ready)
+    : m_cs("Sink")
+    , m_currentState(State::Ready)
     , m_mediaEncodingProfile(encodingProfile)
     , m_streamSinks()
     , m_payloadHandler(nullptr)
+    , m_timeCs("Sink.Time")
+    , m_clockStartOffset(0)
+    , m_startTimeOffset(PRESENTATION_CURRENT_POSITION)
+    , m_alignStreams(false)
+    , m_aligner()
+    , m_frameRateCs("Sink.FrameRate")
+    , m_frameRateHandler(nullptr)
 {
 
     if (encodingProfile.Audio() != nullptr)
@@ -33,6 +43,7 @@ Sink::Sink(MediaEncodingProfile const& encodingProfile)
             streamId = 0;
         }
 
+        // the stream sink sets the negotiated frame rate from its type
         auto sinkStream = CameraCapture::Media::Capture::StreamSink(streamId, encodingProfile.Video(), *this);
         m_streamSinks.emplace_back(sinkStream);
     }
@@ -101,6 +112,7 @@ HRESULT Sink::AddStreamSink(
     IFR(MFCreatePropertiesFromMediaType(pMediaType, guid_of<IMediaEncodingProperties>(), put_abi(encodingProperties)));
 
     auto sinkStream = CameraCapture::Media::Capture::StreamSink(static_cast<uint8_t>(dwStreamSinkIdentifier), encodingProperties, *this);
+    get_self<StreamSink>(sinkStream)->Metrics(m_metrics);
     m_streamSinks.emplace(it, sinkStream);
 
     if (encodingProperties.Type() == L"Audio")
@@ -325,6 +337,19 @@ HRESULT Sink::OnClockStart(
 
     m_currentState = State::Started;
 
+    // both streams restart on one new base, fixed by whichever delivers first
+    {
+        auto timeGuard = m_timeCs.Guard();
+
+        m_clockStartOffset = (llClockStartOffset != PRESENTATION_CURRENT_POSITION) ? llClockStartOffset : 0;
+        m_startTimeOffset = PRESENTATION_CURRENT_POSITION;
+    }
+
+    m_aligner.Reset();
+
+    // a restart is a new measurement, the gap since the stop is not a slow frame
+    m_frameRate.Reset();
+
     for (auto&& streamSink : m_streamSinks)
     {
         IFR(streamSink.Start(hnsSystemTime, llClockStartOffset));
@@ -354,6 +379,9 @@ HRESULT Sink::OnClockStop(
         IFR(sink.Stop());
     }
 
+    // hand out what is left, the next start uses a new base
+    m_aligner.Flush([this](auto&& bundle) { QueueBundle(std::move(bundle)); });
+
     return S_OK;
 }
 
@@ -467,6 +495,8 @@ void Sink::Reset()
         m_payloadHandler = nullptr;
     }
 
+    m_aligner.Reset();
+
     while (m_streamSinks.size() > 0)
     {
         m_streamSinks.front().Shutdown();
@@ -497,6 +527,12 @@ void Sink::QueueMetadata(MediaPropertySet const& metaData)
 {
     auto guard = m_cs.Guard();
 
+    // a flush invalidates anything waiting for its pair
+    if (metaData != nullptr && metaData.HasKey(MF_PAYLOAD_FLUSH))
+    {
+        m_aligner.Reset();
+    }
+
     if (m_payloadHandler != nullptr)
     {
         m_payloadHandler.QueueMetadata(metaData);
@@ -517,8 +553,141 @@ void Sink::QueuePayload(CameraCapture::Media::Payload const& payload)
 {
     auto guard = m_cs.Guard();
 
-    if (m_payloadHandler != nullptr)
+    if (m_payloadHandler == nullptr)
     {
-        m_payloadHandler.QueuePayload(payload);
+        return;
+    }
+
+    m_payloadHandler.QueuePayload(payload);
+
+    if (!m_alignStreams || m_mediaEncodingProfile.Audio() == nullptr || m_mediaEncodingProfile.Video() == nullptr)
+    {
+        return;
     }
+
+    auto streamSample = payload.try_as<IStreamSample>();
+    NULL_CHK_R(streamSample);
+
+    auto sample = streamSample->Sample();
+    NULL_CHK_R(sample);
+
+    LONGLONG timestamp = 0;
+    IFV(sample->GetSampleTime(&timestamp));
+
+    LONGLONG duration = 0;
+    if (FAILED(sample->GetSampleDuration(&duration)))
+    {
+        duration = 0;
+    }
+
+    auto emit = [this](auto&& bundle) { QueueBundle(std::move(bundle)); };
+
+    auto majorType = streamSample->MajorType();
+    if (majorType == MFMediaType_Video)
+    {
+        m_aligner.PushVideo(payload, timestamp, duration, emit);
+    }
+    else if (majorType == MFMediaType_Audio)
+    {
+        m_aligner.PushAudio(payload, timestamp, duration, emit);
+    }
+}
+
+_Use_decl_annotations_
+LONGLONG Sink::RebaseTimestamp(
+    LONGLONG timestamp)
+{
+    auto guard = m_timeCs.Guard();
+
+    if (m_startTimeOffset == PRESENTATION_CURRENT_POSITION)
+    {
+        if (timestamp < m_clockStartOffset) // do not base on samples predating the clock start offset
+        {
+            return timestamp;
+        }
+
+        m_startTimeOffset = timestamp - m_clockStartOffset;
+        if (m_startTimeOffset > 0)
+        {
+            Log(L"first sample is not at the clock start, offset=%I64d timestamp=%I64d\n", m_startTimeOffset, timestamp);
+        }
+    }
+
+    // the other stream may start a little before the first sample, that stays negative
+    // rather than collapsing onto the base
+    return timestamp - m_startTimeOffset;
+}
+
+void Sink::AlignStreams(bool value)
+{
+    auto guard = m_cs.Guard();
+
+    if (m_alignStreams != value)
+    {
+        m_aligner.Reset();
+    }
+
+    m_alignStreams = value;
+}
+
+_Use_decl_annotations_
+void Sink::Metrics(
+    std::shared_ptr<MetricsRegistry> const& value)
+{
+    auto guard = m_cs.Guard();
+
+    m_metrics = value;
+
+    for (auto&& streamSink : m_streamSinks)
+    {
+        get_self<StreamSink>(streamSink)->Metrics(m_metrics);
+    }
+}
+
+_Use_decl_annotations_
+bool Sink::UpdateFrameRate(
+    int64_t timestamp,
+    FRAME_RATE_STATE* state)
+{
+    if (!m_frameRate.Add(timestamp, state))
+    {
+        return false;
+    }
+
+    std::function<void(FRAME_RATE_STATE const&)> handler = nullptr;
+    {
+        auto guard = m_frameRateCs.Guard();
+
+        handler = m_frameRateHandler;
+    }
+
+    if (handler != nullptr)
+    {
+        handler(*state);
+    }
+
+    return true;
+}
+
+_Use_decl_annotations_
+void Sink::FrameRateHandler(
+    std::function<void(FRAME_RATE_STATE const&)> const& handler)
+{
+    auto guard = m_frameRateCs.Guard();
+
+    m_frameRateHandler = handler;
+}
+
+_Use_decl_annotations_
+void Sink::QueueBundle(
+    AVAligner<CameraCapture::Media::Payload>::Bundle&& bundle)
+{
+    if (m_payloadHandler == nullptr)
+    {
+        return;
+    }
+
+    m_payloadHandler.QueuePayloadBundle(
+        make<CameraCapture::Media::implementation::PayloadBundle>(
+            bundle.video, std::move(bundle.audio), bundle.timestamp, bundle.duration, bundle.skew));
 }
@@ -6,10 +6,14 @@
 #include "Media.Capture.Sink.g.h"
 #include "Media.Capture.StreamSink.h"
 #include "Media.PayloadHandler.g.h"
+#include "Media.Capture.AVAligner.h"
+#include "Media.FrameMetadata.h"
+#include "Media.FrameRate.h"
 
 #include <mfapi.h>
 #include <mfidl.h>
 #include <mferror.h>
+#include <functional>
 
 static constexpr uint8_t AudioStreamId = 0;
 static constexpr uint8_t VideoStreamId = 1;
@@ -81,9 +85,46 @@ namespace winrt::CameraCapture::Media::Capture::implementation
         }
         Windows::Media::MediaProperties::MediaEncodingProfile EncodingProfile() { return m_mediaEncodingProfile; }
 
+        bool AlignStreams() { auto guard = m_cs.Guard(); return m_alignStreams; }
+        void AlignStreams(bool value);
+        int64_t MaxSkew() { auto guard = m_cs.Guard(); return m_aligner.MaxSkew(); }
+        void MaxSkew(int64_t value) { auto guard = m_cs.Guard(); m_aligner.MaxSkew(value); }
+
+        // internal
+        void Metrics(
+            _In_ std::shared_ptr<MetricsRegistry> const& value);
+
+        // maps a sample or marker time from either stream onto the shared base. the first
+        // sample at or after the clock start fixes it, that sample lands on the clock start
+        // offset. earlier times are returned unchanged
+        LONGLONG RebaseTimestamp(
+            _In_ LONGLONG timestamp);
+
+        uint32_t AddFrameMetadata(_In_ IMFSample* sample) { return m_frameMetadata.Add(sample); }
+        HRESULT GetFrameMetadata(
+            _In_ uint32_t firstSequence,
+            _Out_writes_opt_(*count) FRAME_METADATA* records,
+            _Inout_ uint32_t* count)
+        {
+            return m_frameMetadata.Get(firstSequence, records, count);
+        }
+
+        // called by the video stream sink for every delivered frame, raises the
+        // handler when delivery drops under, or recovers to, the negotiated rate
+        bool UpdateFrameRate(
+            _In_ int64_t timestamp,
+            _Out_ FRAME_RATE_STATE* state);
+        void GetFrameRate(_Out_ FRAME_RATE_STATE* state) { m_frameRate.Get(state); }
+        void NegotiatedFrameRate(_In_ double fps) { m_frameRate.Negotiated(fps); }
+        void FrameRateHandler(
+            _In_ std::function<void(FRAME_RATE_STATE const&)> const& handler);
+
     private:
         void Reset();
 
+        void QueueBundle(
+            _In_ AVAligner<CameraCapture::Media::Payload>::Bundle&& bundle);
+
         inline bool IsState(Capture::State state)
         {
             return m_currentState == state;
@@ -112,6 +153,27 @@ namespace winrt::CameraCapture::Media::Capture::implementation
         com_ptr<IMFPresentationClock> m_presentationClock;
 
         CameraCapture::Media::PayloadHandler m_payloadHandler;
+
+        // one start offset for both streams, its own lock since the stream sinks call in
+        // with theirs held
+        CriticalSection m_timeCs;
+        LONGLONG m_clockStartOffset;    // presentation time when the clock started
+        LONGLONG m_startTimeOffset;     // amount to subtract from a timestamp
+
+        // a/v pairing on the shared clock
+        bool m_alignStreams;
+        AVAligner<CameraCapture::Media::Payload> m_aligner;
+
+        std::shared_ptr<MetricsRegistry> m_metrics;
+
+        // video frame metadata, has its own lock so readers never wait on the sink
+        FrameMetadataRing m_frameMetadata;
+
+        // rate is negotiated from the video encoding properties, the handler has its
+        // own lock since the stream sinks call in with theirs held
+        FrameRateEstimator m_frameRate;
+        CriticalSection m_frameRateCs;
+        std::function<void(FRAME_RATE_STATE const&)> m_frameRateHandler;
     };
 }
 
@@ -4,6 +4,7 @@
 #include "pch.h"
 #include "Media.Capture.StreamSink.h"
 #include "Media.Capture.StreamSink.g.cpp"
+#include "Media.Capture.Sink.h"
 #include "Media.Payload.h"
 #include "Media.PayloadHandler.h"
 #include "Media.Functions.h"
@@ -20,7 +21,9 @@ StreamSink::StreamSink(
     uint8_t index,
     IMediaEncodingProperties const& encodingProperties,
     CameraCapture::Media::Capture::Sink const& parent)
-    : m_currentState(State::Ready)
+    : m_cs("StreamSink")
+    , m_eventCS("StreamSink.Event")
+    , m_currentState(State::Ready)
     , m_streamIndex(index)
     , m_parentSink(parent)
     , m_encodingProperties(encodingProperties)
@@ -34,13 +37,17 @@ StreamSink::StreamSink(
     IFT(m_mediaType->GetGUID(MF_MT_MAJOR_TYPE, &m_guidMajorType));
     IFT(m_mediaType->GetGUID(MF_MT_SUBTYPE, &m_guidSubType));
     IFT(MFCreateEventQueue(m_eventQueue.put()));
+
+    UpdateNegotiatedFrameRate();
 }
 
 StreamSink::StreamSink(
     uint8_t index,
     IMFMediaType* pMediaType,
     CameraCapture::Media::Capture::Sink const& parent)
-    : m_streamIndex(index)
+    : m_cs("StreamSink")
+    , m_eventCS("StreamSink.Event")
+    , m_streamIndex(index)
     , m_parentSink(parent)
     , m_setDiscontinuity(false)
     , m_enableSampleRequests(true)
@@ -53,6 +60,8 @@ StreamSink::StreamSink(
     IFT(pMediaType->GetGUID(MF_MT_SUBTYPE, &m_guidSubType));
     IFT(MFCreatePropertiesFromMediaType(m_mediaType.get(), guid_of<IMediaEncodingProperties>(), put_abi(m_encodingProperties)));
     IFT(MFCreateEventQueue(m_eventQueue.put()));
+
+    UpdateNegotiatedFrameRate();
 }
 
 // IMediaExtension
@@ -141,8 +150,12 @@ HRESULT StreamSink::ProcessSample(
         IFG(MF_E_INVALIDREQUEST, done);
     }
 
+    LONGLONG previousTimestamp = m_lastTimestamp;
+
     hr = ShouldDropSample(pSample, &shouldDrop);
 
+    UpdateMetrics(shouldDrop, previousTimestamp);
+
     if (!shouldDrop)
     {
         if (m_setDiscontinuity)
@@ -152,6 +165,14 @@ HRESULT StreamSink::ProcessSample(
             m_setDiscontinuity = false;
         }
 
+        // both streams share the sink's start offset, so the payload, its frame metadata
+        // and any bundle it ends up in all carry the same time
+        LONGLONG timestamp = 0;
+        if (SUCCEEDED(pSample->GetSampleTime(&timestamp)))
+        {
+            IFG(pSample->SetSampleTime(get_self<Sink>(m_parentSink)->RebaseTimestamp(timestamp)), done);
+        }
+
         com_ptr<IMFSample> spSample = nullptr;
         spSample.copy_from(pSample); //add ref
 
@@ -160,6 +181,14 @@ HRESULT StreamSink::ProcessSample(
         if (streamSample != nullptr)
         {
             streamSample->Sample(m_guidMajorType, m_mediaType, spSample);
+
+            // metadata is pulled from the sample attributes once, here
+            if (m_guidMajorType == MFMediaType_Video)
+            {
+                streamSample->FrameSequence(get_self<Sink>(m_parentSink)->AddFrameMetadata(pSample));
+
+                UpdateFrameRate(pSample);
+            }
         }
 
         m_parentSink.QueuePayload(payload);
@@ -174,6 +203,82 @@ done:
     return hr;
 }
 
+void StreamSink::UpdateMetrics(bool dropped, LONGLONG previousTimestamp)
+{
+    if (m_metrics == nullptr)
+    {
+        return;
+    }
+
+    if (dropped)
+    {
+        m_metrics->Increment(MetricCounter::SamplesDropped);
+
+        return;
+    }
+
+    bool isVideo = (m_guidMajorType == MFMediaType_Video);
+
+    m_metrics->Increment(isVideo ? MetricCounter::VideoSamples : MetricCounter::AudioSamples);
+
+    LONGLONG interval = m_lastTimestamp - previousTimestamp;
+    if (previousTimestamp < 0 || interval <= 0)
+    {
+        return;
+    }
+
+    // sample times are in 100ns units
+    m_metrics->Set(isVideo ? MetricGauge::VideoFrameRate : MetricGauge::AudioFrameRate, 10000000000LL / interval);
+
+    if (isVideo)
+    {
+        m_metrics->Record(MetricHistogram::VideoFrameInterval, static_cast<uint64_t>(interval / 10));
+    }
+}
+
+_Use_decl_annotations_
+void StreamSink::UpdateFrameRate(IMFSample* pSample)
+{
+    LONGLONG sampleTime = 0;
+    if (FAILED(pSample->GetSampleTime(&sampleTime)))
+    {
+        return;
+    }
+
+    FRAME_RATE_STATE state{};
+    bool changed = get_self<Sink>(m_parentSink)->UpdateFrameRate(sampleTime, &state);
+
+    if (m_metrics == nullptr)
+    {
+        return;
+    }
+
+    m_metrics->Set(MetricGauge::NegotiatedFrameRate, static_cast<int64_t>(state.negotiatedFps * 1000.0f));
+    m_metrics->Set(MetricGauge::VideoFrameJitter, static_cast<int64_t>(state.jitterMs * 1000.0f));
+
+    if (changed && state.belowNegotiated)
+    {
+        m_metrics->Increment(MetricCounter::FrameRateWarnings);
+    }
+}
+
+// the rate the frame rate estimator compares against, from whatever type the stream
+// ends up with, not only the profile the sink was built from
+void StreamSink::UpdateNegotiatedFrameRate()
+{
+    if (m_guidMajorType != MFMediaType_Video)
+    {
+        return;
+    }
+
+    UINT32 numerator = 0;
+    UINT32 denominator = 0;
+    if (SUCCEEDED(MFGetAttributeRatio(m_mediaType.get(), MF_MT_FRAME_RATE, &numerator, &denominator)) && denominator != 0)
+    {
+        get_self<Sink>(m_parentSink)->NegotiatedFrameRate(static_cast<double>(numerator) / denominator);
+    }
+}
+
 _Use_decl_annotations_
 HRESULT StreamSink::PlaceMarker(
     MFSTREAMSINK_MARKER_TYPE eMarkerType,
@@ -204,26 +309,16 @@ HRESULT StreamSink::PlaceMarker(
     {
         if (pvarMarkerValue != nullptr && pvarMarkerValue->vt == VT_I8)
         {
-            LARGE_INTEGER timeStamp = { 0 };
-            timeStamp = pvarMarkerValue->hVal;
-
-            if (m_startTimeOffset == PRESENTATION_CURRENT_POSITION)
-            {
-                // set the offset based on a marker tick
-                SetStartTimeOffset(timeStamp.QuadPart);
-            }
-
-            if (m_startTimeOffset > 0)
+            // on the same base as the samples
+            PROPVARIANT timeStamp = *pvarMarkerValue;
+            timeStamp.hVal.QuadPart = get_self<Sink>(m_parentSink)->RebaseTimestamp(pvarMarkerValue->hVal.QuadPart);
+            if (timeStamp.hVal.QuadPart < 0)
             {
-                LONGLONG correctedSampleTime = timeStamp.QuadPart - m_startTimeOffset;
-                if (correctedSampleTime < 0)
-                    correctedSampleTime = 0;
-
-                timeStamp.QuadPart = correctedSampleTime;
+                timeStamp.hVal.QuadPart = 0;
             }
 
             propSet.Insert(MF_PAYLOAD_MARKER_TICK, ConvertProperty(*pvarContextValue));
-            propSet.Insert(MF_PAYLOAD_MARKER_TICK_TIMESTAMP, ConvertProperty(*pvarMarkerValue));
+            propSet.Insert(MF_PAYLOAD_MARKER_TICK_TIMESTAMP, ConvertProperty(timeStamp));
         }
     }
 
@@ -365,6 +460,8 @@ HRESULT StreamSink::SetCurrentMediaType(
     m_mediaType = mediaType;
     IFR(MFCreatePropertiesFromMediaType(m_mediaType.get(), guid_of<IMediaEncodingProperties>(), put_abi(m_encodingProperties)));
 
+    UpdateNegotiatedFrameRate();
+
     m_parentSink.QueueEncodingProperties(m_encodingProperties);
 
     return S_OK;
@@ -375,13 +472,12 @@ _Use_decl_annotations_
 HRESULT StreamSink::Start(int64_t systemTime, int64_t clockStartOffset)
 {
     UNREFERENCED_PARAMETER(systemTime);
+    UNREFERENCED_PARAMETER(clockStartOffset); // the sink rebases both streams
 
     auto guard = m_cs.Guard();
 
     IFR(CheckShutdown());
 
-    m_clockStartOffset = clockStartOffset;
-
     State(State::Started);
 
     m_parentSink.QueueEncodingProperties(m_encodingProperties);
@@ -418,9 +514,6 @@ HRESULT StreamSink::Shutdown()
     }
     m_currentState = State::Shutdown;
 
-    m_clockStartOffset = PRESENTATION_CURRENT_POSITION;
-    m_startTimeOffset = PRESENTATION_CURRENT_POSITION;
-
     if (m_eventQueue != nullptr)
     {
         m_eventQueue->Shutdown();
@@ -522,17 +615,6 @@ HRESULT StreamSink::ShouldDropSample(
 
     IFG(pSample->GetSampleTime(&timestamp), done);
 
-    // if this is the first sample, calculate the offset from start timestamp
-    if (m_startTimeOffset == PRESENTATION_CURRENT_POSITION)
-    {
-        SetStartTimeOffset(timestamp);
-
-        if (m_startTimeOffset > 0)
-        {
-            Log(L"first sample is not at 0, ts=%I64d (m_startTimeOffset) timestamp=%I64d\n", m_startTimeOffset, timestamp);
-        }
-    }
-
     if (FAILED(pSample->GetUINT64(MFSampleExtension_DecodeTimestamp, (QWORD*)&decodeTime)))
     {
         // No MFSampleExtension_DecodeTimestamp means DTS eaqual to PTS, using timestamp
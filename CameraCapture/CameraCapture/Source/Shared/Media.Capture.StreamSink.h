@@ -4,6 +4,7 @@
 #pragma once
 
 #include "Media.Capture.StreamSink.g.h"
+#include "Media.Metrics.h"
 
 #include <mfapi.h>
 #include <mfidl.h>
@@ -83,6 +84,8 @@ namespace winrt::CameraCapture::Media::Capture::implementation
         Capture::State State() { auto guard = m_cs.Guard(); return m_currentState; }
         void State(Capture::State const& value) { m_currentState = value; }
 
+        void Metrics(std::shared_ptr<MetricsRegistry> const& value) { auto guard = m_cs.Guard(); m_metrics = value; }
+
     private:
         STDMETHODIMP CheckShutdown()
         {
@@ -97,35 +100,21 @@ namespace winrt::CameraCapture::Media::Capture::implementation
         STDMETHODIMP VerifyMediaType(
             _In_ IMFMediaType* pMediaType) const;
 
-        void SetStartTimeOffset(
-            _In_ LONGLONG firstSampleTime)
-        {
-            auto guard = m_cs.Guard();
-
-            if (firstSampleTime < m_clockStartOffset) // do not process samples predating the clock start offset;
-            {
-                return;
-            }
-
-            if (m_startTimeOffset == PRESENTATION_CURRENT_POSITION)
-            {
-                m_startTimeOffset = firstSampleTime - m_clockStartOffset;
-            }
-        }
-
         STDMETHODIMP ShouldDropSample(_In_ IMFSample* pSample, _Outptr_ bool *pDrop);
         STDMETHODIMP NotifyStarted();
         STDMETHODIMP NotifyStopped();
         STDMETHODIMP NotifyMarker(const PROPVARIANT *pVarContextValue);
         STDMETHODIMP NotifyRequestSample();
 
+        void UpdateMetrics(bool dropped, LONGLONG previousTimestamp);
+        void UpdateFrameRate(_In_ IMFSample* pSample);
+        void UpdateNegotiatedFrameRate();
+
     private:
         CriticalSection m_cs;
         CriticalSection m_eventCS;
 
         std::atomic<Capture::State> m_currentState;
-        LONGLONG m_clockStartOffset;    // Presentation time when the clock started.
-        LONGLONG m_startTimeOffset;     // amount to subtract from a timestamp
         
         uint8_t m_streamIndex;
         Windows::Media::MediaProperties::IMediaEncodingProperties m_encodingProperties;
@@ -142,6 +131,8 @@ namespace winrt::CameraCapture::Media::Capture::implementation
         LONGLONG m_lastTimestamp;
         LONGLONG m_lastDecodeTime;
 
+        std::shared_ptr<MetricsRegistry> m_metrics;
+
         static const uint8_t m_cMaxSampleRequests = MAX_SAMPLE_REQUESTS;
     };
 }
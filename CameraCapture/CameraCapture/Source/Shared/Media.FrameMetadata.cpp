@@ -0,0 +1,203 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.FrameMetadata.h"
+
+#include <mfapi.h>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#if !WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+EXTERN_GUID(MFSampleExtension_DeviceTimestamp, 0x8f3e35e7, 0x2dcd, 0x4887, 0x86, 0x22, 0x2a, 0x58, 0xba, 0xa6, 0x52, 0xb0);
+#endif
+
+// the calibration blobs are a count followed by that many entries, the size is whatever the
+// driver wrote, not the one entry the struct declares
+static HRESULT GetBlob(
+    _In_ IMFAttributes* attributes,
+    _In_ REFGUID key,
+    _Inout_ std::vector<uint8_t>& blob)
+{
+    UINT32 size = 0;
+    IFR(attributes->GetBlobSize(key, &size));
+
+    blob.resize(size);
+    if (size > 0)
+    {
+        IFR(attributes->GetBlob(key, blob.data(), size, &size));
+    }
+    blob.resize(size);
+
+    return S_OK;
+}
+
+// the header's count, zero when the blob is too small to hold that many entries
+static UINT32 EntryCount(
+    _In_ std::vector<uint8_t> const& blob,
+    _In_ size_t entriesOffset,
+    _In_ size_t entrySize)
+{
+    if (blob.size() < entriesOffset)
+    {
+        return 0;
+    }
+
+    UINT32 count = 0;
+    memcpy(&count, blob.data(), sizeof(count));
+
+    return (count <= (blob.size() - entriesOffset) / entrySize) ? count : 0;
+}
+
+FrameMetadataRing::FrameMetadataRing()
+    : m_cs("FrameMetadata")
+    , m_lastSequence(0)
+    , m_firstValidSequence(1)
+{
+    ZeroMemory(m_records, sizeof(m_records));
+}
+
+_Use_decl_annotations_
+uint32_t FrameMetadataRing::Add(
+    IMFSample* sample)
+{
+    auto gurad = m_cs.Guard();
+
+    // filled under the lock, every video stream of the sink shares m_blob
+    FRAME_METADATA metadata;
+    Fill(sample, m_blob, &metadata);
+
+    // 0 is never handed out, it means no metadata
+    if (++m_lastSequence == 0)
+    {
+        ++m_lastSequence;
+    }
+
+    metadata.sequence = m_lastSequence;
+    m_records[m_lastSequence % Capacity] = metadata;
+
+    return m_lastSequence;
+}
+
+_Use_decl_annotations_
+HRESULT FrameMetadataRing::Get(
+    uint32_t firstSequence,
+    FRAME_METADATA* records,
+    uint32_t* count)
+{
+    NULL_CHK_HR(count, E_INVALIDARG);
+
+    auto gurad = m_cs.Guard();
+
+    uint32_t oldest = (m_lastSequence > Capacity) ? m_lastSequence - Capacity + 1 : 1;
+    uint32_t first = std::max(std::max(firstSequence, oldest), m_firstValidSequence);
+    uint32_t available = (m_lastSequence >= first) ? m_lastSequence - first + 1 : 0;
+
+    if (records == nullptr)
+    {
+        *count = available;
+
+        return S_OK;
+    }
+
+    uint32_t copied = std::min(*count, available);
+    for (uint32_t i = 0; i < copied; ++i)
+    {
+        records[i] = m_records[(first + i) % Capacity];
+    }
+    *count = copied;
+
+    return S_OK;
+}
+
+uint32_t FrameMetadataRing::LastSequence()
+{
+    auto gurad = m_cs.Guard();
+
+    return m_lastSequence;
+}
+
+void FrameMetadataRing::Reset()
+{
+    auto gurad = m_cs.Guard();
+
+    // sequence keeps counting so stale numbers held by the app never match a new frame
+    ZeroMemory(m_records, sizeof(m_records));
+    m_firstValidSequence = m_lastSequence + 1;
+}
+
+_Use_decl_annotations_
+void FrameMetadataRing::Fill(
+    IMFSample* sample,
+    std::vector<uint8_t>& blob,
+    FRAME_METADATA* metadata)
+{
+    ZeroMemory(metadata, sizeof(FRAME_METADATA));
+
+    LONGLONG timestamp = 0;
+    if (SUCCEEDED(sample->GetSampleTime(&timestamp)))
+    {
+        metadata->timestamp = timestamp;
+    }
+
+    UINT64 deviceTimestamp = 0;
+    if (SUCCEEDED(sample->GetUINT64(MFSampleExtension_DeviceTimestamp, &deviceTimestamp)))
+    {
+        metadata->deviceTimestamp = static_cast<int64_t>(deviceTimestamp);
+        metadata->flags |= FRAME_METADATA_DEVICE_TIMESTAMP;
+    }
+
+    if (SUCCEEDED(GetBlob(sample, MFSampleExtension_PinholeCameraIntrinsics, blob))
+        && EntryCount(blob, offsetof(MFPinholeCameraIntrinsics, IntrinsicModels), sizeof(MFPinholeCameraIntrinsic_IntrinsicModel)) > 0)
+    {
+        auto const& model = reinterpret_cast<MFPinholeCameraIntrinsics const*>(blob.data())->IntrinsicModels[0];
+
+        metadata->width = model.Width;
+        metadata->height = model.Height;
+        metadata->focalLength[0] = model.CameraModel.FocalLength.x;
+        metadata->focalLength[1] = model.CameraModel.FocalLength.y;
+        metadata->principalPoint[0] = model.CameraModel.PrincipalPoint.x;
+        metadata->principalPoint[1] = model.CameraModel.PrincipalPoint.y;
+        metadata->radialDistortion[0] = model.DistortionModel.Radial_k1;
+        metadata->radialDistortion[1] = model.DistortionModel.Radial_k2;
+        metadata->radialDistortion[2] = model.DistortionModel.Radial_k3;
+        metadata->tangentialDistortion[0] = model.DistortionModel.Tangential_p1;
+        metadata->tangentialDistortion[1] = model.DistortionModel.Tangential_p2;
+        metadata->flags |= FRAME_METADATA_INTRINSICS;
+    }
+
+    if (SUCCEEDED(GetBlob(sample, MFSampleExtension_CameraExtrinsics, blob))
+        && EntryCount(blob, offsetof(MFCameraExtrinsics, CalibratedTransforms), sizeof(MFCameraExtrinsic_CalibratedTransform)) > 0)
+    {
+        auto const& transform = reinterpret_cast<MFCameraExtrinsics const*>(blob.data())->CalibratedTransforms[0];
+
+        metadata->calibrationId = transform.CalibrationId;
+        metadata->position[0] = transform.Position.x;
+        metadata->position[1] = transform.Position.y;
+        metadata->position[2] = transform.Position.z;
+        metadata->orientation[0] = transform.Orientation.x;
+        metadata->orientation[1] = transform.Orientation.y;
+        metadata->orientation[2] = transform.Orientation.z;
+        metadata->orientation[3] = transform.Orientation.w;
+        metadata->flags |= FRAME_METADATA_EXTRINSICS;
+    }
+
+    winrt::com_ptr<IMFAttributes> captureMetadata = nullptr;
+    if (SUCCEEDED(sample->GetUnknown(MFSampleExtension_CaptureMetadata, IID_PPV_ARGS(captureMetadata.put()))))
+    {
+        UINT64 exposureTime = 0;
+        if (SUCCEEDED(captureMetadata->GetUINT64(MF_CAPTURE_METADATA_EXPOSURE_TIME, &exposureTime)))
+        {
+            metadata->exposureTime = static_cast<int64_t>(exposureTime);
+            metadata->flags |= FRAME_METADATA_EXPOSURE;
+        }
+
+        UINT32 iso = 0;
+        if (SUCCEEDED(captureMetadata->GetUINT32(MF_CAPTURE_METADATA_ISO_SPEED, &iso)))
+        {
+            metadata->iso = iso;
+            metadata->flags |= FRAME_METADATA_ISO;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <mfidl.h>
+#include <vector>
+
+// last N video frames of metadata, slot = sequence % capacity, so a lookup is one
+// compare and a bulk read is a single copy under the lock
+struct FrameMetadataRing
+{
+    static constexpr uint32_t Capacity = 64;
+
+    FrameMetadataRing();
+
+    // reads the MFSampleExtension_* attributes once, returns the new sequence
+    uint32_t Add(_In_ IMFSample* sample);
+
+    // copies the frames from firstSequence on that are still held, null records returns
+    // how many are available
+    HRESULT Get(
+        _In_ uint32_t firstSequence,
+        _Out_writes_opt_(*count) FRAME_METADATA* records,
+        _Inout_ uint32_t* count);
+
+    uint32_t LastSequence();
+
+    void Reset();
+
+    // blob is scratch for the calibration attributes, kept by the caller so a frame
+    // doesn't allocate once it has grown to the driver's size
+    static void Fill(
+        _In_ IMFSample* sample,
+        _Inout_ std::vector<uint8_t>& blob,
+        _Out_ FRAME_METADATA* metadata);
+
+private:
+    CriticalSection m_cs;
+    uint32_t m_lastSequence;
+    uint32_t m_firstValidSequence;
+    FRAME_METADATA m_records[Capacity];
+    std::vector<uint8_t> m_blob;
+};
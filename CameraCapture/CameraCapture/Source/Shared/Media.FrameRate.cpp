@@ -0,0 +1,182 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.FrameRate.h"
+
+#include <algorithm>
+#include <cmath>
+
+// delivery has to drop under 85% of the negotiated rate to warn, and come back over 95% to clear
+static constexpr double c_belowThreshold = 0.85;
+static constexpr double c_recoverThreshold = 0.95;
+
+// in range first, then over it, then under it. a camera that runs faster than asked can be
+// paced down, one that runs slower never makes up the frames
+static uint32_t RangeRank(
+    _In_ FrameRateRange const& range,
+    _In_ double fps)
+{
+    if (range.Contains(fps))
+    {
+        return 0;
+    }
+
+    return (range.minFps <= 0.0 || fps >= range.minFps) ? 1 : 2;
+}
+
+_Use_decl_annotations_
+int32_t SelectVideoFormat(
+    std::vector<VideoFormatCandidate> const& candidates,
+    uint32_t width,
+    uint32_t height,
+    FrameRateRange const& range)
+{
+    int32_t selected = -1;
+    uint32_t selectedRank = 0;
+    double selectedDistance = 0.0;
+
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        auto const& candidate = candidates[i];
+        if (!candidate.subtypeMatches || candidate.width != width || candidate.height != height)
+        {
+            continue;
+        }
+
+        uint32_t rank = RangeRank(range, candidate.fps);
+        double distance = range.Distance(candidate.fps);
+        if (selected == -1
+            || rank < selectedRank
+            || (rank == selectedRank && distance < selectedDistance)
+            || (rank == selectedRank && distance == selectedDistance && candidate.fps > candidates[selected].fps))
+        {
+            selected = static_cast<int32_t>(i);
+            selectedRank = rank;
+            selectedDistance = distance;
+        }
+    }
+
+    return selected;
+}
+
+FrameRateEstimator::FrameRateEstimator()
+    : m_cs("FrameRateEstimator")
+    , m_negotiatedFps(0.0)
+    , m_lastTimestamp(-1)
+    , m_next(0)
+    , m_count(0)
+{
+    ZeroMemory(m_intervals, sizeof(m_intervals));
+    ZeroMemory(&m_state, sizeof(m_state));
+}
+
+_Use_decl_annotations_
+void FrameRateEstimator::Negotiated(
+    double fps)
+{
+    auto gurad = m_cs.Guard();
+
+    m_negotiatedFps = fps;
+    m_state.negotiatedFps = static_cast<float>(fps);
+}
+
+_Use_decl_annotations_
+bool FrameRateEstimator::Add(
+    int64_t timestamp,
+    FRAME_RATE_STATE* state)
+{
+    auto gurad = m_cs.Guard();
+
+    int64_t previous = m_lastTimestamp;
+    m_lastTimestamp = timestamp;
+
+    *state = m_state;
+
+    // first frame, or the clock went backwards after a restart
+    if (previous < 0 || timestamp <= previous)
+    {
+        return false;
+    }
+
+    m_intervals[m_next] = timestamp - previous;
+    m_next = (m_next + 1) % WindowSize;
+    if (m_count < WindowSize)
+    {
+        ++m_count;
+    }
+
+    bool wasBelow = m_state.belowNegotiated != 0;
+
+    Update();
+
+    *state = m_state;
+
+    return wasBelow != (m_state.belowNegotiated != 0);
+}
+
+_Use_decl_annotations_
+void FrameRateEstimator::Get(
+    FRAME_RATE_STATE* state)
+{
+    auto gurad = m_cs.Guard();
+
+    *state = m_state;
+}
+
+void FrameRateEstimator::Reset()
+{
+    auto gurad = m_cs.Guard();
+
+    m_lastTimestamp = -1;
+    m_next = 0;
+    m_count = 0;
+
+    ZeroMemory(&m_state, sizeof(m_state));
+    m_state.negotiatedFps = static_cast<float>(m_negotiatedFps);
+}
+
+void FrameRateEstimator::Update()
+{
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < m_count; ++i)
+    {
+        sum += m_intervals[i];
+    }
+
+    double mean = static_cast<double>(sum) / m_count;
+
+    double variance = 0.0;
+    for (uint32_t i = 0; i < m_count; ++i)
+    {
+        double delta = m_intervals[i] - mean;
+        variance += delta * delta;
+    }
+    variance /= m_count;
+
+    // intervals are in 100ns
+    m_state.measuredFps = static_cast<float>(10000000.0 / mean);
+    m_state.jitterMs = static_cast<float>(std::sqrt(variance) / 10000.0);
+    m_state.sampleCount = m_count;
+
+    if (m_negotiatedFps <= 0.0)
+    {
+        return;
+    }
+
+    // wait for about a second of frames before judging
+    uint32_t required = std::min(WindowSize, static_cast<uint32_t>(std::max(1.0, m_negotiatedFps)));
+    if (m_count < required)
+    {
+        return;
+    }
+
+    if (m_state.belowNegotiated == 0 && m_state.measuredFps < m_negotiatedFps * c_belowThreshold)
+    {
+        m_state.belowNegotiated = 1;
+    }
+    else if (m_state.belowNegotiated != 0 && m_state.measuredFps >= m_negotiatedFps * c_recoverThreshold)
+    {
+        m_state.belowNegotiated = 0;
+    }
+}
@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <vector>
+
+// 0 for either end leaves that side open
+struct FrameRateRange
+{
+    double minFps;
+    double maxFps;
+
+    bool Contains(double fps) const
+    {
+        return (minFps <= 0.0 || fps >= minFps) && (maxFps <= 0.0 || fps <= maxFps);
+    }
+
+    // how far outside the range, 0 when inside
+    double Distance(double fps) const
+    {
+        if (minFps > 0.0 && fps < minFps)
+        {
+            return minFps - fps;
+        }
+
+        if (maxFps > 0.0 && fps > maxFps)
+        {
+            return fps - maxFps;
+        }
+
+        return 0.0;
+    }
+};
+
+struct VideoFormatCandidate
+{
+    uint32_t width;
+    uint32_t height;
+    double fps;
+    bool subtypeMatches;
+};
+
+// exact size and subtype are required, among those the highest rate in range wins,
+// if nothing is in range the closest rate over minFps does, then the closest under it,
+// -1 when nothing matches the size
+int32_t SelectVideoFormat(
+    _In_ std::vector<VideoFormatCandidate> const& candidates,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ FrameRateRange const& range);
+
+// delivered rate and inter-frame jitter over the last WindowSize sample intervals,
+// flags when delivery falls under the negotiated rate, with hysteresis so a
+// borderline camera does not flap
+struct FrameRateEstimator
+{
+    static constexpr uint32_t WindowSize = 60;
+
+    FrameRateEstimator();
+
+    void Negotiated(_In_ double fps);
+
+    // sample time in 100ns, returns true when belowNegotiated changed
+    bool Add(_In_ int64_t timestamp, _Out_ FRAME_RATE_STATE* state);
+
+    void Get(_Out_ FRAME_RATE_STATE* state);
+
+    void Reset();
+
+private:
+    void Update();
+
+private:
+    CriticalSection m_cs;
+
+    double m_negotiatedFps;
+    int64_t m_lastTimestamp;
+
+    int64_t m_intervals[WindowSize];
+    uint32_t m_next;
+    uint32_t m_count;
+
+    FRAME_RATE_STATE m_state;
+};
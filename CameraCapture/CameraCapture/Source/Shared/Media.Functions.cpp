@@ -163,9 +163,10 @@ IMediaEncodingProperties GetVideoDeviceProperties(
     MediaStreamType mediaStreamType,
     uint32_t width,
     uint32_t height,
-    hstring subType)
+    hstring subType,
+    FrameRateRange const& frameRateRange)
 {
-    // select a camera property that meets the resolution at the highest framerate
+    // select a camera property that meets the resolution at the highest framerate in range
     auto preferredSettings = videoDeviceController.GetAvailableMediaStreamProperties(mediaStreamType);
     if (preferredSettings.Size() == 0)
     {
@@ -174,56 +175,48 @@ IMediaEncodingProperties GetVideoDeviceProperties(
 
     Log(L"Total available MediaStreamProperties for %s: %i\n", videoDeviceController.Id().c_str(), preferredSettings.Size());
 
-    setlocale(LC_ALL, "");
-
-    IMediaEncodingProperties mediaEncodingProperty = nullptr;
-    auto const& found = std::find_if(begin(preferredSettings), end(preferredSettings), [&](IMediaEncodingProperties const& prop)
+    std::vector<IVideoEncodingProperties> properties;
+    std::vector<VideoFormatCandidate> candidates;
+    for (auto const& prop : preferredSettings)
+    {
+        // validate it is video
+        if (prop.Type() != L"Video")
         {
-            // validate it is video
-            if (prop.Type() != L"Video")
-            {
-                false;
-            }
+            continue;
+        }
 
-            auto videoProperty = prop.as<IVideoEncodingProperties>();
+        auto videoProperty = prop.as<IVideoEncodingProperties>();
 
-            if (mediaEncodingProperty == nullptr)
-            {
-                mediaEncodingProperty = videoProperty;
-            }
+        auto frameRate = videoProperty.FrameRate();
+        double fps = frameRate.Denominator() != 0 ? static_cast<double>(frameRate.Numerator()) / frameRate.Denominator() : 0.0;
 
-            Log(L"\tFormat: %s: %i x %i @ %d/%d fps",
-                prop.Subtype().c_str(),
-                videoProperty.Width(),
-                videoProperty.Height(),
-                videoProperty.FrameRate().Numerator(),
-                videoProperty.FrameRate().Denominator());
-
-            // select a size that will be == width/height @ 30fps, final size will be set with enc props
-            double fps = videoProperty.FrameRate().Numerator() / videoProperty.FrameRate().Denominator();
-            bool match =
-                _wcsicmp(videoProperty.Subtype().c_str(), subType.c_str()) == 0 &&
-                videoProperty.Width() == width &&
-                videoProperty.Height() == height &&
-                fps == 30.0;
-            if (match)
-            {
-                Log(L" - found\n");
-            }
-            else
-            {
-                Log(L"\n");
-            }
+        Log(L"\tFormat: %s: %i x %i @ %.2f fps\n",
+            prop.Subtype().c_str(),
+            videoProperty.Width(),
+            videoProperty.Height(),
+            fps);
 
-            return match;
-        });
+        properties.push_back(videoProperty);
+        candidates.push_back(VideoFormatCandidate{ videoProperty.Width(), videoProperty.Height(), fps, _wcsicmp(videoProperty.Subtype().c_str(), subType.c_str()) == 0 });
+    }
 
-    if (found != end(preferredSettings))
+    if (properties.empty())
     {
-        mediaEncodingProperty = *found;
+        return nullptr;
     }
 
-    return mediaEncodingProperty;
+    // final size will be set with enc props, fall back to the first format
+    int32_t selected = SelectVideoFormat(candidates, width, height, frameRateRange);
+    if (selected < 0)
+    {
+        Log(LogLevel::Warning, L"no %i x %i format, using the first available\n", width, height);
+
+        return properties.front();
+    }
+
+    Log(LogLevel::Info, L"selected %i x %i @ %.2f fps\n", width, height, candidates[selected].fps);
+
+    return properties[selected];
 }
 
 _Use_decl_annotations_
@@ -6,6 +6,8 @@
 #include <d3d11_1.h>
 #include <mfidl.h>
 
+#include "Media.FrameRate.h"
+
 #include <winrt/windows.foundation.h>
 #include <winrt/windows.devices.enumeration.h>
 #include <winrt/windows.media.devices.h>
@@ -26,7 +28,8 @@ winrt::Windows::Media::MediaProperties::IMediaEncodingProperties GetVideoDeviceP
     _In_ winrt::Windows::Media::Capture::MediaStreamType mediaStreamType,
     _In_ uint32_t width,
     _In_ uint32_t height,
-    _In_ winrt::hstring subType);
+    _In_ winrt::hstring subType,
+    _In_ FrameRateRange const& frameRateRange);
 
 winrt::Windows::Media::Core::MediaStreamSource CreateMediaSource(
     _In_ winrt::Windows::Media::MediaProperties::MediaEncodingProfile const& encodingProfile);
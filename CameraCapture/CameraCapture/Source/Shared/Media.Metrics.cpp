@@ -0,0 +1,157 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.Metrics.h"
+
+#include <algorithm>
+#include <string>
+
+static char const* const c_counterNames[] =
+{
+    "videoSamples",
+    "audioSamples",
+    "samplesDropped",
+    "payloadsQueued",
+    "payloadsDispatched",
+    "queueFailures",
+    "transformSucceeded",
+    "transformFailed",
+    "videoFramesDelivered",
+    "audioFramesDelivered",
+    "textureReallocations",
+    "copyFailures",
+    "frameRateWarnings",
+};
+static_assert(_countof(c_counterNames) == static_cast<size_t>(MetricCounter::Count), "counter names out of sync");
+
+static char const* const c_gaugeNames[] =
+{
+    "payloadQueueDepth",
+    "videoFrameRateMilli",
+    "audioFrameRateMilli",
+    "videoWidth",
+    "videoHeight",
+    "negotiatedFrameRateMilli",
+    "videoFrameJitterUs",
+};
+static_assert(_countof(c_gaugeNames) == static_cast<size_t>(MetricGauge::Count), "gauge names out of sync");
+
+static char const* const c_histogramNames[] =
+{
+    "videoFrameIntervalUs",
+    "videoCopyTimeUs",
+    "dispatchTimeUs",
+    "transformTimeUs",
+};
+static_assert(_countof(c_histogramNames) == static_cast<size_t>(MetricHistogram::Count), "histogram names out of sync");
+
+MetricsRegistry::MetricsRegistry()
+    : m_ticksPerMicrosecond(1.0)
+{
+    LARGE_INTEGER frequency = {};
+    QueryPerformanceFrequency(&frequency);
+
+    // not rounded, a 3.579545MHz counter would read every time about 19% long
+    m_ticksPerMicrosecond = static_cast<double>(frequency.QuadPart) / 1000000.0;
+
+    Reset();
+}
+
+_Use_decl_annotations_
+HRESULT MetricsRegistry::Snapshot(
+    char* buffer,
+    uint32_t* size) const
+{
+    NULL_CHK_HR(size, E_INVALIDARG);
+
+    char value[64] = {};
+    std::string text;
+    text.reserve(2048);
+
+    text += "{\"counters\":{";
+    for (uint32_t i = 0; i < _countof(c_counterNames); ++i)
+    {
+        StringCchPrintfA(value, _countof(value), "%s\"%s\":%I64u", (i > 0) ? "," : "", c_counterNames[i],
+            m_counters[i].value.load(std::memory_order_relaxed));
+        text += value;
+    }
+
+    text += "},\"gauges\":{";
+    for (uint32_t i = 0; i < _countof(c_gaugeNames); ++i)
+    {
+        StringCchPrintfA(value, _countof(value), "%s\"%s\":%I64d", (i > 0) ? "," : "", c_gaugeNames[i],
+            m_gauges[i].value.load(std::memory_order_relaxed));
+        text += value;
+    }
+
+    text += "},\"histograms\":{";
+    for (uint32_t i = 0; i < _countof(c_histogramNames); ++i)
+    {
+        auto const& histogram = m_histograms[i];
+
+        StringCchPrintfA(value, _countof(value), "%s\"%s\":{", (i > 0) ? "," : "", c_histogramNames[i]);
+        text += value;
+
+        StringCchPrintfA(value, _countof(value), "\"count\":%I64u,\"sum\":%I64u,\"max\":%I64u,\"buckets\":[",
+            histogram.count.load(std::memory_order_relaxed),
+            histogram.sum.load(std::memory_order_relaxed),
+            histogram.max.load(std::memory_order_relaxed));
+        text += value;
+
+        // trailing empty buckets are left out
+        uint32_t used = HistogramBuckets;
+        while (used > 0 && histogram.buckets[used - 1].load(std::memory_order_relaxed) == 0)
+        {
+            --used;
+        }
+
+        for (uint32_t bucket = 0; bucket < used; ++bucket)
+        {
+            StringCchPrintfA(value, _countof(value), "%s%u", (bucket > 0) ? "," : "",
+                histogram.buckets[bucket].load(std::memory_order_relaxed));
+            text += value;
+        }
+
+        text += "]}";
+    }
+    text += "}}";
+
+    uint32_t required = static_cast<uint32_t>(text.size() + 1);
+    if (buffer == nullptr || *size < required)
+    {
+        *size = required;
+
+        return (buffer == nullptr) ? S_OK : HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    memcpy(buffer, text.c_str(), required);
+    *size = required;
+
+    return S_OK;
+}
+
+void MetricsRegistry::Reset()
+{
+    for (auto& counter : m_counters)
+    {
+        counter.value.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& gauge : m_gauges)
+    {
+        gauge.value.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& histogram : m_histograms)
+    {
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.sum.store(0, std::memory_order_relaxed);
+        histogram.max.store(0, std::memory_order_relaxed);
+
+        for (auto& bucket : histogram.buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
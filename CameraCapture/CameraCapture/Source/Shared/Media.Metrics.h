@@ -0,0 +1,140 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <atomic>
+
+#include "BitScan.h"
+
+enum class MetricCounter : uint32_t
+{
+    VideoSamples = 0,
+    AudioSamples,
+    SamplesDropped,
+    PayloadsQueued,
+    PayloadsDispatched,
+    QueueFailures,
+    TransformSucceeded,
+    TransformFailed,
+    VideoFramesDelivered,
+    AudioFramesDelivered,
+    TextureReallocations,
+    CopyFailures,
+    FrameRateWarnings,
+    Count
+};
+
+enum class MetricGauge : uint32_t
+{
+    PayloadQueueDepth = 0,
+    VideoFrameRate,     // fps * 1000
+    AudioFrameRate,     // buffers per second * 1000
+    VideoWidth,
+    VideoHeight,
+    NegotiatedFrameRate,    // fps * 1000
+    VideoFrameJitter,       // microseconds
+    Count
+};
+
+enum class MetricHistogram : uint32_t
+{
+    VideoFrameInterval = 0, // all histograms are in microseconds
+    VideoCopyTime,
+    DispatchTime,
+    TransformTime,
+    Count
+};
+
+// per capture instance, every update is a relaxed atomic on its own cache line
+// so the sink, dispatcher and subscriber threads never serialize on it
+struct MetricsRegistry
+{
+    // bucket 0 is < 1us, bucket n is [2^(n-1), 2^n) us, the last one is open ended
+    static constexpr uint32_t HistogramBuckets = 24;
+
+    MetricsRegistry();
+
+    static int64_t Now()
+    {
+        LARGE_INTEGER value;
+        QueryPerformanceCounter(&value);
+        return value.QuadPart;
+    }
+
+    void Increment(MetricCounter id, uint64_t value = 1)
+    {
+        m_counters[static_cast<uint32_t>(id)].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void Set(MetricGauge id, int64_t value)
+    {
+        m_gauges[static_cast<uint32_t>(id)].value.store(value, std::memory_order_relaxed);
+    }
+
+    void Record(MetricHistogram id, uint64_t microseconds)
+    {
+        auto& histogram = m_histograms[static_cast<uint32_t>(id)];
+
+        histogram.count.fetch_add(1, std::memory_order_relaxed);
+        histogram.sum.fetch_add(microseconds, std::memory_order_relaxed);
+
+        uint64_t previous = histogram.max.load(std::memory_order_relaxed);
+        while (microseconds > previous
+            && !histogram.max.compare_exchange_weak(previous, microseconds, std::memory_order_relaxed))
+        {
+        }
+
+        histogram.buckets[Bucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void RecordElapsed(MetricHistogram id, int64_t startTicks)
+    {
+        Record(id, static_cast<uint64_t>((Now() - startTicks) / m_ticksPerMicrosecond));
+    }
+
+    // json snapshot, call with a null buffer to get the size including the terminator
+    HRESULT Snapshot(
+        _Out_writes_opt_(*size) char* buffer,
+        _Inout_ uint32_t* size) const;
+
+    void Reset();
+
+private:
+    static uint32_t Bucket(uint64_t microseconds)
+    {
+        if (microseconds == 0)
+        {
+            return 0;
+        }
+
+        uint32_t index = HighestSetBit(microseconds);
+
+        return (index + 1 < HistogramBuckets) ? index + 1 : HistogramBuckets - 1;
+    }
+
+    struct alignas(64) Counter
+    {
+        std::atomic<uint64_t> value;
+    };
+
+    struct alignas(64) Gauge
+    {
+        std::atomic<int64_t> value;
+    };
+
+    struct alignas(64) Histogram
+    {
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+        std::atomic<uint32_t> buckets[HistogramBuckets];
+    };
+
+private:
+    double m_ticksPerMicrosecond;
+
+    Counter m_counters[static_cast<uint32_t>(MetricCounter::Count)];
+    Gauge m_gauges[static_cast<uint32_t>(MetricGauge::Count)];
+    Histogram m_histograms[static_cast<uint32_t>(MetricHistogram::Count)];
+};
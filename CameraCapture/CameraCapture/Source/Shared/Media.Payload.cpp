@@ -17,7 +17,8 @@ using namespace Windows::Media::Core;
 using namespace Windows::Media::MediaProperties;
 
 Payload::Payload()
-    : m_mediaType(nullptr)
+    : m_majorType(GUID_NULL)
+    , m_mediaType(nullptr)
     , m_mediaSample(nullptr)
     , m_propertySet()
     , m_encodingProperties(nullptr)
@@ -25,6 +26,7 @@ Payload::Payload()
     , m_hasTransform(false)
     , m_cameraToWorld()
     , m_cameraProjection()
+    , m_frameSequence(0)
 {
 }
 
@@ -73,6 +75,7 @@ hresult Payload::Sample(
     streamSample.ExtendedProperties().Insert(MF_MT_MAJOR_TYPE, box_value(type));
 
     // store objects
+    m_majorType = majorType;
     m_mediaType = mediaType;
     m_mediaSample = mediaSample;
     m_mediaStreamSample = streamSample;
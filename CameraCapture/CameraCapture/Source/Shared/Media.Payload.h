@@ -24,6 +24,7 @@ extern const __declspec(selectany) winrt::guid MF_PAYLOAD_MARKER_TICK_TIMESTAMP
 struct __declspec(uuid("8300b3cc-c919-4c54-b01a-b375b843d3f8")) IStreamSample : ::IUnknown
 {
     virtual winrt::com_ptr<IMFSample> __stdcall Sample() = 0;
+    virtual winrt::guid __stdcall MajorType() = 0;
     virtual winrt::hresult __stdcall Sample(
         _In_ winrt::guid const& majorType,
         _In_ winrt::com_ptr<IMFMediaType> const& mediaType, 
@@ -31,6 +32,8 @@ struct __declspec(uuid("8300b3cc-c919-4c54-b01a-b375b843d3f8")) IStreamSample :
     virtual void __stdcall SetTransformAndProjection(
         _In_ winrt::Windows::Foundation::Numerics::float4x4 const& cameraTranform,
         _In_ winrt::Windows::Foundation::Numerics::float4x4 const& cameraProjection) = 0;
+    virtual uint32_t __stdcall FrameSequence() = 0;
+    virtual void __stdcall FrameSequence(_In_ uint32_t sequence) = 0;
 };
 
 namespace winrt::CameraCapture::Media::implementation
@@ -49,6 +52,7 @@ namespace winrt::CameraCapture::Media::implementation
 
         // IStreamSample
         virtual winrt::com_ptr<IMFSample> __stdcall Sample() override;
+        virtual winrt::guid __stdcall MajorType() override { return m_majorType; }
         virtual hresult __stdcall Sample(
             _In_ guid const& majorType,
             _In_ com_ptr<IMFMediaType> const& mediaType, 
@@ -56,8 +60,11 @@ namespace winrt::CameraCapture::Media::implementation
         virtual void __stdcall SetTransformAndProjection(
             _In_ Windows::Foundation::Numerics::float4x4 const& cameraTranform,
             _In_ Windows::Foundation::Numerics::float4x4 const& cameraProjection) override;
+        virtual uint32_t __stdcall FrameSequence() override { return m_frameSequence; }
+        virtual void __stdcall FrameSequence(_In_ uint32_t sequence) override { m_frameSequence = sequence; }
 
     private:
+        guid m_majorType;
         com_ptr<IMFMediaType> m_mediaType;
         com_ptr<IMFSample> m_mediaSample;
 
@@ -68,6 +75,8 @@ namespace winrt::CameraCapture::Media::implementation
         bool m_hasTransform;
         Windows::Foundation::Numerics::float4x4 m_cameraToWorld;
         Windows::Foundation::Numerics::float4x4 m_cameraProjection;
+
+        uint32_t m_frameSequence;
     };
 }
 
@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.PayloadBundle.h"
+#include "Media.PayloadBundle.g.cpp"
+
+using namespace winrt;
+using namespace CameraCapture::Media::implementation;
+
+_Use_decl_annotations_
+PayloadBundle::PayloadBundle(
+    CameraCapture::Media::Payload const& video,
+    std::vector<CameraCapture::Media::Payload>&& audio,
+    int64_t timestamp,
+    int64_t duration,
+    int64_t skew)
+    : m_video(video)
+    , m_audio(single_threaded_vector<CameraCapture::Media::Payload>(std::move(audio)).GetView())
+    , m_timestamp(timestamp)
+    , m_duration(duration)
+    , m_skew(skew)
+{
+}
@@ -0,0 +1,34 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "Media.PayloadBundle.g.h"
+
+namespace winrt::CameraCapture::Media::implementation
+{
+    struct PayloadBundle : PayloadBundleT<PayloadBundle>
+    {
+        PayloadBundle(
+            _In_ CameraCapture::Media::Payload const& video,
+            _In_ std::vector<CameraCapture::Media::Payload>&& audio,
+            _In_ int64_t timestamp,
+            _In_ int64_t duration,
+            _In_ int64_t skew);
+
+        CameraCapture::Media::Payload Video() { return m_video; }
+        Windows::Foundation::Collections::IVectorView<CameraCapture::Media::Payload> Audio() { return m_audio; }
+
+        int64_t Timestamp() { return m_timestamp; }
+        int64_t Duration() { return m_duration; }
+        int64_t Skew() { return m_skew; }
+
+    private:
+        CameraCapture::Media::Payload m_video;
+        Windows::Foundation::Collections::IVectorView<CameraCapture::Media::Payload> m_audio;
+
+        int64_t m_timestamp;
+        int64_t m_duration;
+        int64_t m_skew;
+    };
+}
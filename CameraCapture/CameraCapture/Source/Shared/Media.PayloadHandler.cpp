@@ -9,14 +9,18 @@
 #include <winrt/windows.media.h>
 #include <winrt/windows.media.core.h>
 
+#include <algorithm>
+
 using namespace winrt;
 using namespace CameraCapture::Media::implementation;
 using namespace Windows::Media::Core;
 using namespace Windows::Media::MediaProperties;
 
 PayloadHandler::PayloadHandler()
-    : m_isShutdown(false)
+    : m_cs("PayloadHandler")
+    , m_isShutdown(false)
     , m_workItemQueueId(MFASYNC_CALLBACK_QUEUE_UNDEFINED)
+    , m_nextSubscriberId(1)
     , m_transform(CameraCapture::Media::Transform())
     , m_appCoordinateSystem(nullptr)
 {
@@ -37,12 +41,29 @@ void PayloadHandler::AppCoordinateSystem(Windows::Perception::Spatial::SpatialCo
 
 bool PayloadHandler::ProceesTranform(CameraCapture::Media::Payload const& payload)
 {
-    if (m_appCoordinateSystem != nullptr)
+    if (m_appCoordinateSystem == nullptr)
     {
-        return m_transform.ProcessWorldTransform(payload, m_appCoordinateSystem);
+        return false;
     }
 
-    return false;
+    std::shared_ptr<MetricsRegistry> metrics = nullptr;
+    {
+        auto gurad = m_cs.Guard();
+
+        metrics = m_metrics;
+    }
+
+    int64_t start = MetricsRegistry::Now();
+
+    bool succeeded = m_transform.ProcessWorldTransform(payload, m_appCoordinateSystem);
+
+    if (metrics != nullptr)
+    {
+        metrics->RecordElapsed(MetricHistogram::TransformTime, start);
+        metrics->Increment(succeeded ? MetricCounter::TransformSucceeded : MetricCounter::TransformFailed);
+    }
+
+    return succeeded;
 }
 
 void PayloadHandler::Close()
@@ -51,27 +72,116 @@ void PayloadHandler::Close()
 
     m_isShutdown = true;
 
+    m_workItems.clear();
+
+    for (auto&& subscriber : m_subscribers)
+    {
+        subscriber->Shutdown();
+    }
+    m_subscribers.clear();
+
     MFShutdown();
 }
 
 void PayloadHandler::QueueEncodingProfile(MediaEncodingProfile const& mediaProfile)
 {
-    QueueUnknown(winrt::get_unknown(mediaProfile));
+    QueueWorkItem(WorkItem{ std::in_place_index<static_cast<size_t>(PayloadType::EncodingProfile)>, mediaProfile });
 }
 
 void PayloadHandler::QueueMetadata(MediaPropertySet const& metaData)
 {
-    QueueUnknown(winrt::get_unknown(metaData));
+    QueueWorkItem(WorkItem{ std::in_place_index<static_cast<size_t>(PayloadType::Metadata)>, metaData });
 }
 
 void PayloadHandler::QueueEncodingProperties(Windows::Media::MediaProperties::IMediaEncodingProperties const& mediaDescription)
 {
-    QueueUnknown(winrt::get_unknown(mediaDescription));
+    QueueWorkItem(WorkItem{ std::in_place_index<static_cast<size_t>(PayloadType::EncodingProperties)>, mediaDescription });
 }
 
 void PayloadHandler::QueuePayload(CameraCapture::Media::Payload const& payload)
 {
-    QueueUnknown(winrt::get_unknown(payload));
+    QueueWorkItem(WorkItem{ std::in_place_index<static_cast<size_t>(PayloadType::Payload)>, payload });
+}
+
+hresult PayloadHandler::QueuePayloadBundle(CameraCapture::Media::PayloadBundle const& bundle)
+{
+    return QueueWorkItem(WorkItem{ std::in_place_index<static_cast<size_t>(PayloadType::PayloadBundle)>, bundle });
+}
+
+uint32_t PayloadHandler::AddPayloadSubscriber(
+    Windows::Foundation::EventHandler<CameraCapture::Media::Payload> const& handler,
+    uint32_t queueDepth,
+    CameraCapture::Media::PayloadOverflowPolicy const& policy,
+    CameraCapture::Media::PayloadStreamFilter const& streams)
+{
+    auto gurad = m_cs.Guard();
+
+    if (m_isShutdown)
+    {
+        throw hresult_error(MF_E_SHUTDOWN);
+    }
+
+    com_ptr<PayloadSubscriber> subscriber = nullptr;
+    IFT(PayloadSubscriber::Create(m_nextSubscriberId++, handler, queueDepth, policy, streams, subscriber));
+
+    m_subscribers.push_back(subscriber);
+
+    return subscriber->Id();
+}
+
+void PayloadHandler::RemovePayloadSubscriber(uint32_t id)
+{
+    com_ptr<PayloadSubscriber> subscriber = nullptr;
+    {
+        auto gurad = m_cs.Guard();
+
+        auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(), [id](auto const& current) { return current->Id() == id; });
+        if (it == m_subscribers.end())
+        {
+            return;
+        }
+
+        subscriber = *it;
+        m_subscribers.erase(it);
+    }
+
+    // outside the lock, a blocked Enqueue on the dispatcher needs it to finish
+    subscriber->Shutdown();
+}
+
+_Use_decl_annotations_
+void PayloadHandler::Metrics(
+    std::shared_ptr<MetricsRegistry> const& value)
+{
+    auto gurad = m_cs.Guard();
+
+    m_metrics = value;
+}
+
+_Use_decl_annotations_
+HRESULT PayloadHandler::GetSubscriberStats(
+    PAYLOAD_SUBSCRIBER_STATS* stats,
+    uint32_t* count)
+{
+    NULL_CHK_HR(count, E_INVALIDARG);
+
+    auto gurad = m_cs.Guard();
+
+    uint32_t available = static_cast<uint32_t>(m_subscribers.size());
+    if (stats == nullptr || *count < available)
+    {
+        *count = available;
+
+        return (stats == nullptr) ? S_OK : HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    for (uint32_t i = 0; i < available; ++i)
+    {
+        m_subscribers[i]->GetStats(&stats[i]);
+    }
+    *count = available;
+
+    return S_OK;
 }
 
 _Use_decl_annotations_
@@ -84,14 +194,17 @@ HRESULT PayloadHandler::QueueMFSample(
 
     payload.as<IStreamSample>()->Sample(majorType, type, sample);
     
-    return QueueUnknown(winrt::get_unknown(payload));
+    return QueueWorkItem(WorkItem{ std::in_place_index<static_cast<size_t>(PayloadType::Payload)>, payload });
 }
 
 _Use_decl_annotations_
-HRESULT PayloadHandler::QueueUnknown(
-    IUnknown* pUnknown)
+HRESULT PayloadHandler::QueueWorkItem(
+    WorkItem&& item)
 {
-    NULL_CHK_HR(pUnknown, S_OK);
+    if (item.index() == static_cast<size_t>(PayloadType::None))
+    {
+        return S_OK;
+    }
 
     auto gurad = m_cs.Guard();
 
@@ -105,10 +218,22 @@ HRESULT PayloadHandler::QueueUnknown(
         return S_OK;
     }
 
-    com_ptr<IMFAsyncResult> asyncResult = nullptr;
-    IFR(MFCreateAsyncResult(nullptr, this, pUnknown, asyncResult.put()));
+    // the serial queue runs one Invoke per put, in order, so the deque stays in step
+    m_workItems.emplace_back(std::move(item));
 
-    return MFPutWorkItemEx2(m_workItemQueueId, 0, asyncResult.detach());
+    HRESULT hr = MFPutWorkItem2(m_workItemQueueId, 0, this, nullptr);
+    if (FAILED(hr))
+    {
+        m_workItems.pop_back();
+    }
+
+    if (m_metrics != nullptr)
+    {
+        m_metrics->Increment(SUCCEEDED(hr) ? MetricCounter::PayloadsQueued : MetricCounter::QueueFailures);
+        m_metrics->Set(MetricGauge::PayloadQueueDepth, static_cast<int64_t>(m_workItems.size()));
+    }
+
+    return hr;
 }
 
 _Use_decl_annotations_
@@ -138,53 +263,96 @@ HRESULT PayloadHandler::Invoke(
         return S_OK;
     }
 
-    // convert back to Payload
-    com_ptr<IUnknown> spState = nullptr;
-    spState.attach(pAsyncResult->GetStateNoAddRef());
-
-    NULL_CHK_HR(spState, E_POINTER);
-        
     hresult hr = S_OK;
 
-    auto payload = spState.try_as<CameraCapture::Media::Payload>();
-    auto profile = spState.try_as<MediaEncodingProfile>();
-    auto metaData = spState.try_as<MediaPropertySet>();
-    auto mediaDescription = spState.try_as<IMediaEncodingProperties>();
-    auto streamSample = spState.try_as<MediaStreamSample>();
-    if (profile != nullptr)
+    WorkItem item;
+    std::shared_ptr<MetricsRegistry> metrics = nullptr;
     {
-        if (m_profileEvent)
+        auto gurad = m_cs.Guard();
+
+        if (m_workItems.empty())
+        {
+            return pAsyncResult->SetStatus(hr);
+        }
+
+        item = std::move(m_workItems.front());
+        m_workItems.pop_front();
+
+        metrics = m_metrics;
+        if (metrics != nullptr)
         {
-            m_profileEvent(*this, profile);
+            metrics->Set(MetricGauge::PayloadQueueDepth, static_cast<int64_t>(m_workItems.size()));
         }
     }
-    else if (payload != nullptr)
+
+    int64_t start = MetricsRegistry::Now();
+
+    switch (static_cast<PayloadType>(item.index()))
     {
-        if (m_payloadEvent)
+    case PayloadType::EncodingProfile:
+        if (m_profileEvent)
         {
-            m_payloadEvent(*this, payload);
+            m_profileEvent(*this, std::get<MediaEncodingProfile>(item));
         }
-    } 
-    else if (metaData != nullptr)
-    {
+        break;
+    case PayloadType::Metadata:
         if (m_metaDataEvent)
         {
-            m_metaDataEvent(*this, metaData);
+            m_metaDataEvent(*this, std::get<MediaPropertySet>(item));
         }
-    } 
-    else if (mediaDescription != nullptr)
-    {
+        break;
+    case PayloadType::EncodingProperties:
         if (m_mediaDescriptionEvent)
         {
-            m_mediaDescriptionEvent(*this, mediaDescription);
+            m_mediaDescriptionEvent(*this, std::get<IMediaEncodingProperties>(item));
         }
-    }
-    else if (streamSample != nullptr)
+        break;
+    case PayloadType::Payload:
     {
+        auto const& payload = std::get<CameraCapture::Media::Payload>(item);
+        if (m_payloadEvent)
+        {
+            m_payloadEvent(*this, payload);
+        }
+
+        // fan out, each subscriber only ever waits on its own queue
+        std::vector<com_ptr<PayloadSubscriber>> subscribers;
+        {
+            auto gurad = m_cs.Guard();
+
+            subscribers = m_subscribers;
+        }
+
+        auto majorType = get_self<Media::implementation::Payload>(payload)->MajorType();
+        for (auto&& subscriber : subscribers)
+        {
+            if (subscriber->Accepts(majorType))
+            {
+                subscriber->Enqueue(*this, payload);
+            }
+        }
+        break;
+    }
+    case PayloadType::PayloadBundle:
+        if (m_bundleEvent)
+        {
+            m_bundleEvent(*this, std::get<CameraCapture::Media::PayloadBundle>(item));
+        }
+        break;
+    case PayloadType::StreamSample:
         if (m_streamSampleEvent)
         {
-            m_streamSampleEvent(*this, streamSample);
+            m_streamSampleEvent(*this, std::get<MediaStreamSample>(item));
         }
+        break;
+    default:
+        break;
+    }
+
+    if (metrics != nullptr)
+    {
+        metrics->RecordElapsed(MetricHistogram::DispatchTime, start);
+        metrics->Increment(MetricCounter::PayloadsDispatched);
     }
 
     return pAsyncResult->SetStatus(hr);
@@ -8,11 +8,40 @@
 #include <mfapi.h>
 #include <mfidl.h>
 #include <mferror.h>
+#include <winrt/windows.media.core.h>
 
 #include "Media.Transform.h"
+#include "Media.PayloadSubscriber.h"
+#include "Media.Metrics.h"
+
+#include <deque>
+#include <variant>
 
 namespace winrt::CameraCapture::Media::implementation
 {
+    // matches the alternative order of WorkItem, so index() is the tag
+    enum class PayloadType : uint8_t
+    {
+        None = 0,
+        EncodingProfile,
+        Metadata,
+        EncodingProperties,
+        Payload,
+        PayloadBundle,
+        StreamSample
+    };
+
+    using WorkItem = std::variant<
+        std::monostate,
+        Windows::Media::MediaProperties::MediaEncodingProfile,
+        Windows::Media::MediaProperties::MediaPropertySet,
+        Windows::Media::MediaProperties::IMediaEncodingProperties,
+        CameraCapture::Media::Payload,
+        CameraCapture::Media::PayloadBundle,
+        Windows::Media::Core::MediaStreamSample>;
+
+    static_assert(std::variant_size_v<WorkItem> == static_cast<size_t>(PayloadType::StreamSample) + 1, "PayloadType and WorkItem are out of sync");
+
     struct PayloadHandler : PayloadHandlerT<PayloadHandler, IMFAsyncCallback>
     {
         PayloadHandler();
@@ -32,6 +61,15 @@ namespace winrt::CameraCapture::Media::implementation
         void QueueEncodingProperties(Windows::Media::MediaProperties::IMediaEncodingProperties const& mediaDescription);
         void QueuePayload(CameraCapture::Media::Payload const& payload);
 
+        // PayloadHandler
+        hresult QueuePayloadBundle(CameraCapture::Media::PayloadBundle const& bundle);
+        uint32_t AddPayloadSubscriber(
+            Windows::Foundation::EventHandler<CameraCapture::Media::Payload> const& handler,
+            uint32_t queueDepth,
+            CameraCapture::Media::PayloadOverflowPolicy const& policy,
+            CameraCapture::Media::PayloadStreamFilter const& streams);
+        void RemovePayloadSubscriber(uint32_t id);
+
         winrt::event_token OnMediaProfile(Windows::Foundation::EventHandler<Windows::Media::MediaProperties::MediaEncodingProfile> const& handler)
         {
             return m_profileEvent.add(handler);
@@ -50,6 +88,15 @@ namespace winrt::CameraCapture::Media::implementation
             m_payloadEvent.remove(token);
         }
 
+        winrt::event_token OnStreamBundle(Windows::Foundation::EventHandler<CameraCapture::Media::PayloadBundle> const& handler)
+        {
+            return m_bundleEvent.add(handler);
+        }
+        void OnStreamBundle(winrt::event_token const& token) noexcept
+        {
+            m_bundleEvent.remove(token);
+        }
+
         winrt::event_token OnStreamSample(Windows::Foundation::EventHandler<Windows::Media::Core::MediaStreamSample> const& handler)
         {
             return m_streamSampleEvent.add(handler);
@@ -78,13 +125,20 @@ namespace winrt::CameraCapture::Media::implementation
         }
 
         // internal
+        void Metrics(
+            _In_ std::shared_ptr<MetricsRegistry> const& value);
+
+        HRESULT GetSubscriberStats(
+            _Out_writes_opt_(*count) PAYLOAD_SUBSCRIBER_STATS* stats,
+            _Inout_ uint32_t* count);
+
         STDMETHODIMP QueueMFSample(
             _In_ GUID majorType,
             _In_ com_ptr<IMFMediaType> const& type,
             _In_ com_ptr<IMFSample> const& sample);
 
-        STDMETHODIMP QueueUnknown(
-            _In_ ::IUnknown* pUnknown);
+        STDMETHODIMP QueueWorkItem(
+            _In_ WorkItem&& item);
 
         // IMFAsyncCallback
         STDOVERRIDEMETHODIMP GetParameters(
@@ -97,15 +151,22 @@ namespace winrt::CameraCapture::Media::implementation
         CriticalSection m_cs;
         boolean m_isShutdown;
         DWORD m_workItemQueueId;
+        std::deque<WorkItem> m_workItems;
+
+        uint32_t m_nextSubscriberId;
+        std::vector<com_ptr<PayloadSubscriber>> m_subscribers;
         
         event<Windows::Foundation::EventHandler<Windows::Media::MediaProperties::MediaEncodingProfile>> m_profileEvent;
         event<Windows::Foundation::EventHandler<CameraCapture::Media::Payload>> m_payloadEvent;
+        event<Windows::Foundation::EventHandler<CameraCapture::Media::PayloadBundle>> m_bundleEvent;
         event<Windows::Foundation::EventHandler<Windows::Media::Core::MediaStreamSample>> m_streamSampleEvent;
         event<Windows::Foundation::EventHandler<Windows::Media::MediaProperties::MediaPropertySet>> m_metaDataEvent;
         event<Windows::Foundation::EventHandler<Windows::Media::MediaProperties::IMediaEncodingProperties>> m_mediaDescriptionEvent;
 
         CameraCapture::Media::Transform m_transform;
         Windows::Perception::Spatial::SpatialCoordinateSystem m_appCoordinateSystem;
+
+        std::shared_ptr<MetricsRegistry> m_metrics;
     };
 }
 
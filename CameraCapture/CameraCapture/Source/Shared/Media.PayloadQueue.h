@@ -0,0 +1,191 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+enum class PayloadQueuePolicy : uint8_t
+{
+    Block = 0,
+    DropOldest,
+    DropNewest,
+};
+
+// the bounded queue of one payload subscriber, without the worker that drains it. there is
+// no platform dependency in here, the subscriber posts a work item per Push and Pops on its
+// own serial queue, the tests drive it from plain threads. times are 100ns on whatever
+// clock the caller passes in
+//
+// Block is backpressure on the thread that pushes, which is the dispatcher every other
+// subscriber shares. a full queue waits for the worker to Pop, at most maxBlockTime. a wait
+// that runs out marks the queue stalled, from then on a full queue drops the newest without
+// waiting until the worker takes something, so a hung handler costs the dispatcher one
+// maxBlockTime rather than one per payload
+template <typename TItem>
+class PayloadQueue
+{
+public:
+    enum class PushResult : uint8_t
+    {
+        Queued = 0,
+        Replaced,       // drop-oldest made room, one item went
+        Dropped,        // the new item went
+        Shutdown,
+    };
+
+    struct Stats
+    {
+        uint32_t pending;
+        uint32_t maxPending;
+        uint64_t delivered;
+        uint64_t dropped;
+        uint64_t stalls;
+        int64_t lastLag;
+        int64_t maxLag;
+        int64_t totalLag;
+    };
+
+    PayloadQueue(
+        uint32_t depth,
+        PayloadQueuePolicy policy,
+        std::chrono::milliseconds maxBlockTime)
+        : m_depth(depth > 0 ? depth : 1)
+        , m_policy(policy)
+        , m_maxBlockTime(maxBlockTime)
+        , m_isShutdown(false)
+        , m_stalled(false)
+        , m_stats{}
+    {
+    }
+
+    uint32_t Depth() const { return m_depth; }
+    PayloadQueuePolicy Policy() const { return m_policy; }
+
+    PushResult Push(TItem&& item, int64_t now)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (m_isShutdown)
+        {
+            return PushResult::Shutdown;
+        }
+
+        if (m_queue.size() >= m_depth && m_policy == PayloadQueuePolicy::Block && !m_stalled)
+        {
+            if (!m_spaceAvailable.wait_for(lock, m_maxBlockTime, [this] { return m_isShutdown || m_queue.size() < m_depth; }))
+            {
+                m_stalled = true;
+                ++m_stats.stalls;
+            }
+
+            if (m_isShutdown)
+            {
+                return PushResult::Shutdown;
+            }
+        }
+
+        PushResult result = PushResult::Queued;
+        if (m_queue.size() >= m_depth)
+        {
+            ++m_stats.dropped;
+
+            if (m_policy != PayloadQueuePolicy::DropOldest)
+            {
+                // drop-newest, or a blocking subscriber that did not drain in time
+                return PushResult::Dropped;
+            }
+
+            m_queue.pop_front();
+            result = PushResult::Replaced;
+        }
+
+        m_queue.push_back({ std::move(item), now });
+        m_stats.maxPending = (std::max)(m_stats.maxPending, static_cast<uint32_t>(m_queue.size()));
+
+        return result;
+    }
+
+    // undoes the Push that just queued item, when the work item for it could not be posted
+    void Unpush()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_queue.empty())
+        {
+            m_queue.pop_back();
+        }
+    }
+
+    bool Pop(TItem& item, int64_t now)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if (m_isShutdown || m_queue.empty())
+            {
+                return false;
+            }
+
+            int64_t lag = now - m_queue.front().queuedTime;
+            item = std::move(m_queue.front().item);
+            m_queue.pop_front();
+
+            m_stats.lastLag = lag;
+            m_stats.maxLag = (std::max)(m_stats.maxLag, lag);
+            m_stats.totalLag += lag;
+            ++m_stats.delivered;
+
+            // the worker is moving again
+            m_stalled = false;
+        }
+
+        m_spaceAvailable.notify_all();
+
+        return true;
+    }
+
+    void GetStats(Stats* stats)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        *stats = m_stats;
+        stats->pending = static_cast<uint32_t>(m_queue.size());
+    }
+
+    // drops what is queued and releases a blocked Push, every call after returns Shutdown
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_isShutdown = true;
+            m_queue.clear();
+        }
+
+        m_spaceAvailable.notify_all();
+    }
+
+private:
+    struct Entry
+    {
+        TItem item;
+        int64_t queuedTime;
+    };
+
+    uint32_t const m_depth;
+    PayloadQueuePolicy const m_policy;
+    std::chrono::milliseconds const m_maxBlockTime;
+
+    std::mutex m_mutex;
+    std::condition_variable m_spaceAvailable;
+    bool m_isShutdown;
+    bool m_stalled;
+    std::deque<Entry> m_queue;
+    Stats m_stats;
+};
@@ -0,0 +1,213 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.PayloadSubscriber.h"
+
+#include <mferror.h>
+
+using namespace winrt;
+using namespace CameraCapture::Media;
+
+// how long a blocking subscriber may stall the dispatcher, and with it every other
+// subscriber, before payloads are dropped. once per stall, see PayloadQueue
+static constexpr std::chrono::milliseconds c_maxBlockTime{ 100 };
+
+static PayloadQueuePolicy ToQueuePolicy(PayloadOverflowPolicy policy)
+{
+    switch (policy)
+    {
+    case PayloadOverflowPolicy::Block:
+        return PayloadQueuePolicy::Block;
+    case PayloadOverflowPolicy::DropNewest:
+        return PayloadQueuePolicy::DropNewest;
+    default:
+        return PayloadQueuePolicy::DropOldest;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT PayloadSubscriber::Create(
+    uint32_t id,
+    PayloadEventHandler const& handler,
+    uint32_t queueDepth,
+    PayloadOverflowPolicy policy,
+    PayloadStreamFilter streams,
+    com_ptr<PayloadSubscriber>& subscriber)
+{
+    NULL_CHK_HR(handler, E_INVALIDARG);
+
+    auto newSubscriber = make_self<PayloadSubscriber>(id, handler, queueDepth, policy, streams);
+
+    IFR(newSubscriber->Initialize());
+
+    subscriber = newSubscriber;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+PayloadSubscriber::PayloadSubscriber(
+    uint32_t id,
+    PayloadEventHandler const& handler,
+    uint32_t queueDepth,
+    PayloadOverflowPolicy policy,
+    PayloadStreamFilter streams)
+    : m_cs("PayloadSubscriber")
+    , m_isShutdown(false)
+    , m_workItemQueueId(MFASYNC_CALLBACK_QUEUE_UNDEFINED)
+    , m_id(id)
+    , m_handler(handler)
+    , m_streams(streams)
+    , m_queue(queueDepth, ToQueuePolicy(policy), c_maxBlockTime)
+{
+}
+
+PayloadSubscriber::~PayloadSubscriber()
+{
+    Shutdown();
+}
+
+HRESULT PayloadSubscriber::Initialize()
+{
+    return MFAllocateSerialWorkQueue(MFASYNC_CALLBACK_QUEUE_MULTITHREADED, &m_workItemQueueId);
+}
+
+_Use_decl_annotations_
+bool PayloadSubscriber::Accepts(
+    guid const& majorType) const
+{
+    switch (m_streams)
+    {
+    case PayloadStreamFilter::Audio:
+        return majorType == MFMediaType_Audio;
+    case PayloadStreamFilter::Video:
+        return majorType == MFMediaType_Video;
+    default:
+        return true;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT PayloadSubscriber::Enqueue(
+    Windows::Foundation::IInspectable const& sender,
+    Payload const& payload)
+{
+    // not under m_cs, a blocking push waits here and Shutdown has to get in to release it
+    auto result = m_queue.Push({ sender, payload }, MFGetSystemTime());
+    if (result == PayloadQueue<QueuedPayload>::PushResult::Shutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    if (result == PayloadQueue<QueuedPayload>::PushResult::Dropped)
+    {
+        return S_OK;
+    }
+
+    auto gurad = m_cs.Guard();
+
+    if (m_isShutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    // a drop-oldest replacement still posts, Invoke tolerates an empty queue
+    HRESULT hr = MFPutWorkItem2(m_workItemQueueId, 0, this, nullptr);
+    if (FAILED(hr) && result == PayloadQueue<QueuedPayload>::PushResult::Queued)
+    {
+        m_queue.Unpush();
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+void PayloadSubscriber::GetStats(PAYLOAD_SUBSCRIBER_STATS* stats)
+{
+    NULL_CHK_R(stats);
+
+    PayloadQueue<QueuedPayload>::Stats queueStats{};
+    m_queue.GetStats(&queueStats);
+
+    ZeroMemory(stats, sizeof(PAYLOAD_SUBSCRIBER_STATS));
+
+    stats->id = m_id;
+    stats->queueDepth = m_queue.Depth();
+    stats->pending = queueStats.pending;
+    stats->maxPending = queueStats.maxPending;
+    stats->delivered = queueStats.delivered;
+    stats->dropped = queueStats.dropped;
+    stats->lastLag = queueStats.lastLag;
+    stats->maxLag = queueStats.maxLag;
+    stats->averageLag = (queueStats.delivered > 0) ? static_cast<int64_t>(queueStats.totalLag / static_cast<int64_t>(queueStats.delivered)) : 0;
+    stats->stalls = queueStats.stalls;
+}
+
+void PayloadSubscriber::Shutdown()
+{
+    DWORD workItemQueueId = MFASYNC_CALLBACK_QUEUE_UNDEFINED;
+
+    {
+        auto gurad = m_cs.Guard();
+
+        if (m_isShutdown)
+        {
+            return;
+        }
+        m_isShutdown = true;
+
+        workItemQueueId = m_workItemQueueId;
+        m_workItemQueueId = MFASYNC_CALLBACK_QUEUE_UNDEFINED;
+    }
+
+    // drops what is left and releases anyone blocked in Enqueue
+    m_queue.Shutdown();
+
+    if (workItemQueueId != MFASYNC_CALLBACK_QUEUE_UNDEFINED)
+    {
+        MFUnlockWorkQueue(workItemQueueId);
+    }
+}
+
+_Use_decl_annotations_
+HRESULT PayloadSubscriber::GetParameters(
+    DWORD *pdwFlags,
+    DWORD *pdwQueue)
+{
+    auto gurad = m_cs.Guard();
+
+    if (m_isShutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    *pdwFlags = 0;
+    *pdwQueue = m_workItemQueueId;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PayloadSubscriber::Invoke(
+    IMFAsyncResult *pAsyncResult)
+{
+    UNREFERENCED_PARAMETER(pAsyncResult);
+
+    QueuedPayload item{ nullptr, nullptr };
+    if (!m_queue.Pop(item, MFGetSystemTime()))
+    {
+        return S_OK;
+    }
+
+    try
+    {
+        m_handler(item.sender, item.payload);
+    }
+    catch (hresult_error const& ex)
+    {
+        Log(L"PayloadSubscriber::Invoke() - subscriber %u failed, hr=0x%08x\n", m_id, ex.code().value);
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,73 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "Media.PayloadHandler.g.h"
+#include "Media.PayloadQueue.h"
+
+#include <mfapi.h>
+
+// one consumer of OnStreamPayload with its own bounded queue and serial work queue,
+// so a slow handler only backs up its own queue. the queue and its policies are in
+// PayloadQueue, this posts a work item per payload and drains it on the serial queue
+struct PayloadSubscriber : winrt::implements<PayloadSubscriber, IMFAsyncCallback>
+{
+    using PayloadEventHandler = winrt::Windows::Foundation::EventHandler<winrt::CameraCapture::Media::Payload>;
+
+    static HRESULT Create(
+        _In_ uint32_t id,
+        _In_ PayloadEventHandler const& handler,
+        _In_ uint32_t queueDepth,
+        _In_ winrt::CameraCapture::Media::PayloadOverflowPolicy policy,
+        _In_ winrt::CameraCapture::Media::PayloadStreamFilter streams,
+        _Out_ winrt::com_ptr<PayloadSubscriber>& subscriber);
+
+    PayloadSubscriber(
+        _In_ uint32_t id,
+        _In_ PayloadEventHandler const& handler,
+        _In_ uint32_t queueDepth,
+        _In_ winrt::CameraCapture::Media::PayloadOverflowPolicy policy,
+        _In_ winrt::CameraCapture::Media::PayloadStreamFilter streams);
+    virtual ~PayloadSubscriber();
+
+    uint32_t Id() const { return m_id; }
+
+    // whether payloads of the stream go to this subscriber at all
+    bool Accepts(_In_ winrt::guid const& majorType) const;
+
+    HRESULT Enqueue(
+        _In_ winrt::Windows::Foundation::IInspectable const& sender,
+        _In_ winrt::CameraCapture::Media::Payload const& payload);
+
+    void GetStats(_Out_ PAYLOAD_SUBSCRIBER_STATS* stats);
+
+    void Shutdown();
+
+    // IMFAsyncCallback
+    STDMETHODIMP GetParameters(
+        __RPC__out DWORD *pdwFlags,
+        __RPC__out DWORD *pdwQueue) override;
+    STDMETHODIMP Invoke(
+        __RPC__in_opt IMFAsyncResult *pAsyncResult) override;
+
+private:
+    HRESULT Initialize();
+
+    struct QueuedPayload
+    {
+        winrt::Windows::Foundation::IInspectable sender;
+        winrt::CameraCapture::Media::Payload payload;
+    };
+
+private:
+    CriticalSection m_cs;
+    bool m_isShutdown;
+    DWORD m_workItemQueueId;
+
+    uint32_t m_id;
+    PayloadEventHandler m_handler;
+    winrt::CameraCapture::Media::PayloadStreamFilter m_streams;
+
+    PayloadQueue<QueuedPayload> m_queue;
+};
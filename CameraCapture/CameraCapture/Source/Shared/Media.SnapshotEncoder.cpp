@@ -0,0 +1,282 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.SnapshotEncoder.h"
+
+#include <mfapi.h>
+#include <mferror.h>
+
+SnapshotEncoder::SnapshotEncoder()
+    : m_cs("SnapshotEncoder")
+    , m_isShutdown(false)
+    , m_workAvailable(nullptr)
+    , m_createWriter(nullptr)
+    , m_completed(nullptr)
+{
+}
+
+SnapshotEncoder::~SnapshotEncoder()
+{
+    Shutdown();
+}
+
+_Use_decl_annotations_
+HRESULT SnapshotEncoder::Initialize(
+    uint32_t workerCount,
+    uint32_t bufferCount,
+    WriterFactory const& createWriter,
+    CompletedHandler const& completed)
+{
+    auto gurad = m_cs.Guard();
+
+    if (m_isShutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    if (!m_workers.empty())
+    {
+        return S_OK;
+    }
+
+    NULL_CHK_HR(createWriter, E_INVALIDARG);
+    NULL_CHK_HR(completed, E_INVALIDARG);
+
+    if (workerCount == 0 || bufferCount == 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    m_workAvailable.attach(CreateSemaphoreEx(nullptr, 0, MAXLONG, nullptr, 0, SEMAPHORE_ALL_ACCESS));
+    NULL_CHK_HR(m_workAvailable.get(), HRESULT_FROM_WIN32(GetLastError()));
+
+    // sized on first use, after that a buffer is only reallocated if the frame grows
+    m_buffers.resize(bufferCount);
+    m_freeBuffers.reserve(bufferCount);
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        m_freeBuffers.push_back(i);
+    }
+
+    m_createWriter = createWriter;
+    m_completed = completed;
+
+    auto strong = shared_from_this();
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back([strong]() { strong->ThreadProc(); });
+    }
+
+    return S_OK;
+}
+
+void SnapshotEncoder::Shutdown()
+{
+    std::vector<std::thread> workers;
+    {
+        auto gurad = m_cs.Guard();
+
+        if (m_isShutdown)
+        {
+            return;
+        }
+        m_isShutdown = true;
+
+        workers.swap(m_workers);
+    }
+
+    if (m_workAvailable)
+    {
+        ReleaseSemaphore(m_workAvailable.get(), static_cast<LONG>(workers.size()), nullptr);
+    }
+
+    auto currentThread = std::this_thread::get_id();
+    for (auto& worker : workers)
+    {
+        // the last reference can be dropped from a completion callback
+        if (worker.get_id() == currentThread)
+        {
+            worker.detach();
+        }
+        else
+        {
+            worker.join();
+        }
+    }
+
+    auto gurad = m_cs.Guard();
+
+    m_completed = nullptr;
+}
+
+_Use_decl_annotations_
+HRESULT SnapshotEncoder::Queue(
+    IMFSample* sample,
+    uint32_t width,
+    uint32_t height,
+    std::wstring const& path,
+    SnapshotFormat format,
+    uint32_t requestId)
+{
+    NULL_CHK_HR(sample, E_INVALIDARG);
+
+    if (path.empty() || width == 0 || height == 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    uint32_t buffer = 0;
+    {
+        auto gurad = m_cs.Guard();
+
+        if (m_isShutdown || m_workers.empty())
+        {
+            IFR(MF_E_SHUTDOWN);
+        }
+
+        if (m_freeBuffers.empty())
+        {
+            IFR(MF_E_NOTACCEPTING);
+        }
+
+        buffer = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+    }
+
+    // the buffer is owned by this call until the job is queued
+    HRESULT hr = CopyFrame(sample, width, height, m_buffers[buffer]);
+
+    auto gurad = m_cs.Guard();
+
+    if (SUCCEEDED(hr) && m_isShutdown)
+    {
+        hr = MF_E_SHUTDOWN;
+    }
+
+    if (FAILED(hr))
+    {
+        m_freeBuffers.push_back(buffer);
+
+        IFR(hr);
+    }
+
+    m_jobs.push_back(Job{ buffer, width, height, path, format, requestId });
+
+    ReleaseSemaphore(m_workAvailable.get(), 1, nullptr);
+
+    return S_OK;
+}
+
+void SnapshotEncoder::ThreadProc()
+{
+    // m_createWriter is set before the workers start and never changes
+    std::unique_ptr<SnapshotWriter> writer = m_createWriter();
+
+    for (;;)
+    {
+        WaitForSingleObject(m_workAvailable.get(), INFINITE);
+
+        Job job{};
+        CompletedHandler completed = nullptr;
+        {
+            auto gurad = m_cs.Guard();
+
+            if (m_jobs.empty())
+            {
+                if (m_isShutdown)
+                {
+                    break;
+                }
+
+                continue;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+
+            completed = m_completed;
+        }
+
+        HRESULT hr = (writer != nullptr) ? writer->Write(m_buffers[job.buffer].data(), job.width, job.height, job.path, job.format) : E_OUTOFMEMORY;
+        if (FAILED(hr))
+        {
+            Log(LogLevel::Warning, L"SnapshotEncoder: request %u failed to write %s, hr=%08X\n", job.requestId, job.path.c_str(), hr);
+        }
+
+        {
+            auto gurad = m_cs.Guard();
+
+            m_freeBuffers.push_back(job.buffer);
+        }
+
+        if (completed != nullptr)
+        {
+            completed(job.requestId, hr);
+        }
+    }
+
+    // released on the thread that created it
+    writer = nullptr;
+}
+
+_Use_decl_annotations_
+HRESULT SnapshotEncoder::CopyFrame(
+    IMFSample* sample,
+    uint32_t width,
+    uint32_t height,
+    std::vector<uint8_t>& pixels)
+{
+    uint32_t rowSize = width * 4;
+    if (pixels.size() != rowSize * height)
+    {
+        pixels.resize(rowSize * height);
+    }
+
+    winrt::com_ptr<IMFMediaBuffer> mediaBuffer = nullptr;
+    IFR(sample->GetBufferByIndex(0, mediaBuffer.put()));
+
+    // 2d buffers can be padded or bottom up, copy row by row
+    auto buffer2d = mediaBuffer.try_as<IMF2DBuffer>();
+    if (buffer2d != nullptr)
+    {
+        BYTE* scanline0 = nullptr;
+        LONG pitch = 0;
+        IFR(buffer2d->Lock2D(&scanline0, &pitch));
+
+        HRESULT hr = S_OK;
+        if (static_cast<uint32_t>(std::abs(pitch)) < rowSize)
+        {
+            hr = MF_E_INVALIDMEDIATYPE;
+        }
+        else
+        {
+            for (uint32_t row = 0; row < height; ++row)
+            {
+                memcpy(pixels.data() + row * rowSize, scanline0 + static_cast<ptrdiff_t>(row) * pitch, rowSize);
+            }
+        }
+
+        buffer2d->Unlock2D();
+
+        return hr;
+    }
+
+    BYTE* data = nullptr;
+    DWORD currentLength = 0;
+    IFR(mediaBuffer->Lock(&data, nullptr, &currentLength));
+
+    HRESULT hr = S_OK;
+    if (currentLength < pixels.size())
+    {
+        hr = MF_E_BUFFERTOOSMALL;
+    }
+    else
+    {
+        memcpy(pixels.data(), data, pixels.size());
+    }
+
+    mediaBuffer->Unlock();
+
+    return hr;
+}
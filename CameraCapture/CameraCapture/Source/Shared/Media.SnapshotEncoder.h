@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <mfidl.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// the encode step, each worker creates its own on its own thread and destroys it there,
+// so it can hold thread affine state like a com apartment
+struct SnapshotWriter
+{
+    virtual ~SnapshotWriter() = default;
+
+    // pixels are width * height bgra, rows packed
+    virtual HRESULT Write(
+        _In_reads_bytes_(width * height * 4) uint8_t const* pixels,
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _In_ std::wstring const& path,
+        _In_ SnapshotFormat format) = 0;
+};
+
+// encodes bgra frames on a small pool of worker threads, the frame is copied into a
+// pooled buffer so the capture thread never waits on the disk
+struct SnapshotEncoder : std::enable_shared_from_this<SnapshotEncoder>
+{
+    typedef std::function<std::unique_ptr<SnapshotWriter>()> WriterFactory;
+    typedef std::function<void(uint32_t requestId, HRESULT hr)> CompletedHandler;
+
+    SnapshotEncoder();
+    ~SnapshotEncoder();
+
+    HRESULT Initialize(
+        _In_ uint32_t workerCount,
+        _In_ uint32_t bufferCount,
+        _In_ WriterFactory const& createWriter,
+        _In_ CompletedHandler const& completed);
+
+    // queued jobs are still written before the workers exit
+    void Shutdown();
+
+    // fails with MF_E_NOTACCEPTING when every buffer is in use
+    HRESULT Queue(
+        _In_ IMFSample* sample,
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _In_ std::wstring const& path,
+        _In_ SnapshotFormat format,
+        _In_ uint32_t requestId);
+
+private:
+    struct Job
+    {
+        uint32_t buffer;
+        uint32_t width;
+        uint32_t height;
+        std::wstring path;
+        SnapshotFormat format;
+        uint32_t requestId;
+    };
+
+    void ThreadProc();
+
+    static HRESULT CopyFrame(
+        _In_ IMFSample* sample,
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _Inout_ std::vector<uint8_t>& pixels);
+
+private:
+    CriticalSection m_cs;
+
+    bool m_isShutdown;
+    winrt::handle m_workAvailable;
+    std::vector<std::thread> m_workers;
+    WriterFactory m_createWriter;
+    CompletedHandler m_completed;
+
+    std::deque<Job> m_jobs;
+    std::vector<std::vector<uint8_t>> m_buffers;
+    std::vector<uint32_t> m_freeBuffers;
+};
@@ -0,0 +1,112 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Media.SnapshotWriter.h"
+
+#pragma comment(lib, "windowscodecs")
+
+static constexpr float c_jpegQuality = 0.9f;
+
+std::unique_ptr<SnapshotWriter> WicSnapshotWriter::Create()
+{
+    return std::make_unique<WicSnapshotWriter>();
+}
+
+// runs on the worker, the factory belongs to that thread's apartment
+WicSnapshotWriter::WicSnapshotWriter()
+    : m_comInitialized(SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+    , m_factoryResult(S_OK)
+    , m_factory(nullptr)
+{
+    m_factoryResult = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(m_factory.put()));
+}
+
+WicSnapshotWriter::~WicSnapshotWriter()
+{
+    m_factory = nullptr;
+
+    if (m_comInitialized)
+    {
+        CoUninitialize();
+    }
+}
+
+_Use_decl_annotations_
+HRESULT WicSnapshotWriter::Write(
+    uint8_t const* pixels,
+    uint32_t width,
+    uint32_t height,
+    std::wstring const& path,
+    SnapshotFormat format)
+{
+    IFR(m_factoryResult);
+
+    UINT stride = width * 4;
+
+    winrt::com_ptr<IWICBitmap> bitmap = nullptr;
+    IFR(m_factory->CreateBitmapFromMemory(
+        width,
+        height,
+        GUID_WICPixelFormat32bppBGR, // camera alpha is undefined, ignore it
+        stride,
+        stride * height,
+        const_cast<BYTE*>(pixels),
+        bitmap.put()));
+
+    // write next to the target and rename, so a reader never sees a partial file
+    std::wstring tempPath = path + L".tmp";
+
+    HRESULT hr = S_OK;
+    {
+        winrt::com_ptr<IWICStream> stream = nullptr;
+        IFG(m_factory->CreateStream(stream.put()), done);
+        IFG(stream->InitializeFromFilename(tempPath.c_str(), GENERIC_WRITE), done);
+
+        winrt::com_ptr<IWICBitmapEncoder> encoder = nullptr;
+        IFG(m_factory->CreateEncoder(format == SnapshotFormat::Png ? GUID_ContainerFormatPng : GUID_ContainerFormatJpeg, nullptr, encoder.put()), done);
+        IFG(encoder->Initialize(stream.get(), WICBitmapEncoderNoCache), done);
+
+        winrt::com_ptr<IWICBitmapFrameEncode> frame = nullptr;
+        winrt::com_ptr<IPropertyBag2> properties = nullptr;
+        IFG(encoder->CreateNewFrame(frame.put(), properties.put()), done);
+
+        if (format == SnapshotFormat::Jpeg && properties != nullptr)
+        {
+            PROPBAG2 option{};
+            option.pstrName = const_cast<LPOLESTR>(L"ImageQuality");
+
+            VARIANT value;
+            VariantInit(&value);
+            value.vt = VT_R4;
+            value.fltVal = c_jpegQuality;
+
+            IFG(properties->Write(1, &option, &value), done);
+        }
+
+        IFG(frame->Initialize(properties.get()), done);
+        IFG(frame->SetSize(width, height), done);
+
+        // WriteSource converts to whatever the encoder settles on
+        WICPixelFormatGUID pixelFormat = GUID_WICPixelFormat24bppBGR;
+        IFG(frame->SetPixelFormat(&pixelFormat), done);
+        IFG(frame->WriteSource(bitmap.get(), nullptr), done);
+        IFG(frame->Commit(), done);
+        IFG(encoder->Commit(), done);
+        IFG(stream->Commit(STGC_DEFAULT), done);
+    }
+
+    // the stream has to be closed before the rename
+    if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        hr = HRESULT_FROM_WIN32(GetLastError());
+    }
+
+done:
+    if (FAILED(hr))
+    {
+        DeleteFileW(tempPath.c_str());
+    }
+
+    return hr;
+}
@@ -0,0 +1,29 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "Media.SnapshotEncoder.h"
+
+#include <wincodec.h>
+
+// the SnapshotEncoder worker's encode step through WIC, jpeg or png
+struct WicSnapshotWriter : SnapshotWriter
+{
+    static std::unique_ptr<SnapshotWriter> Create();
+
+    WicSnapshotWriter();
+    ~WicSnapshotWriter();
+
+    HRESULT Write(
+        _In_reads_bytes_(width * height * 4) uint8_t const* pixels,
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _In_ std::wstring const& path,
+        _In_ SnapshotFormat format) override;
+
+private:
+    bool m_comInitialized;
+    HRESULT m_factoryResult;
+    winrt::com_ptr<IWICImagingFactory> m_factory;
+};
@@ -9,6 +9,7 @@
 #include "Media.Payload.h"
 #include "Media.Capture.MrcAudioEffect.h"
 #include "Media.Capture.MrcVideoEffect.h"
+#include "Media.SnapshotWriter.h"
 
 #include <mferror.h>
 #include <mfmediacapture.h>
@@ -25,6 +26,20 @@ using namespace Windows::Media::Core;
 using namespace Windows::Media::Capture;
 using namespace Windows::Media::MediaProperties;
 
+// preview only needs the newest frames, older ones are dropped rather than queued
+static constexpr uint32_t c_previewQueueDepth = 4;
+
+// audio has its own subscriber so frames never push it out, the meter and the audio
+// frame callback need all of it. a couple of seconds of buffers before any is dropped
+static constexpr uint32_t c_audioQueueDepth = 256;
+
+// what the profile selection asked for before the range could be set
+static constexpr FrameRateRange c_defaultFrameRateRange = { 30.0, 30.0 };
+
+// encoding is disk bound, a couple of workers keep up with a burst of snapshots
+static constexpr uint32_t c_snapshotWorkers = 2;
+static constexpr uint32_t c_snapshotBuffers = 4;
+
 _Use_decl_annotations_
 CameraCapture::Plugin::Module CaptureEngine::Create(
     std::weak_ptr<IUnityDeviceResource> const& unityDevice,
@@ -42,7 +57,8 @@ CameraCapture::Plugin::Module CaptureEngine::Create(
 
 
 CaptureEngine::CaptureEngine()
-    : m_isShutdown(false)
+    : m_cs("CaptureEngine")
+    , m_isShutdown(false)
     , m_startPreviewEventHandle(CreateEvent(nullptr, true, true, nullptr))
     , m_stopPreviewEventHandle(CreateEvent(nullptr, true, true, nullptr))
     , m_takePhotoEventHandle(CreateEvent(nullptr, true, true, nullptr))
@@ -56,11 +72,18 @@ CaptureEngine::CaptureEngine()
     , m_stopPreviewOp(nullptr)
     , m_mediaCapture(nullptr)
     , m_initSettings(nullptr)
+    , m_frameRateRange(c_defaultFrameRateRange)
     , m_mrcAudioEffect(nullptr)
     , m_mrcVideoEffect(nullptr)
     , m_mrcPreviewEffect(nullptr)
     , m_mediaSink(nullptr)
     , m_payloadHandler(nullptr)
+    , m_videoSubscriberId(0)
+    , m_audioSubscriberId(0)
+    , m_audioFramesEnabled(false)
+    , m_metrics(new MetricsRegistry())
+    , m_snapshotEncoder(std::make_shared<SnapshotEncoder>())
+    , m_nextSnapshotId(0)
     , m_audioSample(nullptr)
     , m_sharedVideoTexture(nullptr)
     , m_photoTexture(nullptr)
@@ -120,6 +143,21 @@ void CaptureEngine::Shutdown()
         m_mediaSink = nullptr;
     }
 
+    // anything that never saw a frame is failed, queued files are still written
+    std::deque<SnapshotRequest> snapshotRequests;
+    {
+        auto guard = m_cs.Guard();
+
+        snapshotRequests.swap(m_snapshotRequests);
+    }
+
+    for (auto const& request : snapshotRequests)
+    {
+        SnapshotCompleted(request.requestId, MF_E_SHUTDOWN);
+    }
+
+    m_snapshotEncoder->Shutdown();
+
     ReleaseDeviceResources();
 
     Module::Shutdown();
@@ -159,6 +197,8 @@ hresult CaptureEngine::StartPreview(uint32_t width, uint32_t height, bool enable
         m_sharedVideoTexture = nullptr;
     }
 
+    m_audioMeter.Reset();
+
     m_startPreviewOp = StartPreviewCoroutine(width, height, enableAudio, enableMrc);
     m_startPreviewOp.Completed([this, strong = get_strong()](auto const& result, auto const& status)
     {
@@ -308,6 +348,13 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
 {
     auto strong = get_strong();
 
+    RemovePayloadSubscribers();
+
+    if (m_payloadHandler != nullptr)
+    {
+        get_self<Media::implementation::PayloadHandler>(m_payloadHandler)->Metrics(nullptr);
+    }
+
     m_payloadHandler = value;
 
     if (m_mediaSink != nullptr)
@@ -315,7 +362,13 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
         m_mediaSink.PayloadHandler(m_payloadHandler);
     }
 
-    m_payloadEventRevoker = m_payloadHandler.OnStreamPayload(winrt::auto_revoke, [this, strong](auto const sender, Media::Payload const& payload)
+    NULL_CHK_R(m_payloadHandler);
+
+    get_self<Media::implementation::PayloadHandler>(m_payloadHandler)->Metrics(m_metrics);
+
+    // video and audio each get a subscriber and a queue of their own, so a slow consumer
+    // elsewhere does not hold up the preview, and frames never push out audio
+    auto handler = Windows::Foundation::EventHandler<Media::Payload>([this, strong](auto const sender, Media::Payload const& payload)
         {
             auto guard = m_cs.Guard();
 
@@ -354,6 +407,21 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
 
             if (MFMediaType_Audio == majorType)
             {
+                auto audioProps = payload.EncodingProperties().try_as<IAudioEncodingProperties>();
+                if (audioProps != nullptr)
+                {
+                    bool isFloat = _wcsicmp(audioProps.Subtype().c_str(), MediaEncodingSubtypes::Float().c_str()) == 0;
+                    if (SUCCEEDED(m_audioMeter.Configure(audioProps.ChannelCount(), audioProps.SampleRate(), audioProps.BitsPerSample(), isFloat)))
+                    {
+                        m_audioMeter.Process(streamSample->Sample().get());
+                    }
+                }
+
+                if (!m_audioFramesEnabled)
+                {
+                    return;
+                }
+
                 if (m_audioSample == nullptr)
                 {
                     DWORD bufferSize = 0;
@@ -370,7 +438,12 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
                     m_audioSample.attach(dstSample.detach());
                 }
 
-                IFV(CopySample(MFMediaType_Audio, streamSample->Sample(), m_audioSample));
+                if (FAILED(CopySample(MFMediaType_Audio, streamSample->Sample(), m_audioSample)))
+                {
+                    m_metrics->Increment(MetricCounter::CopyFailures);
+
+                    return;
+                }
 
                 CALLBACK_STATE state{};
                 ZeroMemory(&state, sizeof(CALLBACK_STATE));
@@ -384,6 +457,8 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
                 //state.value.captureState.height = 0;
                 //state.value.captureState.texturePtr = nullptr;
                 Callback(state);
+
+                m_metrics->Increment(MetricCounter::AudioFramesDelivered);
             }
             else if (MFMediaType_Video == majorType)
             {
@@ -407,11 +482,24 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
 
                     IFV(SharedTexture::Create(resources->GetDevice(), m_dxgiDeviceManager, videoProps.Width(), videoProps.Height(), m_sharedVideoTexture));
 
+                    m_metrics->Increment(MetricCounter::TextureReallocations);
+                    m_metrics->Set(MetricGauge::VideoWidth, videoProps.Width());
+                    m_metrics->Set(MetricGauge::VideoHeight, videoProps.Height());
+
                     bufferChanged = true;
                 }
 
+                QueueSnapshots(streamSample->Sample().get(), videoProps.Width(), videoProps.Height(), _wcsicmp(videoProps.Subtype().c_str(), MediaEncodingSubtypes::Bgra8().c_str()) == 0);
+
                 // copy the data
-                IFV(CopySample(MFMediaType_Video, streamSample->Sample(), m_sharedVideoTexture->mediaSample));
+                int64_t copyStart = MetricsRegistry::Now();
+                if (FAILED(CopySample(MFMediaType_Video, streamSample->Sample(), m_sharedVideoTexture->mediaSample)))
+                {
+                    m_metrics->Increment(MetricCounter::CopyFailures);
+
+                    return;
+                }
+                m_metrics->RecordElapsed(MetricHistogram::VideoCopyTime, copyStart);
 
                 // did the texture description change, if so, raise callback
                 CALLBACK_STATE state{};
@@ -425,6 +513,7 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
                 state.value.captureState.width = m_sharedVideoTexture->frameTextureDesc.Width;
                 state.value.captureState.height = m_sharedVideoTexture->frameTextureDesc.Height;
                 state.value.captureState.texturePtr = m_sharedVideoTexture->frameTextureSRV.get();
+                state.value.captureState.frameSequence = streamSample->FrameSequence();
                 if (m_payloadHandler.ProceesTranform(payload))
                 {
                     state.value.captureState.worldMatrix = payload.CameraToWorld();
@@ -437,8 +526,174 @@ void CaptureEngine::PayloadHandler(CameraCapture::Media::PayloadHandler const& v
                 {
                     Callback(state);
                 }
+
+                m_metrics->Increment(MetricCounter::VideoFramesDelivered);
             }
         });
+
+    m_videoSubscriberId = m_payloadHandler.AddPayloadSubscriber(handler, c_previewQueueDepth, Media::PayloadOverflowPolicy::DropOldest, Media::PayloadStreamFilter::Video);
+    m_audioSubscriberId = m_payloadHandler.AddPayloadSubscriber(handler, c_audioQueueDepth, Media::PayloadOverflowPolicy::DropOldest, Media::PayloadStreamFilter::Audio);
+}
+
+void CaptureEngine::RemovePayloadSubscribers()
+{
+    if (m_payloadHandler != nullptr)
+    {
+        for (auto id : { m_videoSubscriberId, m_audioSubscriberId })
+        {
+            if (id != 0)
+            {
+                m_payloadHandler.RemovePayloadSubscriber(id);
+            }
+        }
+    }
+
+    m_videoSubscriberId = 0;
+    m_audioSubscriberId = 0;
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::GetAudioLevels(AUDIO_LEVEL_STATE* state)
+{
+    NULL_CHK_HR(state, E_INVALIDARG);
+
+    m_audioMeter.GetLevels(state);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::SetVoiceActivityParameters(float thresholdDb, uint32_t hangoverMs)
+{
+    m_audioMeter.SetVoiceActivityParameters(thresholdDb, hangoverMs);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::EnableAudioFrames(boolean enable)
+{
+    m_audioFramesEnabled = enable;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::GetMetrics(char* buffer, uint32_t* size)
+{
+    return m_metrics->Snapshot(buffer, size);
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::GetFrameMetadata(uint32_t firstSequence, FRAME_METADATA* records, uint32_t* count)
+{
+    NULL_CHK_HR(count, E_INVALIDARG);
+
+    Media::Capture::Sink mediaSink = nullptr;
+    {
+        auto guard = m_cs.Guard();
+
+        mediaSink = m_mediaSink;
+    }
+
+    if (mediaSink == nullptr)
+    {
+        *count = 0;
+
+        return S_OK;
+    }
+
+    return get_self<Media::Capture::implementation::Sink>(mediaSink)->GetFrameMetadata(firstSequence, records, count);
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::SaveSnapshot(LPCWSTR path, SnapshotFormat format, uint32_t* requestId)
+{
+    NULL_CHK_HR(path, E_INVALIDARG);
+    NULL_CHK_HR(requestId, E_INVALIDARG);
+
+    if (format != SnapshotFormat::Jpeg && format != SnapshotFormat::Png)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    if (m_isShutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    auto weak = get_weak();
+    IFR(m_snapshotEncoder->Initialize(c_snapshotWorkers, c_snapshotBuffers, WicSnapshotWriter::Create, [weak](uint32_t id, HRESULT hr)
+        {
+            auto strong = weak.get();
+            if (strong != nullptr)
+            {
+                strong->SnapshotCompleted(id, hr);
+            }
+        }));
+
+    auto guard = m_cs.Guard();
+
+    if (m_mediaCapture == nullptr)
+    {
+        IFR(E_NOT_VALID_STATE);
+    }
+
+    // never more outstanding than there are buffers to hold them
+    if (m_snapshotRequests.size() >= c_snapshotBuffers)
+    {
+        IFR(MF_E_NOTACCEPTING);
+    }
+
+    // 0 is left for "no request"
+    if (++m_nextSnapshotId == 0)
+    {
+        ++m_nextSnapshotId;
+    }
+
+    m_snapshotRequests.push_back(SnapshotRequest{ path, format, m_nextSnapshotId });
+
+    *requestId = m_nextSnapshotId;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::SetFrameRateRange(float minFps, float maxFps)
+{
+    if (minFps < 0.0f || maxFps < 0.0f || (maxFps > 0.0f && minFps > maxFps))
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    auto guard = m_cs.Guard();
+
+    // applied when the next preview picks its format
+    m_frameRateRange = FrameRateRange{ minFps, maxFps };
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+hresult CaptureEngine::GetFrameRate(FRAME_RATE_STATE* state)
+{
+    NULL_CHK_HR(state, E_INVALIDARG);
+
+    ZeroMemory(state, sizeof(FRAME_RATE_STATE));
+
+    Media::Capture::Sink mediaSink = nullptr;
+    {
+        auto guard = m_cs.Guard();
+
+        mediaSink = m_mediaSink;
+    }
+
+    if (mediaSink != nullptr)
+    {
+        get_self<Media::Capture::implementation::Sink>(mediaSink)->GetFrameRate(state);
+    }
+
+    return S_OK;
 }
 
 CameraCapture::Media::Capture::Sink CaptureEngine::MediaSink()
@@ -563,7 +818,7 @@ IAsyncAction CaptureEngine::StartPreviewCoroutine(
     // override video controller media stream properties
     if (m_initSettings.SharingMode() == MediaCaptureSharingMode::ExclusiveControl)
     {
-        auto videoEncProps = GetVideoDeviceProperties(videoController, m_streamType, width, height, MediaEncodingSubtypes::Nv12());
+        auto videoEncProps = GetVideoDeviceProperties(videoController, m_streamType, width, height, MediaEncodingSubtypes::Nv12(), m_frameRateRange);
         co_await videoController.SetMediaStreamPropertiesAsync(m_streamType, videoEncProps);
 
         auto captureSettings = m_mediaCapture.MediaCaptureSettings();
@@ -573,7 +828,7 @@ IAsyncAction CaptureEngine::StartPreviewCoroutine(
             &&
             captureSettings.VideoDeviceCharacteristic() != VideoDeviceCharacteristic::PreviewRecordStreamsIdentical)
         {
-            videoEncProps = GetVideoDeviceProperties(videoController, MediaStreamType::VideoRecord, width, height, MediaEncodingSubtypes::Nv12());
+            videoEncProps = GetVideoDeviceProperties(videoController, MediaStreamType::VideoRecord, width, height, MediaEncodingSubtypes::Nv12(), m_frameRateRange);
             co_await videoController.SetMediaStreamPropertiesAsync(MediaStreamType::VideoRecord, videoEncProps);
         }
     }
@@ -608,6 +863,10 @@ IAsyncAction CaptureEngine::StartPreviewCoroutine(
     {
         encodingProfile.Video().Width(videoMediaProperty.Width());
         encodingProfile.Video().Height(videoMediaProperty.Height());
+
+        // the sink measures delivery against this
+        encodingProfile.Video().FrameRate().Numerator(videoMediaProperty.FrameRate().Numerator());
+        encodingProfile.Video().FrameRate().Denominator(videoMediaProperty.FrameRate().Denominator());
         if (m_streamType == MediaStreamType::VideoPreview) // for local playback only
         {
             encodingProfile.Video().Subtype(MediaEncodingSubtypes::Bgra8());
@@ -616,6 +875,30 @@ IAsyncAction CaptureEngine::StartPreviewCoroutine(
 
     // media sink
     auto mediaSink = CameraCapture::Media::Capture::Sink(encodingProfile);
+    get_self<Media::Capture::implementation::Sink>(mediaSink)->Metrics(m_metrics);
+
+    auto weak = get_weak();
+    get_self<Media::Capture::implementation::Sink>(mediaSink)->FrameRateHandler([weak](FRAME_RATE_STATE const& frameRate)
+        {
+            auto strong = weak.get();
+            if (strong == nullptr)
+            {
+                return;
+            }
+
+            if (frameRate.belowNegotiated)
+            {
+                Log(LogLevel::Warning, L"video delivery at %.2f fps, negotiated %.2f fps\n", frameRate.measuredFps, frameRate.negotiatedFps);
+            }
+
+            CALLBACK_STATE state{};
+            ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+            state.type = CallbackType::FrameRate;
+            state.value.frameRateState = frameRate;
+
+            strong->Callback(state);
+        });
 
     // create mrc effects first
     if (enableMrc)
@@ -653,7 +936,7 @@ IAsyncAction CaptureEngine::StopPreviewCoroutine()
 
     auto guard = m_cs.Guard();
 
-    m_payloadEventRevoker.revoke();
+    RemovePayloadSubscribers();
 
     m_payloadHandler = nullptr;
 
@@ -763,7 +1046,7 @@ IAsyncAction CaptureEngine::TakePhotoCoroutine(
     if (m_initSettings.SharingMode() == MediaCaptureSharingMode::ExclusiveControl)
     {
         // find the closest resolution
-        auto videoEncProps = GetVideoDeviceProperties(videoController, MediaStreamType::Photo, width, height, MediaEncodingSubtypes::Nv12());
+        auto videoEncProps = GetVideoDeviceProperties(videoController, MediaStreamType::Photo, width, height, MediaEncodingSubtypes::Nv12(), FrameRateRange{ 0.0, 0.0 });
         co_await videoController.SetMediaStreamPropertiesAsync(MediaStreamType::Photo, videoEncProps);
     }
 
@@ -867,58 +1150,47 @@ IAsyncAction CaptureEngine::CreateMediaCaptureAsync(
     {
         initSettings.SharingMode(MediaCaptureSharingMode::SharedReadOnly);
 
-        setlocale(LC_ALL, "");
-
-        // set the profile / mediaDescription that matches
-        MediaCaptureVideoProfile videoProfile = nullptr;
-        MediaCaptureVideoProfileMediaDescription videoProfileMediaDescription = nullptr;
+        // gather every profile / mediaDescription, then pick the best size and rate once
+        std::vector<MediaCaptureVideoProfile> candidateProfiles;
+        std::vector<MediaCaptureVideoProfileMediaDescription> descriptions;
+        std::vector<VideoFormatCandidate> candidates;
         auto profiles = MediaCapture::FindKnownVideoProfiles(videoDevice.Id(), m_videoProfile);
         for (auto const& profile : profiles)
         {
             auto const& videoProfileMediaDescriptions = m_streamType == (MediaStreamType::VideoPreview) ? profile.SupportedPreviewMediaDescription() : profile.SupportedRecordMediaDescription();
-            auto const& found = std::find_if(begin(videoProfileMediaDescriptions), end(videoProfileMediaDescriptions), [&](MediaCaptureVideoProfileMediaDescription const& desc)
-                {
-                    Log(L"\tFormat: %s: %i x %i @ %f fps",
-                        desc.Subtype().c_str(),
-                        desc.Width(),
-                        desc.Height(),
-                        desc.FrameRate());
-
-                    // store a default
-                    if (videoProfile == nullptr)
-                    {
-                        videoProfile = profile;
-                    }
-
-                    if (videoProfileMediaDescription == nullptr)
-                    {
-                        videoProfileMediaDescription = desc;
-                    }
-
-                    // select a size that will be == width/height @ 30fps, final size will be set with enc props
-                    bool match =
-                        _wcsicmp(desc.Subtype().c_str(), MediaEncodingSubtypes::Nv12().c_str()) == 0 &&
-                        desc.Width() == width &&
-                        desc.Height() == height &&
-                        desc.FrameRate() == 30.0;
-                    if (match)
-                    {
-                        Log(L" - found\n");
-                    }
-                    else
-                    {
-                        Log(L"\n");
-                    }
+            for (auto const& desc : videoProfileMediaDescriptions)
+            {
+                Log(L"\tFormat: %s: %i x %i @ %f fps\n",
+                    desc.Subtype().c_str(),
+                    desc.Width(),
+                    desc.Height(),
+                    desc.FrameRate());
+
+                candidateProfiles.push_back(profile);
+                descriptions.push_back(desc);
+                candidates.push_back(VideoFormatCandidate{ desc.Width(), desc.Height(), desc.FrameRate(), _wcsicmp(desc.Subtype().c_str(), MediaEncodingSubtypes::Nv12().c_str()) == 0 });
+            }
+        }
 
-                    return match;
-                });
+        // final size will be set with enc props, otherwise default to the first description
+        MediaCaptureVideoProfile videoProfile = nullptr;
+        MediaCaptureVideoProfileMediaDescription videoProfileMediaDescription = nullptr;
+        if (!candidates.empty())
+        {
+            int32_t selected = SelectVideoFormat(candidates, width, height, m_frameRateRange);
+            if (selected < 0)
+            {
+                Log(LogLevel::Warning, L"no %i x %i profile, using the first available\n", width, height);
 
-            if (found != end(videoProfileMediaDescriptions))
+                selected = 0;
+            }
+            else
             {
-                videoProfile = profile;
-                videoProfileMediaDescription = *found;
-                break;
+                Log(LogLevel::Info, L"selected profile %u x %u @ %.2f fps\n", candidates[selected].width, candidates[selected].height, candidates[selected].fps);
             }
+
+            videoProfile = candidateProfiles[selected];
+            videoProfileMediaDescription = descriptions[selected];
         }
 
         initSettings.VideoProfile(videoProfile);
@@ -1043,6 +1315,38 @@ IAsyncAction CaptureEngine::RemoveMrcEffectsAsync()
     }
 }
 
+_Use_decl_annotations_
+void CaptureEngine::QueueSnapshots(IMFSample* sample, uint32_t width, uint32_t height, bool isBgra)
+{
+    // called from the preview handler with m_cs held
+    while (!m_snapshotRequests.empty())
+    {
+        auto request = std::move(m_snapshotRequests.front());
+        m_snapshotRequests.pop_front();
+
+        HRESULT hr = isBgra ? m_snapshotEncoder->Queue(sample, width, height, request.path, request.format, request.requestId) : MF_E_INVALIDMEDIATYPE;
+        if (FAILED(hr))
+        {
+            SnapshotCompleted(request.requestId, hr);
+        }
+    }
+}
+
+_Use_decl_annotations_
+void CaptureEngine::SnapshotCompleted(uint32_t requestId, HRESULT hr)
+{
+    CALLBACK_STATE state{};
+    ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+    state.type = CallbackType::Snapshot;
+
+    ZeroMemory(&state.value.snapshotState, sizeof(SNAPSHOT_STATE));
+    state.value.snapshotState.requestId = requestId;
+    state.value.snapshotState.hresult = hr;
+
+    Callback(state);
+}
+
 hresult CaptureEngine::CreatePhotoTexture(uint32_t width, uint32_t height)
 {
     auto resources = m_d3d11DeviceResources.lock();
@@ -9,14 +9,28 @@
 #include "Media.SharedTexture.h"
 #include "Media.Capture.Sink.h"
 #include "Media.Transform.h"
+#include "Media.AudioMeter.h"
+#include "Media.SnapshotEncoder.h"
 
 #include <mfapi.h>
 #include <winrt/windows.media.h>
 #include <winrt/Windows.Media.Capture.h>
 
+struct __declspec(uuid("18ae4b1b-a20a-4305-9327-ad86d1f76eb2")) ICaptureEnginePriv : ::IUnknown
+{
+    virtual winrt::hresult __stdcall GetAudioLevels(_Out_ AUDIO_LEVEL_STATE* state) = 0;
+    virtual winrt::hresult __stdcall SetVoiceActivityParameters(_In_ float thresholdDb, _In_ uint32_t hangoverMs) = 0;
+    virtual winrt::hresult __stdcall EnableAudioFrames(_In_ boolean enable) = 0;
+    virtual winrt::hresult __stdcall GetMetrics(_Out_writes_opt_(*size) char* buffer, _Inout_ uint32_t* size) = 0;
+    virtual winrt::hresult __stdcall GetFrameMetadata(_In_ uint32_t firstSequence, _Out_writes_opt_(*count) FRAME_METADATA* records, _Inout_ uint32_t* count) = 0;
+    virtual winrt::hresult __stdcall SaveSnapshot(_In_ LPCWSTR path, _In_ SnapshotFormat format, _Out_ uint32_t* requestId) = 0;
+    virtual winrt::hresult __stdcall SetFrameRateRange(_In_ float minFps, _In_ float maxFps) = 0;
+    virtual winrt::hresult __stdcall GetFrameRate(_Out_ FRAME_RATE_STATE* state) = 0;
+};
+
 namespace winrt::CameraCapture::Plugin::implementation
 {
-    struct CaptureEngine : CaptureEngineT<CaptureEngine, Module>
+    struct CaptureEngine : CaptureEngineT<CaptureEngine, Module, ICaptureEnginePriv>
     {
         static Plugin::Module Create(
             _In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice,
@@ -37,6 +51,15 @@ namespace winrt::CameraCapture::Plugin::implementation
         CameraCapture::Media::PayloadHandler PayloadHandler();
         void PayloadHandler(CameraCapture::Media::PayloadHandler const& value);
 
+        // ICaptureEnginePriv
+        virtual hresult __stdcall GetAudioLevels(_Out_ AUDIO_LEVEL_STATE* state) override;
+        virtual hresult __stdcall SetVoiceActivityParameters(_In_ float thresholdDb, _In_ uint32_t hangoverMs) override;
+        virtual hresult __stdcall EnableAudioFrames(_In_ boolean enable) override;
+        virtual hresult __stdcall GetMetrics(_Out_writes_opt_(*size) char* buffer, _Inout_ uint32_t* size) override;
+        virtual hresult __stdcall GetFrameMetadata(_In_ uint32_t firstSequence, _Out_writes_opt_(*count) FRAME_METADATA* records, _Inout_ uint32_t* count) override;
+        virtual hresult __stdcall SaveSnapshot(_In_ LPCWSTR path, _In_ SnapshotFormat format, _Out_ uint32_t* requestId) override;
+        virtual hresult __stdcall SetFrameRateRange(_In_ float minFps, _In_ float maxFps) override;
+        virtual hresult __stdcall GetFrameRate(_Out_ FRAME_RATE_STATE* state) override;
 
     private:
         hresult CreateDeviceResources();
@@ -54,6 +77,11 @@ namespace winrt::CameraCapture::Plugin::implementation
 
         hresult CreatePhotoTexture(uint32_t width, uint32_t height);
 
+        void RemovePayloadSubscribers();
+
+        void QueueSnapshots(_In_ IMFSample* sample, _In_ uint32_t width, _In_ uint32_t height, _In_ bool isBgra);
+        void SnapshotCompleted(_In_ uint32_t requestId, _In_ HRESULT hr);
+
     private:
         CriticalSection m_cs;
 
@@ -77,6 +105,7 @@ namespace winrt::CameraCapture::Plugin::implementation
         Windows::Media::Capture::MediaCaptureSharingMode m_sharingMode;
         Windows::Media::Capture::MediaCapture m_mediaCapture;
         Windows::Media::Capture::MediaCaptureInitializationSettings m_initSettings;
+        FrameRateRange m_frameRateRange;
 
         Windows::Media::IMediaExtension m_mrcAudioEffect;
         Windows::Media::IMediaExtension m_mrcVideoEffect;
@@ -86,7 +115,26 @@ namespace winrt::CameraCapture::Plugin::implementation
         Media::Capture::Sink m_mediaSink;
 
         Media::PayloadHandler m_payloadHandler;
-        Media::PayloadHandler::OnStreamPayload_revoker m_payloadEventRevoker;
+        uint32_t m_videoSubscriberId;
+        uint32_t m_audioSubscriberId;
+
+        // audio levels, raw frames are only copied out when asked for
+        AudioMeter m_audioMeter;
+        std::atomic<boolean> m_audioFramesEnabled;
+
+        // shared with the sink and payload handler, lives as long as the engine
+        std::shared_ptr<MetricsRegistry> m_metrics;
+
+        // snapshots are taken from the next preview frame and written off thread
+        struct SnapshotRequest
+        {
+            std::wstring path;
+            SnapshotFormat format;
+            uint32_t requestId;
+        };
+        std::shared_ptr<SnapshotEncoder> m_snapshotEncoder;
+        std::deque<SnapshotRequest> m_snapshotRequests;
+        uint32_t m_nextSnapshotId;
 
         // buffers
         com_ptr<IMFSample> m_audioSample;
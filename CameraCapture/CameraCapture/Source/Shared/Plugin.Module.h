@@ -17,7 +17,12 @@ namespace winrt::CameraCapture::Plugin::implementation
 {
     struct Module : ModuleT<Module, IModulePriv>
     {
-        Module() = default;
+        Module()
+            : m_cs("Module")
+            , m_pClientObject(nullptr)
+            , m_stateCallbacks(nullptr)
+        {
+        }
 
         virtual void Shutdown();
         virtual void OnRenderEvent(uint16_t frameNumber);
@@ -63,8 +63,13 @@ struct CustomBuffer : winrt::implements<CustomBuffer, winrt::Windows::Storage::S
     }
 };
 
+// define to build locks that record contention, wait and hold times per lock name,
+// see CaptureGetLockReport, normal builds compile to a plain critical section
+//#define CRITICAL_SECTION_PROFILING
 
-struct CriticalSection
+#include "LockProfiler.h"
+
+struct PlainCriticalSection
 {
     struct CriticalSectionGuard
     {
@@ -86,12 +91,14 @@ struct CriticalSection
         CRITICAL_SECTION& m_criticalSection;
     };
 
-    CriticalSection()
+    PlainCriticalSection(_In_opt_z_ char const* name = nullptr)
     {
+        UNREFERENCED_PARAMETER(name);
+
         InitializeCriticalSection(&m_cs);
     }
 
-    ~CriticalSection()
+    ~PlainCriticalSection()
     {
         DeleteCriticalSection(&m_cs);
     }
@@ -102,21 +109,77 @@ private:
     CRITICAL_SECTION m_cs;
 };
 
-inline void __stdcall Log(
-    _In_ _Printf_format_string_ STRSAFE_LPCWSTR pszFormat,
-    ...)
+// both are always built, the tests measure what the profiling costs against the plain one
+struct ProfiledCriticalSection
 {
-    wchar_t szTextBuf[2048];
+    struct CriticalSectionGuard
+    {
+        CriticalSectionGuard(ProfiledCriticalSection& criticalSection, void* callSite)
+            : m_criticalSection(criticalSection)
+            , m_callSite(callSite)
+        {
+            if (!::TryEnterCriticalSection(&m_criticalSection.m_cs))
+            {
+                void* owner = m_criticalSection.m_owner.load(std::memory_order_relaxed);
+
+                int64_t start = LockProfiler::Now();
+                ::EnterCriticalSection(&m_criticalSection.m_cs);
+                m_criticalSection.m_stats->RecordWait(LockProfiler::Now() - start, m_callSite, owner);
+            }
+
+            // restored on release so a recursive acquire does not lose the outer owner
+            m_previousOwner = m_criticalSection.m_owner.exchange(m_callSite, std::memory_order_relaxed);
+            m_acquired = LockProfiler::Now();
+        }
+
+        ~CriticalSectionGuard()
+        {
+            int64_t held = LockProfiler::Now() - m_acquired;
+
+            m_criticalSection.m_owner.store(m_previousOwner, std::memory_order_relaxed);
+            ::LeaveCriticalSection(&m_criticalSection.m_cs);
+
+            m_criticalSection.m_stats->RecordHold(held, m_callSite);
+        }
+
+    private:
+        CriticalSectionGuard(const CriticalSectionGuard&) = delete;
+        CriticalSectionGuard& operator=(const CriticalSectionGuard&) = delete;
+
+        ProfiledCriticalSection& m_criticalSection;
+        void* m_callSite;
+        void* m_previousOwner;
+        int64_t m_acquired;
+    };
+
+    ProfiledCriticalSection(_In_opt_z_ char const* name = nullptr)
+        : m_stats(LockProfiler::Instance().Register(name))
+        , m_owner(nullptr)
+    {
+        InitializeCriticalSection(&m_cs);
+    }
+
+    ~ProfiledCriticalSection()
+    {
+        DeleteCriticalSection(&m_cs);
+    }
 
-    va_list args;
-    va_start(args, pszFormat);
+    // not inlined so the return address is the caller taking the lock
+    __declspec(noinline) CriticalSectionGuard const Guard() { return CriticalSectionGuard(*this, _ReturnAddress()); }
 
-    StringCchVPrintf(szTextBuf, _countof(szTextBuf), pszFormat, args);
+private:
+    CRITICAL_SECTION m_cs;
+    LockStats* m_stats;
+    std::atomic<void*> m_owner;
+};
 
-    va_end(args);
+#ifdef CRITICAL_SECTION_PROFILING
+using CriticalSection = ProfiledCriticalSection;
+#else
+using CriticalSection = PlainCriticalSection;
+#endif
 
-    OutputDebugStringW(szTextBuf);
-}
+#include "DebugLog.h"
 
 #ifndef IFR
 #define IFR(HR) { HRESULT hrTest = HR; if (FAILED(hrTest)) { return hrTest; } } 
@@ -154,6 +217,8 @@ typedef enum class _CallbackType : int32_t
     None = 0,
     Failed,
     Capture,
+    Snapshot,
+    FrameRate,
 } CallbackType;
 
 typedef struct _FAILED_STATE
@@ -161,6 +226,18 @@ typedef struct _FAILED_STATE
     int32_t hresult;
 } FAILED_STATE;
 
+typedef enum class _SnapshotFormat : int32_t
+{
+    Jpeg = 0,
+    Png,
+} SnapshotFormat;
+
+typedef struct _SNAPSHOT_STATE
+{
+    uint32_t requestId;
+    int32_t hresult;
+} SNAPSHOT_STATE;
+
 typedef enum class _CaptureStateType : int32_t
 {
     None = 0,
@@ -179,8 +256,82 @@ typedef struct _CAPTURE_STATE
     void* texturePtr;
     winrt::Windows::Foundation::Numerics::float4x4 worldMatrix;
     winrt::Windows::Foundation::Numerics::float4x4 projectionMatrix;
+    uint32_t frameSequence;     // key into CaptureGetFrameMetadata, 0 when unknown
 } CAPTURE_STATE;
 
+#ifndef AUDIO_LEVEL_MAX_CHANNELS
+#define AUDIO_LEVEL_MAX_CHANNELS 8
+#endif // AUDIO_LEVEL_MAX_CHANNELS
+
+#pragma pack(push, 4)
+typedef struct _AUDIO_LEVEL_STATE
+{
+    int64_t timestamp;
+    uint32_t sequence;
+    uint32_t channelCount;
+    float rms[AUDIO_LEVEL_MAX_CHANNELS];
+    float peak[AUDIO_LEVEL_MAX_CHANNELS];
+    float energyDb;
+    float noiseFloorDb;
+    float zeroCrossingRate;
+    int32_t voiceActive;
+} AUDIO_LEVEL_STATE;
+#pragma pack(pop)
+
+#pragma pack(push, 4)
+typedef struct _PAYLOAD_SUBSCRIBER_STATS
+{
+    uint32_t id;
+    uint32_t queueDepth;
+    uint32_t pending;
+    uint32_t maxPending;
+    uint64_t delivered;
+    uint64_t dropped;
+    int64_t lastLag;        // 100ns, queued to handler start
+    int64_t maxLag;
+    int64_t averageLag;
+    uint64_t stalls;        // blocking waits that ran out, see PayloadQueue
+} PAYLOAD_SUBSCRIBER_STATS;
+#pragma pack(pop)
+
+#ifndef FRAME_METADATA_INTRINSICS
+#define FRAME_METADATA_INTRINSICS       0x01
+#define FRAME_METADATA_EXTRINSICS       0x02
+#define FRAME_METADATA_DEVICE_TIMESTAMP 0x04
+#define FRAME_METADATA_EXPOSURE         0x08
+#define FRAME_METADATA_ISO              0x10
+#endif // FRAME_METADATA_INTRINSICS
+
+#pragma pack(push, 4)
+typedef struct _FRAME_METADATA
+{
+    uint32_t sequence;
+    uint32_t flags;             // FRAME_METADATA_*, which of the fields below are valid
+    int64_t timestamp;          // sample time, 100ns
+    int64_t deviceTimestamp;    // qpc, 100ns
+    uint32_t width;
+    uint32_t height;
+    float focalLength[2];
+    float principalPoint[2];
+    float radialDistortion[3];
+    float tangentialDistortion[2];
+    GUID calibrationId;
+    float position[3];
+    float orientation[4];
+    int64_t exposureTime;       // 100ns
+    uint32_t iso;
+} FRAME_METADATA;
+#pragma pack(pop)
+
+typedef struct _FRAME_RATE_STATE
+{
+    float negotiatedFps;
+    float measuredFps;          // over the last sampleCount frame intervals
+    float jitterMs;             // standard deviation of the interval
+    uint32_t sampleCount;
+    int32_t belowNegotiated;
+} FRAME_RATE_STATE;
+
 #pragma pack(push, 4)
 typedef struct _CALLBACK_STATE
 {
@@ -189,6 +340,8 @@ typedef struct _CALLBACK_STATE
     {
         FAILED_STATE failedState;
         CAPTURE_STATE captureState;
+        SNAPSHOT_STATE snapshotState;
+        FRAME_RATE_STATE frameRateState;
     } value;
 } CALLBACK_STATE;
 #pragma pack(pop)
@@ -0,0 +1,331 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Media.Capture.AVAligner.h"
+
+#include <algorithm>
+#include <random>
+
+// stands in for a Payload, id 0 is the empty video of an audio only bundle
+struct TestPayload
+{
+    int id;
+    int64_t timestamp;
+    int64_t duration;
+};
+
+using TestAligner = AVAligner<TestPayload>;
+
+struct TestSample
+{
+    bool video;
+    TestPayload payload;
+    int64_t arrival;
+};
+
+static constexpr int64_t c_frameInterval = 333333;  // 30fps
+static constexpr int64_t c_audioInterval = 100000;  // 10ms of audio per sample
+
+// video and audio with jittered times, in the order a capture pipeline would deliver them.
+// every sample arrives a jittered latency after its time, audio usually later than video,
+// and never before the sample ahead of it on its stream
+static std::vector<TestSample> JitteredCapture(
+    uint32_t seed,
+    int64_t start,
+    int64_t length,
+    bool videoDurations)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int64_t> timeJitter(-20000, 20000);
+    std::uniform_int_distribution<int64_t> videoLatency(0, 150000);
+    std::uniform_int_distribution<int64_t> audioLatency(100000, 400000);
+
+    std::vector<TestSample> samples;
+
+    int id = 1;
+    int64_t arrival = INT64_MIN;
+    for (int64_t time = 0; time < length; time += c_frameInterval)
+    {
+        int64_t timestamp = start + time + timeJitter(random);
+        arrival = (std::max)(arrival + 1, timestamp + videoLatency(random));
+        samples.push_back({ true, { id++, timestamp, videoDurations ? c_frameInterval : 0 }, arrival });
+    }
+
+    // audio is continuous, its times only jitter in when they are delivered
+    arrival = INT64_MIN;
+    for (int64_t time = 0; time < length; time += c_audioInterval)
+    {
+        int64_t timestamp = start + time;
+        arrival = (std::max)(arrival + 1, timestamp + audioLatency(random));
+        samples.push_back({ false, { id++, timestamp, c_audioInterval }, arrival });
+    }
+
+    // each stream stays in order, the two interleave by arrival
+    std::stable_sort(samples.begin(), samples.end(), [](auto const& a, auto const& b)
+    {
+        return a.arrival < b.arrival;
+    });
+
+    for (bool video : { true, false })
+    {
+        int64_t last = INT64_MIN;
+        for (auto& sample : samples)
+        {
+            if (sample.video == video)
+            {
+                CHECK(sample.payload.timestamp > last);
+                last = sample.payload.timestamp;
+            }
+        }
+    }
+
+    return samples;
+}
+
+static std::vector<TestAligner::Bundle> Run(
+    _In_ TestAligner& aligner,
+    _In_ std::vector<TestSample> const& samples,
+    _In_ bool flush)
+{
+    std::vector<TestAligner::Bundle> bundles;
+    auto emit = [&bundles](TestAligner::Bundle&& bundle) { bundles.push_back(std::move(bundle)); };
+
+    for (auto const& sample : samples)
+    {
+        if (sample.video)
+        {
+            aligner.PushVideo(sample.payload, sample.payload.timestamp, sample.payload.duration, emit);
+        }
+        else
+        {
+            aligner.PushAudio(sample.payload, sample.payload.timestamp, sample.payload.duration, emit);
+        }
+    }
+
+    if (flush)
+    {
+        aligner.Flush(emit);
+    }
+
+    return bundles;
+}
+
+// every sample comes out exactly once, video in order and audio in order
+static void CheckComplete(
+    _In_ std::vector<TestSample> const& samples,
+    _In_ std::vector<TestAligner::Bundle> const& bundles)
+{
+    std::vector<int> video;
+    std::vector<int> audio;
+    for (auto const& sample : samples)
+    {
+        (sample.video ? video : audio).push_back(sample.payload.id);
+    }
+
+    std::vector<int> videoOut;
+    std::vector<int> audioOut;
+    for (auto const& bundle : bundles)
+    {
+        if (bundle.video.id != 0)
+        {
+            videoOut.push_back(bundle.video.id);
+        }
+
+        for (auto const& payload : bundle.audio)
+        {
+            audioOut.push_back(payload.id);
+        }
+    }
+
+    CHECK(videoOut == video);
+    CHECK(audioOut == audio);
+}
+
+TEST(AVAlignerPairsAudioWithEachFrame)
+{
+    for (uint32_t seed = 1; seed <= 20; ++seed)
+    {
+        auto samples = JitteredCapture(seed, 0, 50000000, true);
+
+        TestAligner aligner;
+        auto bundles = Run(aligner, samples, false);
+
+        // audio arrives well inside the skew, nothing should have been forced out
+        CHECK(aligner.OverflowCount() == 0);
+        CHECK(bundles.size() + 3 >= static_cast<size_t>(50000000 / c_frameInterval));
+
+        for (auto const& bundle : bundles)
+        {
+            CHECK(bundle.video.id != 0);
+            CHECK(bundle.timestamp == bundle.video.timestamp);
+            CHECK(bundle.duration == c_frameInterval);
+
+            // all of its audio starts before the frame ends
+            int64_t frameEnd = bundle.timestamp + bundle.duration;
+            for (auto const& audio : bundle.audio)
+            {
+                CHECK(audio.timestamp < frameEnd);
+            }
+
+            // and reaches past its end by less than a sample
+            CHECK(!bundle.audio.empty());
+            CHECK(bundle.skew >= 0);
+            CHECK(bundle.skew < c_audioInterval);
+        }
+
+        // the frames still waiting for their audio go out on stop, with whatever is left
+        aligner.Flush([&bundles](TestAligner::Bundle&& bundle) { bundles.push_back(std::move(bundle)); });
+
+        CheckComplete(samples, bundles);
+    }
+}
+
+TEST(AVAlignerKeepsTheSharedClock)
+{
+    // the sink hands in times already on the shared base, they come out as they went in,
+    // including the little before the base the second stream can start at
+    auto samples = JitteredCapture(7, -250000, 10000000, true);
+
+    TestAligner aligner;
+    auto bundles = Run(aligner, samples, true);
+
+    CheckComplete(samples, bundles);
+    CHECK(!bundles.empty());
+    CHECK(bundles.front().timestamp == bundles.front().video.timestamp);
+    CHECK(bundles.front().timestamp < 0);
+
+    // the same capture gives the same bundles
+    TestAligner again;
+    auto repeated = Run(again, samples, true);
+    CHECK(repeated.size() == bundles.size());
+    for (size_t i = 0; i < (std::min)(repeated.size(), bundles.size()); ++i)
+    {
+        CHECK(repeated[i].video.id == bundles[i].video.id);
+        CHECK(repeated[i].audio.size() == bundles[i].audio.size());
+        CHECK(repeated[i].skew == bundles[i].skew);
+    }
+}
+
+TEST(AVAlignerTakesMissingDurationsFromTheNextFrame)
+{
+    auto samples = JitteredCapture(3, 0, 10000000, false);
+
+    TestAligner aligner;
+    auto bundles = Run(aligner, samples, false);
+
+    CHECK(!bundles.empty());
+    for (size_t i = 0; i + 1 < bundles.size(); ++i)
+    {
+        // the interval ends where the next frame starts
+        CHECK(bundles[i].timestamp + bundles[i].duration == bundles[i + 1].timestamp);
+    }
+}
+
+TEST(AVAlignerWaitsAtMostMaxSkew)
+{
+    TestAligner aligner(64, 64);
+    aligner.MaxSkew(1000000);
+
+    std::vector<TestAligner::Bundle> bundles;
+    auto emit = [&bundles](TestAligner::Bundle&& bundle) { bundles.push_back(std::move(bundle)); };
+
+    // audio stops at 100ms, video keeps coming
+    int id = 1;
+    for (int64_t time = 0; time < 1000000; time += c_audioInterval)
+    {
+        aligner.PushAudio({ id++, time, c_audioInterval }, time, c_audioInterval, emit);
+    }
+
+    int64_t time = 0;
+    for (int frame = 0; frame < 10; ++frame, time += c_frameInterval)
+    {
+        aligner.PushVideo({ id++, time, c_frameInterval }, time, c_frameInterval, emit);
+    }
+
+    // frames before the end of the audio were covered, the next ones are only released
+    // once the newest frame is more than MaxSkew past their end
+    CHECK(!bundles.empty());
+    for (auto const& bundle : bundles)
+    {
+        CHECK(bundle.timestamp + bundle.duration + aligner.MaxSkew() <= time);
+    }
+
+    auto covered = std::count_if(bundles.begin(), bundles.end(), [](auto const& bundle) { return bundle.skew >= 0; });
+    CHECK(aligner.OverflowCount() == bundles.size() - static_cast<size_t>(covered));
+    CHECK(aligner.OverflowCount() > 0);
+}
+
+TEST(AVAlignerBoundsPendingVideo)
+{
+    TestAligner aligner(4, 64);
+    aligner.MaxSkew(INT64_MAX / 2);
+
+    std::vector<TestAligner::Bundle> bundles;
+    auto emit = [&bundles](TestAligner::Bundle&& bundle) { bundles.push_back(std::move(bundle)); };
+
+    // no audio at all
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        int64_t time = frame * c_frameInterval;
+        aligner.PushVideo({ frame + 1, time, c_frameInterval }, time, c_frameInterval, emit);
+        CHECK(static_cast<size_t>(frame + 1) - bundles.size() <= 4);
+    }
+
+    CHECK(bundles.size() == 6);
+    CHECK(aligner.OverflowCount() == 6);
+
+    aligner.Flush(emit);
+    CHECK(bundles.size() == 10);
+    for (size_t i = 0; i < bundles.size(); ++i)
+    {
+        CHECK(bundles[i].video.id == static_cast<int>(i + 1));
+        CHECK(bundles[i].audio.empty());
+    }
+}
+
+TEST(AVAlignerPassesAudioOnWhenVideoStalls)
+{
+    TestAligner aligner(8, 8);
+
+    std::vector<TestAligner::Bundle> bundles;
+    auto emit = [&bundles](TestAligner::Bundle&& bundle) { bundles.push_back(std::move(bundle)); };
+
+    for (int i = 0; i < 20; ++i)
+    {
+        int64_t time = i * c_audioInterval;
+        aligner.PushAudio({ i + 1, time, c_audioInterval }, time, c_audioInterval, emit);
+    }
+
+    // the oldest go out on their own, none are dropped
+    CHECK(bundles.size() == 12);
+    CHECK(aligner.OverflowCount() == 12);
+    for (size_t i = 0; i < bundles.size(); ++i)
+    {
+        CHECK(bundles[i].video.id == 0);
+        CHECK(bundles[i].audio.size() == 1);
+        CHECK(bundles[i].audio.front().id == static_cast<int>(i + 1));
+        CHECK(bundles[i].timestamp == static_cast<int64_t>(i) * c_audioInterval);
+    }
+
+    aligner.Flush(emit);
+    CHECK(bundles.size() == 20);
+}
+
+TEST(AVAlignerResetDropsPending)
+{
+    TestAligner aligner;
+
+    std::vector<TestAligner::Bundle> bundles;
+    auto emit = [&bundles](TestAligner::Bundle&& bundle) { bundles.push_back(std::move(bundle)); };
+
+    aligner.PushVideo({ 1, 0, c_frameInterval }, 0, c_frameInterval, emit);
+    aligner.PushAudio({ 2, 0, c_audioInterval }, 0, c_audioInterval, emit);
+    CHECK(bundles.empty());
+
+    aligner.Reset();
+    aligner.Flush(emit);
+    CHECK(bundles.empty());
+    CHECK(aligner.OverflowCount() == 0);
+}
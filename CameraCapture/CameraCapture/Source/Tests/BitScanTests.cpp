@@ -0,0 +1,24 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "BitScan.h"
+
+// the two halves on x86 and arm have to agree with the 64 bit scan, the values either side
+// of the 32 bit boundary are the ones that would not
+TEST(HighestSetBitMatchesEveryPosition)
+{
+    for (uint32_t bit = 0; bit < 64; ++bit)
+    {
+        uint64_t value = 1ull << bit;
+        CHECK(HighestSetBit(value) == bit);
+        CHECK(HighestSetBit(value | 1) == bit);
+        CHECK(HighestSetBit(value | (value - 1)) == bit);
+    }
+
+    CHECK(HighestSetBit(0xffffffffull) == 31);
+    CHECK(HighestSetBit(0x100000000ull) == 32);
+    CHECK(HighestSetBit(0x1ffffffffull) == 32);
+    CHECK(HighestSetBit(UINT64_MAX) == 63);
+}
@@ -0,0 +1,66 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+
+#include <type_traits>
+#include <utility>
+
+using namespace DebugLog;
+
+// whether Log() accepts the format, the logger thread reads it long after the call
+template <typename T, typename = void>
+struct AcceptsFormat : std::false_type {};
+
+template <typename T>
+struct AcceptsFormat<T, std::void_t<decltype(Log(std::declval<T>()))>> : std::true_type {};
+
+static_assert(AcceptsFormat<wchar_t const (&)[6]>::value, "a literal is a format");
+static_assert(!AcceptsFormat<wchar_t (&)[64]>::value, "a buffer is not");
+static_assert(!AcceptsFormat<wchar_t const*>::value, "nor is a pointer to one");
+
+// what the logger thread writes for one call
+template <typename... Args>
+static std::wstring Format(wchar_t const* format, Args const&... args)
+{
+    Record record{};
+    record.format = format;
+    (AddArg(record, args), ...);
+
+    std::wstring text;
+    FormatRecord(record, text);
+
+    return text;
+}
+
+TEST(DebugLogReplaysNarrowStrings)
+{
+    char const* narrow = "narrow";
+    wchar_t const* wide = L"wide";
+
+    CHECK(Format(L"%s, %s", narrow, wide) == L"narrow, wide");
+    CHECK(Format(L"[%8s]", narrow) == L"[  narrow]");
+    CHECK(Format(L"%hs %ls", narrow, wide) == L"narrow wide");
+    CHECK(Format(L"%S", narrow) == L"narrow");
+}
+
+TEST(DebugLogReplaysValues)
+{
+    CHECK(Format(L"%u %d %I64d %.2f", 7u, -3, static_cast<int64_t>(1) << 40, 0.5) == L"7 -3 1099511627776 0.50");
+    CHECK(Format(L"100%%") == L"100%");
+
+    // more conversions than arguments, the rest is left as written
+    CHECK(Format(L"%d %d", 1) == L"1 %d");
+
+    // strings are copied, not referenced
+    char buffer[] = "before";
+    Record record{};
+    record.format = L"%s";
+    AddArg(record, static_cast<char const*>(buffer));
+    buffer[0] = 'X';
+
+    std::wstring text;
+    FormatRecord(record, text);
+    CHECK(text == L"before");
+}
@@ -0,0 +1,241 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+
+#include <winrt/Windows.Media.Core.h>
+#include <winrt/Windows.Media.MediaProperties.h>
+
+#include <algorithm>
+#include <variant>
+
+// what PayloadHandler::Invoke costs per work item, the try_as probing it used to do against
+// the tag switch over a WorkItem it does now. Payload and PayloadBundle are the component's
+// own runtimeclasses, a local IStringable object stands in for them, it answers QueryInterface
+// the same way. the rest are the real platform objects
+using namespace winrt;
+using namespace Windows::Foundation;
+using namespace Windows::Media::Core;
+using namespace Windows::Media::MediaProperties;
+
+namespace
+{
+    struct BenchPayload : implements<BenchPayload, IStringable>
+    {
+        hstring ToString() { return L"payload"; }
+    };
+
+    using BenchWorkItem = std::variant<
+        std::monostate,
+        MediaEncodingProfile,
+        MediaPropertySet,
+        IMediaEncodingProperties,
+        IStringable,
+        MediaStreamSample>;
+
+    // what the handlers do with an item, enough that neither path is optimized away
+    struct DispatchSink
+    {
+        uint64_t items = 0;
+        uintptr_t mix = 0;
+
+        template <typename T>
+        void Handle(T const& value)
+        {
+            ++items;
+            mix ^= reinterpret_cast<uintptr_t>(get_abi(value));
+        }
+    };
+
+    // as Invoke was, every item is probed for every type
+    void DispatchByProbing(IInspectable const& state, DispatchSink& sink)
+    {
+        auto payload = state.try_as<IStringable>();
+        auto profile = state.try_as<MediaEncodingProfile>();
+        auto metaData = state.try_as<MediaPropertySet>();
+        auto mediaDescription = state.try_as<IMediaEncodingProperties>();
+        auto streamSample = state.try_as<MediaStreamSample>();
+        if (profile != nullptr)
+        {
+            sink.Handle(profile);
+        }
+        else if (payload != nullptr)
+        {
+            sink.Handle(payload);
+        }
+        else if (metaData != nullptr)
+        {
+            sink.Handle(metaData);
+        }
+        else if (mediaDescription != nullptr)
+        {
+            sink.Handle(mediaDescription);
+        }
+        else if (streamSample != nullptr)
+        {
+            sink.Handle(streamSample);
+        }
+    }
+
+    // as Invoke is, the item is moved off the queue and switched on
+    void DispatchByTag(BenchWorkItem& queued, DispatchSink& sink)
+    {
+        BenchWorkItem item = std::move(queued);
+        switch (item.index())
+        {
+        case 1: sink.Handle(std::get<1>(item)); break;
+        case 2: sink.Handle(std::get<2>(item)); break;
+        case 3: sink.Handle(std::get<3>(item)); break;
+        case 4: sink.Handle(std::get<4>(item)); break;
+        case 5: sink.Handle(std::get<5>(item)); break;
+        default: break;
+        }
+    }
+
+    // roughly a capture with audio, per 16 items: 13 payloads, a marker, a stream description
+    // and a stream sample
+    struct WorkItemSource
+    {
+        WorkItemSource()
+            : profile(MediaEncodingProfile())
+            , metaData(MediaPropertySet())
+            , description(VideoEncodingProperties())
+            , payload(make<BenchPayload>())
+            , streamSample(MediaStreamSample::CreateFromBuffer(Windows::Storage::Streams::Buffer(16), TimeSpan{}))
+        {
+        }
+
+        IInspectable Inspectable(uint32_t i) const
+        {
+            switch (i % 16)
+            {
+            case 3: return metaData;
+            case 7: return description;
+            case 11: return streamSample;
+            default: return (i == 0) ? profile.as<IInspectable>() : payload.as<IInspectable>();
+            }
+        }
+
+        BenchWorkItem Item(uint32_t i) const
+        {
+            switch (i % 16)
+            {
+            case 3: return BenchWorkItem{ std::in_place_index<2>, metaData };
+            case 7: return BenchWorkItem{ std::in_place_index<3>, description };
+            case 11: return BenchWorkItem{ std::in_place_index<5>, streamSample };
+            default: return (i == 0) ? BenchWorkItem{ std::in_place_index<1>, profile } : BenchWorkItem{ std::in_place_index<4>, payload };
+            }
+        }
+
+        MediaEncodingProfile profile;
+        MediaPropertySet metaData;
+        IMediaEncodingProperties description;
+        IStringable payload;
+        MediaStreamSample streamSample;
+    };
+
+    int64_t Ticks()
+    {
+        LARGE_INTEGER counter{};
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    double TicksToNs(int64_t ticks)
+    {
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+    }
+
+    // paced like the capture would be, one item every 1/240s, each dispatch timed on its own.
+    // a cold item out of the cache is the case that matters here, not the tight loop
+    template <typename TDispatch>
+    void RunPaced(char const* name, uint32_t count, TDispatch&& dispatch)
+    {
+        std::vector<int64_t> elapsed(count);
+
+        int64_t next = Ticks();
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        int64_t period = frequency.QuadPart / 240;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            while (Ticks() < next)
+            {
+                Sleep(0);
+            }
+            next += period;
+
+            int64_t start = Ticks();
+            dispatch(i);
+            elapsed[i] = Ticks() - start;
+        }
+
+        std::sort(elapsed.begin(), elapsed.end());
+
+        int64_t total = 0;
+        for (auto value : elapsed)
+        {
+            total += value;
+        }
+
+        printf("  %-8s 240/s   mean %7.0f ns   p50 %7.0f ns   p99 %7.0f ns\n",
+            name,
+            TicksToNs(total) / count,
+            TicksToNs(elapsed[count / 2]),
+            TicksToNs(elapsed[(count * 99) / 100]));
+    }
+
+    template <typename TDispatch>
+    void RunTight(char const* name, uint32_t count, TDispatch&& dispatch)
+    {
+        int64_t start = Ticks();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            dispatch(i);
+        }
+        int64_t elapsed = Ticks() - start;
+
+        printf("  %-8s tight   mean %7.1f ns\n", name, TicksToNs(elapsed) / count);
+    }
+}
+
+BENCHMARK(PayloadDispatchCost)
+{
+    init_apartment();
+
+    WorkItemSource source;
+
+    // the queue holds what QueueWorkItem would have, built ahead so only dispatch is timed
+    constexpr uint32_t c_pacedItems = 240 * 5;
+    constexpr uint32_t c_tightItems = 1000000;
+
+    std::vector<IInspectable> inspectables;
+    std::vector<BenchWorkItem> items;
+    for (uint32_t i = 0; i < c_tightItems; ++i)
+    {
+        inspectables.push_back(source.Inspectable(i));
+        items.push_back(source.Item(i));
+    }
+
+    DispatchSink probeSink;
+    DispatchSink tagSink;
+
+    RunPaced("try_as", c_pacedItems, [&](uint32_t i) { DispatchByProbing(inspectables[i], probeSink); });
+    RunPaced("tag", c_pacedItems, [&](uint32_t i) { DispatchByTag(items[i], tagSink); });
+
+    RunTight("try_as", c_tightItems, [&](uint32_t i) { DispatchByProbing(inspectables[i], probeSink); });
+
+    // the paced run moved its items out
+    for (uint32_t i = 0; i < c_pacedItems; ++i)
+    {
+        items[i] = source.Item(i);
+    }
+    RunTight("tag", c_tightItems, [&](uint32_t i) { DispatchByTag(items[i], tagSink); });
+
+    CHECK(probeSink.items == tagSink.items);
+    CHECK(probeSink.mix == tagSink.mix);
+}
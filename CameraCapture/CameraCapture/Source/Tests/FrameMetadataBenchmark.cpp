@@ -0,0 +1,187 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Media.FrameMetadata.h"
+
+#include <mfapi.h>
+
+// the sink thread's Add() for every video frame, and the app's GetFrameMetadata lookups
+// against it, with a sample carrying every attribute Fill() reads
+namespace
+{
+    int64_t Ticks()
+    {
+        LARGE_INTEGER counter{};
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    double TicksToNs(int64_t ticks)
+    {
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+    }
+
+    winrt::com_ptr<IMFSample> CreateSample(UINT32 intrinsicModels)
+    {
+        winrt::com_ptr<IMFSample> sample = nullptr;
+        MFCreateSample(sample.put());
+        sample->SetSampleTime(333333);
+        sample->SetUINT64(MFSampleExtension_DeviceTimestamp, 1000);
+
+        // count then entries, what a driver hands over for a camera with several models
+        std::vector<uint8_t> intrinsics(
+            offsetof(MFPinholeCameraIntrinsics, IntrinsicModels) + intrinsicModels * sizeof(MFPinholeCameraIntrinsic_IntrinsicModel));
+        auto header = reinterpret_cast<MFPinholeCameraIntrinsics*>(intrinsics.data());
+        header->IntrinsicModelCount = intrinsicModels;
+        for (UINT32 i = 0; i < intrinsicModels; ++i)
+        {
+            header->IntrinsicModels[i].Width = 1920 >> i;
+            header->IntrinsicModels[i].Height = 1080 >> i;
+            header->IntrinsicModels[i].CameraModel.FocalLength.x = 1000.0f;
+        }
+        sample->SetBlob(MFSampleExtension_PinholeCameraIntrinsics, intrinsics.data(), static_cast<UINT32>(intrinsics.size()));
+
+        MFCameraExtrinsics extrinsics{};
+        extrinsics.TransformCount = 1;
+        extrinsics.CalibratedTransforms[0].Position.z = 0.5f;
+        extrinsics.CalibratedTransforms[0].Orientation.w = 1.0f;
+        sample->SetBlob(MFSampleExtension_CameraExtrinsics, reinterpret_cast<UINT8 const*>(&extrinsics), sizeof(extrinsics));
+
+        winrt::com_ptr<IMFAttributes> captureMetadata = nullptr;
+        MFCreateAttributes(captureMetadata.put(), 2);
+        captureMetadata->SetUINT64(MF_CAPTURE_METADATA_EXPOSURE_TIME, 166666);
+        captureMetadata->SetUINT32(MF_CAPTURE_METADATA_ISO_SPEED, 400);
+        sample->SetUnknown(MFSampleExtension_CaptureMetadata, captureMetadata.get());
+
+        return sample;
+    }
+}
+
+TEST(FrameMetadataRingKeepsTheLastFrames)
+{
+    constexpr uint32_t c_frames = FrameMetadataRing::Capacity + 10;
+
+    auto sample = CreateSample(2);
+
+    FrameMetadataRing ring;
+    for (uint32_t i = 0; i < c_frames; ++i)
+    {
+        CHECK(ring.Add(sample.get()) == i + 1);
+    }
+
+    // the ones pushed out are gone, asking from 1 starts at the oldest held
+    uint32_t count = 0;
+    CHECK(SUCCEEDED(ring.Get(1, nullptr, &count)));
+    CHECK(count == FrameMetadataRing::Capacity);
+
+    FRAME_METADATA records[FrameMetadataRing::Capacity]{};
+    CHECK(SUCCEEDED(ring.Get(1, records, &count)));
+    CHECK(count == FrameMetadataRing::Capacity);
+    CHECK(records[0].sequence == 11);
+    CHECK(records[count - 1].sequence == c_frames);
+
+    auto const& last = records[count - 1];
+    CHECK(last.flags == (FRAME_METADATA_INTRINSICS | FRAME_METADATA_EXTRINSICS | FRAME_METADATA_DEVICE_TIMESTAMP | FRAME_METADATA_EXPOSURE | FRAME_METADATA_ISO));
+    CHECK(last.timestamp == 333333);
+    CHECK(last.deviceTimestamp == 1000);
+    CHECK(last.width == 1920 && last.height == 1080);
+    CHECK(last.focalLength[0] == 1000.0f);
+    CHECK(last.position[2] == 0.5f);
+    CHECK(last.orientation[3] == 1.0f);
+    CHECK(last.exposureTime == 166666);
+    CHECK(last.iso == 400);
+
+    // a sequence past the last one has nothing yet
+    count = 1;
+    CHECK(SUCCEEDED(ring.Get(c_frames + 1, records, &count)));
+    CHECK(count == 0);
+
+    // reset drops what's held but keeps counting
+    ring.Reset();
+    CHECK(SUCCEEDED(ring.Get(1, nullptr, &count)));
+    CHECK(count == 0);
+    CHECK(ring.Add(sample.get()) == c_frames + 1);
+    CHECK(SUCCEEDED(ring.Get(1, nullptr, &count)));
+    CHECK(count == 1);
+}
+
+TEST(FrameMetadataFillRejectsShortBlobs)
+{
+    auto sample = CreateSample(1);
+
+    // a count larger than the blob holds is not read past the end
+    MFPinholeCameraIntrinsics intrinsics{};
+    intrinsics.IntrinsicModelCount = 2;
+    sample->SetBlob(MFSampleExtension_PinholeCameraIntrinsics, reinterpret_cast<UINT8 const*>(&intrinsics), sizeof(intrinsics));
+
+    std::vector<uint8_t> blob;
+    FRAME_METADATA metadata{};
+    FrameMetadataRing::Fill(sample.get(), blob, &metadata);
+    CHECK((metadata.flags & FRAME_METADATA_INTRINSICS) == 0);
+    CHECK((metadata.flags & FRAME_METADATA_EXTRINSICS) != 0);
+}
+
+BENCHMARK(FrameMetadataRingAdd)
+{
+    constexpr uint32_t c_frames = 200000;
+
+    auto sample = CreateSample(4);
+
+    FrameMetadataRing ring;
+    int64_t start = Ticks();
+    for (uint32_t i = 0; i < c_frames; ++i)
+    {
+        ring.Add(sample.get());
+    }
+    int64_t elapsed = Ticks() - start;
+
+    printf("  Add, 5 attributes    %7.1f ns per frame\n", TicksToNs(elapsed) / c_frames);
+
+    CHECK(ring.LastSequence() == c_frames);
+}
+
+BENCHMARK(FrameMetadataRingGet)
+{
+    constexpr uint32_t c_lookups = 1000000;
+
+    auto sample = CreateSample(1);
+
+    FrameMetadataRing ring;
+    for (uint32_t i = 0; i < FrameMetadataRing::Capacity; ++i)
+    {
+        ring.Add(sample.get());
+    }
+
+    // one frame by its sequence, what a texture callback asks for
+    FRAME_METADATA records[FrameMetadataRing::Capacity]{};
+    uint32_t found = 0;
+    int64_t start = Ticks();
+    for (uint32_t i = 0; i < c_lookups; ++i)
+    {
+        uint32_t count = 1;
+        ring.Get(1 + (i % FrameMetadataRing::Capacity), records, &count);
+        found += count;
+    }
+    int64_t elapsed = Ticks() - start;
+
+    printf("  Get, 1 frame         %7.1f ns per lookup\n", TicksToNs(elapsed) / c_lookups);
+    CHECK(found == c_lookups);
+
+    // everything held, what a poll after a stall asks for
+    constexpr uint32_t c_bulk = c_lookups / 16;
+    start = Ticks();
+    for (uint32_t i = 0; i < c_bulk; ++i)
+    {
+        uint32_t count = FrameMetadataRing::Capacity;
+        ring.Get(1, records, &count);
+        found += count;
+    }
+    elapsed = Ticks() - start;
+
+    printf("  Get, %u frames       %7.1f ns per lookup\n", FrameMetadataRing::Capacity, TicksToNs(elapsed) / c_bulk);
+    CHECK(found == c_lookups + c_bulk * FrameMetadataRing::Capacity);
+}
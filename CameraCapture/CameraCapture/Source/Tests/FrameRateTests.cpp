@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Media.FrameRate.h"
+
+static std::vector<VideoFormatCandidate> Rates(std::vector<double> const& rates)
+{
+    std::vector<VideoFormatCandidate> candidates;
+    for (double fps : rates)
+    {
+        candidates.push_back({ 1280, 720, fps, true });
+    }
+
+    return candidates;
+}
+
+TEST(SelectVideoFormatPrefersTheHighestRateInRange)
+{
+    auto candidates = Rates({ 15.0, 24.0, 30.0, 60.0 });
+
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 20.0, 30.0 }) == 2);
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 0.0, 0.0 }) == 3);
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 0.0, 25.0 }) == 1);
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 24.0, 0.0 }) == 3);
+}
+
+// nothing at 30 and 15 is closer than 60, but the faster camera can be paced down,
+// the slower one cannot make up the frames
+TEST(SelectVideoFormatPrefersOverTheRangeToUnderIt)
+{
+    auto candidates = Rates({ 15.0, 60.0 });
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 30.0, 30.0 }) == 1);
+
+    // even when the one under is closer
+    candidates = Rates({ 29.0, 60.0 });
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 30.0, 30.0 }) == 1);
+
+    // the closest of those over
+    candidates = Rates({ 120.0, 60.0, 15.0 });
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 30.0, 30.0 }) == 1);
+
+    // an open minimum is never under
+    candidates = Rates({ 60.0, 15.0 });
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 0.0, 30.0 }) == 1);
+}
+
+TEST(SelectVideoFormatFallsBackToTheClosestUnderTheRange)
+{
+    auto candidates = Rates({ 5.0, 15.0, 24.0 });
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 30.0, 60.0 }) == 2);
+}
+
+TEST(SelectVideoFormatRequiresSizeAndSubtype)
+{
+    std::vector<VideoFormatCandidate> candidates =
+    {
+        { 1920, 1080, 30.0, true },
+        { 1280, 720, 60.0, false },
+        { 1280, 720, 15.0, true },
+    };
+
+    CHECK(SelectVideoFormat(candidates, 1280, 720, { 30.0, 30.0 }) == 2);
+    CHECK(SelectVideoFormat(candidates, 640, 480, { 30.0, 30.0 }) == -1);
+    CHECK(SelectVideoFormat({}, 1280, 720, { 30.0, 30.0 }) == -1);
+}
@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+
+#include <algorithm>
+
+// what a Log() call costs the thread that makes it, the ring capture against the Log() it
+// replaced, which formatted into a 2048 character buffer and wrote to the debugger on the
+// caller. run it with and without a debugger attached, OutputDebugString is most of the
+// old cost when one is
+namespace
+{
+    void __stdcall LegacyLog(
+        _In_ _Printf_format_string_ STRSAFE_LPCWSTR pszFormat,
+        ...)
+    {
+        wchar_t szTextBuf[2048];
+
+        va_list args;
+        va_start(args, pszFormat);
+
+        StringCchVPrintf(szTextBuf, _countof(szTextBuf), pszFormat, args);
+
+        va_end(args);
+
+        OutputDebugStringW(szTextBuf);
+    }
+
+    int64_t Ticks()
+    {
+        LARGE_INTEGER counter{};
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    double TicksToNs(int64_t ticks)
+    {
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+    }
+
+    // a line like the capture logs per sample, an integer, a 64 bit time, a double and a string
+    wchar_t const c_format[] = L"StreamSink::ProcessSample(%u) - time: %I64d, rate: %.3f, type: %s\n";
+    wchar_t const* const c_type = L"Video";
+
+    // bursts that fit the ring with the logger thread given time to drain in between, so the
+    // numbers are the capture and not the drop path. each call is timed on its own
+    template <typename TLog>
+    void RunBursts(char const* name, uint32_t bursts, uint32_t burstSize, TLog&& log)
+    {
+        std::vector<int64_t> elapsed;
+        elapsed.reserve(static_cast<size_t>(bursts) * burstSize);
+
+        uint32_t i = 0;
+        for (uint32_t burst = 0; burst < bursts; ++burst)
+        {
+            for (uint32_t call = 0; call < burstSize; ++call, ++i)
+            {
+                int64_t start = Ticks();
+                log(i);
+                elapsed.push_back(Ticks() - start);
+            }
+
+            Sleep(60);
+        }
+
+        std::sort(elapsed.begin(), elapsed.end());
+
+        int64_t total = 0;
+        for (auto value : elapsed)
+        {
+            total += value;
+        }
+
+        size_t count = elapsed.size();
+        printf("  %-10s mean %7.0f ns   p50 %7.0f ns   p99 %7.0f ns   max %9.0f ns\n",
+            name,
+            TicksToNs(total) / count,
+            TicksToNs(elapsed[count / 2]),
+            TicksToNs(elapsed[(count * 99) / 100]),
+            TicksToNs(elapsed.back()));
+    }
+}
+
+BENCHMARK(LogCallCost)
+{
+    constexpr uint32_t c_bursts = 20;
+    constexpr uint32_t c_burstSize = 256;
+
+    auto& logger = DebugLogger::Instance();
+    auto level = DebugLogger::Level();
+    DebugLogger::Level(LogLevel::Verbose);
+
+    // the logger thread is started by the first call, not by the measured ones
+    Log(L"LogCallCost\n");
+    logger.Shutdown();
+    Log(L"LogCallCost\n");
+
+    uint64_t dropped = logger.DroppedCount();
+
+    RunBursts("legacy", c_bursts, c_burstSize, [](uint32_t i)
+        {
+            LegacyLog(c_format, i, static_cast<int64_t>(i) * 333333, i / 30.0, c_type);
+        });
+
+    RunBursts("ring", c_bursts, c_burstSize, [](uint32_t i)
+        {
+            Log(c_format, i, static_cast<int64_t>(i) * 333333, i / 30.0, c_type);
+        });
+
+    // below the level nothing is captured, that is what Verbose lines cost in a release setup
+    DebugLogger::Level(LogLevel::Warning);
+    RunBursts("filtered", c_bursts, c_burstSize, [](uint32_t i)
+        {
+            Log(LogLevel::Verbose, c_format, i, static_cast<int64_t>(i) * 333333, i / 30.0, c_type);
+        });
+
+    logger.Shutdown();
+    DebugLogger::Level(level);
+
+    // the bursts fit the ring, the numbers above are not the drop path
+    CHECK(logger.DroppedCount() == dropped);
+}
@@ -0,0 +1,154 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Media.Metrics.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+// the registry is updated from the sink, dispatcher and subscriber threads at once, nothing
+// it does may serialize them. the test checks no update is lost under contention, the
+// benchmark what an update costs as threads are added
+namespace
+{
+    int64_t Ticks()
+    {
+        LARGE_INTEGER counter{};
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    double TicksToNs(int64_t ticks)
+    {
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+    }
+
+    // every thread waits for the others before it starts, so they contend from the first update
+    template <typename TWork>
+    int64_t RunThreads(uint32_t threadCount, TWork&& work)
+    {
+        std::atomic<uint32_t> ready = 0;
+        std::atomic<bool> go = false;
+
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < threadCount; ++thread)
+        {
+            threads.emplace_back([&, thread]
+                {
+                    ++ready;
+                    while (!go)
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    work(thread);
+                });
+        }
+
+        while (ready < threadCount)
+        {
+            std::this_thread::yield();
+        }
+
+        int64_t start = Ticks();
+        go = true;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        return Ticks() - start;
+    }
+
+    // what one sample costs the sink, a counter, a gauge and a histogram
+    void UpdateSample(MetricsRegistry& metrics, uint32_t metric, uint64_t i)
+    {
+        metrics.Increment(static_cast<MetricCounter>(metric % static_cast<uint32_t>(MetricCounter::Count)));
+        metrics.Set(static_cast<MetricGauge>(metric % static_cast<uint32_t>(MetricGauge::Count)), static_cast<int64_t>(i & 7));
+        metrics.Record(static_cast<MetricHistogram>(metric % static_cast<uint32_t>(MetricHistogram::Count)), i & 0x3fff);
+    }
+}
+
+TEST(MetricsRegistryCountsEveryUpdateUnderContention)
+{
+    constexpr uint32_t c_threads = 4;
+    constexpr uint64_t c_updates = 200000;
+
+    auto metrics = std::make_unique<MetricsRegistry>();
+
+    RunThreads(c_threads, [&](uint32_t)
+        {
+            for (uint64_t i = 0; i < c_updates; ++i)
+            {
+                UpdateSample(*metrics, 0, i);
+            }
+        });
+
+    // every thread recorded 0..c_updates-1 masked, the sum and max follow from that
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < c_updates; ++i)
+    {
+        sum += i & 0x3fff;
+    }
+
+    uint32_t size = 0;
+    CHECK(SUCCEEDED(metrics->Snapshot(nullptr, &size)));
+    std::string json(size, '\0');
+    CHECK(SUCCEEDED(metrics->Snapshot(json.data(), &size)));
+
+    CHECK(json.find("\"videoSamples\":" + std::to_string(c_threads * c_updates) + ",") != std::string::npos);
+    CHECK(json.find("\"videoFrameIntervalUs\":{\"count\":" + std::to_string(c_threads * c_updates)
+        + ",\"sum\":" + std::to_string(c_threads * sum)
+        + ",\"max\":16383,") != std::string::npos);
+
+    // 0 in bucket 0, 16383 in [8192, 16384), bucket 14
+    CHECK(json.find("\"buckets\":[" + std::to_string(c_threads * (c_updates / 0x4000 + 1)) + ",") != std::string::npos);
+}
+
+BENCHMARK(MetricsRegistryContention)
+{
+    constexpr uint64_t c_updates = 2000000;
+
+    // 1, 2, 4 ... up to every core
+    std::vector<uint32_t> threadCounts;
+    uint32_t cores = (std::max)(1u, std::thread::hardware_concurrency());
+    for (uint32_t threadCount = 1; threadCount < cores; threadCount *= 2)
+    {
+        threadCounts.push_back(threadCount);
+    }
+    threadCounts.push_back(cores);
+
+    auto metrics = std::make_unique<MetricsRegistry>();
+
+    // same: every thread on the same counter, gauge and histogram, the worst case, the cache
+    // lines bounce between cores on every update. own: each thread on its own, which is how
+    // the pipeline threads use it, the sink and the dispatcher do not share metrics
+    for (bool shared : { true, false })
+    {
+        for (uint32_t threadCount : threadCounts)
+        {
+            metrics->Reset();
+
+            int64_t elapsed = RunThreads(threadCount, [&](uint32_t thread)
+                {
+                    uint32_t metric = shared ? 0 : thread;
+                    for (uint64_t i = 0; i < c_updates; ++i)
+                    {
+                        UpdateSample(*metrics, metric, i);
+                    }
+                });
+
+            // wall time over the updates each thread made, what one sample costs a thread
+            printf("  %-4s %2u threads   %7.1f ns per sample   %7.1f M samples/s total\n",
+                shared ? "same" : "own",
+                threadCount,
+                TicksToNs(elapsed) / c_updates,
+                threadCount * c_updates * 1e3 / TicksToNs(elapsed));
+        }
+    }
+}
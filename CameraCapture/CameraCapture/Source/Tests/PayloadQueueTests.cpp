@@ -0,0 +1,297 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Media.PayloadQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using TestQueue = PayloadQueue<uint32_t>;
+
+static int64_t TestNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() / 100;
+}
+
+// a PayloadSubscriber on a plain thread. Post stands in for MFPutWorkItem2, the thread runs
+// one Pop per post like the serial work queue runs one Invoke
+class TestSubscriber
+{
+public:
+    TestSubscriber(uint32_t depth, PayloadQueuePolicy policy, std::chrono::milliseconds maxBlockTime, std::function<void(uint32_t)> const& handler)
+        : m_queue(depth, policy, maxBlockTime)
+        , m_handler(handler)
+        , m_posted(0)
+        , m_stop(false)
+        , m_worker([this] { Run(); })
+    {
+    }
+
+    ~TestSubscriber()
+    {
+        Stop();
+    }
+
+    void Enqueue(uint32_t item)
+    {
+        auto result = m_queue.Push(std::move(item), TestNow());
+        if (result == TestQueue::PushResult::Queued || result == TestQueue::PushResult::Replaced)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_posted;
+            m_wake.notify_one();
+        }
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+            m_wake.notify_one();
+        }
+
+        m_queue.Shutdown();
+
+        if (m_worker.joinable())
+        {
+            m_worker.join();
+        }
+    }
+
+    // waits for the worker to take everything posted so far
+    void Drain()
+    {
+        for (;;)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_posted == 0)
+                {
+                    return;
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    TestQueue::Stats Stats()
+    {
+        TestQueue::Stats stats{};
+        m_queue.GetStats(&stats);
+        return stats;
+    }
+
+private:
+    void Run()
+    {
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this] { return m_stop || m_posted > 0; });
+                if (m_stop)
+                {
+                    return;
+                }
+            }
+
+            uint32_t item = 0;
+            if (m_queue.Pop(item, TestNow()))
+            {
+                m_handler(item);
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_posted;
+        }
+    }
+
+private:
+    TestQueue m_queue;
+    std::function<void(uint32_t)> m_handler;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    uint32_t m_posted;
+    bool m_stop;
+
+    std::thread m_worker;
+};
+
+TEST(PayloadQueueDropOldestKeepsTheNewest)
+{
+    TestQueue queue(4, PayloadQueuePolicy::DropOldest, std::chrono::milliseconds(0));
+
+    for (uint32_t i = 1; i <= 6; ++i)
+    {
+        auto result = queue.Push(std::move(i), 0);
+        CHECK(result == (i <= 4 ? TestQueue::PushResult::Queued : TestQueue::PushResult::Replaced));
+    }
+
+    for (uint32_t expected = 3; expected <= 6; ++expected)
+    {
+        uint32_t item = 0;
+        CHECK(queue.Pop(item, 0));
+        CHECK(item == expected);
+    }
+
+    uint32_t item = 0;
+    CHECK(!queue.Pop(item, 0));
+
+    TestQueue::Stats stats{};
+    queue.GetStats(&stats);
+    CHECK(stats.dropped == 2);
+    CHECK(stats.delivered == 4);
+    CHECK(stats.maxPending == 4);
+}
+
+TEST(PayloadQueueDropNewestKeepsTheOldest)
+{
+    TestQueue queue(4, PayloadQueuePolicy::DropNewest, std::chrono::milliseconds(0));
+
+    for (uint32_t i = 1; i <= 6; ++i)
+    {
+        auto result = queue.Push(std::move(i), 0);
+        CHECK(result == (i <= 4 ? TestQueue::PushResult::Queued : TestQueue::PushResult::Dropped));
+    }
+
+    for (uint32_t expected = 1; expected <= 4; ++expected)
+    {
+        uint32_t item = 0;
+        CHECK(queue.Pop(item, 0));
+        CHECK(item == expected);
+    }
+
+    TestQueue::Stats stats{};
+    queue.GetStats(&stats);
+    CHECK(stats.dropped == 2);
+}
+
+TEST(PayloadQueueMeasuresLagOnTheCallersClock)
+{
+    TestQueue queue(4, PayloadQueuePolicy::DropOldest, std::chrono::milliseconds(0));
+
+    queue.Push(1, 100);
+    queue.Push(2, 200);
+
+    uint32_t item = 0;
+    queue.Pop(item, 350);
+    queue.Pop(item, 250);
+
+    TestQueue::Stats stats{};
+    queue.GetStats(&stats);
+    CHECK(stats.lastLag == 50);
+    CHECK(stats.maxLag == 250);
+    CHECK(stats.totalLag == 300);
+    CHECK(stats.delivered == 2);
+    CHECK(stats.pending == 0);
+}
+
+TEST(PayloadQueueShutdownReleasesBlockedPush)
+{
+    TestQueue queue(1, PayloadQueuePolicy::Block, std::chrono::milliseconds(10000));
+    queue.Push(1, 0);
+
+    std::atomic<bool> returned = false;
+    std::thread pusher([&] { CHECK(queue.Push(2, 0) == TestQueue::PushResult::Shutdown); returned = true; });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!returned);
+
+    queue.Shutdown();
+    pusher.join();
+    CHECK(returned);
+}
+
+// the reason subscribers have queues: one that takes 20ms per payload, and one that blocks
+// until it is released, do not hold up one that keeps up, and the dispatcher is only ever
+// held up once by the blocked one
+TEST(PayloadQueueSlowSubscriberDoesNotDelayOthers)
+{
+    constexpr uint32_t c_payloads = 200;
+    constexpr auto c_interval = std::chrono::milliseconds(2);
+    constexpr auto c_maxBlockTime = std::chrono::milliseconds(100);
+
+    TestSubscriber fast(4, PayloadQueuePolicy::DropOldest, c_maxBlockTime, [](uint32_t) {});
+    TestSubscriber slow(4, PayloadQueuePolicy::DropOldest, c_maxBlockTime, [](uint32_t)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        });
+
+    std::mutex hungMutex;
+    std::condition_variable hungReleased;
+    bool released = false;
+    TestSubscriber hung(2, PayloadQueuePolicy::Block, c_maxBlockTime, [&](uint32_t)
+        {
+            std::unique_lock<std::mutex> lock(hungMutex);
+            hungReleased.wait(lock, [&] { return released; });
+        });
+
+    // the dispatcher, every subscriber in turn, like PayloadHandler::Invoke
+    std::vector<int64_t> dispatchTimes;
+    int64_t started = TestNow();
+    for (uint32_t i = 0; i < c_payloads; ++i)
+    {
+        int64_t start = TestNow();
+        fast.Enqueue(i);
+        slow.Enqueue(i);
+        hung.Enqueue(i);
+        dispatchTimes.push_back(TestNow() - start);
+
+        std::this_thread::sleep_for(c_interval);
+    }
+    int64_t elapsed = TestNow() - started;
+
+    fast.Drain();
+    auto fastStats = fast.Stats();
+
+    {
+        std::lock_guard<std::mutex> lock(hungMutex);
+        released = true;
+    }
+    hungReleased.notify_all();
+    hung.Drain();
+    slow.Drain();
+
+    auto slowStats = slow.Stats();
+    auto hungStats = hung.Stats();
+
+    printf("  fast: delivered %llu, dropped %llu, max lag %.2fms\n",
+        static_cast<unsigned long long>(fastStats.delivered), static_cast<unsigned long long>(fastStats.dropped), fastStats.maxLag / 10000.0);
+    printf("  slow: delivered %llu, dropped %llu, max lag %.2fms\n",
+        static_cast<unsigned long long>(slowStats.delivered), static_cast<unsigned long long>(slowStats.dropped), slowStats.maxLag / 10000.0);
+    printf("  hung: delivered %llu, dropped %llu, stalls %llu\n",
+        static_cast<unsigned long long>(hungStats.delivered), static_cast<unsigned long long>(hungStats.dropped), static_cast<unsigned long long>(hungStats.stalls));
+
+    // the fast subscriber got everything, promptly. its lag is scheduling noise, far from
+    // the 20ms the slow one takes per payload
+    CHECK(fastStats.delivered == c_payloads);
+    CHECK(fastStats.dropped == 0);
+    CHECK(fastStats.maxLag < 150000);
+
+    // the slow one fell behind and lost payloads instead of growing
+    CHECK(slowStats.dropped > 0);
+    CHECK(slowStats.delivered + slowStats.dropped == c_payloads);
+    CHECK(slowStats.maxPending <= 4);
+
+    // the hung one stalled the dispatcher once, for about the block time, after that its
+    // payloads were dropped without waiting
+    CHECK(hungStats.stalls == 1);
+    CHECK(hungStats.dropped > 0);
+
+    std::sort(dispatchTimes.begin(), dispatchTimes.end());
+    CHECK(dispatchTimes.back() >= c_maxBlockTime.count() * 10000 * 9 / 10);
+    CHECK(dispatchTimes[dispatchTimes.size() - 2] < c_maxBlockTime.count() * 10000 / 2);
+
+    // and the whole run took about what pacing and that one stall add up to
+    int64_t expected = (c_interval.count() * c_payloads + c_maxBlockTime.count()) * 10000;
+    CHECK(elapsed < expected * 2);
+}
@@ -0,0 +1,229 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Media.SnapshotEncoder.h"
+
+#include <mfapi.h>
+#include <mferror.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// the SnapshotEncoder pool with the wic step swapped for a stub, what the capture thread
+// pays per Queue() and how many snapshots a second 1 to 8 workers get through
+namespace
+{
+    int64_t Ticks()
+    {
+        LARGE_INTEGER counter{};
+        QueryPerformanceCounter(&counter);
+        return counter.QuadPart;
+    }
+
+    double TicksToNs(int64_t ticks)
+    {
+        LARGE_INTEGER frequency{};
+        QueryPerformanceFrequency(&frequency);
+        return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+    }
+
+    // a bgra frame in a plain memory buffer, every pixel is its row number
+    winrt::com_ptr<IMFSample> CreateFrame(uint32_t width, uint32_t height)
+    {
+        DWORD size = width * height * 4;
+
+        winrt::com_ptr<IMFMediaBuffer> buffer = nullptr;
+        MFCreateMemoryBuffer(size, buffer.put());
+
+        BYTE* data = nullptr;
+        buffer->Lock(&data, nullptr, nullptr);
+        for (uint32_t row = 0; row < height; ++row)
+        {
+            memset(data + row * width * 4, static_cast<int>(row & 0xff), width * 4);
+        }
+        buffer->Unlock();
+        buffer->SetCurrentLength(size);
+
+        winrt::com_ptr<IMFSample> sample = nullptr;
+        MFCreateSample(sample.put());
+        sample->AddBuffer(buffer.get());
+
+        return sample;
+    }
+
+    // reads every byte like an encoder would, then waits in place of the file write
+    struct StubWriter : SnapshotWriter
+    {
+        StubWriter(uint32_t writeMs) : m_writeMs(writeMs) {}
+
+        HRESULT Write(
+            uint8_t const* pixels,
+            uint32_t width,
+            uint32_t height,
+            std::wstring const&,
+            SnapshotFormat) override
+        {
+            uint64_t sum = 0;
+            for (size_t i = 0, size = static_cast<size_t>(width) * height * 4; i < size; i += 4)
+            {
+                sum += pixels[i];
+            }
+            checksum += sum;
+
+            Sleep(m_writeMs);
+
+            return S_OK;
+        }
+
+        static std::atomic<uint64_t> checksum;
+
+    private:
+        uint32_t m_writeMs;
+    };
+
+    std::atomic<uint64_t> StubWriter::checksum = 0;
+
+    // Write() waits until the test lets it go, so jobs can be held in the pool
+    struct GatedWriter : SnapshotWriter
+    {
+        HRESULT Write(
+            uint8_t const* pixels,
+            uint32_t width,
+            uint32_t height,
+            std::wstring const& path,
+            SnapshotFormat) override
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            open.wait(lock, [] { return isOpen; });
+
+            // the copy is packed and in order
+            return (pixels[0] == 0 && pixels[(height - 1) * width * 4] == static_cast<uint8_t>(height - 1) && path == L"ok") ? S_OK : E_FAIL;
+        }
+
+        static void Open()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isOpen = true;
+            open.notify_all();
+        }
+
+        static std::mutex mutex;
+        static std::condition_variable open;
+        static bool isOpen;
+    };
+
+    std::mutex GatedWriter::mutex;
+    std::condition_variable GatedWriter::open;
+    bool GatedWriter::isOpen = false;
+}
+
+TEST(SnapshotEncoderBoundsOutstandingFrames)
+{
+    auto frame = CreateFrame(64, 48);
+
+    std::mutex mutex;
+    std::vector<std::pair<uint32_t, HRESULT>> completed;
+
+    auto encoder = std::make_shared<SnapshotEncoder>();
+    CHECK(SUCCEEDED(encoder->Initialize(
+        1,
+        2,
+        [] { return std::unique_ptr<SnapshotWriter>(new GatedWriter()); },
+        [&](uint32_t requestId, HRESULT hr)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            completed.emplace_back(requestId, hr);
+        })));
+
+    // a buffer per outstanding job, the third waits on nothing and is turned away
+    CHECK(SUCCEEDED(encoder->Queue(frame.get(), 64, 48, L"ok", SnapshotFormat::Jpeg, 1)));
+    CHECK(SUCCEEDED(encoder->Queue(frame.get(), 64, 48, L"ok", SnapshotFormat::Png, 2)));
+    CHECK(encoder->Queue(frame.get(), 64, 48, L"ok", SnapshotFormat::Jpeg, 3) == MF_E_NOTACCEPTING);
+
+    GatedWriter::Open();
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (completed.size() == 2)
+            {
+                break;
+            }
+        }
+        std::this_thread::yield();
+    }
+
+    // a frame larger than the sample holds fails without keeping the buffer
+    CHECK(encoder->Queue(frame.get(), 64, 64, L"ok", SnapshotFormat::Jpeg, 4) == MF_E_BUFFERTOOSMALL);
+    CHECK(SUCCEEDED(encoder->Queue(frame.get(), 64, 48, L"ok", SnapshotFormat::Jpeg, 5)));
+
+    // queued jobs are still written before the workers exit
+    encoder->Shutdown();
+    CHECK(encoder->Queue(frame.get(), 64, 48, L"ok", SnapshotFormat::Jpeg, 6) == MF_E_SHUTDOWN);
+
+    CHECK(completed.size() == 3);
+    CHECK(completed[0] == std::make_pair(1u, S_OK));
+    CHECK(completed[1] == std::make_pair(2u, S_OK));
+    CHECK(completed[2] == std::make_pair(5u, S_OK));
+}
+
+BENCHMARK(SnapshotEncoderWorkers)
+{
+    constexpr uint32_t c_width = 1920;
+    constexpr uint32_t c_height = 1080;
+    constexpr uint32_t c_snapshots = 48;
+    constexpr uint32_t c_buffers = 8;
+    constexpr uint32_t c_writeMs = 8;
+
+    auto frame = CreateFrame(c_width, c_height);
+
+    for (uint32_t workerCount : { 1u, 2u, 4u, 8u })
+    {
+        std::atomic<uint32_t> completed = 0;
+
+        auto encoder = std::make_shared<SnapshotEncoder>();
+        encoder->Initialize(
+            workerCount,
+            c_buffers,
+            [] { return std::unique_ptr<SnapshotWriter>(new StubWriter(c_writeMs)); },
+            [&](uint32_t, HRESULT) { ++completed; });
+
+        // the capture thread's side, a full pool is retried a millisecond later, only the
+        // calls that took a frame are timed, that's the copy the capture thread pays for
+        uint32_t rejected = 0;
+        int64_t queueTicks = 0;
+        int64_t start = Ticks();
+        for (uint32_t i = 0; i < c_snapshots; )
+        {
+            int64_t queueStart = Ticks();
+            HRESULT hr = encoder->Queue(frame.get(), c_width, c_height, L"bench", SnapshotFormat::Jpeg, i);
+            if (hr == MF_E_NOTACCEPTING)
+            {
+                ++rejected;
+                Sleep(1);
+                continue;
+            }
+            queueTicks += Ticks() - queueStart;
+
+            CHECK(SUCCEEDED(hr));
+            ++i;
+        }
+
+        while (completed < c_snapshots)
+        {
+            std::this_thread::yield();
+        }
+        int64_t elapsed = Ticks() - start;
+
+        encoder->Shutdown();
+
+        printf("  %u workers   %6.1f snapshots/s   Queue() %7.1f us   %u retries\n",
+            workerCount,
+            c_snapshots * 1e9 / TicksToNs(elapsed),
+            TicksToNs(queueTicks) / 1000.0 / c_snapshots,
+            rejected);
+    }
+}
@@ -21,6 +21,8 @@ namespace CameraCapture
             None = 0,
             Failed,
             Capture,
+            Snapshot,
+            FrameRate,
         };
 
         internal enum CaptureStateType : Int32
@@ -33,6 +35,21 @@ namespace CameraCapture
             PhotoFrame,
         };
 
+        internal enum SnapshotFormat : Int32
+        {
+            Jpeg = 0,
+            Png,
+        };
+
+        internal enum LogLevel : Int32
+        {
+            Verbose = 0,
+            Info,
+            Warning,
+            Error,
+            None,
+        };
+
         [StructLayout(LayoutKind.Sequential)]
         internal struct FailedState
         {
@@ -46,6 +63,42 @@ namespace CameraCapture
             }
         };
 
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct SnapshotState
+        {
+            public UInt32 requestId;
+            public Int32 HResult;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("requestId: " + requestId);
+                sb.AppendLine("HResult: 0x" + HResult.ToString("X", System.Globalization.NumberFormatInfo.InvariantInfo));
+                return sb.ToString();
+            }
+        };
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct FrameRateState
+        {
+            public Single negotiatedFps;
+            public Single measuredFps;
+            public Single jitterMs;
+            public UInt32 sampleCount;
+            public Int32 belowNegotiated;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("negotiatedFps: " + negotiatedFps);
+                sb.AppendLine("measuredFps: " + measuredFps);
+                sb.AppendLine("jitterMs: " + jitterMs);
+                sb.AppendLine("sampleCount: " + sampleCount);
+                sb.AppendLine("belowNegotiated: " + (belowNegotiated != 0));
+                return sb.ToString();
+            }
+        };
+
         [StructLayout(LayoutKind.Sequential)]
         internal struct CaptureState
         {
@@ -55,6 +108,7 @@ namespace CameraCapture
             public IntPtr imgTexture;
             public SpatialTranformHelper.Matrix4x4 cameraWorld;
             public SpatialTranformHelper.Matrix4x4 cameraProjection;
+            public UInt32 frameSequence;
 
             public override string ToString()
             {
@@ -63,6 +117,118 @@ namespace CameraCapture
                 sb.AppendLine("width: " + width);
                 sb.AppendLine("height: " + height);
                 sb.AppendLine("imgTexture: " + imgTexture);
+                sb.AppendLine("frameSequence: " + frameSequence);
+                return sb.ToString();
+            }
+        }
+
+        [Flags]
+        internal enum FrameMetadataFlags : UInt32
+        {
+            None = 0,
+            Intrinsics = 0x01,
+            Extrinsics = 0x02,
+            DeviceTimestamp = 0x04,
+            Exposure = 0x08,
+            Iso = 0x10,
+        };
+
+        // kept blittable so a bulk fetch is a straight copy
+        [StructLayout(LayoutKind.Sequential, Pack = 4)]
+        internal struct FrameMetadata
+        {
+            public UInt32 sequence;
+            public FrameMetadataFlags flags;
+            public Int64 timestamp;
+            public Int64 deviceTimestamp;
+            public UInt32 width;
+            public UInt32 height;
+            public Single focalLengthX;
+            public Single focalLengthY;
+            public Single principalPointX;
+            public Single principalPointY;
+            public Single radialK1;
+            public Single radialK2;
+            public Single radialK3;
+            public Single tangentialP1;
+            public Single tangentialP2;
+            public Guid calibrationId;
+            public Single positionX;
+            public Single positionY;
+            public Single positionZ;
+            public Single orientationX;
+            public Single orientationY;
+            public Single orientationZ;
+            public Single orientationW;
+            public Int64 exposureTime;
+            public UInt32 iso;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("sequence: " + sequence);
+                sb.AppendLine("flags: " + flags);
+                sb.AppendLine("timestamp: " + timestamp);
+                sb.AppendLine("size: " + width + "x" + height);
+                sb.AppendLine("exposureTime: " + exposureTime);
+                sb.AppendLine("iso: " + iso);
+                return sb.ToString();
+            }
+        }
+
+        internal const Int32 AudioLevelMaxChannels = 8;
+
+        [StructLayout(LayoutKind.Sequential, Pack = 4)]
+        internal struct AudioLevelState
+        {
+            public Int64 timestamp;
+            public UInt32 sequence;
+            public UInt32 channelCount;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = AudioLevelMaxChannels)]
+            public Single[] rms;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = AudioLevelMaxChannels)]
+            public Single[] peak;
+            public Single energyDb;
+            public Single noiseFloorDb;
+            public Single zeroCrossingRate;
+            [MarshalAs(UnmanagedType.Bool)]
+            public Boolean voiceActive;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("sequence: " + sequence);
+                sb.AppendLine("channelCount: " + channelCount);
+                sb.AppendLine("energyDb: " + energyDb);
+                sb.AppendLine("noiseFloorDb: " + noiseFloorDb);
+                sb.AppendLine("voiceActive: " + voiceActive);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential, Pack = 4)]
+        internal struct PayloadSubscriberStats
+        {
+            public UInt32 id;
+            public UInt32 queueDepth;
+            public UInt32 pending;
+            public UInt32 maxPending;
+            public UInt64 delivered;
+            public UInt64 dropped;
+            public Int64 lastLag;
+            public Int64 maxLag;
+            public Int64 averageLag;
+            public UInt64 stalls;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("id: " + id);
+                sb.AppendLine("pending: " + pending + "/" + queueDepth);
+                sb.AppendLine("delivered: " + delivered);
+                sb.AppendLine("dropped: " + dropped);
+                sb.AppendLine("averageLag: " + averageLag);
+                sb.AppendLine("stalls: " + stalls);
                 return sb.ToString();
             }
         }
@@ -78,6 +244,12 @@ namespace CameraCapture
 
             [FieldOffset(4)]
             public CaptureState CaptureState;
+
+            [FieldOffset(4)]
+            public SnapshotState SnapshotState;
+
+            [FieldOffset(4)]
+            public FrameRateState FrameRateState;
         };
 
         [UnmanagedFunctionPointer(CallingConvention.StdCall)]
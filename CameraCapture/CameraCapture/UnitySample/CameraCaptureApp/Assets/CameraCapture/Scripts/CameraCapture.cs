@@ -33,6 +33,12 @@ namespace CameraCapture
         TaskCompletionSource<Wrapper.CaptureState> stopCompletionSource = null;
         TaskCompletionSource<Wrapper.CaptureState> photoCompletionSource = null;
 
+        // raised on the app thread once a SaveSnapshot file is written or has failed
+        internal event Action<Wrapper.SnapshotState> SnapshotCompleted;
+
+        // raised on the app thread when delivery drops under, or recovers to, the negotiated rate
+        internal event Action<Wrapper.FrameRateState> FrameRateChanged;
+
         private const string takePhoto = "take photo";
         private const string startPreview = "start preview";
         private const string stopPreveiw = "stop preview";
@@ -170,6 +176,24 @@ namespace CameraCapture
                         break;
                 }
             }
+            else if (type == Wrapper.CallbackType.Snapshot)
+            {
+                if (args.SnapshotState.HResult != 0)
+                {
+                    Debug.LogWarning("Snapshot failed: " + args.SnapshotState.ToString());
+                }
+
+                SnapshotCompleted?.Invoke(args.SnapshotState);
+            }
+            else if (type == Wrapper.CallbackType.FrameRate)
+            {
+                if (args.FrameRateState.belowNegotiated != 0)
+                {
+                    Debug.LogWarning("Camera is delivering " + args.FrameRateState.measuredFps + " fps, negotiated " + args.FrameRateState.negotiatedFps + " fps");
+                }
+
+                FrameRateChanged?.Invoke(args.FrameRateState);
+            }
         }
 
         protected override void OnFailed(Wrapper.FailedState args)
@@ -279,6 +303,132 @@ namespace CameraCapture
             await TakePhotoAsync(Width, Height, true, true);
         }
 
+        public bool GetAudioLevels(out Wrapper.AudioLevelState levels)
+        {
+            return CheckHR(Native.GetAudioLevels(instanceId, out levels)) == 0;
+        }
+
+        public bool SetVoiceActivityParameters(float thresholdDb, UInt32 hangoverMs)
+        {
+            return CheckHR(Native.SetVoiceActivityParameters(instanceId, thresholdDb, hangoverMs)) == 0;
+        }
+
+        public bool EnableAudioFrames(bool enable)
+        {
+            return CheckHR(Native.EnableAudioFrames(instanceId, enable)) == 0;
+        }
+
+        // used by the next StartPreview, 0 leaves that end open, the highest rate in range is preferred
+        public bool SetFrameRateRange(float minFps, float maxFps)
+        {
+            return CheckHR(Native.SetFrameRateRange(instanceId, minFps, maxFps)) == 0;
+        }
+
+        public bool GetFrameRate(out Wrapper.FrameRateState frameRate)
+        {
+            return CheckHR(Native.GetFrameRate(instanceId, out frameRate)) == 0;
+        }
+
+        public Wrapper.PayloadSubscriberStats[] GetSubscriberStats()
+        {
+            UInt32 count = 0;
+            if (CheckHR(Native.GetSubscriberStats(instanceId, null, ref count)) != 0 || count == 0)
+            {
+                return new Wrapper.PayloadSubscriberStats[0];
+            }
+
+            var stats = new Wrapper.PayloadSubscriberStats[count];
+            if (CheckHR(Native.GetSubscriberStats(instanceId, stats, ref count)) != 0)
+            {
+                return new Wrapper.PayloadSubscriberStats[0];
+            }
+
+            return stats;
+        }
+
+        // metadata for every video frame still held, starting at firstSequence,
+        // CaptureState.frameSequence identifies the frame a callback is for
+        public Wrapper.FrameMetadata[] GetFrameMetadata(UInt32 firstSequence)
+        {
+            UInt32 count = 0;
+            if (CheckHR(Native.GetFrameMetadata(instanceId, firstSequence, null, ref count)) != 0 || count == 0)
+            {
+                return new Wrapper.FrameMetadata[0];
+            }
+
+            var records = new Wrapper.FrameMetadata[count];
+            if (CheckHR(Native.GetFrameMetadata(instanceId, firstSequence, records, ref count)) != 0)
+            {
+                return new Wrapper.FrameMetadata[0];
+            }
+
+            if (count < records.Length)
+            {
+                Array.Resize(ref records, (int)count);
+            }
+
+            return records;
+        }
+
+        // the next preview frame is written to path in the background, returns the id
+        // SnapshotCompleted reports back with, 0 if the request was rejected
+        public UInt32 SaveSnapshot(string path, Wrapper.SnapshotFormat format)
+        {
+            UInt32 requestId = 0;
+            if (CheckHR(Native.SaveSnapshot(instanceId, path, format, out requestId)) != 0)
+            {
+                return 0;
+            }
+
+            return requestId;
+        }
+
+        // json snapshot of the pipeline counters, gauges and histograms
+        public string GetMetrics()
+        {
+            UInt32 size = 0;
+            if (CheckHR(Native.GetMetrics(instanceId, null, ref size)) != 0 || size == 0)
+            {
+                return string.Empty;
+            }
+
+            var buffer = new byte[size];
+            if (CheckHR(Native.GetMetrics(instanceId, buffer, ref size)) != 0)
+            {
+                return string.Empty;
+            }
+
+            return System.Text.Encoding.UTF8.GetString(buffer, 0, (int)size - 1);
+        }
+
+        public static bool SetLogLevel(Wrapper.LogLevel level)
+        {
+            return CheckHR(Native.SetLogLevel(level)) == 0;
+        }
+
+        public static bool SetLogFile(string path)
+        {
+            return CheckHR(Native.SetLogFile(path)) == 0;
+        }
+
+        // only available when the plugin is built with CRITICAL_SECTION_PROFILING
+        public static string GetLockReport(bool reset)
+        {
+            UInt32 size = 0;
+            if (Native.GetLockReport(null, ref size, false) != 0 || size == 0)
+            {
+                return string.Empty;
+            }
+
+            var buffer = new byte[size];
+            if (CheckHR(Native.GetLockReport(buffer, ref size, reset)) != 0)
+            {
+                return string.Empty;
+            }
+
+            return System.Text.Encoding.UTF8.GetString(buffer, 0, (int)size - 1);
+        }
+
         public async Task<bool> StartPreviewAsync(int width, int height, bool enableAudio, bool useMrc)
         {
             startPreviewCompletionSource?.TrySetCanceled();
@@ -452,6 +602,42 @@ namespace CameraCapture
 
             [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureTakePhoto")]
             internal static extern Int32 TakePhoto(Int32 instanceId, UInt32 width, UInt32 height, [MarshalAs(UnmanagedType.I1)]Boolean enableMrc);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureGetAudioLevels")]
+            internal static extern Int32 GetAudioLevels(Int32 instanceId, out Wrapper.AudioLevelState levels);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureSetVoiceActivityParameters")]
+            internal static extern Int32 SetVoiceActivityParameters(Int32 instanceId, Single thresholdDb, UInt32 hangoverMs);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureEnableAudioFrames")]
+            internal static extern Int32 EnableAudioFrames(Int32 instanceId, [MarshalAs(UnmanagedType.I1)]Boolean enable);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureGetSubscriberStats")]
+            internal static extern Int32 GetSubscriberStats(Int32 instanceId, [In, Out] Wrapper.PayloadSubscriberStats[] stats, ref UInt32 count);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureGetMetrics")]
+            internal static extern Int32 GetMetrics(Int32 instanceId, [In, Out] byte[] buffer, ref UInt32 size);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureGetFrameMetadata")]
+            internal static extern Int32 GetFrameMetadata(Int32 instanceId, UInt32 firstSequence, [In, Out] Wrapper.FrameMetadata[] records, ref UInt32 count);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureSaveSnapshot")]
+            internal static extern Int32 SaveSnapshot(Int32 instanceId, [MarshalAs(UnmanagedType.LPWStr)]string path, Wrapper.SnapshotFormat format, out UInt32 requestId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureSetFrameRateRange")]
+            internal static extern Int32 SetFrameRateRange(Int32 instanceId, Single minFps, Single maxFps);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureGetFrameRate")]
+            internal static extern Int32 GetFrameRate(Int32 instanceId, out Wrapper.FrameRateState frameRate);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureSetLogLevel")]
+            internal static extern Int32 SetLogLevel(Wrapper.LogLevel level);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureSetLogFile")]
+            internal static extern Int32 SetLogFile([MarshalAs(UnmanagedType.LPWStr)]string path);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CaptureGetLockReport")]
+            internal static extern Int32 GetLockReport([In, Out] byte[] buffer, ref UInt32 size, [MarshalAs(UnmanagedType.I1)]Boolean reset);
         }
     }
 }
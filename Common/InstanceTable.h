@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <vector>
+
+// the plugin's live modules by the handle unity holds. the render thread looks one up for
+// every plugin event while the main thread creates and releases them, so a lookup takes no
+// lock: it joins the slot's reader count if the slot still holds the handle's generation,
+// copies the module out and leaves. Add and Remove are serialized among themselves, Remove
+// waits for the readers of its slot before it lets go of the module
+//
+// a handle is INSTANCE_HANDLE_START + generation * Capacity + slot. unity packs it into the
+// low word of the render event, so the generations are bounded to keep it below 0x10000.
+// every Remove moves the slot to the next generation, a stale handle fails the lookup until
+// its slot has been reused Generations times
+//
+// shared by every plugin, INSTANCE_HANDLE, the IFR macros and winrt::slim_mutex come from
+// the including plugin's pch.h
+template <typename TModule, uint32_t Capacity = 128>
+class InstanceTable
+{
+public:
+    static constexpr uint32_t Generations = (0x10000 - INSTANCE_HANDLE_START) / Capacity;
+
+    static_assert(Generations > 1, "too many slots to tell a reused slot apart");
+
+    InstanceTable()
+    {
+        for (uint32_t index = 0; index < Capacity; ++index)
+        {
+            m_slots[index].state.store(0, std::memory_order_relaxed);
+            m_free.push_back(index);
+        }
+    }
+
+    HRESULT Add(_In_ TModule const& module, _Out_ INSTANCE_HANDLE* handle)
+    {
+        NULL_CHK_HR(handle, E_INVALIDARG);
+        NULL_CHK_HR(module, E_INVALIDARG);
+
+        *handle = INSTANCE_HANDLE_INVALID;
+
+        std::lock_guard<winrt::slim_mutex> guard(m_writerMutex);
+
+        if (m_free.empty())
+        {
+            IFR(HRESULT_FROM_WIN32(ERROR_NO_MORE_ITEMS));
+        }
+
+        uint32_t index = m_free.front();
+        m_free.pop_front();
+
+        // nobody reads a closed slot, the module is in place before the slot opens
+        Slot& slot = m_slots[index];
+        slot.module = module;
+
+        uint64_t sequence = (slot.state.load(std::memory_order_relaxed) >> 32) + 1;
+        slot.state.store(sequence << 32, std::memory_order_release);
+
+        *handle = static_cast<INSTANCE_HANDLE>(INSTANCE_HANDLE_START + Generation(sequence) * Capacity + index);
+
+        return S_OK;
+    }
+
+    HRESULT Get(_In_ INSTANCE_HANDLE handle, _Out_ TModule& module)
+    {
+        module = nullptr;
+
+        uint32_t index = 0;
+        uint32_t generation = 0;
+        IFR(Decode(handle, &index, &generation));
+
+        Slot& slot = m_slots[index];
+
+        uint64_t state = slot.state.load(std::memory_order_acquire);
+        do
+        {
+            if (!Matches(state, generation))
+            {
+                IFR(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+            }
+        } while (!slot.state.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_acquire));
+
+        module = slot.module;
+
+        slot.state.fetch_sub(1, std::memory_order_release);
+
+        NULL_CHK_HR(module, E_POINTER);
+
+        return S_OK;
+    }
+
+    // the module is handed back so its Shutdown runs outside the table
+    HRESULT Remove(_In_ INSTANCE_HANDLE handle, _Out_ TModule& module)
+    {
+        module = nullptr;
+
+        uint32_t index = 0;
+        uint32_t generation = 0;
+        IFR(Decode(handle, &index, &generation));
+
+        std::lock_guard<winrt::slim_mutex> guard(m_writerMutex);
+
+        Slot& slot = m_slots[index];
+
+        uint64_t state = slot.state.load(std::memory_order_relaxed);
+        do
+        {
+            if (!Matches(state, generation))
+            {
+                IFR(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+            }
+        } while (!slot.state.compare_exchange_weak(state, state + (1ull << 32), std::memory_order_relaxed));
+
+        Close(index, module);
+
+        return S_OK;
+    }
+
+    // every live module, the table is empty afterwards
+    std::vector<TModule> Clear()
+    {
+        std::vector<TModule> modules;
+
+        std::lock_guard<winrt::slim_mutex> guard(m_writerMutex);
+
+        for (uint32_t index = 0; index < Capacity; ++index)
+        {
+            Slot& slot = m_slots[index];
+
+            uint64_t state = slot.state.load(std::memory_order_relaxed);
+            if (((state >> 32) & 1) == 0)
+            {
+                continue;
+            }
+
+            slot.state.fetch_add(1ull << 32, std::memory_order_relaxed);
+
+            TModule module = nullptr;
+            Close(index, module);
+
+            modules.push_back(std::move(module));
+        }
+
+        return modules;
+    }
+
+private:
+    // the high half counts opens and closes, odd while the slot is live, the low half is
+    // the number of lookups copying the module right now
+    struct Slot
+    {
+        std::atomic<uint64_t> state;
+        TModule module{ nullptr };
+    };
+
+    static uint32_t Generation(_In_ uint64_t sequence)
+    {
+        return static_cast<uint32_t>((sequence >> 1) % Generations);
+    }
+
+    static bool Matches(_In_ uint64_t state, _In_ uint32_t generation)
+    {
+        uint64_t sequence = state >> 32;
+
+        return (sequence & 1) != 0 && Generation(sequence) == generation;
+    }
+
+    static HRESULT Decode(_In_ INSTANCE_HANDLE handle, _Out_ uint32_t* index, _Out_ uint32_t* generation)
+    {
+        if (handle < INSTANCE_HANDLE_START || handle >= static_cast<INSTANCE_HANDLE>(INSTANCE_HANDLE_START + Generations * Capacity))
+        {
+            IFR(E_INVALIDARG);
+        }
+
+        uint32_t value = static_cast<uint32_t>(handle - INSTANCE_HANDLE_START);
+        *index = value % Capacity;
+        *generation = value / Capacity;
+
+        return S_OK;
+    }
+
+    // the slot is already closed to new lookups, the ones inside only copy the module
+    void Close(_In_ uint32_t index, _Out_ TModule& module)
+    {
+        Slot& slot = m_slots[index];
+
+        while ((slot.state.load(std::memory_order_acquire) & 0xffffffff) != 0)
+        {
+            std::this_thread::yield();
+        }
+
+        module = std::move(slot.module);
+        slot.module = nullptr;
+
+        m_free.push_back(index);
+    }
+
+    std::array<Slot, Capacity> m_slots;
+
+    winrt::slim_mutex m_writerMutex;
+    std::deque<uint32_t> m_free;   // oldest release first, a slot rests as long as it can
+};
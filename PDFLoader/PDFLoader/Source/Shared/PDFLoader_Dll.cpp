@@ -6,6 +6,7 @@
 #include "Unity/IUnityGraphics.h"
 #include "PlatformBase.h"
 #include "UnityDeviceResource.h"
+#include "InstanceTable.h"
 
 #include "Plugin.PdfLoader.h"
 
@@ -19,26 +20,11 @@ namespace winrt
     using namespace winrt::PDFLoader::Plugin;
 }
 
-static INSTANCE_HANDLE s_lastPluginHandleIndex = INSTANCE_HANDLE_INVALID;
-static std::unordered_map<INSTANCE_HANDLE, winrt::IModule> s_instances;
+// looked up from the render thread as well, see InstanceTable
+static InstanceTable<winrt::IModule> s_instances;
 HRESULT GetModule(INSTANCE_HANDLE id, _Out_ winrt::IModule& module)
 {
-    if (id < INSTANCE_HANDLE_START)
-    {
-        IFR(E_INVALIDARG);
-    }
-
-    auto it = s_instances.find(id);
-    if (it == s_instances.end())
-    {
-        IFR(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
-    }
-
-    module = it->second;
-
-    NULL_CHK_HR(module, E_POINTER);
-
-    return S_OK;
+    return s_instances.Get(id, module);
 }
 
 static std::shared_ptr<IUnityDeviceResource> s_deviceResource;
@@ -48,18 +34,7 @@ static IUnityGraphics* s_unityGraphics = nullptr;
 
 HRESULT TrackModule(winrt::IModule &module, INSTANCE_HANDLE * handleId)
 {
-    // get the last index value;
-    auto handle = s_lastPluginHandleIndex;
-
-    // add to map
-    auto success = s_instances.emplace(handle, module);
-    if (success.second)
-    {
-        *handleId = handle++;
-        s_lastPluginHandleIndex = handle;
-    }
-
-    return (success.second ? S_OK : E_UNEXPECTED);
+    return s_instances.Add(module, handleId);
 }
 
 // --------------------------------------------------------------------------
@@ -68,9 +43,6 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 
 extern "C" void	UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
 {
-    s_lastPluginHandleIndex = INSTANCE_HANDLE_START;
-    s_instances.clear();
-
     s_unityInterfaces = unityInterfaces;
     s_unityGraphics = s_unityInterfaces->Get<IUnityGraphics>();
     s_unityGraphics->RegisterDeviceEventCallback(OnGraphicsDeviceEvent);
@@ -81,14 +53,11 @@ extern "C" void	UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnit
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
-    for (auto&& kv : s_instances)
+    for (auto&& module : s_instances.Clear())
     {
-        kv.second.Shutdown();
-        kv.second = nullptr;
+        module.Shutdown();
+        module = nullptr;
     }
-    s_instances.clear();
-
-    s_lastPluginHandleIndex = INSTANCE_HANDLE_INVALID;
 
     s_unityGraphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
 }
@@ -157,9 +126,8 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseInstance(
     _In_ INSTANCE_HANDLE id)
 {
     winrt::IModule module = nullptr;
-    if (SUCCEEDED(GetModule(id, module)))
+    if (SUCCEEDED(s_instances.Remove(id, module)))
     {
-        s_instances.erase(id);
         module.Shutdown();
         module = nullptr;
     }
@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "AdaptiveResolution.h"
+
+#include <algorithm>
+
+// a step up this many windows before stepping down again did not hold
+static constexpr uint32_t c_failedStepUpWindows = 2;
+
+AdaptiveResolution::Settings AdaptiveResolution::DefaultSettings()
+{
+    Settings settings{};
+    settings.window = 5000000;      // 0.5s
+    settings.minWindowFrames = 8;
+    settings.copyHigh = 80000;      // half a 60Hz frame
+    settings.copyLow = 30000;
+    settings.lostHigh = 0.1f;
+    settings.lostLow = 0.02f;
+    settings.calmWindows = 4;
+    settings.maxCalmWindows = 32;
+
+    return settings;
+}
+
+AdaptiveResolution::AdaptiveResolution()
+{
+    Reset(std::vector<float>{ 1.0f }, DefaultSettings());
+}
+
+_Use_decl_annotations_
+void AdaptiveResolution::Reset(
+    std::vector<float> const& scales,
+    Settings const& settings)
+{
+    m_scales = scales.empty() ? std::vector<float>{ 1.0f } : scales;
+    m_settings = settings;
+    m_level = 0;
+
+    m_calmWindows = 0;
+    m_calmNeeded = std::max<uint32_t>(1, settings.calmWindows);
+    m_windowsSinceUp = UINT32_MAX;
+
+    StartWindow(0, 0);
+}
+
+_Use_decl_annotations_
+bool AdaptiveResolution::OnFrame(
+    int64_t systemTime,
+    int64_t copyTime,
+    uint64_t lost)
+{
+    if (m_scales.size() < 2)
+    {
+        return false;
+    }
+
+    // the first frame after a reset only opens the window
+    if (m_windowStart == 0 || lost < m_windowLostStart)
+    {
+        StartWindow(systemTime, lost);
+
+        return false;
+    }
+
+    ++m_windowFrames;
+    if (copyTime >= 0)
+    {
+        ++m_windowCopies;
+        m_windowCopyTime += copyTime;
+    }
+    else
+    {
+        ++m_windowFailures;
+    }
+
+    if (systemTime - m_windowStart < m_settings.window || m_windowFrames < m_settings.minWindowFrames)
+    {
+        return false;
+    }
+
+    int64_t copyAverage = m_windowCopies > 0 ? m_windowCopyTime / m_windowCopies : 0;
+    float lostRate = static_cast<float>(lost - m_windowLostStart + m_windowFailures) / m_windowFrames;
+
+    StartWindow(systemTime, lost);
+
+    if (m_windowsSinceUp != UINT32_MAX)
+    {
+        ++m_windowsSinceUp;
+    }
+
+    bool pressure = copyAverage > m_settings.copyHigh || lostRate > m_settings.lostHigh;
+    if (pressure)
+    {
+        m_calmWindows = 0;
+
+        if (m_level + 1 >= m_scales.size())
+        {
+            return false;
+        }
+
+        if (m_windowsSinceUp <= c_failedStepUpWindows)
+        {
+            m_calmNeeded = std::min(m_calmNeeded * 2, std::max(m_settings.maxCalmWindows, m_settings.calmWindows));
+        }
+
+        ++m_level;
+        m_windowsSinceUp = UINT32_MAX;
+
+        return true;
+    }
+
+    // held at this size long enough, the back off is forgiven
+    if (m_windowsSinceUp != UINT32_MAX && m_windowsSinceUp >= m_settings.maxCalmWindows)
+    {
+        m_calmNeeded = std::max<uint32_t>(1, m_settings.calmWindows);
+        m_windowsSinceUp = UINT32_MAX;
+    }
+
+    if (m_level == 0)
+    {
+        return false;
+    }
+
+    // the copy scales with the pixel count, what it would cost one level up
+    float ratio = m_scales[m_level - 1] / m_scales[m_level];
+    int64_t copyAbove = static_cast<int64_t>(copyAverage * ratio * ratio);
+
+    bool calm = copyAbove <= m_settings.copyLow && lostRate <= m_settings.lostLow;
+    if (!calm)
+    {
+        m_calmWindows = 0;
+
+        return false;
+    }
+
+    if (++m_calmWindows < m_calmNeeded)
+    {
+        return false;
+    }
+
+    --m_level;
+    m_calmWindows = 0;
+    m_windowsSinceUp = 0;
+
+    return true;
+}
+
+_Use_decl_annotations_
+void AdaptiveResolution::StartWindow(
+    int64_t systemTime,
+    uint64_t lost)
+{
+    m_windowStart = systemTime;
+    m_windowLostStart = lost;
+    m_windowFrames = 0;
+    m_windowCopies = 0;
+    m_windowFailures = 0;
+    m_windowCopyTime = 0;
+}
@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "FrameRing.h"
+
+#include <vector>
+
+// picks which of a few preallocated output sizes the frame server copies into, level 0 is
+// full size and every level after it is smaller. fed once per frame signalled and decides
+// once per window, all times are 100ns
+//
+// a window under pressure (slow copies or lost frames) steps down straight away. stepping
+// back up needs several calm windows in a row, and the copy cost scaled up to the larger
+// size has to look calm too. a step up that is undone within a couple of windows doubles
+// the calm windows the next one needs, so a player sitting on the edge does not flip
+// between two sizes. only ever called from the producer, no locking
+struct AdaptiveResolution
+{
+    struct Settings
+    {
+        int64_t window;             // a decision at most this often
+        uint32_t minWindowFrames;   // and not on fewer frames than this
+        int64_t copyHigh;           // average copy time that counts as pressure
+        int64_t copyLow;            // needed at the larger size before stepping up
+        float lostHigh;             // frames stalled or failed per frame signalled that count as pressure
+        float lostLow;
+        uint32_t calmWindows;       // before stepping up
+        uint32_t maxCalmWindows;    // cap of the back off
+    };
+
+    static Settings DefaultSettings();
+
+    AdaptiveResolution();
+
+    // scales are of the full size, largest first. one scale turns it off
+    void Reset(_In_ std::vector<float> const& scales, _In_ Settings const& settings);
+
+    uint32_t Level() const { return m_level; }
+    uint32_t LevelCount() const { return static_cast<uint32_t>(m_scales.size()); }
+
+    // copyTime < 0 for a frame that could not be copied, lost is a running total of frames
+    // skipped because there was no buffer to write into. frames replaced before unity
+    // showed them are not pressure, a video faster than the display always has some. true
+    // when the level changed, the next frame is copied at the new size
+    bool OnFrame(_In_ int64_t systemTime, _In_ int64_t copyTime, _In_ uint64_t lost);
+
+    // the running total OnFrame() takes, from the ring the frames are copied into
+    static uint64_t LostFrames(_In_ FrameRing::Stats const& ringStats) { return ringStats.stalled; }
+
+private:
+    void StartWindow(_In_ int64_t systemTime, _In_ uint64_t lost);
+
+    std::vector<float> m_scales;
+    Settings m_settings;
+    uint32_t m_level;
+
+    int64_t m_windowStart;
+    uint64_t m_windowLostStart;
+    uint32_t m_windowFrames;
+    uint32_t m_windowCopies;
+    uint32_t m_windowFailures;
+    int64_t m_windowCopyTime;
+
+    uint32_t m_calmWindows;     // in a row at the current level
+    uint32_t m_calmNeeded;
+    uint32_t m_windowsSinceUp;  // UINT32_MAX until the first step up
+};
@@ -0,0 +1,228 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "AudioConverter.h"
+
+#include <algorithm>
+
+// -3dB, what a center or surround channel contributes to each side of a fold down
+static constexpr float c_foldLevel = 0.70710678f;
+
+AudioConverter::AudioConverter()
+    : m_inputRate(0)
+    , m_inputChannels(0)
+    , m_outputRate(0)
+    , m_outputChannels(0)
+    , m_passThrough(false)
+    , m_step(1.0)
+    , m_position(1.0)
+{
+}
+
+_Use_decl_annotations_
+HRESULT AudioConverter::Reset(
+    uint32_t inputRate,
+    uint32_t inputChannels,
+    uint32_t outputRate,
+    uint32_t outputChannels)
+{
+    if (inputRate == 0 || inputChannels == 0 || outputRate == 0 || outputChannels == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_inputRate = inputRate;
+    m_inputChannels = inputChannels;
+    m_outputRate = outputRate;
+    m_outputChannels = outputChannels;
+    m_step = static_cast<double>(inputRate) / outputRate;
+
+    m_matrix.assign(static_cast<size_t>(outputChannels) * inputChannels, 0.0f);
+    auto gain = [this](uint32_t output, uint32_t input) -> float& { return m_matrix[output * m_inputChannels + input]; };
+
+    // what goes to the left and right of a fold down, per input channel
+    std::vector<float> left(inputChannels, 0.0f);
+    std::vector<float> right(inputChannels, 0.0f);
+    if (inputChannels == 1)
+    {
+        left[0] = right[0] = 1.0f;
+    }
+    else if (inputChannels == 6 || inputChannels == 8)
+    {
+        // FL FR C LFE BL BR, then SL SR, the LFE is dropped
+        left[0] = right[1] = 1.0f;
+        left[2] = right[2] = c_foldLevel;
+        for (uint32_t channel = 4; channel < inputChannels; channel += 2)
+        {
+            left[channel] = right[channel + 1] = c_foldLevel;
+        }
+    }
+    else
+    {
+        for (uint32_t channel = 0; channel < inputChannels; ++channel)
+        {
+            (channel % 2 == 0 ? left : right)[channel] = 1.0f;
+        }
+    }
+
+    if (outputChannels == inputChannels)
+    {
+        for (uint32_t channel = 0; channel < outputChannels; ++channel)
+        {
+            gain(channel, channel) = 1.0f;
+        }
+    }
+    else if (inputChannels == 1)
+    {
+        for (uint32_t channel = 0; channel < outputChannels; ++channel)
+        {
+            gain(channel, 0) = 1.0f;
+        }
+    }
+    else if (outputChannels <= 2)
+    {
+        for (uint32_t input = 0; input < inputChannels; ++input)
+        {
+            if (outputChannels == 1)
+            {
+                gain(0, input) = left[input] + right[input];
+            }
+            else
+            {
+                gain(0, input) = left[input];
+                gain(1, input) = right[input];
+            }
+        }
+    }
+    else
+    {
+        for (uint32_t channel = 0; channel < std::min(inputChannels, outputChannels); ++channel)
+        {
+            gain(channel, channel) = 1.0f;
+        }
+    }
+
+    // normalized rows keep a full scale input from clipping
+    for (uint32_t output = 0; output < outputChannels; ++output)
+    {
+        float sum = 0.0f;
+        for (uint32_t input = 0; input < inputChannels; ++input)
+        {
+            sum += gain(output, input);
+        }
+
+        if (sum > 1.0f)
+        {
+            for (uint32_t input = 0; input < inputChannels; ++input)
+            {
+                gain(output, input) /= sum;
+            }
+        }
+    }
+
+    m_passThrough = inputChannels == outputChannels;
+
+    Flush();
+
+    return S_OK;
+}
+
+void AudioConverter::Flush()
+{
+    m_previous.assign(m_outputChannels, 0.0f);
+    m_position = 1.0;
+}
+
+_Use_decl_annotations_
+uint32_t AudioConverter::Convert(
+    float const* input,
+    uint32_t frames,
+    std::vector<float>& output)
+{
+    if (frames == 0 || m_outputChannels == 0)
+    {
+        return 0;
+    }
+
+    uint32_t const outputChannels = m_outputChannels;
+    uint32_t const inputChannels = m_inputChannels;
+
+    if (m_inputRate == m_outputRate && m_passThrough)
+    {
+        output.insert(output.end(), input, input + static_cast<size_t>(frames) * inputChannels);
+
+        return frames;
+    }
+
+    // mix behind the last frame of the previous block. plain scalar loops, the slowest case
+    // (5.1 at 44.1khz to stereo at 48khz) is under 10us per 10ms block on the decode thread,
+    // see AudioConverterThroughput, so there is no hand written simd
+    m_mixed.resize(static_cast<size_t>(frames + 1) * outputChannels);
+    std::copy(m_previous.begin(), m_previous.end(), m_mixed.begin());
+
+    float const* matrix = m_matrix.data();
+    float* mixed = m_mixed.data() + outputChannels;
+    if (m_passThrough)
+    {
+        std::copy_n(input, static_cast<size_t>(frames) * inputChannels, mixed);
+    }
+    else
+    {
+        for (uint32_t frame = 0; frame < frames; ++frame)
+        {
+            float const* source = input + static_cast<size_t>(frame) * inputChannels;
+            float* target = mixed + static_cast<size_t>(frame) * outputChannels;
+            for (uint32_t channel = 0; channel < outputChannels; ++channel)
+            {
+                float const* row = matrix + static_cast<size_t>(channel) * inputChannels;
+
+                float sum = 0.0f;
+                for (uint32_t index = 0; index < inputChannels; ++index)
+                {
+                    sum += row[index] * source[index];
+                }
+
+                target[channel] = sum;
+            }
+        }
+    }
+
+    std::copy_n(m_mixed.end() - outputChannels, outputChannels, m_previous.begin());
+
+    if (m_inputRate == m_outputRate)
+    {
+        output.insert(output.end(), mixed, mixed + static_cast<size_t>(frames) * outputChannels);
+
+        return frames;
+    }
+
+    // frame i of the block is i + 1 here, an output frame needs both neighbours
+    size_t start = output.size();
+    uint32_t produced = 0;
+    output.resize(start + (static_cast<size_t>(frames / m_step) + 2) * outputChannels);
+
+    float const* block = m_mixed.data();
+    double position = m_position;
+    while (position < static_cast<double>(frames))
+    {
+        uint32_t index = static_cast<uint32_t>(position);
+        float fraction = static_cast<float>(position - index);
+
+        float const* before = block + static_cast<size_t>(index) * outputChannels;
+        float const* after = before + outputChannels;
+        float* target = output.data() + start + static_cast<size_t>(produced) * outputChannels;
+        for (uint32_t channel = 0; channel < outputChannels; ++channel)
+        {
+            target[channel] = before[channel] + (after[channel] - before[channel]) * fraction;
+        }
+
+        ++produced;
+        position = m_position + produced * m_step;
+    }
+
+    m_position = position - frames;
+    output.resize(start + static_cast<size_t>(produced) * outputChannels);
+
+    return produced;
+}
@@ -0,0 +1,53 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <vector>
+
+// channel mix and linear rate conversion of interleaved float pcm. the fractional position and
+// the last input frame carry over between calls so consecutive blocks join without a click
+//
+// mono is copied to every channel, 5.1 and 7.1 fold down to stereo with the usual -3dB center
+// and surrounds, any other layout to stereo averages its even and odd channels, and a layout
+// to one with more channels keeps the ones they share. the rows are normalized so a full scale
+// input cannot clip
+struct AudioConverter
+{
+    AudioConverter();
+
+    HRESULT Reset(
+        _In_ uint32_t inputRate,
+        _In_ uint32_t inputChannels,
+        _In_ uint32_t outputRate,
+        _In_ uint32_t outputChannels);
+
+    // forget the previous block, after a seek
+    void Flush();
+
+    uint32_t InputChannels() const { return m_inputChannels; }
+
+    // appends to output, returns the frames produced
+    uint32_t Convert(
+        _In_reads_(frames * InputChannels()) float const* input,
+        _In_ uint32_t frames,
+        _Inout_ std::vector<float>& output);
+
+private:
+    uint32_t m_inputRate;
+    uint32_t m_inputChannels;
+    uint32_t m_outputRate;
+    uint32_t m_outputChannels;
+
+    std::vector<float> m_matrix;    // output x input
+    bool m_passThrough;
+
+    // input frames per output frame
+    double m_step;
+
+    // of the next output frame, in input frames counted from m_previous
+    double m_position;
+
+    std::vector<float> m_mixed;     // the block after the mix, m_previous in front
+    std::vector<float> m_previous;
+};
@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "AudioRing.h"
+
+#include <algorithm>
+
+AudioRing::AudioRing()
+    : m_capacity(0)
+    , m_channels(0)
+    , m_sampleRate(0)
+    , m_writePosition(0)
+    , m_readPosition(0)
+    , m_flushTimestamp(0)
+    , m_flushRequest(0)
+    , m_flushAcknowledged(0)
+    , m_basePosition(0)
+    , m_baseTimestamp(0)
+{
+}
+
+_Use_decl_annotations_
+void AudioRing::Reset(
+    uint32_t capacity,
+    uint32_t channels,
+    uint32_t sampleRate)
+{
+    m_samples.assign(static_cast<size_t>(capacity) * channels, 0.0f);
+    m_capacity = capacity;
+    m_channels = channels;
+    m_sampleRate = sampleRate;
+
+    m_writePosition.store(0, std::memory_order_relaxed);
+    m_readPosition.store(0, std::memory_order_relaxed);
+
+    m_flushTimestamp.store(0, std::memory_order_relaxed);
+    m_flushRequest.store(0, std::memory_order_relaxed);
+    m_flushAcknowledged.store(0, std::memory_order_relaxed);
+
+    m_basePosition = 0;
+    m_baseTimestamp = 0;
+}
+
+_Use_decl_annotations_
+void AudioRing::RequestFlush(
+    int64_t timestamp)
+{
+    m_flushTimestamp.store(timestamp, std::memory_order_relaxed);
+    m_flushRequest.fetch_add(1, std::memory_order_release);
+}
+
+bool AudioRing::Flushed()
+{
+    return m_flushAcknowledged.load(std::memory_order_acquire) == m_flushRequest.load(std::memory_order_relaxed);
+}
+
+uint32_t AudioRing::Space()
+{
+    uint64_t used = m_writePosition.load(std::memory_order_relaxed) - m_readPosition.load(std::memory_order_acquire);
+
+    return m_capacity - static_cast<uint32_t>(used);
+}
+
+_Use_decl_annotations_
+uint32_t AudioRing::Write(
+    float const* frames,
+    uint32_t count)
+{
+    if (!Flushed())
+    {
+        return 0;
+    }
+
+    uint64_t writePosition = m_writePosition.load(std::memory_order_relaxed);
+
+    count = std::min(count, Space());
+
+    // at most two runs, up to the end of the buffer and from its start
+    uint32_t offset = static_cast<uint32_t>(writePosition % m_capacity);
+    uint32_t first = std::min(count, m_capacity - offset);
+
+    std::copy_n(frames, static_cast<size_t>(first) * m_channels, m_samples.begin() + static_cast<size_t>(offset) * m_channels);
+    std::copy_n(frames + static_cast<size_t>(first) * m_channels, static_cast<size_t>(count - first) * m_channels, m_samples.begin());
+
+    m_writePosition.store(writePosition + count, std::memory_order_release);
+
+    return count;
+}
+
+uint32_t AudioRing::Available()
+{
+    uint32_t request = m_flushRequest.load(std::memory_order_acquire);
+    if (request != m_flushAcknowledged.load(std::memory_order_relaxed))
+    {
+        // the producer is not writing, its position is final until the acknowledgement
+        uint64_t writePosition = m_writePosition.load(std::memory_order_acquire);
+
+        m_readPosition.store(writePosition, std::memory_order_release);
+        m_basePosition = writePosition;
+        m_baseTimestamp = m_flushTimestamp.load(std::memory_order_relaxed);
+
+        m_flushAcknowledged.store(request, std::memory_order_release);
+
+        return 0;
+    }
+
+    return static_cast<uint32_t>(m_writePosition.load(std::memory_order_acquire) - m_readPosition.load(std::memory_order_relaxed));
+}
+
+int64_t AudioRing::Timestamp()
+{
+    uint64_t frames = m_readPosition.load(std::memory_order_relaxed) - m_basePosition;
+
+    return m_baseTimestamp + static_cast<int64_t>(frames * 10000000 / m_sampleRate);
+}
+
+_Use_decl_annotations_
+uint32_t AudioRing::Read(
+    float* frames,
+    uint32_t count)
+{
+    uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+
+    count = std::min(count, static_cast<uint32_t>(m_writePosition.load(std::memory_order_acquire) - readPosition));
+
+    uint32_t offset = static_cast<uint32_t>(readPosition % m_capacity);
+    uint32_t first = std::min(count, m_capacity - offset);
+
+    std::copy_n(m_samples.begin() + static_cast<size_t>(offset) * m_channels, static_cast<size_t>(first) * m_channels, frames);
+    std::copy_n(m_samples.begin(), static_cast<size_t>(count - first) * m_channels, frames + static_cast<size_t>(first) * m_channels);
+
+    m_readPosition.store(readPosition + count, std::memory_order_release);
+
+    return count;
+}
+
+_Use_decl_annotations_
+uint32_t AudioRing::Skip(
+    uint32_t count)
+{
+    uint64_t readPosition = m_readPosition.load(std::memory_order_relaxed);
+
+    count = std::min(count, static_cast<uint32_t>(m_writePosition.load(std::memory_order_acquire) - readPosition));
+
+    m_readPosition.store(readPosition + count, std::memory_order_release);
+
+    return count;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// single producer, single consumer ring of interleaved float frames that knows the media time
+// of every frame in it. the producer only writes m_writePosition and the consumer only
+// m_readPosition, each publishes its own with release and reads the other's with acquire,
+// neither side ever waits on the other
+//
+// everything written since the last flush is one continuous timeline. a flush (seek, new
+// source) is requested by the producer and carried out by the consumer on its next call, which
+// drops what was left unread and takes the new start time. the producer writes nothing until
+// it sees the flush acknowledged
+struct AudioRing
+{
+    AudioRing();
+
+    // neither side may be running
+    void Reset(_In_ uint32_t capacity, _In_ uint32_t channels, _In_ uint32_t sampleRate);
+
+    uint32_t Capacity() const { return m_capacity; }
+    uint32_t Channels() const { return m_channels; }
+    uint32_t SampleRate() const { return m_sampleRate; }
+
+    // producer
+    void RequestFlush(_In_ int64_t timestamp);
+    bool Flushed();
+    uint32_t Space();
+
+    // as many frames as fit, none while a flush is pending
+    uint32_t Write(_In_reads_(count * Channels()) float const* frames, _In_ uint32_t count);
+
+    // consumer, Available has to come first, it acknowledges a pending flush
+    uint32_t Available();
+    int64_t Timestamp();
+    uint32_t Read(_Out_writes_(count * Channels()) float* frames, _In_ uint32_t count);
+    uint32_t Skip(_In_ uint32_t count);
+
+private:
+    std::vector<float> m_samples;
+    uint32_t m_capacity;    // frames
+    uint32_t m_channels;
+    uint32_t m_sampleRate;
+
+    // running frame counts, the index into m_samples is the position modulo the capacity
+    std::atomic<uint64_t> m_writePosition;
+    std::atomic<uint64_t> m_readPosition;
+
+    // the producer stores the timestamp before publishing the request, so the consumer sees
+    // it once it has seen the request. a second request before the first is acknowledged
+    // only moves the timestamp, nothing has been written in between
+    std::atomic<int64_t> m_flushTimestamp;
+    std::atomic<uint32_t> m_flushRequest;
+    std::atomic<uint32_t> m_flushAcknowledged;
+
+    // consumer only, where the current timeline starts
+    uint64_t m_basePosition;
+    int64_t m_baseTimestamp;
+};
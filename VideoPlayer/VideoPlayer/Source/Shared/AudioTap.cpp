@@ -0,0 +1,579 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "AudioTap.h"
+#include "FramePacer.h"
+
+#include <mfapi.h>
+#include <mferror.h>
+
+#include <algorithm>
+#include <system_error>
+
+#pragma comment(lib, "mfplat")
+#pragma comment(lib, "mfreadwrite")
+
+using namespace winrt;
+
+// the clock moves in steps of a video frame, closer than this counts as in sync
+static constexpr int64_t c_syncTolerance = 400000;      // 40ms
+
+// the decode thread seeks once it is this far outside what the ring can hold
+static constexpr int64_t c_resyncThreshold = 5000000;   // 0.5s
+
+// a jump between two samples of the source that is padded with silence or cut
+static constexpr int64_t c_gapTolerance = 20000;        // 2ms
+
+// how long the decode thread sleeps while the ring is full or there is nothing to decode
+static constexpr DWORD c_idleWaitMs = 5;
+
+// a reader that failed is opened again after this, doubling while it keeps failing
+static constexpr int64_t c_retryDelay = 1000000;        // 100ms
+static constexpr int64_t c_maxRetryDelay = 50000000;    // 5s
+
+_Use_decl_annotations_
+HRESULT AudioTap::Create(
+    uint32_t sampleRate,
+    uint32_t channels,
+    uint32_t bufferMs,
+    std::shared_ptr<AudioTap>& tap)
+{
+    tap = nullptr;
+
+    std::shared_ptr<AudioTap> newTap(new AudioTap(), &AudioTap::Destroy);
+
+    uint32_t capacity = static_cast<uint32_t>(static_cast<uint64_t>(sampleRate) * bufferMs / 1000);
+    newTap->m_ring.Reset(std::max<uint32_t>(1, capacity), channels, sampleRate);
+
+    IFR(newTap->Start());
+
+    tap = newTap;
+
+    return S_OK;
+}
+
+AudioTap::AudioTap()
+    : m_sourceGeneration(0)
+    , m_stop(false)
+    , m_wake(nullptr)
+    , m_clockSequence(0)
+    , m_clockMediaTime(-1)
+    , m_clockSystemTime(0)
+    , m_clockRate(0.0)
+    , m_pendingOffset(0)
+    , m_sourceSampleRate(0)
+    , m_sourceChannels(0)
+    , m_framesDecoded(0)
+    , m_framesRead(0)
+    , m_framesSkipped(0)
+    , m_framesSilence(0)
+    , m_resyncs(0)
+{
+}
+
+AudioTap::~AudioTap()
+{
+    Stop();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+_Use_decl_annotations_
+void AudioTap::Destroy(
+    AudioTap* tap)
+{
+    // the last reference can go on unity's audio thread or in a frame callback, the decode
+    // thread can be inside a ReadSample for a while. it is told to stop here and joined on
+    // a thread of its own
+    tap->Stop();
+
+    try
+    {
+        std::thread([tap]() { delete tap; }).detach();
+    }
+    catch (std::system_error const&)
+    {
+        delete tap;
+    }
+}
+
+HRESULT AudioTap::Start()
+{
+    m_wake.attach(CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS));
+    NULL_CHK_HR(m_wake.get(), HRESULT_FROM_WIN32(GetLastError()));
+
+    m_thread = std::thread([this]() { ThreadProc(); });
+
+    return S_OK;
+}
+
+void AudioTap::Stop()
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_sourceMutex);
+
+        m_stop = true;
+    }
+
+    if (m_wake)
+    {
+        SetEvent(m_wake.get());
+    }
+}
+
+_Use_decl_annotations_
+void AudioTap::SetSource(
+    hstring const& location)
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_sourceMutex);
+
+        if (location == m_location)
+        {
+            return;
+        }
+
+        m_location = location;
+        ++m_sourceGeneration;
+    }
+
+    SetEvent(m_wake.get());
+}
+
+_Use_decl_annotations_
+void AudioTap::SetClock(
+    int64_t mediaTime,
+    int64_t systemTime,
+    double rate)
+{
+    std::lock_guard<slim_mutex> guard(m_clockMutex);
+
+    // odd while the fields are being written
+    m_clockSequence.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_clockMediaTime.store(mediaTime, std::memory_order_relaxed);
+    m_clockSystemTime.store(systemTime, std::memory_order_relaxed);
+    m_clockRate.store(rate, std::memory_order_relaxed);
+
+    m_clockSequence.fetch_add(1, std::memory_order_release);
+}
+
+_Use_decl_annotations_
+bool AudioTap::ReadClock(
+    Clock* clock)
+{
+    for (;;)
+    {
+        uint32_t sequence = m_clockSequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0)
+        {
+            continue;
+        }
+
+        clock->mediaTime = m_clockMediaTime.load(std::memory_order_relaxed);
+        clock->systemTime = m_clockSystemTime.load(std::memory_order_relaxed);
+        clock->rate = m_clockRate.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_clockSequence.load(std::memory_order_relaxed) == sequence)
+        {
+            return clock->mediaTime >= 0;
+        }
+    }
+}
+
+_Use_decl_annotations_
+int64_t AudioTap::ClockTime(
+    Clock const& clock,
+    int64_t systemTime)
+{
+    return clock.mediaTime + static_cast<int64_t>((systemTime - clock.systemTime) * clock.rate);
+}
+
+_Use_decl_annotations_
+void AudioTap::Read(
+    float* buffer,
+    uint32_t frames,
+    int64_t* timestamp,
+    uint32_t* framesRead)
+{
+    uint32_t channels = m_ring.Channels();
+    uint32_t sampleRate = m_ring.SampleRate();
+
+    std::fill_n(buffer, static_cast<size_t>(frames) * channels, 0.0f);
+    *timestamp = -1;
+    *framesRead = 0;
+
+    // acknowledges a flush of the decode thread before anything else looks at the ring
+    uint32_t available = m_ring.Available();
+
+    Clock clock{};
+    if (!ReadClock(&clock))
+    {
+        return;
+    }
+
+    int64_t now = ClockTime(clock, FramePacer::Now());
+    *timestamp = now;
+
+    // paused, what is queued waits for the clock to move again
+    if (clock.rate == 0.0)
+    {
+        return;
+    }
+
+    uint32_t offset = 0;
+    if (available > 0)
+    {
+        int64_t lag = now - m_ring.Timestamp();
+        if (lag > c_syncTolerance)
+        {
+            uint32_t late = static_cast<uint32_t>(std::min<int64_t>(available, lag * sampleRate / 10000000));
+            uint32_t skipped = m_ring.Skip(late);
+
+            available -= skipped;
+            m_framesSkipped.fetch_add(skipped, std::memory_order_relaxed);
+        }
+        else if (lag < -c_syncTolerance)
+        {
+            offset = static_cast<uint32_t>(std::min<int64_t>(frames, -lag * sampleRate / 10000000));
+        }
+
+        if (available > 0)
+        {
+            *timestamp = m_ring.Timestamp() - static_cast<int64_t>(offset) * 10000000 / sampleRate;
+        }
+    }
+
+    uint32_t read = m_ring.Read(buffer + static_cast<size_t>(offset) * channels, frames - offset);
+
+    *framesRead = read;
+    m_framesRead.fetch_add(read, std::memory_order_relaxed);
+    m_framesSilence.fetch_add(frames - read, std::memory_order_relaxed);
+}
+
+_Use_decl_annotations_
+void AudioTap::GetStats(
+    AUDIO_TAP_STATS* stats)
+{
+    ZeroMemory(stats, sizeof(AUDIO_TAP_STATS));
+
+    stats->sampleRate = m_ring.SampleRate();
+    stats->channels = m_ring.Channels();
+    stats->sourceSampleRate = m_sourceSampleRate.load(std::memory_order_relaxed);
+    stats->sourceChannels = m_sourceChannels.load(std::memory_order_relaxed);
+    stats->framesDecoded = m_framesDecoded.load(std::memory_order_relaxed);
+    stats->framesRead = m_framesRead.load(std::memory_order_relaxed);
+    stats->framesSkipped = m_framesSkipped.load(std::memory_order_relaxed);
+    stats->framesSilence = m_framesSilence.load(std::memory_order_relaxed);
+    stats->resyncs = m_resyncs.load(std::memory_order_relaxed);
+    stats->bufferedFrames = m_ring.Capacity() - m_ring.Space();
+}
+
+void AudioTap::ThreadProc()
+{
+    bool comInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+    HRESULT startup = MFStartup(MF_VERSION, MFSTARTUP_LITE);
+
+    uint32_t const sampleRate = m_ring.SampleRate();
+    uint32_t const channels = m_ring.Channels();
+    int64_t const ringDuration = static_cast<int64_t>(m_ring.Capacity()) * 10000000 / sampleRate;
+
+    com_ptr<IMFSourceReader> reader = nullptr;
+    uint32_t sourceRate = 0;
+    uint32_t sourceChannels = 0;
+    uint32_t generation = 0;
+    bool opened = false;
+    hstring location;
+
+    // set once the item opened, a reader that fails after that is opened again
+    bool recoverable = false;
+    uint32_t failures = 0;
+    int64_t retryTime = 0;
+
+    auto readerFailed = [&]()
+    {
+        reader = nullptr;
+
+        int64_t delay = std::min(c_retryDelay << std::min<uint32_t>(failures, 16), c_maxRetryDelay);
+        retryTime = FramePacer::Now() + delay;
+        ++failures;
+    };
+
+    // media time of the end of what has been converted, once the reader has been positioned
+    int64_t decodeTime = 0;
+    bool positioned = false;
+    bool endOfStream = false;
+
+    for (;;)
+    {
+        bool sourceChanged = false;
+        {
+            std::lock_guard<slim_mutex> guard(m_sourceMutex);
+
+            if (m_stop)
+            {
+                break;
+            }
+
+            if (!opened || generation != m_sourceGeneration)
+            {
+                generation = m_sourceGeneration;
+                location = m_location;
+                opened = true;
+                sourceChanged = true;
+            }
+        }
+
+        if (sourceChanged)
+        {
+            reader = nullptr;
+            recoverable = false;
+            failures = 0;
+            retryTime = 0;
+        }
+
+        // a new item, or another go at one whose reader failed. the reader is positioned on
+        // the clock again below
+        if (sourceChanged || (reader == nullptr && recoverable && FramePacer::Now() >= retryTime))
+        {
+            positioned = false;
+            m_pending.clear();
+            m_pendingOffset = 0;
+
+            if (SUCCEEDED(startup) && !location.empty())
+            {
+                if (FAILED(OpenReader(location, reader, &sourceRate, &sourceChannels))
+                    || FAILED(m_converter.Reset(sourceRate, sourceChannels, sampleRate, channels)))
+                {
+                    readerFailed();
+                }
+                else
+                {
+                    recoverable = true;
+                }
+            }
+
+            m_sourceSampleRate.store(reader != nullptr ? sourceRate : 0, std::memory_order_relaxed);
+            m_sourceChannels.store(reader != nullptr ? sourceChannels : 0, std::memory_order_relaxed);
+        }
+
+        Clock clock{};
+        if (reader == nullptr || !ReadClock(&clock))
+        {
+            WaitForSingleObject(m_wake.get(), c_idleWaitMs);
+            continue;
+        }
+
+        // follow the player, whatever moved its clock away from what is queued
+        int64_t now = ClockTime(clock, FramePacer::Now());
+        if (!positioned || decodeTime < now - c_resyncThreshold || decodeTime > now + ringDuration + c_resyncThreshold)
+        {
+            if (FAILED(Seek(reader.get(), now)))
+            {
+                readerFailed();
+                continue;
+            }
+
+            if (positioned)
+            {
+                m_resyncs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            m_converter.Flush();
+            m_pending.clear();
+            m_pendingOffset = 0;
+            m_ring.RequestFlush(now);
+
+            decodeTime = now;
+            positioned = true;
+            endOfStream = false;
+        }
+
+        if (!Drain() || endOfStream)
+        {
+            WaitForSingleObject(m_wake.get(), c_idleWaitMs);
+            continue;
+        }
+
+        DWORD streamIndex = 0;
+        DWORD flags = 0;
+        LONGLONG sampleTime = 0;
+        com_ptr<IMFSample> sample = nullptr;
+        if (FAILED(reader->ReadSample(static_cast<DWORD>(MF_SOURCE_READER_FIRST_AUDIO_STREAM), 0, &streamIndex, &flags, &sampleTime, sample.put()))
+            || (flags & MF_SOURCE_READERF_ERROR) != 0)
+        {
+            readerFailed();
+            continue;
+        }
+
+        failures = 0;
+
+        if ((flags & MF_SOURCE_READERF_ENDOFSTREAM) != 0)
+        {
+            endOfStream = true;
+            continue;
+        }
+
+        // he-aac and the like settle on their real rate only after the first frames
+        if ((flags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) != 0)
+        {
+            com_ptr<IMFMediaType> currentType = nullptr;
+            if (FAILED(reader->GetCurrentMediaType(static_cast<DWORD>(MF_SOURCE_READER_FIRST_AUDIO_STREAM), currentType.put())))
+            {
+                readerFailed();
+                continue;
+            }
+
+            sourceRate = MFGetAttributeUINT32(currentType.get(), MF_MT_AUDIO_SAMPLES_PER_SECOND, 0);
+            sourceChannels = MFGetAttributeUINT32(currentType.get(), MF_MT_AUDIO_NUM_CHANNELS, 0);
+            if (FAILED(m_converter.Reset(sourceRate, sourceChannels, sampleRate, channels)))
+            {
+                readerFailed();
+                continue;
+            }
+
+            m_sourceSampleRate.store(sourceRate, std::memory_order_relaxed);
+            m_sourceChannels.store(sourceChannels, std::memory_order_relaxed);
+        }
+
+        if (sample == nullptr)
+        {
+            continue;
+        }
+
+        com_ptr<IMFMediaBuffer> mediaBuffer = nullptr;
+        BYTE* data = nullptr;
+        DWORD length = 0;
+        if (FAILED(sample->ConvertToContiguousBuffer(mediaBuffer.put())) || FAILED(mediaBuffer->Lock(&data, nullptr, &length)))
+        {
+            continue;
+        }
+
+        uint32_t frames = length / (sourceChannels * sizeof(float));
+        float const* input = reinterpret_cast<float const*>(data);
+
+        // the ring is one continuous timeline, holes in the source become silence and samples
+        // that start before the end of the last one are cut
+        uint32_t skip = 0;
+        int64_t gap = sampleTime - decodeTime;
+        if (gap > c_gapTolerance)
+        {
+            // a longer hole is left to the resync once the clock has passed it
+            size_t silence = static_cast<size_t>(std::min(gap, ringDuration) * sampleRate / 10000000);
+            m_pending.insert(m_pending.end(), silence * channels, 0.0f);
+            m_framesDecoded.fetch_add(silence, std::memory_order_relaxed);
+            m_converter.Flush();
+        }
+        else if (gap < -c_gapTolerance)
+        {
+            skip = static_cast<uint32_t>(std::min<int64_t>(frames, -gap * sourceRate / 10000000));
+        }
+
+        if (skip < frames)
+        {
+            uint32_t produced = m_converter.Convert(input + static_cast<size_t>(skip) * sourceChannels, frames - skip, m_pending);
+            m_framesDecoded.fetch_add(produced, std::memory_order_relaxed);
+
+            decodeTime = sampleTime + static_cast<int64_t>(frames) * 10000000 / sourceRate;
+        }
+
+        mediaBuffer->Unlock();
+    }
+
+    reader = nullptr;
+
+    if (SUCCEEDED(startup))
+    {
+        MFShutdown();
+    }
+
+    if (comInitialized)
+    {
+        CoUninitialize();
+    }
+}
+
+_Use_decl_annotations_
+HRESULT AudioTap::OpenReader(
+    hstring const& location,
+    com_ptr<IMFSourceReader>& reader,
+    uint32_t* sampleRate,
+    uint32_t* channels)
+{
+    reader = nullptr;
+    *sampleRate = 0;
+    *channels = 0;
+
+    com_ptr<IMFSourceReader> newReader = nullptr;
+    IFR(MFCreateSourceReaderFromURL(location.c_str(), nullptr, newReader.put()));
+
+    IFR(newReader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_ALL_STREAMS), FALSE));
+    IFR(newReader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_FIRST_AUDIO_STREAM), TRUE));
+
+    // the decoder's float output at the source's own rate and layout, the converter does the rest
+    com_ptr<IMFMediaType> mediaType = nullptr;
+    IFR(MFCreateMediaType(mediaType.put()));
+    IFR(mediaType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Audio));
+    IFR(mediaType->SetGUID(MF_MT_SUBTYPE, MFAudioFormat_Float));
+    IFR(newReader->SetCurrentMediaType(static_cast<DWORD>(MF_SOURCE_READER_FIRST_AUDIO_STREAM), nullptr, mediaType.get()));
+
+    com_ptr<IMFMediaType> currentType = nullptr;
+    IFR(newReader->GetCurrentMediaType(static_cast<DWORD>(MF_SOURCE_READER_FIRST_AUDIO_STREAM), currentType.put()));
+
+    UINT32 rate = MFGetAttributeUINT32(currentType.get(), MF_MT_AUDIO_SAMPLES_PER_SECOND, 0);
+    UINT32 count = MFGetAttributeUINT32(currentType.get(), MF_MT_AUDIO_NUM_CHANNELS, 0);
+    if (rate == 0 || count == 0)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    reader = newReader;
+    *sampleRate = rate;
+    *channels = count;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT AudioTap::Seek(
+    IMFSourceReader* reader,
+    int64_t position)
+{
+    PROPVARIANT seekPosition;
+    PropVariantInit(&seekPosition);
+    seekPosition.vt = VT_I8;
+    seekPosition.hVal.QuadPart = std::max<int64_t>(0, position);
+
+    HRESULT hr = reader->SetCurrentPosition(GUID_NULL, seekPosition);
+    PropVariantClear(&seekPosition);
+
+    return hr;
+}
+
+bool AudioTap::Drain()
+{
+    uint32_t channels = m_ring.Channels();
+    size_t total = m_pending.size() / channels;
+
+    while (m_pendingOffset < total)
+    {
+        uint32_t written = m_ring.Write(m_pending.data() + m_pendingOffset * channels, static_cast<uint32_t>(total - m_pendingOffset));
+        if (written == 0)
+        {
+            return false;
+        }
+
+        m_pendingOffset += written;
+    }
+
+    m_pending.clear();
+    m_pendingOffset = 0;
+
+    return true;
+}
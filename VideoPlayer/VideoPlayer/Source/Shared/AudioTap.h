@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "AudioRing.h"
+#include "AudioConverter.h"
+
+#include <mfreadwrite.h>
+
+#include <thread>
+
+// decoded pcm of the playing item for unity's audio thread. MediaPlayer renders its audio
+// itself and never hands it out, so the tap decodes the item a second time with its own
+// source reader on a background thread, converts it to the requested rate and channels and
+// queues it in an AudioRing
+//
+// the player's video frames drive a clock, the decode thread seeks whenever it has drifted
+// from that clock (a seek, the next item, a loop) and Read lines the queued samples up with
+// it, skipping what is late and padding with silence what is early. at rates other than 1
+// the audio plays at normal speed and is kept in place by those skips
+//
+// a reader that fails after the item opened (a network hiccup, a decoder error) is opened
+// again after a back off, an item that never opens stays silent until the next one
+struct AudioTap
+{
+    static HRESULT Create(
+        _In_ uint32_t sampleRate,
+        _In_ uint32_t channels,
+        _In_ uint32_t bufferMs,
+        _Out_ std::shared_ptr<AudioTap>& tap);
+
+    uint32_t SampleRate() const { return m_ring.SampleRate(); }
+    uint32_t Channels() const { return m_ring.Channels(); }
+
+    // the item to decode, empty for one without a location the reader can open
+    void SetSource(_In_ winrt::hstring const& location);
+
+    // mediaTime was on screen at systemTime and moves at rate, 0 while paused
+    void SetClock(_In_ int64_t mediaTime, _In_ int64_t systemTime, _In_ double rate);
+
+    // unity's audio thread, always fills frames, with silence where nothing is queued.
+    // timestamp is the media time of the first frame, -1 while there is no clock
+    void Read(
+        _Out_writes_(frames * m_ring.Channels()) float* buffer,
+        _In_ uint32_t frames,
+        _Out_ int64_t* timestamp,
+        _Out_ uint32_t* framesRead);
+
+    void GetStats(_Out_ AUDIO_TAP_STATS* stats);
+
+private:
+    AudioTap();
+    ~AudioTap();
+
+    // the deleter of the taps Create hands out
+    static void Destroy(_In_ AudioTap* tap);
+
+    struct Clock
+    {
+        int64_t mediaTime;
+        int64_t systemTime;
+        double rate;
+    };
+
+    HRESULT Start();
+    void Stop();
+
+    bool ReadClock(_Out_ Clock* clock);
+    static int64_t ClockTime(_In_ Clock const& clock, _In_ int64_t systemTime);
+
+    void ThreadProc();
+
+    HRESULT OpenReader(
+        _In_ winrt::hstring const& location,
+        _Out_ winrt::com_ptr<IMFSourceReader>& reader,
+        _Out_ uint32_t* sampleRate,
+        _Out_ uint32_t* channels);
+
+    HRESULT Seek(_In_ IMFSourceReader* reader, _In_ int64_t position);
+
+    // queues as much of m_pending as fits, false while some is left
+    bool Drain();
+
+    // the source, changes are picked up by the decode thread
+    winrt::slim_mutex m_sourceMutex;
+    winrt::hstring m_location;
+    uint32_t m_sourceGeneration;
+    bool m_stop;
+    winrt::handle m_wake;
+    std::thread m_thread;
+
+    // a seqlock, the writers are serialized by m_clockMutex, readers never wait
+    winrt::slim_mutex m_clockMutex;
+    std::atomic<uint32_t> m_clockSequence;
+    std::atomic<int64_t> m_clockMediaTime;      // -1 until the first frame
+    std::atomic<int64_t> m_clockSystemTime;
+    std::atomic<double> m_clockRate;
+
+    AudioRing m_ring;
+
+    // decode thread only
+    AudioConverter m_converter;
+    std::vector<float> m_pending;
+    size_t m_pendingOffset;     // frames already queued
+
+    std::atomic<uint32_t> m_sourceSampleRate;
+    std::atomic<uint32_t> m_sourceChannels;
+    std::atomic<uint64_t> m_framesDecoded;
+    std::atomic<uint64_t> m_framesRead;
+    std::atomic<uint64_t> m_framesSkipped;
+    std::atomic<uint64_t> m_framesSilence;
+    std::atomic<uint32_t> m_resyncs;
+};
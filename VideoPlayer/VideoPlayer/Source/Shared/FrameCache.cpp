@@ -0,0 +1,166 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "FrameCache.h"
+
+using namespace winrt;
+
+static uint64_t TextureBytes(
+    _In_ D3D11_TEXTURE2D_DESC const& desc)
+{
+    return static_cast<uint64_t>(desc.Width) * desc.Height * 4;
+}
+
+FrameCache::FrameCache()
+    : m_stats{}
+{
+}
+
+_Use_decl_annotations_
+void FrameCache::SetBudget(
+    uint64_t budget)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    m_stats.budget = budget;
+
+    while (!m_recent.empty() && m_stats.bytes > m_stats.budget)
+    {
+        EvictOldest();
+    }
+}
+
+bool FrameCache::Enabled()
+{
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    return m_stats.budget > 0;
+}
+
+_Use_decl_annotations_
+HRESULT FrameCache::Insert(
+    ID3D11DeviceContext* context,
+    int64_t timestamp,
+    ID3D11Texture2D* source)
+{
+    NULL_CHK_HR(context, E_INVALIDARG);
+    NULL_CHK_HR(source, E_INVALIDARG);
+
+    D3D11_TEXTURE2D_DESC desc{};
+    source->GetDesc(&desc);
+
+    uint64_t bytes = TextureBytes(desc);
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (bytes > m_stats.budget || m_entries.find(timestamp) != m_entries.end())
+    {
+        return S_OK;
+    }
+
+    com_ptr<ID3D11Texture2D> texture = nullptr;
+    while (!m_recent.empty() && m_stats.bytes + bytes > m_stats.budget)
+    {
+        auto evicted = EvictOldest();
+
+        D3D11_TEXTURE2D_DESC evictedDesc{};
+        evicted->GetDesc(&evictedDesc);
+
+        if (evictedDesc.Width == desc.Width && evictedDesc.Height == desc.Height && evictedDesc.Format == desc.Format)
+        {
+            texture = evicted;
+        }
+    }
+
+    if (texture == nullptr)
+    {
+        com_ptr<ID3D11Device> device = nullptr;
+        source->GetDevice(device.put());
+
+        // only ever a copy source and destination
+        desc.BindFlags = 0;
+        desc.MiscFlags = 0;
+        desc.CPUAccessFlags = 0;
+        desc.Usage = D3D11_USAGE_DEFAULT;
+
+        IFR(device->CreateTexture2D(&desc, nullptr, texture.put()));
+    }
+
+    context->CopyResource(texture.get(), source);
+
+    m_recent.push_front(timestamp);
+    m_entries[timestamp] = Entry{ texture, bytes, m_recent.begin() };
+
+    m_stats.bytes += bytes;
+    m_stats.frames = static_cast<uint32_t>(m_entries.size());
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+bool FrameCache::CopyTo(
+    ID3D11DeviceContext* context,
+    int64_t position,
+    int64_t tolerance,
+    ID3D11Texture2D* target,
+    int64_t* timestamp)
+{
+    *timestamp = 0;
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    auto it = m_entries.upper_bound(position);
+    if (it == m_entries.begin() || position - std::prev(it)->first >= tolerance)
+    {
+        ++m_stats.misses;
+
+        return false;
+    }
+
+    --it;
+
+    context->CopyResource(target, it->second.texture.get());
+
+    // most recently used
+    m_recent.splice(m_recent.begin(), m_recent, it->second.recent);
+
+    ++m_stats.hits;
+    *timestamp = it->first;
+
+    return true;
+}
+
+void FrameCache::Clear()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    m_entries.clear();
+    m_recent.clear();
+
+    m_stats.bytes = 0;
+    m_stats.frames = 0;
+}
+
+FrameCache::Stats FrameCache::GetStats()
+{
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    return m_stats;
+}
+
+com_ptr<ID3D11Texture2D> FrameCache::EvictOldest()
+{
+    auto it = m_entries.find(m_recent.back());
+    m_recent.pop_back();
+
+    auto texture = it->second.texture;
+
+    m_stats.bytes -= it->second.bytes;
+    ++m_stats.evictions;
+
+    m_entries.erase(it);
+    m_stats.frames = static_cast<uint32_t>(m_entries.size());
+
+    return texture;
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <d3d11.h>
+#include <list>
+#include <map>
+
+// recently decoded frames kept on the media device, keyed by the playback position they
+// were copied at and evicted least recently used first once the byte budget is reached.
+// a budget of 0 turns it off. copies go through the context passed in, the caller owns
+// the device
+struct FrameCache
+{
+    struct Stats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t bytes;
+        uint64_t budget;
+        uint32_t frames;
+    };
+
+    FrameCache();
+
+    // evicts down to the new budget straight away
+    void SetBudget(_In_ uint64_t budget);
+
+    bool Enabled();
+
+    // no-op when the timestamp is already cached or a single frame exceeds the budget
+    HRESULT Insert(
+        _In_ ID3D11DeviceContext* context,
+        _In_ int64_t timestamp,
+        _In_ ID3D11Texture2D* source);
+
+    // the newest frame at or before position and less than tolerance away,
+    // copied into target, false on a miss
+    bool CopyTo(
+        _In_ ID3D11DeviceContext* context,
+        _In_ int64_t position,
+        _In_ int64_t tolerance,
+        _In_ ID3D11Texture2D* target,
+        _Out_ int64_t* timestamp);
+
+    // timestamps are only meaningful within one source
+    void Clear();
+
+    Stats GetStats();
+
+private:
+    struct Entry
+    {
+        winrt::com_ptr<ID3D11Texture2D> texture;
+        uint64_t bytes;
+        std::list<int64_t>::iterator recent;
+    };
+
+    // returns the evicted texture so an insert of the same size can reuse it
+    winrt::com_ptr<ID3D11Texture2D> EvictOldest();
+
+    winrt::slim_mutex m_mutex;
+    std::map<int64_t, Entry> m_entries;
+    std::list<int64_t> m_recent;  // most recent first
+    Stats m_stats;
+};
@@ -0,0 +1,148 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace winrt;
+
+// 60Hz until unity has rendered a few frames
+static constexpr double c_defaultVsyncInterval = 166667.0;
+static constexpr double c_minVsyncInterval = 40000.0;
+static constexpr double c_maxVsyncInterval = 500000.0;
+
+// a render event gap longer than this is a hitch, not a refresh rate
+static constexpr int64_t c_maxVsyncGap = 1000000;
+
+// frames further than this from the predicted clock re-anchor it (seek, stall, rate change)
+static constexpr int64_t c_maxClockError = 1000000;
+
+// each frame pulls the clock 1/8 of the way towards its timestamp
+static constexpr int64_t c_clockSmoothing = 8;
+static constexpr double c_vsyncSmoothing = 0.1;
+
+FramePacer::FramePacer()
+    : m_hasClock(false)
+    , m_anchorMedia(0)
+    , m_anchorSystem(0)
+    , m_rate(1.0)
+    , m_lastTimestamp(0)
+    , m_lastVsync(-1)
+    , m_vsyncInterval(c_defaultVsyncInterval)
+{
+}
+
+int64_t FramePacer::Now()
+{
+    static LARGE_INTEGER frequency = []()
+    {
+        LARGE_INTEGER value{};
+        QueryPerformanceFrequency(&value);
+        return value;
+    }();
+
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+
+    // split to avoid overflowing on long uptimes
+    int64_t seconds = counter.QuadPart / frequency.QuadPart;
+    int64_t remainder = counter.QuadPart % frequency.QuadPart;
+
+    return seconds * 10000000 + remainder * 10000000 / frequency.QuadPart;
+}
+
+void FramePacer::Reset()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    m_hasClock = false;
+    m_anchorMedia = 0;
+    m_anchorSystem = 0;
+    m_rate = 1.0;
+    m_lastTimestamp = 0;
+}
+
+_Use_decl_annotations_
+void FramePacer::OnFrame(
+    int64_t timestamp,
+    int64_t systemTime,
+    double rate)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    m_lastTimestamp = timestamp;
+
+    int64_t predicted = MediaTime(systemTime);
+    int64_t error = timestamp - predicted;
+
+    if (!m_hasClock || rate != m_rate || std::abs(error) > c_maxClockError)
+    {
+        m_anchorMedia = timestamp;
+        m_hasClock = true;
+    }
+    else
+    {
+        m_anchorMedia = predicted + error / c_clockSmoothing;
+    }
+
+    m_anchorSystem = systemTime;
+    m_rate = rate;
+}
+
+_Use_decl_annotations_
+void FramePacer::OnVsync(
+    int64_t systemTime)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    int64_t previous = m_lastVsync;
+    m_lastVsync = systemTime;
+
+    if (previous < 0 || systemTime <= previous || systemTime - previous > c_maxVsyncGap)
+    {
+        return;
+    }
+
+    double interval = static_cast<double>(systemTime - previous);
+    m_vsyncInterval += (interval - m_vsyncInterval) * c_vsyncSmoothing;
+    m_vsyncInterval = std::clamp(m_vsyncInterval, c_minVsyncInterval, c_maxVsyncInterval);
+}
+
+_Use_decl_annotations_
+int64_t FramePacer::DisplayTime(
+    int64_t systemTime,
+    uint32_t latencyFrames)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (!m_hasClock)
+    {
+        return m_lastTimestamp;
+    }
+
+    return MediaTime(systemTime + static_cast<int64_t>(m_vsyncInterval * latencyFrames));
+}
+
+int64_t FramePacer::VsyncInterval()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    return static_cast<int64_t>(m_vsyncInterval);
+}
+
+bool FramePacer::HasClock()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    return m_hasClock;
+}
+
+_Use_decl_annotations_
+int64_t FramePacer::MediaTime(
+    int64_t systemTime)
+{
+    return m_anchorMedia + static_cast<int64_t>((systemTime - m_anchorSystem) * m_rate);
+}
@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+// maps system time onto media time so the render thread can ask which frame timestamp
+// will be on the display after the next vsync. every call takes the time explicitly,
+// Now() is only the default source, all values are 100ns
+//
+// the media clock is anchored by the timestamps frames arrive with and smoothed so a late
+// callback does not jerk it around, the vsync interval is estimated from the spacing of
+// unity's render events. the media player only gives its playback position, so there the
+// clock follows the position, not the samples' own times
+struct FramePacer
+{
+    FramePacer();
+
+    static int64_t Now();
+
+    void Reset();
+
+    // producer, a frame with this timestamp became available at systemTime
+    void OnFrame(_In_ int64_t timestamp, _In_ int64_t systemTime, _In_ double rate);
+
+    // consumer, called once per rendered frame
+    void OnVsync(_In_ int64_t systemTime);
+
+    // media time expected on screen latencyFrames vsyncs after systemTime,
+    // the newest frame timestamp until the clock is anchored
+    int64_t DisplayTime(_In_ int64_t systemTime, _In_ uint32_t latencyFrames);
+
+    int64_t VsyncInterval();
+
+    bool HasClock();
+
+private:
+    int64_t MediaTime(_In_ int64_t systemTime);
+
+    winrt::slim_mutex m_mutex;
+
+    bool m_hasClock;
+    int64_t m_anchorMedia;
+    int64_t m_anchorSystem;
+    double m_rate;
+    int64_t m_lastTimestamp;
+
+    int64_t m_lastVsync;
+    double m_vsyncInterval;
+};
@@ -0,0 +1,242 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "FrameRing.h"
+
+#include <cstdlib>
+
+using namespace winrt;
+
+FrameRing::FrameRing()
+    : m_nextSequence(1)
+    , m_lastTimestamp(0)
+    , m_stats{}
+{
+}
+
+_Use_decl_annotations_
+void FrameRing::Reset(
+    uint32_t capacity)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    m_slots.assign(capacity, Slot{ SlotState::Free, 0, 0 });
+    m_nextSequence = 1;
+    m_lastTimestamp = 0;
+    m_stats = Stats{};
+}
+
+uint32_t FrameRing::Capacity()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    return static_cast<uint32_t>(m_slots.size());
+}
+
+int32_t FrameRing::BeginWrite()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    int32_t oldestReady = -1;
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        auto& slot = m_slots[i];
+        if (slot.state == SlotState::Free)
+        {
+            slot.state = SlotState::Writing;
+
+            return static_cast<int32_t>(i);
+        }
+
+        if (slot.state == SlotState::Ready
+            && (oldestReady == -1 || slot.sequence < m_slots[oldestReady].sequence))
+        {
+            oldestReady = static_cast<int32_t>(i);
+        }
+    }
+
+    // unity is behind, overwrite the frame it was least likely to show
+    if (oldestReady != -1)
+    {
+        m_slots[oldestReady].state = SlotState::Writing;
+        ++m_stats.dropped;
+
+        return oldestReady;
+    }
+
+    ++m_stats.stalled;
+
+    return -1;
+}
+
+_Use_decl_annotations_
+void FrameRing::EndWrite(
+    int32_t slot,
+    bool succeeded,
+    int64_t timestamp)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (slot < 0 || static_cast<size_t>(slot) >= m_slots.size() || m_slots[slot].state != SlotState::Writing)
+    {
+        return;
+    }
+
+    if (!succeeded)
+    {
+        m_slots[slot].state = SlotState::Free;
+
+        return;
+    }
+
+    if (m_stats.written > 0 && timestamp < m_lastTimestamp)
+    {
+        for (auto& other : m_slots)
+        {
+            if (other.state == SlotState::Ready)
+            {
+                other.state = SlotState::Free;
+                ++m_stats.dropped;
+            }
+            else if (other.state == SlotState::Presented)
+            {
+                // stays on screen until replaced, but is no longer a candidate
+                other.sequence = 0;
+            }
+        }
+    }
+
+    m_slots[slot].state = SlotState::Ready;
+    m_slots[slot].sequence = m_nextSequence++;
+    m_slots[slot].timestamp = timestamp;
+    m_lastTimestamp = timestamp;
+    ++m_stats.written;
+}
+
+_Use_decl_annotations_
+int32_t FrameRing::Present(
+    PacingMode mode,
+    int64_t displayTime)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    int32_t selected = Select(mode, displayTime);
+    if (selected == -1)
+    {
+        return -1;
+    }
+
+    if (m_slots[selected].state == SlotState::Presented)
+    {
+        ++m_stats.repeated;
+
+        return -1;
+    }
+
+    // the previous frame is released, anything queued before the new one is never shown
+    auto const& next = m_slots[selected];
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        auto& slot = m_slots[i];
+        if (slot.state == SlotState::Presented)
+        {
+            slot.state = SlotState::Free;
+        }
+        else if (slot.state == SlotState::Ready
+            && static_cast<int32_t>(i) != selected
+            && (slot.timestamp < next.timestamp || (mode == PacingMode::Latest && slot.sequence < next.sequence)))
+        {
+            slot.state = SlotState::Free;
+            ++m_stats.dropped;
+        }
+    }
+
+    m_slots[selected].state = SlotState::Presented;
+    ++m_stats.presented;
+
+    return selected;
+}
+
+_Use_decl_annotations_
+int32_t FrameRing::Select(
+    PacingMode mode,
+    int64_t displayTime)
+{
+    int32_t best = -1;
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        auto const& slot = m_slots[i];
+
+        // the frame on screen competes too, sequence 0 marks it as an old timeline
+        bool candidate =
+            slot.state == SlotState::Ready
+            ||
+            (slot.state == SlotState::Presented && mode != PacingMode::Latest && slot.sequence != 0);
+        if (!candidate)
+        {
+            continue;
+        }
+
+        if (mode == PacingMode::Floor && slot.timestamp > displayTime)
+        {
+            continue;
+        }
+
+        if (best == -1)
+        {
+            best = static_cast<int32_t>(i);
+
+            continue;
+        }
+
+        auto const& current = m_slots[best];
+
+        bool better = false;
+        switch (mode)
+        {
+        case PacingMode::Nearest:
+        {
+            int64_t distance = std::abs(slot.timestamp - displayTime);
+            int64_t bestDistance = std::abs(current.timestamp - displayTime);
+            better = distance < bestDistance || (distance == bestDistance && slot.sequence > current.sequence);
+            break;
+        }
+        case PacingMode::Floor:
+            better = slot.timestamp > current.timestamp || (slot.timestamp == current.timestamp && slot.sequence > current.sequence);
+            break;
+        default:
+            better = slot.sequence > current.sequence;
+            break;
+        }
+
+        if (better)
+        {
+            best = static_cast<int32_t>(i);
+        }
+    }
+
+    return best;
+}
+
+int32_t FrameRing::Presented()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        if (m_slots[i].state == SlotState::Presented)
+        {
+            return static_cast<int32_t>(i);
+        }
+    }
+
+    return -1;
+}
+
+FrameRing::Stats FrameRing::GetStats()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    return m_stats;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <vector>
+
+// slot ownership for the ring of output buffers shared by the frame server (producer)
+// and the unity render thread (consumer), the buffers themselves live with the caller
+// and are addressed by slot index
+//
+//   Free -> Writing -> Ready -> Presented -> Free
+//
+// the consumer keeps the slot it presented until the next present, so the producer can
+// never write into a texture that unity may still be reading from. every slot carries the
+// frame's timestamp so the consumer can pace against the display, for the media player that
+// is the playback position when the frame was copied out, not the sample's own time
+struct FrameRing
+{
+    enum class SlotState : uint8_t
+    {
+        Free = 0,
+        Writing,
+        Ready,
+        Presented,
+    };
+
+    struct Stats
+    {
+        uint64_t written;
+        uint64_t presented;
+        uint64_t dropped;   // completed but replaced before unity saw them
+        uint64_t stalled;   // producer found no slot to write into
+        uint64_t repeated;  // present kept the current frame because it was still the best match
+    };
+
+    FrameRing();
+
+    void Reset(_In_ uint32_t capacity);
+
+    uint32_t Capacity();
+
+    // producer, a free slot or the oldest ready one, -1 when every slot is busy
+    int32_t BeginWrite();
+
+    // a timestamp earlier than the previous frame is a new timeline (seek, loop),
+    // frames still queued from the old one are dropped
+    void EndWrite(_In_ int32_t slot, _In_ bool succeeded, _In_ int64_t timestamp);
+
+    // consumer, picks the frame for displayTime (media time, ignored for Latest),
+    // -1 when the frame already presented is still the right one
+    int32_t Present(_In_ PacingMode mode, _In_ int64_t displayTime);
+
+    // the slot unity is showing, -1 before the first present
+    int32_t Presented();
+
+    Stats GetStats();
+
+private:
+    struct Slot
+    {
+        SlotState state;
+        uint64_t sequence;  // order of completion
+        int64_t timestamp;  // media time, 100ns
+    };
+
+    int32_t Select(_In_ PacingMode mode, _In_ int64_t displayTime);
+
+    winrt::slim_mutex m_mutex;
+    std::vector<Slot> m_slots;
+    uint64_t m_nextSequence;
+    int64_t m_lastTimestamp;
+    Stats m_stats;
+};
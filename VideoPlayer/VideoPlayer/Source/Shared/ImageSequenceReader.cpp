@@ -0,0 +1,596 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "ImageSequenceReader.h"
+
+#include <mferror.h>
+
+#include <algorithm>
+#include <cwctype>
+
+using namespace winrt;
+
+constexpr wchar_t ImageSequenceReader::PackedExtension[];
+
+// directories carry no rate
+static constexpr uint32_t c_directoryFrameRate = 30;
+
+// png frames decoded ahead of the one asked for, out of the buffers in the pool, the rest
+// cover the samples the pipeline has not processed yet
+static constexpr uint32_t c_readAheadFrames = 4;
+static constexpr uint32_t c_poolFrames = 8;
+
+// a frame that is not ready by then fails the sample, which ends the stream
+static constexpr std::chrono::seconds c_frameTimeout(5);
+
+static constexpr uint8_t c_pngSignature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+static uint32_t ReadBigEndian32(
+    _In_reads_bytes_(4) uint8_t const* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+// the size from the IHDR chunk, which a valid png always starts with
+static HRESULT PngSize(
+    _In_reads_bytes_(size) uint8_t const* data,
+    _In_ uint64_t size,
+    _Out_ uint32_t* width,
+    _Out_ uint32_t* height)
+{
+    *width = 0;
+    *height = 0;
+
+    if (size < 24
+        || memcmp(data, c_pngSignature, sizeof(c_pngSignature)) != 0
+        || memcmp(data + 12, "IHDR", 4) != 0)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    *width = ReadBigEndian32(data + 16);
+    *height = ReadBigEndian32(data + 20);
+
+    return S_OK;
+}
+
+// name order, except that a run of digits at the end of the name counts as a number so
+// frame_9 comes before frame_10 without zero padding
+static bool NumberedLess(
+    _In_ std::wstring const& left,
+    _In_ std::wstring const& right)
+{
+    auto split = [](std::wstring const& name, std::wstring& prefix, std::wstring& digits)
+    {
+        size_t stem = name.find_last_of(L'.');
+        if (stem == std::wstring::npos)
+        {
+            stem = name.size();
+        }
+
+        size_t start = stem;
+        while (start > 0 && std::iswdigit(name[start - 1]))
+        {
+            --start;
+        }
+
+        prefix = name.substr(0, start);
+        digits = name.substr(start, stem - start);
+
+        // leading zeros do not change the number
+        size_t significant = digits.find_first_not_of(L'0');
+        digits = significant == std::wstring::npos ? std::wstring() : digits.substr(significant);
+    };
+
+    std::wstring leftPrefix, leftDigits, rightPrefix, rightDigits;
+    split(left, leftPrefix, leftDigits);
+    split(right, rightPrefix, rightDigits);
+
+    int compare = _wcsicmp(leftPrefix.c_str(), rightPrefix.c_str());
+    if (compare != 0)
+    {
+        return compare < 0;
+    }
+
+    if (leftDigits.size() != rightDigits.size())
+    {
+        return leftDigits.size() < rightDigits.size();
+    }
+
+    if (leftDigits != rightDigits)
+    {
+        return leftDigits < rightDigits;
+    }
+
+    return _wcsicmp(left.c_str(), right.c_str()) < 0;
+}
+
+ImageSequenceReader::MappedFile::MappedFile()
+    : view(nullptr)
+    , size(0)
+{
+}
+
+ImageSequenceReader::MappedFile::~MappedFile()
+{
+    if (view != nullptr)
+    {
+        UnmapViewOfFile(view);
+        view = nullptr;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT ImageSequenceReader::MappedFile::Open(
+    std::wstring const& path)
+{
+    file.attach(CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr));
+    if (!file)
+    {
+        IFR(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file.get(), &fileSize))
+    {
+        IFR(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    if (fileSize.QuadPart == 0)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    if (static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+    {
+        IFR(HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE));
+    }
+
+    mapping.attach(CreateFileMappingFromApp(file.get(), nullptr, PAGE_READONLY, 0, nullptr));
+    NULL_CHK_HR(mapping.get(), HRESULT_FROM_WIN32(GetLastError()));
+
+    view = static_cast<uint8_t const*>(MapViewOfFileFromApp(mapping.get(), FILE_MAP_READ, 0, 0));
+    NULL_CHK_HR(view, HRESULT_FROM_WIN32(GetLastError()));
+
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT ImageSequenceReader::OpenDirectory(
+    hstring const& path,
+    std::shared_ptr<RawFrameReader>& reader)
+{
+    reader = nullptr;
+
+    std::wstring directory(path.c_str());
+    while (!directory.empty() && (directory.back() == L'\\' || directory.back() == L'/'))
+    {
+        directory.pop_back();
+    }
+
+    std::vector<std::wstring> names;
+
+    WIN32_FIND_DATAW findData{};
+    HANDLE find = FindFirstFileExW((directory + L"\\*.png").c_str(), FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        DWORD error = GetLastError();
+        IFR(error == ERROR_FILE_NOT_FOUND ? MF_E_INVALID_FILE_FORMAT : HRESULT_FROM_WIN32(error));
+    }
+
+    do
+    {
+        if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+        {
+            names.push_back(findData.cFileName);
+        }
+    } while (FindNextFileW(find, &findData));
+
+    FindClose(find);
+
+    if (names.empty() || names.size() > UINT32_MAX)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    std::sort(names.begin(), names.end(), NumberedLess);
+
+    auto sequence = std::make_shared<ImageSequenceReader>();
+    sequence->m_encoding = Encoding::Png;
+
+    for (auto const& name : names)
+    {
+        sequence->m_entries.push_back(Entry{ directory + L"\\" + name, 0, 0 });
+    }
+
+    // every frame has to match the first one, checked as each is decoded
+    MappedFile first;
+    IFR(first.Open(sequence->m_entries.front().path));
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    IFR(PngSize(first.view, first.size, &width, &height));
+
+    IFR(PackedSequence::SetSize(width, height, sequence->m_format));
+    sequence->m_format.frameRateNumerator = c_directoryFrameRate;
+    sequence->m_format.frameRateDenominator = 1;
+    sequence->m_format.frameCount = static_cast<uint32_t>(sequence->m_entries.size());
+
+    IFR(sequence->Start());
+
+    reader = sequence;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT ImageSequenceReader::OpenPacked(
+    hstring const& path,
+    std::shared_ptr<RawFrameReader>& reader)
+{
+    reader = nullptr;
+
+    auto sequence = std::make_shared<ImageSequenceReader>();
+
+    IFR(sequence->m_packed.Open(path.c_str()));
+    IFR(sequence->ParsePacked());
+
+    if (sequence->m_encoding == Encoding::Png)
+    {
+        IFR(sequence->Start());
+    }
+
+    reader = sequence;
+
+    return S_OK;
+}
+
+ImageSequenceReader::ImageSequenceReader()
+    : m_prefetchStart(0)
+    , m_prefetchEnd(0)
+    , m_format{}
+    , m_encoding(Encoding::Bgra)
+    , m_playhead(0)
+    , m_stop(false)
+    , m_wicFactory(nullptr)
+{
+}
+
+ImageSequenceReader::~ImageSequenceReader()
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_poolMutex);
+
+        m_stop = true;
+    }
+
+    m_poolChanged.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+_Use_decl_annotations_
+HRESULT ImageSequenceReader::Frame(
+    uint32_t index,
+    FrameData& frame)
+{
+    frame = FrameData{};
+
+    if (index >= m_entries.size())
+    {
+        IFR(E_BOUNDS);
+    }
+
+    if (m_encoding == Encoding::Bgra)
+    {
+        return MappedFrame(index, frame);
+    }
+
+    std::unique_lock<slim_mutex> lock(m_poolMutex);
+
+    // playback order, the decode thread carries on from here, frames it decoded ahead of a
+    // seek are taken back as soon as nothing holds them
+    m_playhead = index;
+    m_poolChanged.notify_all();
+
+    int32_t slot = -1;
+    bool finished = m_poolChanged.wait_for(lock, c_frameTimeout, [this, index, &slot]()
+    {
+        slot = -1;
+        for (size_t i = 0; i < m_pool.size(); ++i)
+        {
+            if (m_pool[i].index == index && (m_pool[i].state == PoolState::Ready || m_pool[i].state == PoolState::Failed))
+            {
+                slot = static_cast<int32_t>(i);
+            }
+        }
+
+        return m_stop || slot >= 0;
+    });
+
+    if (m_stop)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    if (!finished)
+    {
+        IFR(HRESULT_FROM_WIN32(ERROR_TIMEOUT));
+    }
+
+    auto& poolFrame = m_pool[slot];
+    if (poolFrame.state == PoolState::Failed)
+    {
+        IFR(poolFrame.hr);
+    }
+
+    ++poolFrame.references;
+
+    m_playhead = index + 1;
+    m_poolChanged.notify_all();
+
+    // the buffer goes back to the pool when the sample is released, the reader lives as long
+    auto self = std::static_pointer_cast<ImageSequenceReader>(shared_from_this());
+    frame.data = poolFrame.pixels.data();
+    frame.owner = std::shared_ptr<void const>(frame.data, [self, slot](void const*)
+    {
+        self->Release(slot);
+    });
+
+    return S_OK;
+}
+
+HRESULT ImageSequenceReader::ParsePacked()
+{
+    std::vector<PackedSequence::Frame> frames;
+    IFR(PackedSequence::Parse(m_packed.view, m_packed.size, m_format, &m_encoding, frames));
+
+    m_entries.reserve(frames.size());
+    for (auto const& frame : frames)
+    {
+        m_entries.push_back(Entry{ std::wstring(), frame.offset, frame.size });
+    }
+
+    return S_OK;
+}
+
+HRESULT ImageSequenceReader::Start()
+{
+    // allocated once, the decode thread writes into them without holding the lock
+    m_pool.resize(c_poolFrames);
+    for (auto& poolFrame : m_pool)
+    {
+        try
+        {
+            poolFrame.pixels.resize(m_format.frameSize);
+        }
+        catch (std::bad_alloc const&)
+        {
+            IFR(E_OUTOFMEMORY);
+        }
+
+        poolFrame.state = PoolState::Free;
+        poolFrame.index = UINT32_MAX;
+        poolFrame.references = 0;
+        poolFrame.hr = S_OK;
+    }
+
+    m_thread = std::thread([this]()
+    {
+        ReadAhead();
+    });
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT ImageSequenceReader::MappedFrame(
+    uint32_t index,
+    FrameData& frame)
+{
+    auto const& entry = m_entries[index];
+
+    frame.data = m_packed.view + entry.offset;
+    frame.owner = shared_from_this();
+
+    // the frames after this one are asked for once playback gets near them, or after a seek,
+    // the read happens in the background and the mapping finds the pages resident
+    std::lock_guard<slim_mutex> guard(m_poolMutex);
+
+    if (index < m_prefetchStart || index + c_readAheadFrames >= m_prefetchEnd)
+    {
+        // a seek back starts over, otherwise what was asked for already is skipped
+        uint32_t start = index < m_prefetchStart ? index + 1 : std::max(index + 1, m_prefetchEnd);
+        uint32_t end = std::min<uint32_t>(static_cast<uint32_t>(m_entries.size()), index + 1 + c_readAheadFrames * 2);
+
+        std::vector<WIN32_MEMORY_RANGE_ENTRY> ranges;
+        for (uint32_t i = start; i < end; ++i)
+        {
+            ranges.push_back(WIN32_MEMORY_RANGE_ENTRY{ const_cast<uint8_t*>(m_packed.view + m_entries[i].offset), m_entries[i].size });
+        }
+
+        // only a hint, the frame is read on access either way
+        if (!ranges.empty())
+        {
+            PrefetchVirtualMemory(GetCurrentProcess(), ranges.size(), ranges.data(), 0);
+        }
+
+        m_prefetchStart = index;
+        m_prefetchEnd = end;
+    }
+
+    return S_OK;
+}
+
+void ImageSequenceReader::ReadAhead()
+{
+    bool comInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+
+    HRESULT factoryHr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(m_wicFactory.put()));
+
+    while (true)
+    {
+        uint32_t index = 0;
+        int32_t slot = -1;
+        {
+            std::unique_lock<slim_mutex> lock(m_poolMutex);
+
+            m_poolChanged.wait(lock, [this, &index, &slot]()
+            {
+                slot = NextToDecode(&index);
+
+                return m_stop || slot >= 0;
+            });
+
+            if (m_stop)
+            {
+                break;
+            }
+
+            m_pool[slot].state = PoolState::Decoding;
+            m_pool[slot].index = index;
+        }
+
+        HRESULT hr = FAILED(factoryHr) ? factoryHr : Decode(index, m_pool[slot].pixels.data());
+
+        {
+            std::lock_guard<slim_mutex> guard(m_poolMutex);
+
+            m_pool[slot].state = SUCCEEDED(hr) ? PoolState::Ready : PoolState::Failed;
+            m_pool[slot].hr = hr;
+        }
+
+        m_poolChanged.notify_all();
+    }
+
+    m_wicFactory = nullptr;
+
+    if (comInitialized)
+    {
+        CoUninitialize();
+    }
+}
+
+_Use_decl_annotations_
+int32_t ImageSequenceReader::NextToDecode(
+    uint32_t* index)
+{
+    *index = 0;
+
+    uint32_t end = std::min<uint32_t>(static_cast<uint32_t>(m_entries.size()), m_playhead + c_readAheadFrames);
+
+    // the first frame of the window that is not decoded or on its way
+    uint32_t next = m_playhead;
+    for (; next < end; ++next)
+    {
+        auto found = std::find_if(m_pool.begin(), m_pool.end(), [next](PoolFrame const& poolFrame)
+        {
+            return poolFrame.state != PoolState::Free && poolFrame.index == next;
+        });
+
+        if (found == m_pool.end())
+        {
+            break;
+        }
+    }
+
+    if (next >= end)
+    {
+        return -1;
+    }
+
+    // a buffer nothing holds and that is not part of the window
+    for (size_t i = 0; i < m_pool.size(); ++i)
+    {
+        auto const& poolFrame = m_pool[i];
+        if (poolFrame.references > 0 || poolFrame.state == PoolState::Decoding)
+        {
+            continue;
+        }
+
+        if (poolFrame.state == PoolState::Free || poolFrame.index < m_playhead || poolFrame.index >= end)
+        {
+            *index = next;
+
+            return static_cast<int32_t>(i);
+        }
+    }
+
+    return -1;
+}
+
+_Use_decl_annotations_
+HRESULT ImageSequenceReader::Decode(
+    uint32_t index,
+    uint8_t* pixels)
+{
+    auto const& entry = m_entries[index];
+
+    // directory frames are mapped one at a time, packed ones are in the file's view
+    MappedFile file;
+    uint8_t const* data = nullptr;
+    uint64_t size = 0;
+    if (!entry.path.empty())
+    {
+        IFR(file.Open(entry.path));
+
+        data = file.view;
+        size = file.size;
+    }
+    else
+    {
+        data = m_packed.view + entry.offset;
+        size = entry.size;
+    }
+
+    if (size > MAXDWORD)
+    {
+        IFR(HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE));
+    }
+
+    com_ptr<IWICStream> stream = nullptr;
+    IFR(m_wicFactory->CreateStream(stream.put()));
+    IFR(stream->InitializeFromMemory(const_cast<uint8_t*>(data), static_cast<DWORD>(size)));
+
+    com_ptr<IWICBitmapDecoder> decoder = nullptr;
+    IFR(m_wicFactory->CreateDecoderFromStream(stream.get(), nullptr, WICDecodeMetadataCacheOnDemand, decoder.put()));
+
+    com_ptr<IWICBitmapFrameDecode> bitmapFrame = nullptr;
+    IFR(decoder->GetFrame(0, bitmapFrame.put()));
+
+    UINT width = 0;
+    UINT height = 0;
+    IFR(bitmapFrame->GetSize(&width, &height));
+
+    if (width != m_format.width || height != m_format.height)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    com_ptr<IWICFormatConverter> converter = nullptr;
+    IFR(m_wicFactory->CreateFormatConverter(converter.put()));
+    IFR(converter->Initialize(bitmapFrame.get(), GUID_WICPixelFormat32bppBGRA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom));
+
+    IFR(converter->CopyPixels(nullptr, m_format.width * 4, m_format.frameSize, pixels));
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void ImageSequenceReader::Release(
+    int32_t slot)
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_poolMutex);
+
+        --m_pool[slot].references;
+    }
+
+    m_poolChanged.notify_all();
+}
@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "PackedSequence.h"
+#include "RawVideoSource.h"
+
+#include <wincodec.h>
+
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+// numbered frames played as 32 bit bgra video, either every .png of a directory in name order
+// (frame_9 before frame_10) at 30fps, or one packed file that carries its own rate:
+//
+//   header  "FSEQ", version 1, width, height, frame rate numerator, denominator, frame count
+//           and encoding (0 raw bgra, 1 png), all uint32 little endian
+//   index   per frame the uint64 offset and uint32 size of its bytes, and a reserved uint32
+//   frames  anywhere after the index
+//
+// files are mapped read only. raw frames are handed out straight from the mapping, the pages
+// of the next ones are prefetched as playback reaches them. png frames are decoded ahead of
+// playback on one background thread into a fixed pool of buffers, a frame goes back to the
+// pool once the pipeline has processed its sample
+struct ImageSequenceReader : RawFrameReader
+{
+    static constexpr wchar_t PackedExtension[] = L".fseq";
+
+    static HRESULT OpenDirectory(
+        _In_ winrt::hstring const& path,
+        _Out_ std::shared_ptr<RawFrameReader>& reader);
+
+    static HRESULT OpenPacked(
+        _In_ winrt::hstring const& path,
+        _Out_ std::shared_ptr<RawFrameReader>& reader);
+
+    ImageSequenceReader();
+    virtual ~ImageSequenceReader();
+
+    virtual Format const& GetFormat() const override { return m_format; }
+
+    virtual HRESULT Frame(_In_ uint32_t index, _Out_ FrameData& frame) override;
+
+private:
+    // a read only view of a whole file
+    struct MappedFile
+    {
+        MappedFile();
+        ~MappedFile();
+
+        HRESULT Open(_In_ std::wstring const& path);
+
+        winrt::file_handle file;
+        winrt::handle mapping;
+        uint8_t const* view;
+        uint64_t size;
+    };
+
+    using Encoding = PackedSequence::Encoding;
+
+    struct Entry
+    {
+        std::wstring path;      // directory frames, empty for packed ones
+        uint64_t offset;        // into the packed file
+        uint32_t size;
+    };
+
+    enum class PoolState
+    {
+        Free = 0,
+        Decoding,
+        Ready,
+        Failed,
+    };
+
+    struct PoolFrame
+    {
+        std::vector<uint8_t> pixels;
+        PoolState state;
+        uint32_t index;
+        uint32_t references;    // samples the pipeline still holds
+        HRESULT hr;
+    };
+
+    HRESULT ParsePacked();
+    HRESULT Start();
+
+    // raw frames of a packed file, no pool
+    HRESULT MappedFrame(_In_ uint32_t index, _Out_ FrameData& frame);
+
+    void ReadAhead();
+    int32_t NextToDecode(_Out_ uint32_t* index);
+    HRESULT Decode(_In_ uint32_t index, _Out_writes_bytes_(m_format.frameSize) uint8_t* pixels);
+    void Release(_In_ int32_t slot);
+
+    MappedFile m_packed;
+
+    // raw frames whose pages have been asked for
+    uint32_t m_prefetchStart;
+    uint32_t m_prefetchEnd;
+
+    Format m_format;
+    Encoding m_encoding;
+    std::vector<Entry> m_entries;
+
+    // the decode thread's pool, the frames from m_playhead on are decoded in order
+    winrt::slim_mutex m_poolMutex;
+    std::condition_variable_any m_poolChanged;
+    std::vector<PoolFrame> m_pool;
+    uint32_t m_playhead;
+    bool m_stop;
+    std::thread m_thread;
+
+    winrt::com_ptr<IWICImagingFactory> m_wicFactory;   // the decode thread's
+};
@@ -0,0 +1,256 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "KeyframeIndex.h"
+
+#include <mfapi.h>
+#include <mferror.h>
+#include <mfreadwrite.h>
+
+#include <algorithm>
+#include <thread>
+
+#pragma comment(lib, "mfplat")
+#pragma comment(lib, "mfreadwrite")
+
+using namespace winrt;
+
+// the first video stream's compressed samples, no media type is set so nothing is decoded
+struct ReaderSampleSource : KeyframeIndex::SampleSource
+{
+    explicit ReaderSampleSource(
+        _In_ com_ptr<IMFSourceReader> const& reader)
+        : m_reader(reader)
+    {
+    }
+
+    HRESULT Next(
+        _Out_ int64_t* timestamp,
+        _Out_ int64_t* duration,
+        _Out_ bool* keyframe) override
+    {
+        *timestamp = 0;
+        *duration = 0;
+        *keyframe = false;
+
+        for (;;)
+        {
+            DWORD streamIndex = 0;
+            DWORD flags = 0;
+            LONGLONG sampleTime = 0;
+            com_ptr<IMFSample> sample = nullptr;
+            IFR(m_reader->ReadSample(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), 0, &streamIndex, &flags, &sampleTime, sample.put()));
+
+            if ((flags & MF_SOURCE_READERF_ENDOFSTREAM) != 0)
+            {
+                return S_FALSE;
+            }
+
+            if (sample == nullptr)
+            {
+                continue;
+            }
+
+            LONGLONG sampleDuration = 0;
+            if (SUCCEEDED(sample->GetSampleDuration(&sampleDuration)))
+            {
+                *duration = sampleDuration;
+            }
+
+            *timestamp = sampleTime;
+            *keyframe = MFGetAttributeUINT32(sample.get(), MFSampleExtension_CleanPoint, FALSE) != FALSE;
+
+            return S_OK;
+        }
+    }
+
+private:
+    com_ptr<IMFSourceReader> m_reader;
+};
+
+_Use_decl_annotations_
+KeyframeIndex::KeyframeIndex(
+    hstring const& location)
+    : m_location(location)
+    , m_state(State::NotStarted)
+    , m_frameDuration(0)
+{
+}
+
+void KeyframeIndex::BuildAsync()
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_state != State::NotStarted)
+        {
+            return;
+        }
+
+        m_state = State::Building;
+    }
+
+    // the thread only holds a weak reference, a player that goes away stops the scan
+    std::weak_ptr<KeyframeIndex> weakThis = weak_from_this();
+    hstring location = m_location;
+
+    std::thread([weakThis, location]()
+    {
+        bool comInitialized = SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED));
+
+        std::vector<int64_t> keyframes;
+        int64_t frameDuration = 0;
+
+        HRESULT hr = MFStartup(MF_VERSION, MFSTARTUP_LITE);
+        if (SUCCEEDED(hr))
+        {
+            hr = Build(location, weakThis, keyframes, &frameDuration);
+
+            MFShutdown();
+        }
+
+        auto strongThis = weakThis.lock();
+        if (strongThis != nullptr)
+        {
+            std::lock_guard<slim_mutex> guard(strongThis->m_mutex);
+
+            if (SUCCEEDED(hr) && !keyframes.empty())
+            {
+                strongThis->m_keyframes.swap(keyframes);
+                strongThis->m_frameDuration = frameDuration;
+                strongThis->m_state = State::Ready;
+            }
+            else
+            {
+                strongThis->m_state = State::Failed;
+            }
+        }
+
+        if (comInitialized)
+        {
+            CoUninitialize();
+        }
+    }).detach();
+}
+
+KeyframeIndex::State KeyframeIndex::GetState()
+{
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    return m_state;
+}
+
+_Use_decl_annotations_
+bool KeyframeIndex::Nearest(
+    int64_t position,
+    int64_t* keyframe)
+{
+    *keyframe = position;
+
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    if (m_state != State::Ready)
+    {
+        return false;
+    }
+
+    *keyframe = Closest(m_keyframes, position);
+
+    return true;
+}
+
+int64_t KeyframeIndex::FrameDuration()
+{
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    return m_frameDuration;
+}
+
+_Use_decl_annotations_
+int64_t KeyframeIndex::Closest(
+    std::vector<int64_t> const& keyframes,
+    int64_t position)
+{
+    auto next = std::lower_bound(keyframes.begin(), keyframes.end(), position);
+    if (next == keyframes.end())
+    {
+        return keyframes.back();
+    }
+
+    if (next == keyframes.begin())
+    {
+        return *next;
+    }
+
+    auto previous = next - 1;
+
+    return (position - *previous <= *next - position) ? *previous : *next;
+}
+
+_Use_decl_annotations_
+HRESULT KeyframeIndex::Build(
+    SampleSource& source,
+    std::weak_ptr<KeyframeIndex> const& owner,
+    std::vector<int64_t>& keyframes,
+    int64_t* frameDuration)
+{
+    keyframes.clear();
+    *frameDuration = 0;
+
+    for (;;)
+    {
+        if (owner.expired())
+        {
+            IFR(E_ABORT);
+        }
+
+        int64_t timestamp = 0;
+        int64_t duration = 0;
+        bool keyframe = false;
+        HRESULT hr = source.Next(&timestamp, &duration, &keyframe);
+        IFR(hr);
+
+        if (hr == S_FALSE)
+        {
+            break;
+        }
+
+        if (*frameDuration == 0)
+        {
+            *frameDuration = duration;
+        }
+
+        if (keyframe)
+        {
+            keyframes.push_back(timestamp);
+        }
+    }
+
+    // samples arrive in decode order
+    std::sort(keyframes.begin(), keyframes.end());
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT KeyframeIndex::Build(
+    hstring const& location,
+    std::weak_ptr<KeyframeIndex> const& owner,
+    std::vector<int64_t>& keyframes,
+    int64_t* frameDuration)
+{
+    keyframes.clear();
+    *frameDuration = 0;
+
+    com_ptr<IMFSourceReader> reader = nullptr;
+    IFR(MFCreateSourceReaderFromURL(location.c_str(), nullptr, reader.put()));
+
+    // no media type is set, so the reader hands back compressed samples without a decoder
+    IFR(reader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_ALL_STREAMS), FALSE));
+    IFR(reader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), TRUE));
+
+    ReaderSampleSource source(reader);
+
+    return Build(source, owner, keyframes, frameDuration);
+}
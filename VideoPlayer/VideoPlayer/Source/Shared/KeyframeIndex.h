@@ -0,0 +1,71 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// presentation times of the sync samples in a source's first video stream, read from
+// the container with a source reader so nothing is decoded. built once, on a
+// background thread, the first time someone asks for it
+struct KeyframeIndex : std::enable_shared_from_this<KeyframeIndex>
+{
+    enum class State : int32_t
+    {
+        NotStarted = 0,
+        Building,
+        Ready,
+        Failed,
+    };
+
+    explicit KeyframeIndex(_In_ winrt::hstring const& location);
+
+    // no-op after the first call
+    void BuildAsync();
+
+    State GetState();
+
+    // closest keyframe to position, false until the index is ready
+    bool Nearest(_In_ int64_t position, _Out_ int64_t* keyframe);
+
+    // duration of the first video sample, 0 until the index is ready
+    int64_t FrameDuration();
+
+    // closest of sorted, non empty keyframes to position, the earlier one on a tie
+    static int64_t Closest(_In_ std::vector<int64_t> const& keyframes, _In_ int64_t position);
+
+    // what Build scans, a source reader over the file outside of the tests
+    struct SampleSource
+    {
+        virtual ~SampleSource() = default;
+
+        // the next sample in decode order, S_FALSE at the end of the stream. duration is 0
+        // when the container has none
+        virtual HRESULT Next(
+            _Out_ int64_t* timestamp,
+            _Out_ int64_t* duration,
+            _Out_ bool* keyframe) = 0;
+    };
+
+    // every sample of source, keyframes sorted. stops with E_ABORT once owner has gone
+    static HRESULT Build(
+        _In_ SampleSource& source,
+        _In_ std::weak_ptr<KeyframeIndex> const& owner,
+        _Out_ std::vector<int64_t>& keyframes,
+        _Out_ int64_t* frameDuration);
+
+private:
+    static HRESULT Build(
+        _In_ winrt::hstring const& location,
+        _In_ std::weak_ptr<KeyframeIndex> const& owner,
+        _Out_ std::vector<int64_t>& keyframes,
+        _Out_ int64_t* frameDuration);
+
+    winrt::hstring const m_location;
+
+    winrt::slim_mutex m_mutex;
+    State m_state;
+    std::vector<int64_t> m_keyframes;  // sorted
+    int64_t m_frameDuration;
+};
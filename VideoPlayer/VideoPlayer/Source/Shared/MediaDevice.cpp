@@ -0,0 +1,258 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "MediaDevice.h"
+
+#include <algorithm>
+
+using namespace winrt;
+
+// enough for a few players of the same size to come and go without reallocating, a
+// 1080p ring of 3 is about 25MB, a 4k one 100MB
+static constexpr uint64_t c_maxPooledBytes = 256ull * 1024 * 1024;
+
+static slim_mutex s_instanceMutex;
+static std::weak_ptr<MediaDevice> s_instance;
+
+static uint64_t BufferBytes(
+    _In_ SharedTextureBuffer const& buffer)
+{
+    return static_cast<uint64_t>(buffer.frameTextureDesc.Width) * buffer.frameTextureDesc.Height * 4;
+}
+
+_Use_decl_annotations_
+HRESULT MediaDevice::Acquire(
+    ID3D11Device* unityDevice,
+    std::shared_ptr<MediaDevice>& mediaDevice)
+{
+    mediaDevice = nullptr;
+
+    NULL_CHK_HR(unityDevice, E_INVALIDARG);
+
+    com_ptr<IDXGIDevice> dxgiDevice = nullptr;
+    IFR(unityDevice->QueryInterface(__uuidof(IDXGIDevice), dxgiDevice.put_void()));
+
+    com_ptr<IDXGIAdapter> dxgiAdapter = nullptr;
+    IFR(dxgiDevice->GetAdapter(dxgiAdapter.put()));
+
+    DXGI_ADAPTER_DESC adapterDesc{};
+    IFR(dxgiAdapter->GetDesc(&adapterDesc));
+
+    std::lock_guard<slim_mutex> guard(s_instanceMutex);
+
+    auto existing = s_instance.lock();
+    if (existing != nullptr
+        && existing->m_adapterLuid.LowPart == adapterDesc.AdapterLuid.LowPart
+        && existing->m_adapterLuid.HighPart == adapterDesc.AdapterLuid.HighPart)
+    {
+        mediaDevice = existing;
+
+        return S_OK;
+    }
+
+    // unity moved to another adapter, players still on the old device keep it
+    // until they are recreated, the dxgi manager follows the new one
+    std::shared_ptr<MediaDevice> created(new MediaDevice());
+    created->m_adapterLuid = adapterDesc.AdapterLuid;
+
+    IFR(CreateMediaDevice(dxgiAdapter.get(), created->m_d3dDevice.put()));
+
+    // media foundation's dxgi manager is process wide, lock it for the life of this object
+    IFR(MFLockDXGIDeviceManager(&created->m_resetToken, created->m_dxgiDeviceManager.put()));
+
+    HRESULT hr = created->m_dxgiDeviceManager->ResetDevice(created->m_d3dDevice.get(), created->m_resetToken);
+    if (FAILED(hr))
+    {
+        MFUnlockDXGIDeviceManager();
+
+        created->m_dxgiDeviceManager = nullptr;
+
+        IFR(hr);
+    }
+
+    s_instance = created;
+    mediaDevice = created;
+
+    return S_OK;
+}
+
+MediaDevice::Stats MediaDevice::GetStats()
+{
+    std::shared_ptr<MediaDevice> instance = nullptr;
+    {
+        std::lock_guard<slim_mutex> guard(s_instanceMutex);
+
+        instance = s_instance.lock();
+    }
+
+    if (instance == nullptr)
+    {
+        return Stats{};
+    }
+
+    auto stats = instance->CurrentStats();
+
+    // not counting the reference taken above
+    stats.references = static_cast<uint32_t>(instance.use_count() - 1);
+
+    return stats;
+}
+
+MediaDevice::MediaDevice()
+    : m_adapterLuid{}
+    , m_d3dDevice(nullptr)
+    , m_resetToken(0)
+    , m_dxgiDeviceManager(nullptr)
+    , m_buffersInUse(0)
+    , m_bytesInUse(0)
+    , m_bytesPooled(0)
+{
+}
+
+MediaDevice::~MediaDevice()
+{
+    m_pool.clear();
+
+    if (m_dxgiDeviceManager != nullptr)
+    {
+        // release the default media foundation dxgi manager
+        MFUnlockDXGIDeviceManager();
+
+        m_dxgiDeviceManager = nullptr;
+    }
+
+    m_d3dDevice = nullptr;
+}
+
+_Use_decl_annotations_
+HRESULT MediaDevice::CreateBuffer(
+    ID3D11Device* unityDevice,
+    uint32_t width,
+    uint32_t height,
+    std::shared_ptr<SharedTextureBuffer>& buffer)
+{
+    buffer = nullptr;
+
+    NULL_CHK_HR(unityDevice, E_INVALIDARG);
+
+    com_ptr<ID3D11Device> device = nullptr;
+    device.copy_from(unityDevice);
+
+    std::shared_ptr<SharedTextureBuffer> pooled = nullptr;
+    {
+        std::lock_guard<slim_mutex> guard(m_bufferMutex);
+
+        // buffers made on another unity device are from before a device reset, they
+        // are never handed out again
+        auto staleBegin = std::stable_partition(m_pool.begin(), m_pool.end(), [&](PooledBuffer const& entry)
+        {
+            return entry.unityDevice == device;
+        });
+        for (auto it = staleBegin; it != m_pool.end(); ++it)
+        {
+            m_bytesPooled -= BufferBytes(*it->buffer);
+        }
+        m_pool.erase(staleBegin, m_pool.end());
+
+        auto it = std::find_if(m_pool.begin(), m_pool.end(), [&](PooledBuffer const& entry)
+        {
+            return entry.buffer->frameTextureDesc.Width == width
+                && entry.buffer->frameTextureDesc.Height == height;
+        });
+
+        if (it != m_pool.end())
+        {
+            pooled = it->buffer;
+            m_pool.erase(it);
+
+            m_bytesPooled -= BufferBytes(*pooled);
+        }
+    }
+
+    if (pooled == nullptr)
+    {
+        pooled = std::make_shared<SharedTextureBuffer>();
+
+        IFR(SharedTextureBuffer::Create(unityDevice, m_dxgiDeviceManager.get(), width, height, pooled));
+    }
+
+    {
+        std::lock_guard<slim_mutex> guard(m_bufferMutex);
+
+        ++m_buffersInUse;
+        m_bytesInUse += BufferBytes(*pooled);
+    }
+
+    // the handed out pointer owns the pooled one, releasing it returns the buffer. the device
+    // reference keeps its identity, a new device can not reuse the address while it is held
+    std::weak_ptr<MediaDevice> weakThis = weak_from_this();
+    buffer = std::shared_ptr<SharedTextureBuffer>(pooled.get(), [weakThis, device, pooled](SharedTextureBuffer*)
+    {
+        auto strongThis = weakThis.lock();
+        if (strongThis != nullptr)
+        {
+            strongThis->Recycle(device, pooled);
+        }
+    });
+
+    return S_OK;
+}
+
+void MediaDevice::Trim()
+{
+    std::lock_guard<slim_mutex> guard(m_bufferMutex);
+
+    // enough for the players still running to recreate their buffers once
+    EvictPooled(m_bytesInUse);
+}
+
+_Use_decl_annotations_
+void MediaDevice::Recycle(
+    com_ptr<ID3D11Device> const& unityDevice,
+    std::shared_ptr<SharedTextureBuffer> const& buffer)
+{
+    std::lock_guard<slim_mutex> guard(m_bufferMutex);
+
+    uint64_t bytes = BufferBytes(*buffer);
+
+    --m_buffersInUse;
+    m_bytesInUse -= bytes;
+
+    if (bytes > c_maxPooledBytes)
+    {
+        return;
+    }
+
+    EvictPooled(c_maxPooledBytes - bytes);
+
+    m_pool.push_back(PooledBuffer{ unityDevice, buffer });
+    m_bytesPooled += bytes;
+}
+
+_Use_decl_annotations_
+void MediaDevice::EvictPooled(
+    uint64_t maxBytes)
+{
+    size_t evicted = 0;
+    while (evicted < m_pool.size() && m_bytesPooled > maxBytes)
+    {
+        m_bytesPooled -= BufferBytes(*m_pool[evicted].buffer);
+        ++evicted;
+    }
+
+    m_pool.erase(m_pool.begin(), m_pool.begin() + evicted);
+}
+
+MediaDevice::Stats MediaDevice::CurrentStats()
+{
+    std::lock_guard<slim_mutex> guard(m_bufferMutex);
+
+    Stats stats{};
+    stats.buffersInUse = m_buffersInUse;
+    stats.buffersPooled = static_cast<uint32_t>(m_pool.size());
+    stats.bytesInUse = m_bytesInUse;
+    stats.bytesPooled = m_bytesPooled;
+
+    return stats;
+}
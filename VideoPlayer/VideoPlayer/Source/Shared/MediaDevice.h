@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "MediaHelpers.h"
+
+#include <vector>
+
+// the decode device and the media foundation dxgi manager are dll wide, every player
+// holds a reference and the last one to let go tears them down. frame buffers are
+// allocated here too, released buffers are kept for the next player of the same size,
+// up to a byte budget
+struct MediaDevice : std::enable_shared_from_this<MediaDevice>
+{
+    // texture memory is counted as width * height * 4 per buffer
+    struct Stats
+    {
+        uint32_t references;
+        uint32_t buffersInUse;
+        uint32_t buffersPooled;
+        uint64_t bytesInUse;
+        uint64_t bytesPooled;
+    };
+
+    // the current device when it is on the same adapter as unity, otherwise a new one
+    static HRESULT Acquire(
+        _In_ ID3D11Device* unityDevice,
+        _Out_ std::shared_ptr<MediaDevice>& mediaDevice);
+
+    static Stats GetStats();
+
+    ~MediaDevice();
+
+    ID3D11Device* Device() const { return m_d3dDevice.get(); }
+    IMFDXGIDeviceManager* DeviceManager() const { return m_dxgiDeviceManager.get(); }
+
+    // goes back to the pool when the last reference is released
+    HRESULT CreateBuffer(
+        _In_ ID3D11Device* unityDevice,
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _Out_ std::shared_ptr<SharedTextureBuffer>& buffer);
+
+    // a player is going away, pooled buffers beyond what the remaining players use are freed
+    void Trim();
+
+private:
+    MediaDevice();
+
+    void Recycle(
+        _In_ winrt::com_ptr<ID3D11Device> const& unityDevice,
+        _In_ std::shared_ptr<SharedTextureBuffer> const& buffer);
+
+    // oldest first, the caller holds m_bufferMutex
+    void EvictPooled(_In_ uint64_t maxBytes);
+
+    Stats CurrentStats();
+
+private:
+    struct PooledBuffer
+    {
+        winrt::com_ptr<ID3D11Device> unityDevice;
+        std::shared_ptr<SharedTextureBuffer> buffer;
+    };
+
+    LUID m_adapterLuid;
+    winrt::com_ptr<ID3D11Device> m_d3dDevice;
+    uint32_t m_resetToken;
+    winrt::com_ptr<IMFDXGIDeviceManager> m_dxgiDeviceManager;
+
+    winrt::slim_mutex m_bufferMutex;
+    std::vector<PooledBuffer> m_pool;
+    uint32_t m_buffersInUse;
+    uint64_t m_bytesInUse;
+    uint64_t m_bytesPooled;
+};
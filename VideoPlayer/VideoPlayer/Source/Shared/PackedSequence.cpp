@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "PackedSequence.h"
+
+#include <mferror.h>
+
+static constexpr char c_packedMagic[] = "FSEQ";
+static constexpr uint32_t c_packedVersion = 1;
+
+#pragma pack(push, 4)
+struct PackedHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameRateNumerator;
+    uint32_t frameRateDenominator;
+    uint32_t frameCount;
+    uint32_t encoding;
+};
+
+struct PackedEntry
+{
+    uint64_t offset;
+    uint32_t size;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+_Use_decl_annotations_
+HRESULT PackedSequence::Parse(
+    uint8_t const* data,
+    uint64_t size,
+    RawFrameReader::Format& format,
+    Encoding* encoding,
+    std::vector<Frame>& frames)
+{
+    format = RawFrameReader::Format{};
+    *encoding = Encoding::Bgra;
+    frames.clear();
+
+    if (size < sizeof(PackedHeader))
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    PackedHeader header{};
+    memcpy(&header, data, sizeof(PackedHeader));
+
+    if (memcmp(header.magic, c_packedMagic, sizeof(header.magic)) != 0 || header.version != c_packedVersion)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    if (header.encoding != static_cast<uint32_t>(Encoding::Bgra) && header.encoding != static_cast<uint32_t>(Encoding::Png))
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    if (header.frameCount == 0 || header.frameRateNumerator == 0 || header.frameRateDenominator == 0)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    RawFrameReader::Format parsed{};
+    IFR(SetSize(header.width, header.height, parsed));
+    parsed.frameRateNumerator = header.frameRateNumerator;
+    parsed.frameRateDenominator = header.frameRateDenominator;
+    parsed.frameCount = header.frameCount;
+
+    uint64_t indexEnd = sizeof(PackedHeader) + static_cast<uint64_t>(header.frameCount) * sizeof(PackedEntry);
+    if (indexEnd > size)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    std::vector<Frame> parsedFrames;
+    parsedFrames.reserve(header.frameCount);
+    for (uint32_t i = 0; i < header.frameCount; ++i)
+    {
+        PackedEntry entry{};
+        memcpy(&entry, data + sizeof(PackedHeader) + static_cast<uint64_t>(i) * sizeof(PackedEntry), sizeof(PackedEntry));
+
+        // offset + size can wrap, the size is checked against what is left after the offset
+        if (entry.offset < indexEnd || entry.size == 0 || entry.offset > size || entry.size > size - entry.offset)
+        {
+            IFR(MF_E_INVALID_FILE_FORMAT);
+        }
+
+        // raw frames are handed out as they are, they have to be exactly one frame
+        if (header.encoding == static_cast<uint32_t>(Encoding::Bgra) && entry.size != parsed.frameSize)
+        {
+            IFR(MF_E_INVALID_FILE_FORMAT);
+        }
+
+        parsedFrames.push_back(Frame{ entry.offset, entry.size });
+    }
+
+    format = parsed;
+    *encoding = static_cast<Encoding>(header.encoding);
+    frames = std::move(parsedFrames);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PackedSequence::SetSize(
+    uint32_t width,
+    uint32_t height,
+    RawFrameReader::Format& format)
+{
+    if (width == 0 || height == 0)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    uint64_t frameSize = static_cast<uint64_t>(width) * height * 4;
+    if (frameSize > UINT32_MAX)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    format.width = width;
+    format.height = height;
+    format.frameSize = static_cast<uint32_t>(frameSize);
+    format.pixelFormat = RawFrameReader::PixelFormat::Bgra;
+
+    return S_OK;
+}
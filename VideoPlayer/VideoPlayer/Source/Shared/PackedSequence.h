@@ -0,0 +1,40 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "RawVideoSource.h"
+
+#include <vector>
+
+// the header and index of a packed image sequence, see ImageSequenceReader.h for the layout.
+// only the bytes are looked at, nothing is opened or decoded
+struct PackedSequence
+{
+    enum class Encoding : uint32_t
+    {
+        Bgra = 0,
+        Png,
+    };
+
+    struct Frame
+    {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    // every frame is checked to lie in the file after the index, raw ones to be exactly one
+    // frame. format is bgra whatever the encoding
+    static HRESULT Parse(
+        _In_reads_bytes_(size) uint8_t const* data,
+        _In_ uint64_t size,
+        _Out_ RawFrameReader::Format& format,
+        _Out_ Encoding* encoding,
+        _Out_ std::vector<Frame>& frames);
+
+    // width and height of 32 bit bgra, a frame has to fit in 4 gb
+    static HRESULT SetSize(
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _Inout_ RawFrameReader::Format& format);
+};
@@ -0,0 +1,112 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "PlaybackStats.h"
+
+// one second
+static constexpr int64_t c_fpsWindow = 10000000;
+
+// upper bounds of the copy time buckets, 0.25ms doubling to 16ms, the last bucket takes the rest
+static constexpr int64_t c_copyBucketLimits[PLAYBACK_STATS_COPY_BUCKETS - 1] = { 2500, 5000, 10000, 20000, 40000, 80000, 160000 };
+
+PlaybackStats::PlaybackStats()
+{
+    Reset();
+}
+
+void PlaybackStats::Reset()
+{
+    m_framesAvailable.store(0, std::memory_order_relaxed);
+    m_framesCopied.store(0, std::memory_order_relaxed);
+    m_framesFailed.store(0, std::memory_order_relaxed);
+
+    m_copyTimeTotal.store(0, std::memory_order_relaxed);
+    m_copyTimeMax.store(0, std::memory_order_relaxed);
+    for (auto& bucket : m_copyHistogram)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+
+    m_windowStart.store(0, std::memory_order_relaxed);
+    m_windowFrames.store(0, std::memory_order_relaxed);
+    m_effectiveFps.store(0.0f, std::memory_order_relaxed);
+}
+
+void PlaybackStats::OnFrameAvailable()
+{
+    m_framesAvailable.fetch_add(1, std::memory_order_relaxed);
+}
+
+_Use_decl_annotations_
+void PlaybackStats::OnCopied(
+    int64_t copyTime,
+    int64_t systemTime)
+{
+    m_framesCopied.fetch_add(1, std::memory_order_relaxed);
+
+    m_copyTimeTotal.fetch_add(copyTime, std::memory_order_relaxed);
+    UpdateMax(m_copyTimeMax, copyTime);
+
+    uint32_t bucket = 0;
+    while (bucket < PLAYBACK_STATS_COPY_BUCKETS - 1 && copyTime >= c_copyBucketLimits[bucket])
+    {
+        ++bucket;
+    }
+    m_copyHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    int64_t windowStart = m_windowStart.load(std::memory_order_relaxed);
+    if (windowStart == 0)
+    {
+        m_windowStart.compare_exchange_strong(windowStart, systemTime, std::memory_order_relaxed);
+
+        return;
+    }
+
+    uint32_t frames = m_windowFrames.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    int64_t elapsed = systemTime - windowStart;
+    if (elapsed >= c_fpsWindow
+        && m_windowStart.compare_exchange_strong(windowStart, systemTime, std::memory_order_relaxed))
+    {
+        m_windowFrames.fetch_sub(frames, std::memory_order_relaxed);
+        m_effectiveFps.store(static_cast<float>(frames * 10000000.0 / elapsed), std::memory_order_relaxed);
+    }
+}
+
+void PlaybackStats::OnCopyFailed()
+{
+    m_framesFailed.fetch_add(1, std::memory_order_relaxed);
+}
+
+_Use_decl_annotations_
+void PlaybackStats::Get(
+    PLAYBACK_STATS* stats)
+{
+    stats->framesAvailable = m_framesAvailable.load(std::memory_order_relaxed);
+    stats->framesCopied = m_framesCopied.load(std::memory_order_relaxed);
+    stats->framesFailed = m_framesFailed.load(std::memory_order_relaxed);
+
+    stats->effectiveFps = m_effectiveFps.load(std::memory_order_relaxed);
+
+    int64_t copyTimeTotal = m_copyTimeTotal.load(std::memory_order_relaxed);
+    stats->copyMsAverage = stats->framesCopied > 0 ? static_cast<float>(copyTimeTotal / 10000.0 / stats->framesCopied) : 0.0f;
+    stats->copyMsMax = static_cast<float>(m_copyTimeMax.load(std::memory_order_relaxed) / 10000.0);
+
+    for (uint32_t i = 0; i < PLAYBACK_STATS_COPY_BUCKETS; ++i)
+    {
+        stats->copyHistogram[i] = m_copyHistogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+_Use_decl_annotations_
+void PlaybackStats::UpdateMax(
+    std::atomic<int64_t>& value,
+    int64_t candidate)
+{
+    int64_t current = value.load(std::memory_order_relaxed);
+    while (candidate > current
+        && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+    {
+    }
+}
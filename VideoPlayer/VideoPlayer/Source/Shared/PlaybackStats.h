@@ -0,0 +1,41 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <atomic>
+
+// counters for the frame server path, updated from VideoFrameAvailable without taking a
+// lock, every field is its own relaxed atomic so a reader can see them slightly out of
+// step with each other. all times are 100ns
+struct PlaybackStats
+{
+    PlaybackStats();
+
+    // not synchronized with the producer, a frame in flight can land on either side
+    void Reset();
+
+    void OnFrameAvailable();
+    void OnCopied(_In_ int64_t copyTime, _In_ int64_t systemTime);
+    void OnCopyFailed();
+
+    // the ring counters are added by the caller
+    void Get(_Out_ PLAYBACK_STATS* stats);
+
+private:
+    static void UpdateMax(_Inout_ std::atomic<int64_t>& value, _In_ int64_t candidate);
+
+    std::atomic<uint64_t> m_framesAvailable;
+    std::atomic<uint64_t> m_framesCopied;
+    std::atomic<uint64_t> m_framesFailed;
+
+    std::atomic<int64_t> m_copyTimeTotal;
+    std::atomic<int64_t> m_copyTimeMax;
+    std::atomic<uint32_t> m_copyHistogram[PLAYBACK_STATS_COPY_BUCKETS];
+
+    // effective rate over the last complete window, the producer that crosses the window
+    // boundary publishes it
+    std::atomic<int64_t> m_windowStart;
+    std::atomic<uint32_t> m_windowFrames;
+    std::atomic<float> m_effectiveFps;
+};
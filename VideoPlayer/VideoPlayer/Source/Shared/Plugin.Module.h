@@ -18,8 +18,8 @@ namespace winrt::VideoPlayer::Plugin::implementation
     {
         Module() = default;
 
-		void Shutdown();
-		void OnRenderEvent(uint16_t frameNumber);
+		virtual void Shutdown();
+		virtual void OnRenderEvent(uint16_t frameNumber);
 
         // IModulePriv
         STDOVERRIDEMETHODIMP Initialize(_In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice, _In_ StateChangedCallback stateCallback, _In_ void* pCallbackObject);
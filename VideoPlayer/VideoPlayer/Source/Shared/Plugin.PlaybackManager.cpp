@@ -3,15 +3,49 @@
 #include "Plugin.PlaybackManager.g.cpp"
 
 #include <winrt/Windows.Media.Core.h>
+#include <winrt/Windows.Media.MediaProperties.h>
 #include <winrt/Windows.Graphics.DirectX.Direct3D11.h>
 #include <Windows.Graphics.DirectX.Direct3D11.h>
 
+#include <algorithm>
+#include <chrono>
+
 using namespace winrt;
 using namespace VideoPlayer::Plugin::implementation;
 using namespace winrt::Windows::Foundation;
 
 using winrtPlaybackManager = VideoPlayer::Plugin::PlaybackManager;
 
+// one being written, one ready and one on screen
+static constexpr uint32_t c_defaultFrameBufferCount = 3;
+static constexpr uint32_t c_minFrameBufferCount = 2;
+static constexpr uint32_t c_maxFrameBufferCount = 8;
+
+// adaptive resolution, full size and up to three smaller ones
+static constexpr uint32_t c_maxResolutionLevels = 4;
+static constexpr float c_minResolutionScale = 0.25f;
+
+// unity presents the frame it renders now on the next vsync
+static constexpr uint32_t c_defaultPacingLatencyFrames = 1;
+static constexpr uint32_t c_maxPacingLatencyFrames = 4;
+
+// sources opened ahead of the current item, the list prefetches the next one's
+// first frames this long before the current one ends
+static constexpr uint32_t c_defaultPreloadCount = 1;
+static constexpr uint32_t c_maxPreloadCount = 4;
+static constexpr TimeSpan c_prefetchTime = std::chrono::seconds(5);
+
+// multi-frame steps when the stream does not report a rate, 30fps
+static constexpr int64_t c_defaultFrameDuration = 333333;
+static constexpr double c_maxPlaybackRate = 16.0;
+
+// audio tap formats unity can ask for, the buffer is what the decoder may run ahead
+static constexpr uint32_t c_minAudioSampleRate = 8000;
+static constexpr uint32_t c_maxAudioSampleRate = 192000;
+static constexpr uint32_t c_maxAudioChannels = 8;
+static constexpr uint32_t c_minAudioBufferMs = 50;
+static constexpr uint32_t c_maxAudioBufferMs = 2000;
+
 VideoPlayer::Plugin::IModule PlaybackManager::Create(
     _In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice,
     _In_ StateChangedCallback fnCallback,
@@ -28,19 +62,47 @@ VideoPlayer::Plugin::IModule PlaybackManager::Create(
 }
 
 PlaybackManager::PlaybackManager()
-    : m_d3dDevice(nullptr)
+    : m_mediaDevice(nullptr)
+    , m_createTextureMs(0.0f)
+    , m_atlas(nullptr)
+    , m_atlasId(0)
+    , m_pendingSeek{}
+    , m_hasDeferredSeek(false)
+    , m_deferredSeek(0)
     , m_mediaPlayer(nullptr)
     , m_mediaPlaybackSession(nullptr)
-    , m_primaryBuffer(std::make_shared<SharedTextureBuffer>())
+    , m_frameBufferCount(c_defaultFrameBufferCount)
+    , m_resolutionLevels(1)
+    , m_resolutionMinScale(1.0f)
+    , m_frameBufferLevels(1)
+    , m_presentedLevel(0)
+    , m_displayTexture(nullptr)
+    , m_displayTextureSRV(nullptr)
+    , m_pacingMode(PacingMode::Nearest)
+    , m_pacingLatencyFrames(c_defaultPacingLatencyFrames)
+    , m_playbackList(nullptr)
+    , m_preloadCount(c_defaultPreloadCount)
+    , m_lastFrameItem(UINT32_MAX)
+    , m_lastFrameTime(0)
 {
 }
 
 void PlaybackManager::Shutdown()
 {
-    m_primaryBuffer.reset();
-
     ReleaseMediaPlayer();
 
+    // joins the decode thread outside the lock
+    std::shared_ptr<AudioTap> audioTap = nullptr;
+    {
+        std::lock_guard<slim_mutex> guard(m_audioTapMutex);
+
+        audioTap.swap(m_audioTap);
+    }
+
+    audioTap = nullptr;
+
+    ReleaseFrameBuffers();
+
     ReleaseResources();
 
     Module::Shutdown();
@@ -66,59 +128,921 @@ HRESULT PlaybackManager::CreatePlaybackTexture(
 
     if (width < 1 || height < 1)
     {
-        IFR(E_INVALIDARG);
+        IFR(E_INVALIDARG);
+    }
+
+    *ppvTexture = nullptr;
+
+    auto resources = m_d3d11DeviceResources.lock();
+    NULL_CHK_HR(resources, E_POINTER);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // make sure we have a reference to the shared media device
+    IFR(CreateResources(resources->GetDevice()));
+
+    IFR(CreateFrameBuffers(resources->GetDevice().get(), width, height, false));
+
+    m_createTextureMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    com_ptr<ID3D11ShaderResourceView> spSRV = nullptr;
+    m_displayTextureSRV.copy_to(spSRV.put());
+
+    *ppvTexture = spSRV.detach();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::CreateAtlasTexture(
+    UINT32 width,
+    UINT32 height,
+    void** ppvTexture,
+    ATLAS_RECT* rect)
+{
+    NULL_CHK_HR(ppvTexture, E_INVALIDARG);
+    NULL_CHK_HR(rect, E_INVALIDARG);
+
+    if (width < 1 || height < 1)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    *ppvTexture = nullptr;
+    ZeroMemory(rect, sizeof(ATLAS_RECT));
+
+    auto resources = m_d3d11DeviceResources.lock();
+    NULL_CHK_HR(resources, E_POINTER);
+
+    auto start = std::chrono::steady_clock::now();
+
+    IFR(CreateResources(resources->GetDevice()));
+
+    IFR(CreateFrameBuffers(resources->GetDevice().get(), width, height, true));
+
+    m_createTextureMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    // every player in atlas mode gets the same texture
+    com_ptr<ID3D11ShaderResourceView> spSRV = nullptr;
+    spSRV.copy_from(m_atlas->ShaderResourceView());
+
+    m_atlas->GetRect(m_atlasId, rect);
+
+    *ppvTexture = spSRV.detach();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::GetAtlasRect(
+    ATLAS_RECT* rect)
+{
+    NULL_CHK_HR(rect, E_INVALIDARG);
+
+    ZeroMemory(rect, sizeof(ATLAS_RECT));
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    NULL_CHK_HR(m_atlas, MF_E_NOT_INITIALIZED);
+
+    m_atlas->GetRect(m_atlasId, rect);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SetFrameBufferCount(
+    uint32_t count)
+{
+    if (count < c_minFrameBufferCount || count > c_maxFrameBufferCount)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    // takes effect with the next CreatePlaybackTexture
+    std::lock_guard<slim_mutex> guard(m_frameBufferMutex);
+
+    m_frameBufferCount = count;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SetAdaptiveResolution(
+    uint32_t levels,
+    float minScale)
+{
+    if (levels < 1 || levels > c_maxResolutionLevels)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    if (levels > 1 && (minScale < c_minResolutionScale || minScale >= 1.0f))
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    // takes effect with the next CreatePlaybackTexture, atlas mode always plays at full size
+    std::lock_guard<slim_mutex> guard(m_frameBufferMutex);
+
+    m_resolutionLevels = levels;
+    m_resolutionMinScale = levels > 1 ? minScale : 1.0f;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SetAudioTap(
+    uint32_t sampleRate,
+    uint32_t channels,
+    uint32_t bufferMs)
+{
+    std::shared_ptr<AudioTap> audioTap = nullptr;
+    if (sampleRate != 0)
+    {
+        if (sampleRate < c_minAudioSampleRate || sampleRate > c_maxAudioSampleRate
+            || channels < 1 || channels > c_maxAudioChannels
+            || bufferMs < c_minAudioBufferMs || bufferMs > c_maxAudioBufferMs)
+        {
+            IFR(E_INVALIDARG);
+        }
+
+        IFR(AudioTap::Create(sampleRate, channels, bufferMs, audioTap));
+
+        // picks up the item already playing, the next frame starts its clock
+        audioTap->SetSource(AudioLocation(m_lastFrameItem));
+    }
+
+    // the previous tap's thread is joined outside the lock, the audio thread never waits on it
+    {
+        std::lock_guard<slim_mutex> guard(m_audioTapMutex);
+
+        audioTap.swap(m_audioTap);
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SetPacing(
+    PacingMode mode,
+    uint32_t latencyFrames)
+{
+    if (mode < PacingMode::Latest || mode > PacingMode::Floor || latencyFrames > c_maxPacingLatencyFrames)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    m_pacingMode = mode;
+    m_pacingLatencyFrames = latencyFrames;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::GetResourceStats(
+    RESOURCE_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    ZeroMemory(stats, sizeof(RESOURCE_STATS));
+
+    auto deviceStats = MediaDevice::GetStats();
+    stats->playerCount = deviceStats.references;
+    stats->buffersInUse = deviceStats.buffersInUse;
+    stats->buffersPooled = deviceStats.buffersPooled;
+    stats->bytesInUse = deviceStats.bytesInUse;
+    stats->bytesPooled = deviceStats.bytesPooled;
+    stats->createTextureMs = m_createTextureMs;
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    stats->frameBufferCount = static_cast<uint32_t>(m_frameBuffers.size());
+    for (auto const& frameBuffer : m_frameBuffers)
+    {
+        stats->frameBufferBytes += static_cast<uint64_t>(frameBuffer->frameTextureDesc.Width) * frameBuffer->frameTextureDesc.Height * 4;
+    }
+
+    if (m_displayTexture != nullptr)
+    {
+        D3D11_TEXTURE2D_DESC desc{};
+        m_displayTexture->GetDesc(&desc);
+
+        stats->frameBufferBytes += static_cast<uint64_t>(desc.Width) * desc.Height * 4;
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void PlaybackManager::OnRenderEvent(
+    uint16_t frameNumber)
+{
+    Module::OnRenderEvent(frameNumber);
+
+    // render events arrive once per unity frame, their spacing is the display cadence
+    int64_t now = FramePacer::Now();
+    m_framePacer.OnVsync(now);
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    if (m_displayTexture == nullptr && m_atlas == nullptr)
+    {
+        return;
+    }
+
+    int32_t slot = m_frameRing.Present(m_pacingMode, m_framePacer.DisplayTime(now, m_pacingLatencyFrames));
+
+    // moved by a defragment, the frame on screen has to be painted at the new position
+    bool moved = m_atlas != nullptr && m_atlas->TakeMoved(m_atlasId);
+    if (moved)
+    {
+        CALLBACK_STATE state{};
+        ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+        state.type = CallbackType::AtlasRect;
+        m_atlas->GetRect(m_atlasId, &state.value.atlasRect);
+
+        Callback(state);
+
+        if (slot < 0)
+        {
+            slot = m_frameRing.Presented();
+        }
+    }
+
+    if (slot < 0)
+    {
+        return;
+    }
+
+    // unity's render thread, so the copy is ordered with whatever samples the texture
+    uint32_t level = m_slotLevels[slot];
+    auto const& frameBuffer = SlotBuffer(slot, level);
+    auto const& frameTexture = frameBuffer->frameTexture;
+
+    com_ptr<ID3D11Device> device = nullptr;
+    frameTexture->GetDevice(device.put());
+
+    com_ptr<ID3D11DeviceContext> context = nullptr;
+    device->GetImmediateContext(context.put());
+
+    if (m_atlas != nullptr)
+    {
+        m_atlas->Copy(context.get(), m_atlasId, frameTexture.get());
+    }
+    else if (level == 0)
+    {
+        context->CopyResource(m_displayTexture.get(), frameTexture.get());
+    }
+    else
+    {
+        // a smaller level only covers the top left of the display texture
+        D3D11_BOX box = { 0, 0, 0, frameBuffer->frameTextureDesc.Width, frameBuffer->frameTextureDesc.Height, 1 };
+        context->CopySubresourceRegion(m_displayTexture.get(), 0, 0, 0, 0, frameTexture.get(), 0, &box);
+    }
+
+    if (m_atlas == nullptr && level != m_presentedLevel)
+    {
+        m_presentedLevel = level;
+
+        D3D11_TEXTURE2D_DESC displayDesc{};
+        m_displayTexture->GetDesc(&displayDesc);
+
+        CALLBACK_STATE state{};
+        ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+        state.type = CallbackType::Resolution;
+        state.value.resolutionState.level = level;
+        state.value.resolutionState.width = frameBuffer->frameTextureDesc.Width;
+        state.value.resolutionState.height = frameBuffer->frameTextureDesc.Height;
+        state.value.resolutionState.uWidth = static_cast<float>(frameBuffer->frameTextureDesc.Width) / displayDesc.Width;
+        state.value.resolutionState.vHeight = static_cast<float>(frameBuffer->frameTextureDesc.Height) / displayDesc.Height;
+
+        Callback(state);
+    }
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::LoadContent(
+    hstring const& contentLocation)
+{
+    if (contentLocation.empty())
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    if (m_mediaPlayer == nullptr)
+    {
+        IFR(CreateMediaPlayer());
+    }
+
+    // replaces whatever was playing or queued with a new list
+    ReleasePlaybackList();
+
+    m_frameCache.Clear();
+    m_hasDeferredSeek = false;
+
+    m_playbackStats.Reset();
+
+    // the new list's first frame hands the tap its source
+    auto audioTap = CurrentAudioTap();
+    if (audioTap != nullptr)
+    {
+        audioTap->SetSource(hstring{});
+    }
+
+    IFR(CreatePlaybackList());
+
+    IFR(Enqueue(contentLocation));
+
+    Windows::Media::Playback::MediaPlaybackList playbackList = nullptr;
+    {
+        std::shared_lock<slim_mutex> slock(m_playlistMutex);
+
+        playbackList = m_playbackList;
+    }
+
+    HRESULT hr = S_OK;
+
+    try
+    {
+        m_mediaPlayer.Source(playbackList);
+    }
+    catch (hresult_error const & e)
+    {
+        hr = e.code();
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::Enqueue(
+    hstring const& contentLocation)
+{
+    if (contentLocation.empty())
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    bool hasList = false;
+    {
+        std::shared_lock<slim_mutex> slock(m_playlistMutex);
+
+        hasList = m_playbackList != nullptr;
+    }
+
+    if (!hasList)
+    {
+        return LoadContent(contentLocation);
+    }
+
+    HRESULT hr = S_OK;
+    uint32_t currentIndex = UINT32_MAX;
+
+    try
+    {
+        // raw frames and image sequences are served by a reader, everything else goes to media foundation
+        std::shared_ptr<RawVideoSource> rawSource = nullptr;
+        Windows::Media::Core::MediaSource mediaSource = nullptr;
+        if (RawFrameReader::IsSupported(contentLocation))
+        {
+            std::shared_ptr<RawFrameReader> reader = nullptr;
+            IFR(RawFrameReader::Open(contentLocation, reader));
+            IFR(RawVideoSource::Create(reader, rawSource));
+
+            mediaSource = Windows::Media::Core::MediaSource::CreateFromMediaStreamSource(rawSource->StreamSource());
+        }
+        else
+        {
+            auto uri = Windows::Foundation::Uri(contentLocation);
+
+            mediaSource = Windows::Media::Core::MediaSource::CreateFromUri(uri);
+        }
+
+        auto mediaItem = Windows::Media::Playback::MediaPlaybackItem(mediaSource);
+
+        std::lock_guard<slim_mutex> guard(m_playlistMutex);
+
+        NULL_CHK_HR(m_playbackList, MF_E_SHUTDOWN);
+
+        m_playlist.push_back(PlaylistEntry{ mediaSource, nullptr, contentLocation, nullptr, rawSource });
+        m_playbackList.Items().Append(mediaItem);
+
+        currentIndex = m_playbackList.CurrentItemIndex();
+    }
+    catch (hresult_error const & e)
+    {
+        hr = e.code();
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        Preload(currentIndex);
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::Seek(
+    int64_t position,
+    SeekMode mode)
+{
+    NULL_CHK_HR(m_mediaPlaybackSession, MF_E_NOT_INITIALIZED);
+
+    if (position < 0 || mode < SeekMode::Exact || mode > SeekMode::Keyframe)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    // the frame is already decoded, nothing for the decoder to do until play resumes
+    int64_t cachedTimestamp = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (ServeFromCache(position, &cachedTimestamp))
+    {
+        m_hasDeferredSeek = true;
+        m_deferredSeek = position;
+
+        CALLBACK_STATE state{};
+        ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+        state.type = CallbackType::Seek;
+        state.value.seekState.requested = position;
+        state.value.seekState.position = cachedTimestamp;
+        state.value.seekState.latencyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        state.value.seekState.mode = mode;
+        state.value.seekState.cached = 1;
+
+        Callback(state);
+
+        return S_OK;
+    }
+
+    m_hasDeferredSeek = false;
+
+    int64_t target = position;
+    if (mode == SeekMode::Keyframe)
+    {
+        // the first keyframe seek on a source starts indexing it, until that is done
+        // the seek is exact
+        auto keyframes = CurrentKeyframeIndex();
+        if (keyframes != nullptr)
+        {
+            keyframes->Nearest(position, &target);
+        }
+    }
+
+    return SeekTo(position, target, mode);
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::Step(
+    int32_t frames)
+{
+    NULL_CHK_HR(m_mediaPlayer, MF_E_NOT_INITIALIZED);
+    NULL_CHK_HR(m_mediaPlaybackSession, MF_E_NOT_INITIALIZED);
+
+    if (frames == 0)
+    {
+        return S_OK;
+    }
+
+    IFR(ApplyDeferredSeek());
+
+    HRESULT hr = S_OK;
+
+    try
+    {
+        // single steps pause and let the player find the neighbouring frame
+        if (frames == 1)
+        {
+            m_mediaPlayer.StepForwardOneFrame();
+
+            return S_OK;
+        }
+
+        if (frames == -1)
+        {
+            m_mediaPlayer.StepBackwardOneFrame();
+
+            return S_OK;
+        }
+
+        m_mediaPlayer.Pause();
+
+        int64_t position = m_mediaPlaybackSession.Position().count() + static_cast<int64_t>(frames) * CurrentFrameDuration();
+
+        int64_t duration = m_mediaPlaybackSession.NaturalDuration().count();
+        position = std::clamp<int64_t>(position, 0, duration > 0 ? duration : position);
+
+        hr = SeekTo(position, position, SeekMode::Exact);
+    }
+    catch (hresult_error const & e)
+    {
+        hr = e.code();
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SetRate(
+    double rate)
+{
+    NULL_CHK_HR(m_mediaPlaybackSession, MF_E_NOT_INITIALIZED);
+
+    if (!(rate > 0.0) || rate > c_maxPlaybackRate)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    HRESULT hr = S_OK;
+
+    try
+    {
+        m_mediaPlaybackSession.PlaybackRate(rate);
+    }
+    catch (hresult_error const & e)
+    {
+        hr = e.code();
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SeekTo(
+    int64_t requested,
+    int64_t position,
+    SeekMode mode)
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_seekMutex);
+
+        m_pendingSeek = PendingSeek{ true, mode, requested, position, std::chrono::steady_clock::now() };
+    }
+
+    HRESULT hr = S_OK;
+
+    try
+    {
+        m_mediaPlaybackSession.Position(TimeSpan(position));
+    }
+    catch (hresult_error const & e)
+    {
+        hr = e.code();
+
+        std::lock_guard<slim_mutex> guard(m_seekMutex);
+
+        m_pendingSeek.active = false;
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+bool PlaybackManager::ServeFromCache(
+    int64_t position,
+    int64_t* timestamp)
+{
+    *timestamp = 0;
+
+    if (!m_frameCache.Enabled() || m_mediaDevice == nullptr)
+    {
+        return false;
+    }
+
+    // while playing the decoder is producing frames anyway
+    try
+    {
+        if (m_mediaPlaybackSession.PlaybackState() != Windows::Media::Playback::MediaPlaybackState::Paused)
+        {
+            return false;
+        }
+    }
+    catch (hresult_error const&)
+    {
+        return false;
+    }
+
+    int64_t tolerance = CurrentFrameDuration();
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    int32_t slot = m_frameRing.BeginWrite();
+    if (slot < 0)
+    {
+        return false;
+    }
+
+    com_ptr<ID3D11DeviceContext> context = nullptr;
+    m_mediaDevice->Device()->GetImmediateContext(context.put());
+
+    // only full size frames are cached
+    m_slotLevels[slot] = 0;
+
+    bool hit = m_frameCache.CopyTo(context.get(), position, tolerance, SlotBuffer(slot, 0)->mediaTexture.get(), timestamp);
+    if (hit)
+    {
+        context->Flush();
+
+        // a jump, not playback, start the clock over at the cached frame
+        m_framePacer.Reset();
+        m_framePacer.OnFrame(*timestamp, FramePacer::Now(), 1.0);
+    }
+
+    m_frameRing.EndWrite(slot, hit, *timestamp);
+
+    return hit;
+}
+
+HRESULT PlaybackManager::ApplyDeferredSeek()
+{
+    if (!m_hasDeferredSeek)
+    {
+        return S_OK;
+    }
+
+    m_hasDeferredSeek = false;
+
+    NULL_CHK_HR(m_mediaPlaybackSession, MF_E_NOT_INITIALIZED);
+
+    HRESULT hr = S_OK;
+
+    try
+    {
+        m_mediaPlaybackSession.Position(TimeSpan(m_deferredSeek));
+    }
+    catch (hresult_error const & e)
+    {
+        hr = e.code();
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::SetFrameCacheBudget(
+    uint64_t bytes)
+{
+    m_frameCache.SetBudget(bytes);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::GetFrameCacheStats(
+    FRAME_CACHE_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    auto cacheStats = m_frameCache.GetStats();
+
+    stats->hits = cacheStats.hits;
+    stats->misses = cacheStats.misses;
+    stats->evictions = cacheStats.evictions;
+    stats->bytes = cacheStats.bytes;
+    stats->budget = cacheStats.budget;
+    stats->frames = cacheStats.frames;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::GetRawSourceStats(
+    RAW_SOURCE_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    auto rawSource = CurrentRawSource();
+    NULL_CHK_HR(rawSource, E_NOT_VALID_STATE);
+
+    rawSource->GetStats(stats);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::GetStats(
+    PLAYBACK_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    ZeroMemory(stats, sizeof(PLAYBACK_STATS));
+
+    m_playbackStats.Get(stats);
+
+    auto ringStats = m_frameRing.GetStats();
+    stats->framesStalled = ringStats.stalled;
+    stats->framesDropped = ringStats.dropped;
+    stats->framesPresented = ringStats.presented;
+    stats->framesRepeated = ringStats.repeated;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::ReadAudio(
+    float* buffer,
+    uint32_t frames,
+    uint32_t channels,
+    int64_t* timestamp,
+    uint32_t* framesRead)
+{
+    NULL_CHK_HR(buffer, E_INVALIDARG);
+    NULL_CHK_HR(timestamp, E_INVALIDARG);
+    NULL_CHK_HR(framesRead, E_INVALIDARG);
+
+    *timestamp = -1;
+    *framesRead = 0;
+
+    std::shared_lock<slim_mutex> slock(m_audioTapMutex);
+
+    NULL_CHK_HR(m_audioTap, E_NOT_VALID_STATE);
+
+    if (channels != m_audioTap->Channels())
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    m_audioTap->Read(buffer, frames, timestamp, framesRead);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::GetAudioTapStats(
+    AUDIO_TAP_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    ZeroMemory(stats, sizeof(AUDIO_TAP_STATS));
+
+    auto audioTap = CurrentAudioTap();
+    NULL_CHK_HR(audioTap, E_NOT_VALID_STATE);
+
+    audioTap->GetStats(stats);
+
+    return S_OK;
+}
+
+std::shared_ptr<RawVideoSource> PlaybackManager::CurrentRawSource()
+{
+    std::shared_lock<slim_mutex> slock(m_playlistMutex);
+
+    if (m_playbackList == nullptr)
+    {
+        return nullptr;
+    }
+
+    uint32_t currentIndex = UINT32_MAX;
+    try
+    {
+        currentIndex = m_playbackList.CurrentItemIndex();
+    }
+    catch (hresult_error const&)
+    {
+        return nullptr;
+    }
+
+    if (currentIndex >= m_playlist.size())
+    {
+        return nullptr;
+    }
+
+    return m_playlist[currentIndex].rawSource;
+}
+
+std::shared_ptr<AudioTap> PlaybackManager::CurrentAudioTap()
+{
+    std::shared_lock<slim_mutex> slock(m_audioTapMutex);
+
+    return m_audioTap;
+}
+
+_Use_decl_annotations_
+hstring PlaybackManager::AudioLocation(
+    uint32_t itemIndex)
+{
+    std::shared_lock<slim_mutex> slock(m_playlistMutex);
+
+    // raw items have no audio, the tap idles through them
+    if (itemIndex >= m_playlist.size() || m_playlist[itemIndex].rawSource != nullptr)
+    {
+        return hstring{};
+    }
+
+    return m_playlist[itemIndex].location;
+}
+
+std::shared_ptr<KeyframeIndex> PlaybackManager::CurrentKeyframeIndex()
+{
+    std::lock_guard<slim_mutex> guard(m_playlistMutex);
+
+    if (m_playbackList == nullptr)
+    {
+        return nullptr;
+    }
+
+    uint32_t currentIndex = UINT32_MAX;
+    try
+    {
+        currentIndex = m_playbackList.CurrentItemIndex();
+    }
+    catch (hresult_error const&)
+    {
+        return nullptr;
     }
 
-    *ppvTexture = nullptr;
-
-    m_primaryBuffer->Reset();
+    if (currentIndex >= m_playlist.size())
+    {
+        return nullptr;
+    }
 
-    auto resources = m_d3d11DeviceResources.lock();
-    NULL_CHK_HR(resources, E_POINTER);
+    auto& entry = m_playlist[currentIndex];
+    if (entry.keyframes == nullptr)
+    {
+        entry.keyframes = std::make_shared<KeyframeIndex>(entry.location);
+        entry.keyframes->BuildAsync();
+    }
 
-    // make sure we have created our own d3d device
-    IFR(CreateResources(resources->GetDevice()));
+    return entry.keyframes;
+}
 
-    IFR(SharedTextureBuffer::Create(resources->GetDevice().get(), m_dxgiDeviceManager.get(), width, height, m_primaryBuffer));
+int64_t PlaybackManager::CurrentFrameDuration()
+{
+    Windows::Media::Playback::MediaPlaybackItem currentItem = nullptr;
+    {
+        std::shared_lock<slim_mutex> slock(m_playlistMutex);
 
-    com_ptr<ID3D11ShaderResourceView> spSRV = nullptr;
-    m_primaryBuffer->frameTextureSRV.copy_to(spSRV.put());
+        if (m_playbackList != nullptr)
+        {
+            try
+            {
+                currentItem = m_playbackList.CurrentItem();
+            }
+            catch (hresult_error const&)
+            {
+            }
+        }
+    }
 
-    *ppvTexture = spSRV.detach();
+    try
+    {
+        if (currentItem != nullptr && currentItem.VideoTracks().Size() > 0)
+        {
+            auto frameRate = currentItem.VideoTracks().GetAt(0).GetEncodingProperties().FrameRate();
+            if (frameRate.Numerator() > 0 && frameRate.Denominator() > 0)
+            {
+                return static_cast<int64_t>(10000000) * frameRate.Denominator() / frameRate.Numerator();
+            }
+        }
+    }
+    catch (hresult_error const&)
+    {
+    }
 
-    return S_OK;
+    return c_defaultFrameDuration;
 }
 
 _Use_decl_annotations_
-HRESULT PlaybackManager::LoadContent(
-    hstring const& contentLocation)
+HRESULT PlaybackManager::SetPreloadCount(
+    uint32_t count)
 {
-    if (contentLocation.empty())
+    if (count > c_maxPreloadCount)
     {
         IFR(E_INVALIDARG);
     }
 
-    if (m_mediaPlayer == nullptr)
+    uint32_t currentIndex = UINT32_MAX;
     {
-        IFR(CreateMediaPlayer());
-    }
+        std::lock_guard<slim_mutex> guard(m_playlistMutex);
 
-    HRESULT hr = S_OK;
-
-    try
-    {
-        auto uri = Windows::Foundation::Uri(contentLocation);
+        m_preloadCount = count;
 
-        auto mediaSource = Windows::Media::Core::MediaSource::CreateFromUri(uri);
+        if (m_playbackList == nullptr)
+        {
+            return S_OK;
+        }
 
-        m_mediaPlayer.Source(mediaSource);
-    }
-    catch (hresult_error const & e)
-    {
-        hr = e.code();
+        try
+        {
+            currentIndex = m_playbackList.CurrentItemIndex();
+        }
+        catch (hresult_error const&)
+        {
+        }
     }
 
-    return hr;
+    Preload(currentIndex);
+
+    return S_OK;
 }
 
 _Use_decl_annotations_
@@ -126,6 +1050,8 @@ HRESULT PlaybackManager::Play()
 {
     NULL_CHK_HR(m_mediaPlayer, MF_E_NOT_INITIALIZED);
 
+    IFR(ApplyDeferredSeek());
+
     HRESULT hr = S_OK;
 
     try
@@ -175,6 +1101,11 @@ HRESULT PlaybackManager::Stop()
         hr = e.code();
     }
 
+    ReleasePlaybackList();
+
+    m_frameCache.Clear();
+    m_hasDeferredSeek = false;
+
     return hr;
 }
 
@@ -248,10 +1179,7 @@ HRESULT PlaybackManager::CreateMediaPlayer()
         UNREFERENCED_PARAMETER(sender);
         UNREFERENCED_PARAMETER(args);
 
-        if (nullptr != m_primaryBuffer->mediaSurface)
-        {
-            m_mediaPlayer.CopyFrameToVideoSurface(m_primaryBuffer->mediaSurface);
-        }
+        OnVideoFrameAvailable();
     });
 
     m_mediaPlaybackSession = m_mediaPlayer.PlaybackSession();
@@ -280,6 +1208,54 @@ HRESULT PlaybackManager::CreateMediaPlayer()
             state.value.playbackState.state = MediaPlayerState::None;
         }
 
+        // frames only move the tap's clock while they arrive, a pause has to stop it
+        auto audioTap = CurrentAudioTap();
+        if (audioTap != nullptr)
+        {
+            try
+            {
+                bool playing = state.value.playbackState.state == MediaPlayerState::Playing;
+
+                audioTap->SetClock(
+                    m_mediaPlaybackSession.Position().count(),
+                    FramePacer::Now(),
+                    playing ? m_mediaPlaybackSession.PlaybackRate() : 0.0);
+            }
+            catch (hresult_error const&)
+            {
+            }
+        }
+
+        Callback(state);
+    });
+
+    m_seekCompletedToken = m_mediaPlaybackSession.SeekCompleted([=](Windows::Media::Playback::MediaPlaybackSession const& sender, Windows::Foundation::IInspectable const& args)
+    {
+        UNREFERENCED_PARAMETER(sender);
+        UNREFERENCED_PARAMETER(args);
+
+        PendingSeek pendingSeek{};
+        {
+            std::lock_guard<slim_mutex> guard(m_seekMutex);
+
+            pendingSeek = m_pendingSeek;
+            m_pendingSeek.active = false;
+        }
+
+        if (!pendingSeek.active)
+        {
+            return;
+        }
+
+        CALLBACK_STATE state{};
+        ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+        state.type = CallbackType::Seek;
+        state.value.seekState.requested = pendingSeek.requested;
+        state.value.seekState.position = pendingSeek.position;
+        state.value.seekState.latencyMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - pendingSeek.start).count();
+        state.value.seekState.mode = pendingSeek.mode;
+
         Callback(state);
     });
 
@@ -307,16 +1283,389 @@ void PlaybackManager::FillPlaybackState(PLAYBACK_STATE& playbackState)
 }
 
 
+_Use_decl_annotations_
+HRESULT PlaybackManager::CreateFrameBuffers(
+    ID3D11Device* unityDevice,
+    uint32_t width,
+    uint32_t height,
+    bool atlas)
+{
+    ReleaseFrameBuffers();
+
+    std::lock_guard<slim_mutex> guard(m_frameBufferMutex);
+
+    // evenly spaced from full size down to the smallest, every size even for the decoder
+    std::vector<float> scales{ 1.0f };
+    uint32_t levels = atlas ? 1 : m_resolutionLevels;
+    for (uint32_t level = 1; level < levels; ++level)
+    {
+        scales.push_back(1.0f - (1.0f - m_resolutionMinScale) * level / (levels - 1));
+    }
+
+    std::vector<std::shared_ptr<SharedTextureBuffer>> frameBuffers;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        uint32_t levelWidth = width;
+        uint32_t levelHeight = height;
+        if (level > 0)
+        {
+            levelWidth = std::max(2u, static_cast<uint32_t>(width * scales[level] + 0.5f) & ~1u);
+            levelHeight = std::max(2u, static_cast<uint32_t>(height * scales[level] + 0.5f) & ~1u);
+        }
+
+        for (uint32_t i = 0; i < m_frameBufferCount; ++i)
+        {
+            std::shared_ptr<SharedTextureBuffer> frameBuffer = nullptr;
+
+            IFR(m_mediaDevice->CreateBuffer(unityDevice, levelWidth, levelHeight, frameBuffer));
+
+            frameBuffers.push_back(frameBuffer);
+        }
+    }
+
+    m_frameBufferLevels = levels;
+    m_slotLevels.assign(m_frameBufferCount, 0);
+    m_adaptiveResolution.Reset(scales, AdaptiveResolution::DefaultSettings());
+    m_presentedLevel = 0;
+
+    if (atlas)
+    {
+        std::shared_ptr<VideoAtlas> videoAtlas = nullptr;
+        IFR(VideoAtlas::Acquire(unityDevice, videoAtlas));
+
+        uint32_t atlasId = 0;
+        IFR(videoAtlas->Allocate(width, height, &atlasId));
+
+        m_frameBuffers.swap(frameBuffers);
+        m_atlas = videoAtlas;
+        m_atlasId = atlasId;
+
+        m_frameRing.Reset(m_frameBufferCount);
+        m_framePacer.Reset();
+
+        return S_OK;
+    }
+
+    // what unity samples, only ever written on the render thread
+    auto textureDesc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_B8G8R8A8_UNORM, width, height);
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    textureDesc.MipLevels = 1;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+    com_ptr<ID3D11Texture2D> displayTexture = nullptr;
+    IFR(unityDevice->CreateTexture2D(&textureDesc, nullptr, displayTexture.put()));
+
+    auto srvDesc = CD3D11_SHADER_RESOURCE_VIEW_DESC(displayTexture.get(), D3D11_SRV_DIMENSION_TEXTURE2D);
+
+    com_ptr<ID3D11ShaderResourceView> displayTextureSRV = nullptr;
+    IFR(unityDevice->CreateShaderResourceView(displayTexture.get(), &srvDesc, displayTextureSRV.put()));
+
+    m_frameBuffers.swap(frameBuffers);
+    m_displayTexture = displayTexture;
+    m_displayTextureSRV = displayTextureSRV;
+
+    m_frameRing.Reset(m_frameBufferCount);
+    m_framePacer.Reset();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void PlaybackManager::ReleaseFrameBuffers()
+{
+    std::lock_guard<slim_mutex> guard(m_frameBufferMutex);
+
+    m_frameRing.Reset(0);
+
+    m_frameBuffers.clear();
+    m_frameBufferLevels = 1;
+    m_slotLevels.clear();
+    m_displayTextureSRV = nullptr;
+    m_displayTexture = nullptr;
+
+    if (m_atlas != nullptr)
+    {
+        m_atlas->Free(m_atlasId);
+
+        m_atlas = nullptr;
+        m_atlasId = 0;
+    }
+}
+
+_Use_decl_annotations_
+std::shared_ptr<SharedTextureBuffer> const& PlaybackManager::SlotBuffer(
+    int32_t slot,
+    uint32_t level)
+{
+    // the ring has one slot per buffer of a level, the caller holds m_frameBufferMutex
+    size_t ringSize = m_frameBuffers.size() / m_frameBufferLevels;
+
+    return m_frameBuffers[level * ringSize + slot];
+}
+
+_Use_decl_annotations_
+void PlaybackManager::OnVideoFrameAvailable()
+{
+    m_playbackStats.OnFrameAvailable();
+
+    std::shared_lock<slim_mutex> slock(m_frameBufferMutex);
+
+    int32_t slot = m_frameRing.BeginWrite();
+    if (slot < 0)
+    {
+        return;
+    }
+
+    bool succeeded = false;
+    int64_t timestamp = 0;
+    int64_t copyTime = -1;
+
+    // the size the controller settled on, the copy scales to it
+    uint32_t level = m_adaptiveResolution.Level();
+    auto const& frameBuffer = SlotBuffer(slot, level);
+    m_slotLevels[slot] = level;
+
+    try
+    {
+        // the frame server does not say which sample it copies out, the frame is tagged with
+        // the session position when it became available. that follows the sample times but
+        // is not them, it moves with when the callback runs
+        if (m_mediaPlaybackSession != nullptr)
+        {
+            timestamp = m_mediaPlaybackSession.Position().count();
+
+            int64_t now = FramePacer::Now();
+            double rate = m_mediaPlaybackSession.PlaybackRate();
+            m_framePacer.OnFrame(timestamp, now, rate);
+
+            auto audioTap = CurrentAudioTap();
+            if (audioTap != nullptr)
+            {
+                audioTap->SetClock(timestamp, now, rate);
+            }
+        }
+
+        int64_t copyStart = FramePacer::Now();
+
+        m_mediaPlayer.CopyFrameToVideoSurface(frameBuffer->mediaSurface);
+
+        int64_t copyEnd = FramePacer::Now();
+        copyTime = copyEnd - copyStart;
+        m_playbackStats.OnCopied(copyTime, copyEnd);
+
+        com_ptr<ID3D11DeviceContext> context = nullptr;
+        m_mediaDevice->Device()->GetImmediateContext(context.put());
+
+        if (level == 0 && m_frameCache.Enabled())
+        {
+            m_frameCache.Insert(context.get(), timestamp, frameBuffer->mediaTexture.get());
+        }
+
+        // make sure the copy is submitted before the render thread can pick the slot
+        context->Flush();
+
+        succeeded = true;
+    }
+    catch (hresult_error const&)
+    {
+        m_playbackStats.OnCopyFailed();
+    }
+
+    m_frameRing.EndWrite(slot, succeeded, timestamp);
+
+    // only what the copy path could not keep up with. failures come in as copyTime < 0, stalls
+    // return before this and are taken from the ring's running count. dropped frames were
+    // copied fine, unity just replaced them before showing them
+    if (m_adaptiveResolution.LevelCount() > 1)
+    {
+        m_adaptiveResolution.OnFrame(FramePacer::Now(), copyTime, AdaptiveResolution::LostFrames(m_frameRing.GetStats()));
+    }
+
+    if (succeeded)
+    {
+        UpdateTransition(FramePacer::Now());
+
+        auto rawSource = CurrentRawSource();
+        if (rawSource != nullptr)
+        {
+            rawSource->OnFrameAvailable(timestamp);
+        }
+    }
+}
+
+_Use_decl_annotations_
+HRESULT PlaybackManager::CreatePlaybackList()
+{
+    Windows::Media::Playback::MediaPlaybackList playbackList = nullptr;
+    event_token currentItemChangedToken{};
+
+    try
+    {
+        playbackList = Windows::Media::Playback::MediaPlaybackList();
+
+        // the list opens and decodes the start of the next item while this one plays out,
+        // and releases items once they have been played
+        playbackList.MaxPrefetchTime(c_prefetchTime);
+        playbackList.MaxPlayedItemsToKeepOpen(1);
+
+        currentItemChangedToken = playbackList.CurrentItemChanged([=](Windows::Media::Playback::MediaPlaybackList const& sender, Windows::Media::Playback::CurrentMediaPlaybackItemChangedEventArgs const& args)
+        {
+            UNREFERENCED_PARAMETER(args);
+
+            uint32_t currentIndex = UINT32_MAX;
+            try
+            {
+                currentIndex = sender.CurrentItemIndex();
+            }
+            catch (hresult_error const&)
+            {
+                return;
+            }
+
+            Preload(currentIndex);
+        });
+    }
+    catch (hresult_error const & e)
+    {
+        IFR(e.code());
+    }
+
+    std::lock_guard<slim_mutex> guard(m_playlistMutex);
+
+    m_playbackList = playbackList;
+    m_currentItemChangedToken = currentItemChangedToken;
+    m_lastFrameItem = UINT32_MAX;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void PlaybackManager::ReleasePlaybackList()
+{
+    std::lock_guard<slim_mutex> guard(m_playlistMutex);
+
+    if (m_playbackList != nullptr)
+    {
+        m_playbackList.CurrentItemChanged(m_currentItemChangedToken);
+
+        m_playbackList = nullptr;
+    }
+
+    for (auto& entry : m_playlist)
+    {
+        if (entry.opening != nullptr)
+        {
+            entry.opening.Cancel();
+        }
+    }
+
+    m_playlist.clear();
+}
+
+_Use_decl_annotations_
+void PlaybackManager::Preload(
+    uint32_t currentIndex)
+{
+    std::lock_guard<slim_mutex> guard(m_playlistMutex);
+
+    // before the list starts the first item is what it opens itself
+    size_t first = static_cast<size_t>(currentIndex < m_playlist.size() ? currentIndex : 0) + 1;
+    size_t last = std::min(m_playlist.size(), first + m_preloadCount);
+
+    for (size_t i = first; i < last; ++i)
+    {
+        auto& entry = m_playlist[i];
+        if (entry.opening != nullptr)
+        {
+            continue;
+        }
+
+        try
+        {
+            // resolves the uri and parses the container on a background thread,
+            // a failure shows up as MediaFailed once the list reaches the item
+            if (!entry.source.IsOpen())
+            {
+                entry.opening = entry.source.OpenAsync();
+            }
+        }
+        catch (hresult_error const&)
+        {
+        }
+    }
+}
+
+_Use_decl_annotations_
+void PlaybackManager::UpdateTransition(
+    int64_t systemTime)
+{
+    uint32_t itemIndex = UINT32_MAX;
+    uint32_t itemCount = 0;
+    {
+        std::shared_lock<slim_mutex> slock(m_playlistMutex);
+
+        if (m_playbackList == nullptr)
+        {
+            return;
+        }
+
+        try
+        {
+            itemIndex = m_playbackList.CurrentItemIndex();
+            itemCount = m_playbackList.Items().Size();
+        }
+        catch (hresult_error const&)
+        {
+            return;
+        }
+    }
+
+    uint32_t lastFrameItem = m_lastFrameItem.exchange(itemIndex);
+    int64_t lastFrameTime = m_lastFrameTime;
+    m_lastFrameTime = systemTime;
+
+    if (itemIndex == lastFrameItem)
+    {
+        return;
+    }
+
+    // cached timestamps belong to the previous item
+    m_frameCache.Clear();
+
+    auto audioTap = CurrentAudioTap();
+    if (audioTap != nullptr)
+    {
+        audioTap->SetSource(AudioLocation(itemIndex));
+    }
+
+    CALLBACK_STATE state{};
+    ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+    state.type = CallbackType::Playlist;
+    state.value.playlistState.itemIndex = itemIndex;
+    state.value.playlistState.itemCount = itemCount;
+
+    // a seamless switch is one frame interval, anything beyond that was visible as a stall
+    state.value.playlistState.transitionGapMs = lastFrameItem == UINT32_MAX
+        ? -1.0f
+        : static_cast<float>(systemTime - lastFrameTime) / 10000.0f;
+
+    Callback(state);
+}
+
 _Use_decl_annotations_
 void PlaybackManager::ReleaseMediaPlayer()
 {
     if (m_mediaPlaybackSession != nullptr)
     {
         m_mediaPlaybackSession.PlaybackStateChanged(m_stateChangedEventToken);
+        m_mediaPlaybackSession.SeekCompleted(m_seekCompletedToken);
 
         m_mediaPlaybackSession = nullptr;
     }
 
+    ReleasePlaybackList();
+
     if (m_mediaPlayer != nullptr)
     {
         m_mediaPlayer.MediaEnded(m_endedToken);
@@ -331,36 +1680,18 @@ void PlaybackManager::ReleaseMediaPlayer()
 _Use_decl_annotations_
 HRESULT PlaybackManager::CreateResources(com_ptr<ID3D11Device> const& unityDevice)
 {
-    if (m_d3dDevice != nullptr)
+    if (m_mediaDevice != nullptr)
     {
         return S_OK;
     }
 
     NULL_CHK_HR(unityDevice, E_INVALIDARG);
 
-    auto sdxgiDevice = unityDevice.as<IDXGIDevice>();
-    NULL_CHK_HR(sdxgiDevice, E_POINTER);
-
-    com_ptr<IDXGIAdapter> dxgiAdapter = nullptr;
-    IFR(sdxgiDevice->GetAdapter(dxgiAdapter.put()));
-
-    // create dx device for media pipeline
-    com_ptr<ID3D11Device> d3dDevice = nullptr;
-    IFR(CreateMediaDevice(dxgiAdapter.get(), d3dDevice.put()));
-
-    // lock the shared dxgi device manager
-    // will keep lock open for the life of object
-    //     call MFUnlockDXGIDeviceManager when unloading
-    uint32_t resetToken;
-    com_ptr<IMFDXGIDeviceManager> dxgiDeviceManager;
-    IFR(MFLockDXGIDeviceManager(&resetToken, dxgiDeviceManager.put()));
+    // the decode device is shared with every other player in the dll
+    std::shared_ptr<MediaDevice> mediaDevice = nullptr;
+    IFR(MediaDevice::Acquire(unityDevice.get(), mediaDevice));
 
-    // associtate the device with the manager
-    IFR(dxgiDeviceManager->ResetDevice(d3dDevice.get(), resetToken));
-    
-    m_d3dDevice.attach(d3dDevice.detach());
-    m_resetToken = resetToken;
-    m_dxgiDeviceManager = dxgiDeviceManager;
+    m_mediaDevice = mediaDevice;
 
     return S_OK;
 }
@@ -368,20 +1699,14 @@ HRESULT PlaybackManager::CreateResources(com_ptr<ID3D11Device> const& unityDevic
 _Use_decl_annotations_
 void PlaybackManager::ReleaseResources()
 {
-    if (m_dxgiDeviceManager != nullptr)
+    // the frame buffers went back to the pool, only keep what other players can use
+    if (m_mediaDevice != nullptr)
     {
-        m_dxgiDeviceManager->ResetDevice(m_d3dDevice.get(), m_resetToken);
-
-        // release the default media foundation dxgi manager
-        MFUnlockDXGIDeviceManager();
-
-        m_dxgiDeviceManager = nullptr;
+        m_mediaDevice->Trim();
     }
 
-    if (m_d3dDevice != nullptr)
-    {
-        m_d3dDevice = nullptr;
-    }
+    // the last player to release it tears down the device
+    m_mediaDevice = nullptr;
 
     if (m_closedEvent)
     {
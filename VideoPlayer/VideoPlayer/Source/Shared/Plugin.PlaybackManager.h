@@ -4,9 +4,23 @@
 #include "Plugin.Module.h"
 #include "D3D11DeviceResources.h"
 #include "MediaHelpers.h"
-
+#include "MediaDevice.h"
+#include "VideoAtlas.h"
+#include "KeyframeIndex.h"
+#include "RawVideoSource.h"
+#include "FrameCache.h"
+#include "FrameRing.h"
+#include "PlaybackStats.h"
+#include "AdaptiveResolution.h"
+#include "AudioTap.h"
+#include "FramePacer.h"
+
+#include <winrt/Windows.Media.Core.h>
 #include <winrt/Windows.Media.Playback.h>
 
+#include <atomic>
+#include <chrono>
+
 struct __declspec(uuid("905a0fef-bc53-11df-8c49-001e4fc686da")) IPlaybackManagerPriv : ::IUnknown
 {
     STDMETHOD(CreatePlaybackTexture)(_In_ uint32_t width, _In_ uint32_t height, _COM_Outptr_ void** ppvTexture) PURE;
@@ -14,6 +28,24 @@ struct __declspec(uuid("905a0fef-bc53-11df-8c49-001e4fc686da")) IPlaybackManager
     STDMETHOD(Play)() PURE;
     STDMETHOD(Pause)() PURE;
     STDMETHOD(Stop)() PURE;
+    STDMETHOD(SetFrameBufferCount)(_In_ uint32_t count) PURE;
+    STDMETHOD(SetPacing)(_In_ PacingMode mode, _In_ uint32_t latencyFrames) PURE;
+    STDMETHOD(Enqueue)(_In_ winrt::hstring const& contentLocation) PURE;
+    STDMETHOD(SetPreloadCount)(_In_ uint32_t count) PURE;
+    STDMETHOD(GetResourceStats)(_Out_ RESOURCE_STATS* stats) PURE;
+    STDMETHOD(CreateAtlasTexture)(_In_ uint32_t width, _In_ uint32_t height, _COM_Outptr_ void** ppvTexture, _Out_ ATLAS_RECT* rect) PURE;
+    STDMETHOD(GetAtlasRect)(_Out_ ATLAS_RECT* rect) PURE;
+    STDMETHOD(Seek)(_In_ int64_t position, _In_ SeekMode mode) PURE;
+    STDMETHOD(Step)(_In_ int32_t frames) PURE;
+    STDMETHOD(SetRate)(_In_ double rate) PURE;
+    STDMETHOD(SetFrameCacheBudget)(_In_ uint64_t bytes) PURE;
+    STDMETHOD(GetFrameCacheStats)(_Out_ FRAME_CACHE_STATS* stats) PURE;
+    STDMETHOD(GetRawSourceStats)(_Out_ RAW_SOURCE_STATS* stats) PURE;
+    STDMETHOD(GetStats)(_Out_ PLAYBACK_STATS* stats) PURE;
+    STDMETHOD(SetAdaptiveResolution)(_In_ uint32_t levels, _In_ float minScale) PURE;
+    STDMETHOD(SetAudioTap)(_In_ uint32_t sampleRate, _In_ uint32_t channels, _In_ uint32_t bufferMs) PURE;
+    STDMETHOD(ReadAudio)(_Out_writes_(frames * channels) float* buffer, _In_ uint32_t frames, _In_ uint32_t channels, _Out_ int64_t* timestamp, _Out_ uint32_t* framesRead) PURE;
+    STDMETHOD(GetAudioTapStats)(_Out_ AUDIO_TAP_STATS* stats) PURE;
 };
 
 namespace winrt::VideoPlayer::Plugin::implementation
@@ -28,7 +60,8 @@ namespace winrt::VideoPlayer::Plugin::implementation
 
         PlaybackManager();
 
-        virtual void Shutdown();
+        virtual void Shutdown() override;
+        virtual void OnRenderEvent(uint16_t frameNumber) override;
 
         event_token Closed(Windows::Foundation::EventHandler<Plugin::PlaybackManager> const& handler);
         void Closed(event_token const& token);
@@ -39,6 +72,24 @@ namespace winrt::VideoPlayer::Plugin::implementation
         STDOVERRIDEMETHODIMP Play();
         STDOVERRIDEMETHODIMP Pause();
         STDOVERRIDEMETHODIMP Stop();
+        STDOVERRIDEMETHODIMP SetFrameBufferCount(_In_ uint32_t count);
+        STDOVERRIDEMETHODIMP SetPacing(_In_ PacingMode mode, _In_ uint32_t latencyFrames);
+        STDOVERRIDEMETHODIMP Enqueue(_In_ hstring const& contentLocation);
+        STDOVERRIDEMETHODIMP SetPreloadCount(_In_ uint32_t count);
+        STDOVERRIDEMETHODIMP GetResourceStats(_Out_ RESOURCE_STATS* stats);
+        STDOVERRIDEMETHODIMP CreateAtlasTexture(_In_ UINT32 width, _In_ UINT32 height, _COM_Outptr_ void** ppvTexture, _Out_ ATLAS_RECT* rect);
+        STDOVERRIDEMETHODIMP GetAtlasRect(_Out_ ATLAS_RECT* rect);
+        STDOVERRIDEMETHODIMP Seek(_In_ int64_t position, _In_ SeekMode mode);
+        STDOVERRIDEMETHODIMP Step(_In_ int32_t frames);
+        STDOVERRIDEMETHODIMP SetRate(_In_ double rate);
+        STDOVERRIDEMETHODIMP SetFrameCacheBudget(_In_ uint64_t bytes);
+        STDOVERRIDEMETHODIMP GetFrameCacheStats(_Out_ FRAME_CACHE_STATS* stats);
+        STDOVERRIDEMETHODIMP GetRawSourceStats(_Out_ RAW_SOURCE_STATS* stats);
+        STDOVERRIDEMETHODIMP GetStats(_Out_ PLAYBACK_STATS* stats);
+        STDOVERRIDEMETHODIMP SetAdaptiveResolution(_In_ uint32_t levels, _In_ float minScale);
+        STDOVERRIDEMETHODIMP SetAudioTap(_In_ uint32_t sampleRate, _In_ uint32_t channels, _In_ uint32_t bufferMs);
+        STDOVERRIDEMETHODIMP ReadAudio(_Out_writes_(frames * channels) float* buffer, _In_ uint32_t frames, _In_ uint32_t channels, _Out_ int64_t* timestamp, _Out_ uint32_t* framesRead);
+        STDOVERRIDEMETHODIMP GetAudioTapStats(_Out_ AUDIO_TAP_STATS* stats);
 
     private:
         HRESULT CreateMediaPlayer();
@@ -49,10 +100,28 @@ namespace winrt::VideoPlayer::Plugin::implementation
 
         void FillPlaybackState(PLAYBACK_STATE& playbackState);
 
+        HRESULT CreateFrameBuffers(_In_ ID3D11Device* unityDevice, _In_ uint32_t width, _In_ uint32_t height, _In_ bool atlas);
+        void ReleaseFrameBuffers();
+        std::shared_ptr<SharedTextureBuffer> const& SlotBuffer(_In_ int32_t slot, _In_ uint32_t level);
+        void OnVideoFrameAvailable();
+
+        HRESULT CreatePlaybackList();
+        void ReleasePlaybackList();
+        void Preload(_In_ uint32_t currentIndex);
+        void UpdateTransition(_In_ int64_t systemTime);
+
+        std::shared_ptr<KeyframeIndex> CurrentKeyframeIndex();
+        std::shared_ptr<RawVideoSource> CurrentRawSource();
+        std::shared_ptr<AudioTap> CurrentAudioTap();
+        hstring AudioLocation(_In_ uint32_t itemIndex);
+        int64_t CurrentFrameDuration();
+        HRESULT SeekTo(_In_ int64_t requested, _In_ int64_t position, _In_ SeekMode mode);
+        bool ServeFromCache(_In_ int64_t position, _Out_ int64_t* timestamp);
+        HRESULT ApplyDeferredSeek();
+
     private:
-        com_ptr<ID3D11Device> m_d3dDevice;
-        uint32_t m_resetToken;
-        com_ptr<IMFDXGIDeviceManager> m_dxgiDeviceManager;
+        std::shared_ptr<MediaDevice> m_mediaDevice;
+        float m_createTextureMs;
 
         Windows::Media::Playback::MediaPlayer m_mediaPlayer;
         event_token m_endedToken;
@@ -62,8 +131,81 @@ namespace winrt::VideoPlayer::Plugin::implementation
 
         Windows::Media::Playback::MediaPlaybackSession m_mediaPlaybackSession;
         event_token m_stateChangedEventToken;
-
-        std::shared_ptr<SharedTextureBuffer> m_primaryBuffer;
+        event_token m_seekCompletedToken;
+
+        // the seek SeekCompleted is reported for, a newer seek replaces it
+        struct PendingSeek
+        {
+            bool active;
+            SeekMode mode;
+            int64_t requested;
+            int64_t position;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        slim_mutex m_seekMutex;
+        PendingSeek m_pendingSeek;
+
+        // scrubbing while paused is served from here, the position the decoder still
+        // has to seek to is applied when playback resumes, unity thread only
+        FrameCache m_frameCache;
+        bool m_hasDeferredSeek;
+        int64_t m_deferredSeek;
+
+        // the decoder writes into the ring, unity samples m_displayTexture and the newest
+        // completed slot is copied into it on the render thread
+        slim_mutex m_frameBufferMutex;
+        uint32_t m_frameBufferCount;
+        std::vector<std::shared_ptr<SharedTextureBuffer>> m_frameBuffers;
+        FrameRing m_frameRing;
+        PlaybackStats m_playbackStats;
+
+        // adaptive resolution keeps a set of ring buffers per level, level major, the level
+        // a slot was written at travels with it to the render thread. the controller is fed
+        // by the frame server, m_presentedLevel is the render thread's
+        uint32_t m_resolutionLevels;
+        float m_resolutionMinScale;
+        uint32_t m_frameBufferLevels;
+        std::vector<uint32_t> m_slotLevels;
+        AdaptiveResolution m_adaptiveResolution;
+        uint32_t m_presentedLevel;
+        com_ptr<ID3D11Texture2D> m_displayTexture;
+        com_ptr<ID3D11ShaderResourceView> m_displayTextureSRV;
+
+        // atlas mode replaces the display texture with a rect in the shared atlas
+        std::shared_ptr<VideoAtlas> m_atlas;
+        uint32_t m_atlasId;
+
+        // which queued frame OnRenderEvent shows, latency is how many vsyncs ahead it aims
+        FramePacer m_framePacer;
+        std::atomic<PacingMode> m_pacingMode;
+        std::atomic<uint32_t> m_pacingLatencyFrames;
+
+        // LoadContent starts a new list, Enqueue appends, the items after the current one
+        // are opened ahead of time so the list can prefetch them for a gapless switch
+        struct PlaylistEntry
+        {
+            Windows::Media::Core::MediaSource source;
+            Windows::Foundation::IAsyncAction opening;
+            hstring location;
+            std::shared_ptr<KeyframeIndex> keyframes;  // created by the first keyframe seek
+            std::shared_ptr<RawVideoSource> rawSource; // .y4m items, null for everything else
+        };
+
+        slim_mutex m_playlistMutex;
+        Windows::Media::Playback::MediaPlaybackList m_playbackList;
+        event_token m_currentItemChangedToken;
+        std::vector<PlaylistEntry> m_playlist;
+        uint32_t m_preloadCount;
+
+        // written by the frame server, the item is reset with the list
+        std::atomic<uint32_t> m_lastFrameItem;
+        int64_t m_lastFrameTime;
+
+        // decodes the current item's audio again for unity's audio thread, which reads under
+        // the shared lock, the tap is only replaced under the exclusive one
+        slim_mutex m_audioTapMutex;
+        std::shared_ptr<AudioTap> m_audioTap;
 
         event<Windows::Foundation::EventHandler<Plugin::PlaybackManager>> m_closedEvent;
     };
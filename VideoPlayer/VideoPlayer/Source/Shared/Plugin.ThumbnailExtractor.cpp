@@ -0,0 +1,536 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Plugin.ThumbnailExtractor.h"
+#include "Plugin.ThumbnailExtractor.g.cpp"
+
+#include <mfapi.h>
+#include <mferror.h>
+#include <mfreadwrite.h>
+
+#include <algorithm>
+
+#pragma comment(lib, "mfplat")
+#pragma comment(lib, "mfreadwrite")
+
+using namespace winrt;
+using namespace VideoPlayer::Plugin::implementation;
+
+static constexpr uint32_t c_maxThumbnailSize = 4096;
+
+// thumbnails queued, being extracted or waiting for the render thread, past it Queue() returns
+// MF_E_NOTACCEPTING until some are reported
+static constexpr uint32_t c_maxPendingThumbnails = 4096;
+
+// a source reader per worker on the worker's own thread, decoding to rgb32 in software
+struct MfThumbnailDecoder : ThumbnailDecoder
+{
+    MfThumbnailDecoder()
+        : m_comInitialized(SUCCEEDED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+        , m_startup(MFStartup(MF_VERSION, MFSTARTUP_LITE))
+        , m_reader(nullptr)
+        , m_width(0)
+        , m_height(0)
+        , m_pitch(0)
+        , m_buffer(nullptr)
+        , m_buffer2d(nullptr)
+    {
+    }
+
+    ~MfThumbnailDecoder()
+    {
+        Unlock();
+        m_reader = nullptr;
+
+        if (SUCCEEDED(m_startup))
+        {
+            MFShutdown();
+        }
+
+        if (m_comInitialized)
+        {
+            CoUninitialize();
+        }
+    }
+
+    HRESULT Open(
+        _In_ hstring const& location) override
+    {
+        Unlock();
+        m_reader = nullptr;
+        m_width = 0;
+        m_height = 0;
+        m_pitch = 0;
+
+        IFR(m_startup);
+
+        com_ptr<IMFSourceReader> reader = nullptr;
+
+        // software decode with the reader's own converter to rgb32, thumbnails never touch the gpu
+        // until the render thread uploads them
+        com_ptr<IMFAttributes> attributes = nullptr;
+        IFR(MFCreateAttributes(attributes.put(), 1));
+        IFR(attributes->SetUINT32(MF_SOURCE_READER_ENABLE_VIDEO_PROCESSING, TRUE));
+
+        IFR(MFCreateSourceReaderFromURL(location.c_str(), attributes.get(), reader.put()));
+
+        IFR(reader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_ALL_STREAMS), FALSE));
+        IFR(reader->SetStreamSelection(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), TRUE));
+
+        com_ptr<IMFMediaType> mediaType = nullptr;
+        IFR(MFCreateMediaType(mediaType.put()));
+        IFR(mediaType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video));
+        IFR(mediaType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_RGB32));
+        IFR(reader->SetCurrentMediaType(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), nullptr, mediaType.get()));
+
+        com_ptr<IMFMediaType> currentType = nullptr;
+        IFR(reader->GetCurrentMediaType(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), currentType.put()));
+
+        UINT32 frameWidth = 0;
+        UINT32 frameHeight = 0;
+        IFR(MFGetAttributeSize(currentType.get(), MF_MT_FRAME_SIZE, &frameWidth, &frameHeight));
+        if (frameWidth == 0 || frameHeight == 0)
+        {
+            IFR(MF_E_INVALIDMEDIATYPE);
+        }
+
+        // rgb32 is bottom up unless the type says otherwise
+        UINT32 stride = 0;
+        if (FAILED(currentType->GetUINT32(MF_MT_DEFAULT_STRIDE, &stride)))
+        {
+            stride = static_cast<UINT32>(-static_cast<int32_t>(frameWidth * 4));
+        }
+
+        m_reader = reader;
+        m_width = frameWidth;
+        m_height = frameHeight;
+        m_pitch = static_cast<int32_t>(stride);
+
+        return S_OK;
+    }
+
+    HRESULT DecodeKeyframe(
+        _In_ int64_t position,
+        _Out_ int64_t* timestamp,
+        _Out_ Frame* frame) override
+    {
+        *timestamp = 0;
+        *frame = Frame{};
+
+        Unlock();
+
+        NULL_CHK_HR(m_reader, E_NOT_VALID_STATE);
+
+        int64_t sampleTimestamp = 0;
+        com_ptr<IMFSample> sample = nullptr;
+        IFR(ReadKeyframe(position, &sampleTimestamp, sample));
+
+        com_ptr<IMFMediaBuffer> mediaBuffer = nullptr;
+        IFR(sample->ConvertToContiguousBuffer(mediaBuffer.put()));
+
+        // 2d buffers know their own pitch, bottom up ones report it negative
+        auto buffer2d = mediaBuffer.try_as<IMF2DBuffer>();
+        if (buffer2d != nullptr)
+        {
+            BYTE* scanline0 = nullptr;
+            LONG pitch = 0;
+            IFR(buffer2d->Lock2D(&scanline0, &pitch));
+            m_buffer2d = buffer2d;
+
+            *frame = Frame{ scanline0, static_cast<int32_t>(pitch), m_width, m_height };
+        }
+        else
+        {
+            BYTE* data = nullptr;
+            DWORD currentLength = 0;
+            IFR(mediaBuffer->Lock(&data, nullptr, &currentLength));
+            m_buffer = mediaBuffer;
+
+            if (currentLength < static_cast<DWORD>(std::abs(m_pitch)) * m_height)
+            {
+                IFR(MF_E_BUFFERTOOSMALL);
+            }
+
+            uint8_t const* scanline0 = m_pitch < 0 ? data + static_cast<size_t>(-m_pitch) * (m_height - 1) : data;
+            *frame = Frame{ scanline0, m_pitch, m_width, m_height };
+        }
+
+        *timestamp = sampleTimestamp;
+
+        return S_OK;
+    }
+
+private:
+    HRESULT ReadKeyframe(
+        _In_ int64_t position,
+        _Out_ int64_t* timestamp,
+        _Out_ com_ptr<IMFSample>& sample)
+    {
+        *timestamp = 0;
+        sample = nullptr;
+
+        IMFSourceReader* reader = m_reader.get();
+
+        // the source lands on the keyframe at or before position, the first sample out of the
+        // decoder is that keyframe, nothing after it is decoded
+        PROPVARIANT seekPosition;
+        PropVariantInit(&seekPosition);
+        seekPosition.vt = VT_I8;
+        seekPosition.hVal.QuadPart = std::max<int64_t>(0, position);
+
+        HRESULT hr = reader->SetCurrentPosition(GUID_NULL, seekPosition);
+        PropVariantClear(&seekPosition);
+        IFR(hr);
+
+        for (;;)
+        {
+            DWORD streamIndex = 0;
+            DWORD flags = 0;
+            LONGLONG sampleTime = 0;
+            IFR(reader->ReadSample(static_cast<DWORD>(MF_SOURCE_READER_FIRST_VIDEO_STREAM), 0, &streamIndex, &flags, &sampleTime, sample.put()));
+
+            if ((flags & MF_SOURCE_READERF_ENDOFSTREAM) != 0)
+            {
+                IFR(MF_E_END_OF_STREAM);
+            }
+
+            // a format change would need a new pitch, not worth it for a thumbnail
+            if ((flags & MF_SOURCE_READERF_CURRENTMEDIATYPECHANGED) != 0)
+            {
+                IFR(MF_E_INVALIDMEDIATYPE);
+            }
+
+            if (sample != nullptr)
+            {
+                *timestamp = sampleTime;
+
+                return S_OK;
+            }
+        }
+    }
+
+    // the last frame handed out stays locked until the next call
+    void Unlock()
+    {
+        if (m_buffer2d != nullptr)
+        {
+            m_buffer2d->Unlock2D();
+            m_buffer2d = nullptr;
+        }
+
+        if (m_buffer != nullptr)
+        {
+            m_buffer->Unlock();
+            m_buffer = nullptr;
+        }
+    }
+
+private:
+    bool m_comInitialized;
+    HRESULT m_startup;
+    com_ptr<IMFSourceReader> m_reader;
+    uint32_t m_width;
+    uint32_t m_height;
+    int32_t m_pitch;
+    com_ptr<IMFMediaBuffer> m_buffer;
+    com_ptr<IMF2DBuffer> m_buffer2d;
+};
+
+VideoPlayer::Plugin::IModule ThumbnailExtractor::Create(
+    _In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice,
+    _In_ StateChangedCallback fnCallback,
+    _In_ void* pCallbackObject,
+    _In_ uint32_t workerCount)
+{
+    auto extractor = make<ThumbnailExtractor>();
+
+    if (SUCCEEDED(extractor.as<IModulePriv>()->Initialize(unityDevice, fnCallback, pCallbackObject))
+        && SUCCEEDED(extractor.as<IThumbnailExtractorPriv>()->Start(workerCount)))
+    {
+        return extractor;
+    }
+
+    return nullptr;
+}
+
+ThumbnailExtractor::ThumbnailExtractor()
+    : m_isShutdown(false)
+    , m_pool(std::make_shared<ThumbnailPool>())
+    , m_textureArray(nullptr)
+    , m_textureWidth(0)
+    , m_textureHeight(0)
+    , m_textureSlices(0)
+    , m_textureMipLevels(0)
+{
+}
+
+void ThumbnailExtractor::Shutdown()
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_isShutdown)
+        {
+            return;
+        }
+        m_isShutdown = true;
+    }
+
+    // queued batches are dropped, a running one stops at its next timestamp
+    m_pool->Shutdown();
+
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        m_uploads.clear();
+        m_textureArray = nullptr;
+    }
+
+    Module::Shutdown();
+}
+
+_Use_decl_annotations_
+void ThumbnailExtractor::OnRenderEvent(
+    uint16_t frameNumber)
+{
+    Module::OnRenderEvent(frameNumber);
+
+    std::vector<Upload> uploads;
+    com_ptr<ID3D11Texture2D> textureArray = nullptr;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t slices = 0;
+    uint32_t mipLevels = 0;
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_uploads.empty())
+        {
+            return;
+        }
+
+        uploads.swap(m_uploads);
+        textureArray = m_textureArray;
+        width = m_textureWidth;
+        height = m_textureHeight;
+        slices = m_textureSlices;
+        mipLevels = m_textureMipLevels;
+    }
+
+    // unity's render thread, the immediate context is not shared with the workers
+    com_ptr<ID3D11DeviceContext> context = nullptr;
+    if (textureArray != nullptr)
+    {
+        com_ptr<ID3D11Device> device = nullptr;
+        textureArray->GetDevice(device.put());
+        device->GetImmediateContext(context.put());
+    }
+
+    for (auto& upload : uploads)
+    {
+        if (SUCCEEDED(upload.state.hresult))
+        {
+            if (context == nullptr)
+            {
+                upload.state.hresult = E_POINTER;
+            }
+            else if (upload.width != width || upload.height != height || upload.slice >= slices)
+            {
+                // scaled for an array that has since been replaced
+                upload.state.hresult = E_CHANGED_STATE;
+            }
+            else
+            {
+                context->UpdateSubresource(
+                    textureArray.get(),
+                    D3D11CalcSubresource(0, upload.slice, mipLevels),
+                    nullptr,
+                    upload.pixels.data(),
+                    width * 4,
+                    0);
+            }
+        }
+
+        Complete(upload.state);
+    }
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailExtractor::Start(
+    uint32_t workerCount)
+{
+    // the pool's workers only hold a weak reference, Shutdown() stops them
+    auto weak = get_weak();
+
+    return m_pool->Start(
+        workerCount,
+        c_maxPendingThumbnails,
+        []() { return std::unique_ptr<ThumbnailDecoder>(new MfThumbnailDecoder()); },
+        [weak](ThumbnailPool::Batch const& batch, THUMBNAIL_STATE const& state, std::vector<uint8_t>&& pixels)
+        {
+            auto strong = weak.get();
+            if (strong != nullptr)
+            {
+                strong->OnExtracted(batch, state, std::move(pixels));
+            }
+        });
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailExtractor::SetTextureArray(
+    void* texture)
+{
+    NULL_CHK_HR(texture, E_INVALIDARG);
+
+    com_ptr<ID3D11Texture2D> textureArray = nullptr;
+    IFR(static_cast<IUnknown*>(texture)->QueryInterface(IID_PPV_ARGS(textureArray.put())));
+
+    D3D11_TEXTURE2D_DESC desc{};
+    textureArray->GetDesc(&desc);
+
+    // unity's bgra32, linear or srgb
+    if (desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM
+        && desc.Format != DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+        && desc.Format != DXGI_FORMAT_B8G8R8A8_TYPELESS)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    if (desc.Width > c_maxThumbnailSize || desc.Height > c_maxThumbnailSize || desc.Usage != D3D11_USAGE_DEFAULT)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (m_isShutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    // batches still running for a different size fail their remaining slices on upload
+    m_textureArray = textureArray;
+    m_textureWidth = desc.Width;
+    m_textureHeight = desc.Height;
+    m_textureSlices = desc.ArraySize;
+    m_textureMipLevels = desc.MipLevels;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailExtractor::Queue(
+    hstring const& contentLocation,
+    int64_t const* timestamps,
+    uint32_t count,
+    uint32_t width,
+    uint32_t height,
+    uint8_t* buffer,
+    uint32_t bufferSize,
+    uint32_t* batchId)
+{
+    NULL_CHK_HR(timestamps, E_INVALIDARG);
+    NULL_CHK_HR(buffer, E_INVALIDARG);
+    NULL_CHK_HR(batchId, E_INVALIDARG);
+
+    if (contentLocation.empty() || count == 0
+        || width < 1 || height < 1 || width > c_maxThumbnailSize || height > c_maxThumbnailSize)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    // thumbnails are packed one after another, each width * height * 4
+    if (static_cast<uint64_t>(width) * height * 4 * count > bufferSize)
+    {
+        IFR(MF_E_BUFFERTOOSMALL);
+    }
+
+    return m_pool->Add(ThumbnailPool::Batch{ 0, contentLocation, std::vector<int64_t>(timestamps, timestamps + count), width, height, buffer, 0 }, batchId);
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailExtractor::QueueToTextureArray(
+    hstring const& contentLocation,
+    int64_t const* timestamps,
+    uint32_t count,
+    uint32_t firstSlice,
+    uint32_t* batchId)
+{
+    NULL_CHK_HR(timestamps, E_INVALIDARG);
+    NULL_CHK_HR(batchId, E_INVALIDARG);
+
+    if (contentLocation.empty() || count == 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    {
+        std::shared_lock<slim_mutex> slock(m_mutex);
+
+        NULL_CHK_HR(m_textureArray, E_NOT_VALID_STATE);
+
+        if (static_cast<uint64_t>(firstSlice) + count > m_textureSlices)
+        {
+            IFR(E_BOUNDS);
+        }
+
+        width = m_textureWidth;
+        height = m_textureHeight;
+    }
+
+    return m_pool->Add(ThumbnailPool::Batch{ 0, contentLocation, std::vector<int64_t>(timestamps, timestamps + count), width, height, nullptr, firstSlice }, batchId);
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailExtractor::GetStats(
+    THUMBNAIL_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    m_pool->GetStats(stats);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void ThumbnailExtractor::OnExtracted(
+    ThumbnailPool::Batch const& batch,
+    THUMBNAIL_STATE const& state,
+    std::vector<uint8_t>&& pixels)
+{
+    if (batch.buffer != nullptr)
+    {
+        Complete(state);
+
+        return;
+    }
+
+    // the render thread writes the slice and reports it
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (m_isShutdown)
+    {
+        return;
+    }
+
+    m_uploads.push_back(Upload{ state, batch.firstSlice + state.index, batch.width, batch.height, std::move(pixels) });
+}
+
+_Use_decl_annotations_
+void ThumbnailExtractor::Complete(
+    THUMBNAIL_STATE const& state)
+{
+    m_pool->Complete(state);
+
+    CALLBACK_STATE callbackState{};
+    ZeroMemory(&callbackState, sizeof(CALLBACK_STATE));
+
+    callbackState.type = CallbackType::Thumbnail;
+    callbackState.value.thumbnailState = state;
+
+    Callback(callbackState);
+}
+
@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "Plugin.ThumbnailExtractor.g.h"
+#include "Plugin.Module.h"
+#include "D3D11DeviceResources.h"
+#include "ThumbnailPool.h"
+
+#include <memory>
+#include <vector>
+
+struct __declspec(uuid("5d0c8a4e-2f7b-4b1a-9e63-7c2d41f0b8a5")) IThumbnailExtractorPriv : ::IUnknown
+{
+    STDMETHOD(Start)(_In_ uint32_t workerCount) PURE;
+    STDMETHOD(SetTextureArray)(_In_ void* texture) PURE;
+    STDMETHOD(Queue)(_In_ winrt::hstring const& contentLocation, _In_reads_(count) int64_t const* timestamps, _In_ uint32_t count, _In_ uint32_t width, _In_ uint32_t height, _In_ uint8_t* buffer, _In_ uint32_t bufferSize, _Out_ uint32_t* batchId) PURE;
+    STDMETHOD(QueueToTextureArray)(_In_ winrt::hstring const& contentLocation, _In_reads_(count) int64_t const* timestamps, _In_ uint32_t count, _In_ uint32_t firstSlice, _Out_ uint32_t* batchId) PURE;
+    STDMETHOD(GetStats)(_Out_ THUMBNAIL_STATS* stats) PURE;
+};
+
+namespace winrt::VideoPlayer::Plugin::implementation
+{
+    // poster frames and thumbnails for many files without a player per file. a ThumbnailPool
+    // does the work, each worker opens the file with a source reader, seeks to every timestamp
+    // in order and decodes only the keyframe it lands on, then scales it down into the
+    // caller's buffer or into a slice of a texture array
+    struct ThumbnailExtractor : ThumbnailExtractorT<ThumbnailExtractor, Module, IThumbnailExtractorPriv>
+    {
+        static Plugin::IModule Create(
+            _In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice,
+            _In_ StateChangedCallback fnCallback,
+            _In_ void* pCallbackObject,
+            _In_ uint32_t workerCount);
+
+        ThumbnailExtractor();
+
+        virtual void Shutdown() override;
+        virtual void OnRenderEvent(uint16_t frameNumber) override;
+
+        // IThumbnailExtractorPriv
+        STDOVERRIDEMETHODIMP Start(_In_ uint32_t workerCount);
+        STDOVERRIDEMETHODIMP SetTextureArray(_In_ void* texture);
+        STDOVERRIDEMETHODIMP Queue(_In_ hstring const& contentLocation, _In_reads_(count) int64_t const* timestamps, _In_ uint32_t count, _In_ uint32_t width, _In_ uint32_t height, _In_ uint8_t* buffer, _In_ uint32_t bufferSize, _Out_ uint32_t* batchId);
+        STDOVERRIDEMETHODIMP QueueToTextureArray(_In_ hstring const& contentLocation, _In_reads_(count) int64_t const* timestamps, _In_ uint32_t count, _In_ uint32_t firstSlice, _Out_ uint32_t* batchId);
+        STDOVERRIDEMETHODIMP GetStats(_Out_ THUMBNAIL_STATS* stats);
+
+    private:
+        struct Upload
+        {
+            THUMBNAIL_STATE state;
+            uint32_t slice;
+            uint32_t width;
+            uint32_t height;
+            std::vector<uint8_t> pixels;
+        };
+
+        // a worker's result, buffer batches are reported now, texture ones on the render thread
+        void OnExtracted(
+            _In_ ThumbnailPool::Batch const& batch,
+            _In_ THUMBNAIL_STATE const& state,
+            _Inout_ std::vector<uint8_t>&& pixels);
+
+        void Complete(_In_ THUMBNAIL_STATE const& state);
+
+    private:
+        slim_mutex m_mutex;
+        bool m_isShutdown;
+        std::shared_ptr<ThumbnailPool> m_pool;
+
+        // unity's texture, the render thread copies finished slices into the top mip
+        com_ptr<ID3D11Texture2D> m_textureArray;
+        uint32_t m_textureWidth;
+        uint32_t m_textureHeight;
+        uint32_t m_textureSlices;
+        uint32_t m_textureMipLevels;
+        std::vector<Upload> m_uploads;
+    };
+}
+
+namespace winrt::VideoPlayer::Plugin::factory_implementation
+{
+    struct ThumbnailExtractor : ThumbnailExtractorT<ThumbnailExtractor, implementation::ThumbnailExtractor>
+    {
+    };
+}
@@ -0,0 +1,904 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Plugin.TiledPlayer.h"
+#include "Plugin.TiledPlayer.g.cpp"
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace winrt;
+using namespace VideoPlayer::Plugin::implementation;
+
+// per tile, one being written, one ready and one the atlas was last painted from
+static constexpr uint32_t c_tileBufferCount = 3;
+
+// a decoder per tile, past this the hardware runs out long before the scheduler would
+static constexpr uint32_t c_maxActiveTiles = 32;
+
+VideoPlayer::Plugin::IModule TiledPlayer::Create(
+    _In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice,
+    _In_ StateChangedCallback fnCallback,
+    _In_ void* pCallbackObject)
+{
+    auto player = make<TiledPlayer>();
+
+    if (SUCCEEDED(player.as<IModulePriv>()->Initialize(unityDevice, fnCallback, pCallbackObject)))
+    {
+        return player;
+    }
+
+    return nullptr;
+}
+
+TiledPlayer::TiledPlayer()
+    : m_loop(false)
+    , m_maxActiveTiles(0)
+    , m_tileWidth(0)
+    , m_tileHeight(0)
+    , m_baseWidth(0)
+    , m_baseHeight(0)
+    , m_timeline(nullptr)
+    , m_duration(0)
+    , m_ended(false)
+    , m_mediaDevice(nullptr)
+    , m_atlas(nullptr)
+    , m_mapVersion(0)
+    , m_framesCopied(0)
+    , m_framesFailed(0)
+    , m_tilesFailed(0)
+{
+}
+
+void TiledPlayer::Shutdown()
+{
+    std::vector<std::shared_ptr<Tile>> tiles;
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        tiles = ReleaseTiles();
+
+        if (m_timeline != nullptr)
+        {
+            m_timeline.PositionChanged(m_positionChangedToken);
+            m_timeline.Pause();
+            m_timeline = nullptr;
+        }
+    }
+
+    for (auto const& tile : tiles)
+    {
+        StopTile(tile);
+    }
+
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        // the tiles' buffers went back to the pool, only keep what other players can use
+        if (m_mediaDevice != nullptr)
+        {
+            m_mediaDevice->Trim();
+        }
+
+        m_atlas = nullptr;
+        m_mediaDevice = nullptr;
+    }
+
+    Module::Shutdown();
+}
+
+_Use_decl_annotations_
+void TiledPlayer::OnRenderEvent(
+    uint16_t frameNumber)
+{
+    Module::OnRenderEvent(frameNumber);
+
+    std::vector<std::shared_ptr<Tile>> tiles;
+    {
+        std::shared_lock<slim_mutex> slock(m_mutex);
+
+        std::copy_if(m_tiles.begin(), m_tiles.end(), std::back_inserter(tiles), [](auto const& tile) { return tile != nullptr; });
+    }
+
+    bool changed = false;
+    std::vector<std::shared_ptr<Tile>> ready;
+    for (auto const& tile : tiles)
+    {
+        std::shared_lock<slim_mutex> slock(tile->mutex);
+
+        if (tile->stopped || tile->atlasId == 0)
+        {
+            continue;
+        }
+
+        int32_t slot = tile->ring.Present(PacingMode::Latest, 0);
+
+        // moved by a defragment, repaint the frame at the new position
+        if (tile->atlas->TakeMoved(tile->atlasId))
+        {
+            changed = true;
+
+            if (slot < 0)
+            {
+                slot = tile->ring.Presented();
+            }
+        }
+
+        if (slot < 0)
+        {
+            continue;
+        }
+
+        // unity's render thread, so the copy is ordered with whatever samples the atlas
+        auto const& frameTexture = tile->buffers[slot]->frameTexture;
+
+        com_ptr<ID3D11Device> device = nullptr;
+        frameTexture->GetDevice(device.put());
+
+        com_ptr<ID3D11DeviceContext> context = nullptr;
+        device->GetImmediateContext(context.put());
+
+        tile->atlas->Copy(context.get(), tile->atlasId, frameTexture.get());
+
+        if (!tile->resident.exchange(true))
+        {
+            ready.push_back(tile);
+            changed = true;
+        }
+    }
+
+    if (!ready.empty())
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        // a tile stopped and started again since is not the one that became ready
+        for (auto const& tile : ready)
+        {
+            if (!tile->base && tile->index < m_tiles.size() && m_tiles[tile->index] == tile)
+            {
+                m_scheduler.OnReady(tile->index);
+            }
+        }
+    }
+
+    if (changed)
+    {
+        ++m_mapVersion;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::Open(
+    hstring const& tilePattern,
+    uint32_t columns,
+    uint32_t rows,
+    hstring const& baseLocation,
+    uint32_t maxActiveTiles,
+    bool loop,
+    void** ppvAtlasTexture)
+{
+    NULL_CHK_HR(ppvAtlasTexture, E_INVALIDARG);
+
+    *ppvAtlasTexture = nullptr;
+
+    if (tilePattern.empty())
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    auto resources = m_d3d11DeviceResources.lock();
+    NULL_CHK_HR(resources, E_POINTER);
+
+    auto unityDevice = resources->GetDevice();
+    NULL_CHK_HR(unityDevice, E_POINTER);
+
+    // the decode device and the atlas are shared with every other player in the dll
+    std::shared_ptr<MediaDevice> mediaDevice = nullptr;
+    IFR(MediaDevice::Acquire(unityDevice.get(), mediaDevice));
+
+    std::shared_ptr<VideoAtlas> atlas = nullptr;
+    IFR(VideoAtlas::Acquire(unityDevice.get(), atlas));
+
+    auto settings = TileScheduler::DefaultSettings();
+    if (maxActiveTiles > 0)
+    {
+        settings.maxActiveTiles = std::min(maxActiveTiles, c_maxActiveTiles);
+    }
+
+    HRESULT hr = S_OK;
+    std::vector<std::shared_ptr<Tile>> stopped;
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        stopped = ReleaseTiles();
+
+        hr = m_scheduler.Reset(columns, rows, settings);
+        if (SUCCEEDED(hr))
+        {
+            m_tilePattern = tilePattern.c_str();
+            m_loop = loop;
+            m_tiles.assign(m_scheduler.TileCount() + 1, nullptr);
+            m_maxActiveTiles = settings.maxActiveTiles;
+            m_tileWidth = 0;
+            m_tileHeight = 0;
+            m_baseWidth = 0;
+            m_baseHeight = 0;
+            m_mediaDevice = mediaDevice;
+            m_atlas = atlas;
+            m_duration = 0;
+            m_ended = false;
+
+            try
+            {
+                if (m_timeline == nullptr)
+                {
+                    m_timeline = Windows::Media::MediaTimelineController();
+                    m_positionChangedToken = m_timeline.PositionChanged([=](Windows::Media::MediaTimelineController const& sender, Windows::Foundation::IInspectable const& args)
+                    {
+                        UNREFERENCED_PARAMETER(args);
+
+                        OnPositionChanged(sender.Position());
+                    });
+                }
+
+                m_timeline.Pause();
+                m_timeline.Position(Windows::Foundation::TimeSpan{ 0 });
+            }
+            catch (hresult_error const& e)
+            {
+                hr = e.code();
+            }
+        }
+
+        if (SUCCEEDED(hr) && !baseLocation.empty())
+        {
+            uint32_t index = m_scheduler.TileCount();
+
+            std::shared_ptr<Tile> base = nullptr;
+            hr = StartTile(index, baseLocation, base);
+            if (SUCCEEDED(hr))
+            {
+                m_tiles[index] = base;
+            }
+        }
+    }
+
+    for (auto const& tile : stopped)
+    {
+        StopTile(tile);
+    }
+
+    ++m_mapVersion;
+
+    IFR(hr);
+
+    com_ptr<ID3D11ShaderResourceView> spSRV = nullptr;
+    spSRV.copy_from(atlas->ShaderResourceView());
+
+    *ppvAtlasTexture = spSRV.detach();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::Play()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    NULL_CHK_HR(m_timeline, MF_E_NOT_INITIALIZED);
+
+    try
+    {
+        // from the top after the end
+        if (m_ended.exchange(false))
+        {
+            m_timeline.Position(Windows::Foundation::TimeSpan{ 0 });
+        }
+
+        m_timeline.Resume();
+    }
+    catch (hresult_error const& e)
+    {
+        IFR(e.code());
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::Pause()
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    NULL_CHK_HR(m_timeline, MF_E_NOT_INITIALIZED);
+
+    try
+    {
+        m_timeline.Pause();
+    }
+    catch (hresult_error const& e)
+    {
+        IFR(e.code());
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::Seek(
+    int64_t position)
+{
+    if (position < 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    NULL_CHK_HR(m_timeline, MF_E_NOT_INITIALIZED);
+
+    try
+    {
+        m_ended = false;
+        m_timeline.Position(Windows::Foundation::TimeSpan{ position });
+    }
+    catch (hresult_error const& e)
+    {
+        IFR(e.code());
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::SetView(
+    float yaw,
+    float pitch,
+    float fovH,
+    float fovV)
+{
+    if (fovH <= 0.0f || fovH >= 180.0f || fovV <= 0.0f || fovV >= 180.0f)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    std::vector<std::shared_ptr<Tile>> stopped;
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_tiles.empty() || m_timeline == nullptr)
+        {
+            IFR(MF_E_NOT_INITIALIZED);
+        }
+
+        // the base takes its rect first, tiles that got there before it could leave it no room
+        if (m_tiles.back() != nullptr && m_baseWidth == 0)
+        {
+            return S_OK;
+        }
+
+        TileScheduler::View view{ FramePacer::Now(), yaw, pitch, fovH, fovV };
+
+        std::vector<uint32_t> start;
+        std::vector<uint32_t> stop;
+        m_scheduler.Update(view, start, stop);
+
+        for (uint32_t index : stop)
+        {
+            stopped.push_back(std::move(m_tiles[index]));
+            m_tiles[index] = nullptr;
+        }
+
+        // a tile that would not start gives its decoder back, the base covers it until it is retried
+        for (uint32_t index : start)
+        {
+            std::shared_ptr<Tile> tile = nullptr;
+            if (FAILED(StartTile(index, TileLocation(index), tile)))
+            {
+                m_scheduler.OnFailed(index, view.time);
+                ++m_tilesFailed;
+                continue;
+            }
+
+            m_tiles[index] = tile;
+        }
+    }
+
+    for (auto const& tile : stopped)
+    {
+        if (tile != nullptr)
+        {
+            StopTile(tile);
+        }
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::GetTileMap(
+    ATLAS_RECT* rects,
+    uint32_t count,
+    uint32_t* version)
+{
+    NULL_CHK_HR(rects, E_INVALIDARG);
+    NULL_CHK_HR(version, E_INVALIDARG);
+
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    // every tile and the base after them
+    if (m_tiles.empty() || count < m_tiles.size())
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    // read first, a change while the rects are filled shows up as the next version
+    *version = m_mapVersion;
+
+    ZeroMemory(rects, sizeof(ATLAS_RECT) * count);
+
+    for (size_t index = 0; index < m_tiles.size(); ++index)
+    {
+        auto const& tile = m_tiles[index];
+        if (tile == nullptr || !tile->resident)
+        {
+            continue;
+        }
+
+        std::shared_lock<slim_mutex> tileLock(tile->mutex);
+
+        if (!tile->stopped && tile->atlasId != 0)
+        {
+            tile->atlas->GetRect(tile->atlasId, &rects[index]);
+        }
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::GetStats(
+    TILED_STATS* stats)
+{
+    NULL_CHK_HR(stats, E_INVALIDARG);
+
+    ZeroMemory(stats, sizeof(TILED_STATS));
+
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    m_scheduler.GetStats(stats);
+
+    stats->framesCopied = m_framesCopied;
+    stats->framesFailed = m_framesFailed;
+    stats->tilesFailed = m_tilesFailed;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT TiledPlayer::StartTile(
+    uint32_t index,
+    hstring const& location,
+    std::shared_ptr<Tile>& tile)
+{
+    tile = nullptr;
+
+    auto newTile = std::make_shared<Tile>();
+    newTile->index = index;
+    newTile->base = index == m_scheduler.TileCount();
+    newTile->stopped = false;
+    newTile->mediaDevice = m_mediaDevice;
+    newTile->atlas = m_atlas;
+    newTile->atlasId = 0;
+    newTile->resident = false;
+
+    std::weak_ptr<Tile> weakTile = newTile;
+
+    try
+    {
+        auto player = Windows::Media::Playback::MediaPlayer();
+
+        // the timeline drives every player, the base alone is heard
+        player.CommandManager().IsEnabled(false);
+        player.TimelineController(m_timeline);
+        player.IsMuted(!newTile->base);
+        player.IsVideoFrameServerEnabled(true);
+
+        newTile->openedToken = player.MediaOpened([=](Windows::Media::Playback::MediaPlayer const& sender, Windows::Foundation::IInspectable const& args)
+        {
+            UNREFERENCED_PARAMETER(sender);
+            UNREFERENCED_PARAMETER(args);
+
+            auto strongTile = weakTile.lock();
+            if (strongTile != nullptr)
+            {
+                OnTileOpened(strongTile);
+            }
+        });
+
+        newTile->failedToken = player.MediaFailed([=](Windows::Media::Playback::MediaPlayer const& sender, Windows::Media::Playback::MediaPlayerFailedEventArgs const& args)
+        {
+            UNREFERENCED_PARAMETER(sender);
+
+            auto strongTile = weakTile.lock();
+            if (strongTile != nullptr)
+            {
+                OnTileFailed(strongTile, args.ExtendedErrorCode());
+            }
+        });
+
+        newTile->frameToken = player.VideoFrameAvailable([=](Windows::Media::Playback::MediaPlayer const& sender, Windows::Foundation::IInspectable const& args)
+        {
+            UNREFERENCED_PARAMETER(sender);
+            UNREFERENCED_PARAMETER(args);
+
+            auto strongTile = weakTile.lock();
+            if (strongTile != nullptr)
+            {
+                OnTileFrame(strongTile);
+            }
+        });
+
+        newTile->player = player;
+
+        player.Source(Windows::Media::Core::MediaSource::CreateFromUri(Windows::Foundation::Uri(location)));
+    }
+    catch (hresult_error const& e)
+    {
+        StopTile(newTile);
+
+        IFR(e.code());
+    }
+
+    tile = newTile;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void TiledPlayer::StopTile(
+    std::shared_ptr<Tile> const& tile)
+{
+    Windows::Media::Playback::MediaPlayer player = nullptr;
+    {
+        std::lock_guard<slim_mutex> guard(tile->mutex);
+
+        if (tile->stopped)
+        {
+            return;
+        }
+        tile->stopped = true;
+
+        player = tile->player;
+        tile->player = nullptr;
+
+        if (tile->atlasId != 0)
+        {
+            tile->atlas->Free(tile->atlasId);
+            tile->atlasId = 0;
+        }
+
+        // back to the pool, the next tile to start has the same size
+        tile->buffers.clear();
+        tile->ring.Reset(0);
+        tile->resident = false;
+    }
+
+    ++m_mapVersion;
+
+    // outside the lock, a handler may be waiting on it
+    if (player != nullptr)
+    {
+        try
+        {
+            player.MediaOpened(tile->openedToken);
+            player.MediaFailed(tile->failedToken);
+            player.VideoFrameAvailable(tile->frameToken);
+
+            player.Source(nullptr);
+            player.Close();
+        }
+        catch (hresult_error const&)
+        {
+        }
+    }
+}
+
+_Use_decl_annotations_
+hstring TiledPlayer::TileLocation(
+    uint32_t index) const
+{
+    uint32_t columns = m_scheduler.Columns();
+
+    std::wstring location = m_tilePattern;
+    auto replace = [&location](std::wstring const& key, uint32_t value)
+    {
+        for (size_t position = location.find(key); position != std::wstring::npos; position = location.find(key, position))
+        {
+            location.replace(position, key.size(), std::to_wstring(value));
+        }
+    };
+
+    replace(L"{index}", index);
+    replace(L"{column}", index % columns);
+    replace(L"{row}", index / columns);
+
+    return hstring(location);
+}
+
+_Use_decl_annotations_
+void TiledPlayer::OnTileOpened(
+    std::shared_ptr<Tile> const& tile)
+{
+    auto resources = m_d3d11DeviceResources.lock();
+    if (resources == nullptr)
+    {
+        return;
+    }
+
+    auto unityDevice = resources->GetDevice();
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    HRESULT hr = S_OK;
+
+    CALLBACK_STATE state{};
+    ZeroMemory(&state, sizeof(CALLBACK_STATE));
+    {
+        std::lock_guard<slim_mutex> guard(tile->mutex);
+
+        if (tile->stopped || tile->player == nullptr)
+        {
+            return;
+        }
+
+        int64_t duration = 0;
+        try
+        {
+            auto session = tile->player.PlaybackSession();
+
+            width = session.NaturalVideoWidth();
+            height = session.NaturalVideoHeight();
+            duration = session.NaturalDuration().count();
+        }
+        catch (hresult_error const&)
+        {
+        }
+
+        // the timeline has no end of its own, the longest stream is it
+        int64_t longest = m_duration;
+        while (duration > longest && !m_duration.compare_exchange_weak(longest, duration))
+        {
+        }
+
+        hr = width > 0 && height > 0 ? S_OK : MF_E_INVALIDMEDIATYPE;
+
+        std::vector<std::shared_ptr<SharedTextureBuffer>> buffers;
+        for (uint32_t i = 0; i < c_tileBufferCount && SUCCEEDED(hr); ++i)
+        {
+            std::shared_ptr<SharedTextureBuffer> buffer = nullptr;
+
+            hr = tile->mediaDevice->CreateBuffer(unityDevice.get(), width, height, buffer);
+
+            buffers.push_back(buffer);
+        }
+
+        uint32_t atlasId = 0;
+        if (SUCCEEDED(hr))
+        {
+            hr = tile->atlas->Allocate(width, height, &atlasId);
+        }
+
+        if (SUCCEEDED(hr))
+        {
+            tile->buffers.swap(buffers);
+            tile->atlasId = atlasId;
+            tile->ring.Reset(c_tileBufferCount);
+
+            state.type = CallbackType::VideoPlayer;
+            state.value.playbackState.state = MediaPlayerState::Opened;
+            state.value.playbackState.width = static_cast<int32_t>(width);
+            state.value.playbackState.height = static_cast<int32_t>(height);
+            state.value.playbackState.canSeek = true;
+            state.value.playbackState.duration = duration;
+        }
+    }
+
+    // without buffers or a rect the tile can never show a frame, its decoder goes to another
+    if (FAILED(hr))
+    {
+        OnTileFailed(tile, hr);
+        return;
+    }
+
+    FitToAtlas(tile, width, height);
+
+    if (!tile->base)
+    {
+        return;
+    }
+
+    Callback(state);
+}
+
+_Use_decl_annotations_
+void TiledPlayer::OnTileFailed(
+    std::shared_ptr<Tile> const& tile,
+    HRESULT hr)
+{
+    ++m_tilesFailed;
+
+    // unless it was stopped and started again since, the scheduler can use the slot
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (tile->index < m_tiles.size() && m_tiles[tile->index] == tile)
+        {
+            m_tiles[tile->index] = nullptr;
+
+            if (!tile->base)
+            {
+                m_scheduler.OnFailed(tile->index, FramePacer::Now());
+            }
+        }
+    }
+
+    StopTile(tile);
+
+    // a missing tile only costs detail, without the base there is nothing to fall back on
+    if (!tile->base)
+    {
+        return;
+    }
+
+    CALLBACK_STATE state{};
+    ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+    state.type = CallbackType::Failed;
+    state.value.failedState.hresult = hr;
+
+    Callback(state);
+}
+
+_Use_decl_annotations_
+void TiledPlayer::FitToAtlas(
+    std::shared_ptr<Tile> const& tile,
+    uint32_t width,
+    uint32_t height)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    // a tile from before the last Open knows nothing about this layout
+    if (tile->index >= m_tiles.size() || m_tiles[tile->index] != tile)
+    {
+        return;
+    }
+
+    if (tile->base)
+    {
+        m_baseWidth = width;
+        m_baseHeight = height;
+    }
+    else
+    {
+        m_tileWidth = std::max(m_tileWidth, width);
+        m_tileHeight = std::max(m_tileHeight, height);
+    }
+
+    if (m_tileWidth == 0)
+    {
+        return;
+    }
+
+    // a tile started past it finds no room and fails, one still active past it stops on the next update
+    m_scheduler.SetMaxActiveTiles(VideoAtlas::Capacity(m_tileWidth, m_tileHeight, m_baseWidth, m_baseHeight, m_maxActiveTiles));
+}
+
+_Use_decl_annotations_
+void TiledPlayer::OnTileFrame(
+    std::shared_ptr<Tile> const& tile)
+{
+    std::shared_lock<slim_mutex> slock(tile->mutex);
+
+    if (tile->stopped || tile->buffers.empty())
+    {
+        return;
+    }
+
+    int32_t slot = tile->ring.BeginWrite();
+    if (slot < 0)
+    {
+        return;
+    }
+
+    bool succeeded = false;
+    int64_t timestamp = 0;
+
+    try
+    {
+        timestamp = tile->player.PlaybackSession().Position().count();
+
+        tile->player.CopyFrameToVideoSurface(tile->buffers[slot]->mediaSurface);
+
+        // make sure the copy is submitted before the render thread can pick the slot
+        com_ptr<ID3D11DeviceContext> context = nullptr;
+        tile->mediaDevice->Device()->GetImmediateContext(context.put());
+        context->Flush();
+
+        succeeded = true;
+        ++m_framesCopied;
+    }
+    catch (hresult_error const&)
+    {
+        ++m_framesFailed;
+    }
+
+    tile->ring.EndWrite(slot, succeeded, timestamp);
+}
+
+_Use_decl_annotations_
+void TiledPlayer::OnPositionChanged(
+    Windows::Foundation::TimeSpan const& position)
+{
+    int64_t duration = m_duration;
+    if (duration <= 0 || position.count() < duration)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_timeline == nullptr)
+        {
+            return;
+        }
+
+        try
+        {
+            if (m_loop)
+            {
+                m_timeline.Position(Windows::Foundation::TimeSpan{ 0 });
+                return;
+            }
+
+            if (m_ended.exchange(true))
+            {
+                return;
+            }
+
+            m_timeline.Pause();
+        }
+        catch (hresult_error const&)
+        {
+            return;
+        }
+    }
+
+    CALLBACK_STATE state{};
+    ZeroMemory(&state, sizeof(CALLBACK_STATE));
+
+    state.type = CallbackType::VideoPlayer;
+    state.value.playbackState.state = MediaPlayerState::Ended;
+
+    Callback(state);
+}
+
+_Use_decl_annotations_
+std::vector<std::shared_ptr<TiledPlayer::Tile>> TiledPlayer::ReleaseTiles()
+{
+    std::vector<std::shared_ptr<Tile>> tiles;
+    for (auto& tile : m_tiles)
+    {
+        if (tile != nullptr)
+        {
+            tiles.push_back(std::move(tile));
+        }
+    }
+
+    m_tiles.clear();
+
+    return tiles;
+}
@@ -0,0 +1,144 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "Plugin.TiledPlayer.g.h"
+#include "Plugin.Module.h"
+#include "D3D11DeviceResources.h"
+#include "MediaHelpers.h"
+#include "MediaDevice.h"
+#include "VideoAtlas.h"
+#include "FrameRing.h"
+#include "TileScheduler.h"
+
+#include <winrt/Windows.Media.h>
+#include <winrt/Windows.Media.Core.h>
+#include <winrt/Windows.Media.Playback.h>
+
+#include <atomic>
+#include <vector>
+
+struct __declspec(uuid("ca47ffb6-84e7-4d00-b7f0-9c5989afa01c")) ITiledPlayerPriv : ::IUnknown
+{
+    STDMETHOD(Open)(_In_ winrt::hstring const& tilePattern, _In_ uint32_t columns, _In_ uint32_t rows, _In_ winrt::hstring const& baseLocation, _In_ uint32_t maxActiveTiles, _In_ bool loop, _COM_Outptr_ void** ppvAtlasTexture) PURE;
+    STDMETHOD(Play)() PURE;
+    STDMETHOD(Pause)() PURE;
+    STDMETHOD(Seek)(_In_ int64_t position) PURE;
+    STDMETHOD(SetView)(_In_ float yaw, _In_ float pitch, _In_ float fovH, _In_ float fovV) PURE;
+    STDMETHOD(GetTileMap)(_Out_writes_(count) ATLAS_RECT* rects, _In_ uint32_t count, _Out_ uint32_t* version) PURE;
+    STDMETHOD(GetStats)(_Out_ TILED_STATS* stats) PURE;
+};
+
+namespace winrt::VideoPlayer::Plugin::implementation
+{
+    // a 360 video too large to decode whole, pre split into a stream per tile of the
+    // equirectangular frame. the TileScheduler picks the tiles around the view, each of them
+    // gets a muted frame server player and a rect in the shared VideoAtlas, and the render
+    // thread copies their newest frames in. an optional low resolution stream of the whole
+    // frame always plays and fills in for tiles that are not ready, it carries the audio
+    //
+    // every player hangs off one MediaTimelineController, a tile started mid playback joins at
+    // the controller's position. the render thread takes the newest frame of every tile, the
+    // timeline keeps them within a frame or so of each other
+    struct TiledPlayer : TiledPlayerT<TiledPlayer, Module, ITiledPlayerPriv>
+    {
+        static Plugin::IModule Create(
+            _In_ std::weak_ptr<IUnityDeviceResource> const& unityDevice,
+            _In_ StateChangedCallback fnCallback,
+            _In_ void* pCallbackObject);
+
+        TiledPlayer();
+
+        virtual void Shutdown() override;
+        virtual void OnRenderEvent(uint16_t frameNumber) override;
+
+        // ITiledPlayerPriv
+        STDOVERRIDEMETHODIMP Open(_In_ hstring const& tilePattern, _In_ uint32_t columns, _In_ uint32_t rows, _In_ hstring const& baseLocation, _In_ uint32_t maxActiveTiles, _In_ bool loop, _COM_Outptr_ void** ppvAtlasTexture);
+        STDOVERRIDEMETHODIMP Play();
+        STDOVERRIDEMETHODIMP Pause();
+        STDOVERRIDEMETHODIMP Seek(_In_ int64_t position);
+        STDOVERRIDEMETHODIMP SetView(_In_ float yaw, _In_ float pitch, _In_ float fovH, _In_ float fovV);
+        STDOVERRIDEMETHODIMP GetTileMap(_Out_writes_(count) ATLAS_RECT* rects, _In_ uint32_t count, _Out_ uint32_t* version);
+        STDOVERRIDEMETHODIMP GetStats(_Out_ TILED_STATS* stats);
+
+    private:
+        // one stream, buffers and atlas rect arrive once the player has opened and knows its size
+        struct Tile
+        {
+            uint32_t index;     // the base is the one after the last tile
+            bool base;
+
+            // the frame server and the render thread share it, stopping takes it exclusively
+            slim_mutex mutex;
+            bool stopped;
+
+            Windows::Media::Playback::MediaPlayer player{ nullptr };
+            event_token openedToken;
+            event_token failedToken;
+            event_token frameToken;
+
+            std::shared_ptr<MediaDevice> mediaDevice;
+            std::shared_ptr<VideoAtlas> atlas;
+            std::vector<std::shared_ptr<SharedTextureBuffer>> buffers;
+            FrameRing ring;
+            uint32_t atlasId;
+
+            std::atomic<bool> resident;     // a frame is in the atlas
+        };
+
+        HRESULT StartTile(
+            _In_ uint32_t index,
+            _In_ hstring const& location,
+            _Out_ std::shared_ptr<Tile>& tile);
+
+        void StopTile(_In_ std::shared_ptr<Tile> const& tile);
+
+        hstring TileLocation(_In_ uint32_t index) const;
+
+        void OnTileOpened(_In_ std::shared_ptr<Tile> const& tile);
+        void OnTileFailed(_In_ std::shared_ptr<Tile> const& tile, _In_ HRESULT hr);
+        void OnTileFrame(_In_ std::shared_ptr<Tile> const& tile);
+
+        // caps the scheduler's budget to the tiles that fit into the atlas next to the base
+        void FitToAtlas(_In_ std::shared_ptr<Tile> const& tile, _In_ uint32_t width, _In_ uint32_t height);
+
+        void OnPositionChanged(_In_ Windows::Foundation::TimeSpan const& position);
+
+        // the caller holds m_mutex
+        std::vector<std::shared_ptr<Tile>> ReleaseTiles();
+
+    private:
+        // the scheduler, the tiles and the timeline
+        slim_mutex m_mutex;
+        TileScheduler m_scheduler;
+        std::wstring m_tilePattern;
+        bool m_loop;
+        std::vector<std::shared_ptr<Tile>> m_tiles;     // by index, null while a tile is stopped
+        uint32_t m_maxActiveTiles;                      // asked for in Open, before the atlas caps it
+        uint32_t m_tileWidth;                           // the largest tile opened, 0 until one has
+        uint32_t m_tileHeight;
+        uint32_t m_baseWidth;
+        uint32_t m_baseHeight;
+
+        Windows::Media::MediaTimelineController m_timeline;
+        event_token m_positionChangedToken;
+        std::atomic<int64_t> m_duration;        // the longest stream opened so far, 0 until then
+        std::atomic<bool> m_ended;
+
+        std::shared_ptr<MediaDevice> m_mediaDevice;
+        std::shared_ptr<VideoAtlas> m_atlas;
+
+        std::atomic<uint32_t> m_mapVersion;
+        std::atomic<uint64_t> m_framesCopied;
+        std::atomic<uint64_t> m_framesFailed;
+        std::atomic<uint32_t> m_tilesFailed;
+    };
+}
+
+namespace winrt::VideoPlayer::Plugin::factory_implementation
+{
+    struct TiledPlayer : TiledPlayerT<TiledPlayer, implementation::TiledPlayer>
+    {
+    };
+}
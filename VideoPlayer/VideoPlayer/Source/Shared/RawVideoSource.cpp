@@ -0,0 +1,485 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "RawVideoSource.h"
+#include "Y4mReader.h"
+#include "ImageSequenceReader.h"
+
+#include <mfapi.h>
+#include <mferror.h>
+#include <robuffer.h>
+
+#include <winrt/Windows.Media.MediaProperties.h>
+#include <winrt/Windows.Storage.Streams.h>
+
+#include <algorithm>
+#include <cwctype>
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Media::Core;
+
+// a sample's buffer over a frame the reader owns, keeps the frame alive until the pipeline
+// has processed the sample. the pointer is writable through IBufferByteAccess, but nothing
+// downstream of a source writes into its input
+struct FrameBuffer : implements<FrameBuffer, Windows::Storage::Streams::IBuffer, ::Windows::Storage::Streams::IBufferByteAccess>
+{
+    FrameBuffer(
+        RawFrameReader::FrameData const& frame,
+        uint32_t size)
+        : m_owner(frame.owner)
+        , m_data(frame.data)
+        , m_capacity(size)
+        , m_length(size)
+    {
+    }
+
+    uint32_t Capacity() const { return m_capacity; }
+    uint32_t Length() const { return m_length; }
+    void Length(uint32_t value)
+    {
+        if (value > m_capacity)
+        {
+            throw hresult_invalid_argument();
+        }
+
+        m_length = value;
+    }
+
+    // the pipeline is done with the sample, the frame goes back to the reader even if the
+    // sample itself is held on to for a while longer
+    void ReleaseFrame()
+    {
+        m_owner = nullptr;
+    }
+
+    // IBufferByteAccess
+    HRESULT __stdcall Buffer(uint8_t** value) noexcept final
+    {
+        NULL_CHK_HR(value, E_POINTER);
+
+        *value = const_cast<uint8_t*>(m_data);
+
+        return S_OK;
+    }
+
+private:
+    std::shared_ptr<void const> m_owner;
+    uint8_t const* const m_data;
+    uint32_t const m_capacity;
+    uint32_t m_length;
+};
+
+static std::wstring Extension(
+    _In_ std::wstring const& location)
+{
+    std::wstring extension(location);
+
+    size_t end = extension.find_first_of(L"?#");
+    if (end != std::wstring::npos)
+    {
+        extension.resize(end);
+    }
+
+    size_t dot = extension.find_last_of(L'.');
+    size_t separator = extension.find_last_of(L"/\\");
+    if (dot == std::wstring::npos || (separator != std::wstring::npos && dot < separator))
+    {
+        return std::wstring();
+    }
+
+    extension = extension.substr(dot);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::towlower(c)); });
+
+    return extension;
+}
+
+static bool IsDirectory(
+    _In_ std::wstring const& path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes{};
+    if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes))
+    {
+        return false;
+    }
+
+    return (attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+}
+
+_Use_decl_annotations_
+bool RawFrameReader::IsSupported(
+    hstring const& location)
+{
+    std::wstring extension = Extension(location.c_str());
+    if (extension == L".y4m" || extension == ImageSequenceReader::PackedExtension)
+    {
+        return true;
+    }
+
+    // anything with a scheme other than file: belongs to media foundation
+    std::wstring path;
+    if (FAILED(ToPath(location, path)))
+    {
+        return false;
+    }
+
+    return IsDirectory(path);
+}
+
+_Use_decl_annotations_
+HRESULT RawFrameReader::Open(
+    hstring const& location,
+    std::shared_ptr<RawFrameReader>& reader)
+{
+    reader = nullptr;
+
+    std::wstring path;
+    IFR(ToPath(location, path));
+
+    std::wstring extension = Extension(path);
+    if (extension == L".y4m")
+    {
+        return Y4mReader::Open(hstring(path), reader);
+    }
+
+    if (extension == ImageSequenceReader::PackedExtension)
+    {
+        return ImageSequenceReader::OpenPacked(hstring(path), reader);
+    }
+
+    if (IsDirectory(path))
+    {
+        return ImageSequenceReader::OpenDirectory(hstring(path), reader);
+    }
+
+    IFR(MF_E_UNSUPPORTED_FORMAT);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT RawFrameReader::ToPath(
+    hstring const& location,
+    std::wstring& path)
+{
+    // players are handed uris or plain paths, the readers need a path
+    path = location.c_str();
+    if (path.compare(0, 5, L"file:") == 0)
+    {
+        try
+        {
+            path = Uri::UnescapeComponent(Uri(location).Path()).c_str();
+        }
+        catch (hresult_error const& e)
+        {
+            IFR(e.code());
+        }
+
+        if (path.size() > 2 && path[0] == L'/' && path[2] == L':')
+        {
+            path.erase(0, 1);
+        }
+
+        std::replace(path.begin(), path.end(), L'/', L'\\');
+    }
+    else if (path.find(L"://") != std::wstring::npos)
+    {
+        IFR(MF_E_UNSUPPORTED_SCHEME);
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT RawVideoSource::Create(
+    std::shared_ptr<RawFrameReader> const& reader,
+    std::shared_ptr<RawVideoSource>& source)
+{
+    source = nullptr;
+
+    NULL_CHK_HR(reader, E_INVALIDARG);
+
+    auto rawSource = std::make_shared<RawVideoSource>(reader);
+
+    IFR(rawSource->Initialize());
+
+    source = rawSource;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+RawVideoSource::RawVideoSource(
+    std::shared_ptr<RawFrameReader> const& reader)
+    : m_reader(reader)
+    , m_frameDuration(0)
+    , m_streamSource(nullptr)
+    , m_nextFrame(0)
+    , m_inFlight{}
+    , m_inFlightNext(0)
+    , m_framesDelivered(0)
+    , m_framesShown(0)
+    , m_requestUs(0.0)
+    , m_maxRequestUs(0.0)
+    , m_latencyMs(0.0)
+    , m_maxLatencyMs(0.0)
+{
+    for (auto& inFlight : m_inFlight)
+    {
+        inFlight.timestamp = -1;
+    }
+}
+
+RawVideoSource::~RawVideoSource()
+{
+    if (m_streamSource == nullptr)
+    {
+        return;
+    }
+
+    try
+    {
+        m_streamSource.Starting(m_startingToken);
+        m_streamSource.SampleRequested(m_sampleRequestedToken);
+    }
+    catch (hresult_error const&)
+    {
+    }
+}
+
+HRESULT RawVideoSource::Initialize()
+{
+    auto const& format = m_reader->GetFormat();
+
+    m_frameDuration = 10000000ll * format.frameRateDenominator / format.frameRateNumerator;
+    if (m_frameDuration <= 0)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    try
+    {
+        bool bgra = format.pixelFormat == RawFrameReader::PixelFormat::Bgra;
+
+        auto properties = Windows::Media::MediaProperties::VideoEncodingProperties::CreateUncompressed(
+            bgra ? Windows::Media::MediaProperties::MediaEncodingSubtypes::Bgra8() : Windows::Media::MediaProperties::MediaEncodingSubtypes::Iyuv(),
+            format.width,
+            format.height);
+
+        // rgb is bottom up in media foundation unless the stride says otherwise
+        if (bgra)
+        {
+            properties.Properties().Insert(reinterpret_cast<guid const&>(MF_MT_DEFAULT_STRIDE), box_value(format.width * 4));
+        }
+
+        properties.FrameRate().Numerator(format.frameRateNumerator);
+        properties.FrameRate().Denominator(format.frameRateDenominator);
+
+        auto streamSource = MediaStreamSource(VideoStreamDescriptor(properties));
+        streamSource.CanSeek(true);
+        streamSource.Duration(TimeSpan{ static_cast<int64_t>(format.frameCount) * m_frameDuration });
+
+        // every frame is ready as soon as it is asked for
+        streamSource.BufferTime(TimeSpan{ 0 });
+
+        // the stream source outlives this when the pipeline still holds it
+        std::weak_ptr<RawVideoSource> weakThis = weak_from_this();
+
+        m_startingToken = streamSource.Starting([weakThis](MediaStreamSource const&, MediaStreamSourceStartingEventArgs const& args)
+        {
+            auto strongThis = weakThis.lock();
+            if (strongThis != nullptr)
+            {
+                strongThis->OnStarting(args);
+            }
+        });
+
+        m_sampleRequestedToken = streamSource.SampleRequested([weakThis](MediaStreamSource const&, MediaStreamSourceSampleRequestedEventArgs const& args)
+        {
+            auto strongThis = weakThis.lock();
+            if (strongThis != nullptr)
+            {
+                strongThis->OnSampleRequested(args);
+            }
+        });
+
+        m_streamSource = streamSource;
+    }
+    catch (hresult_error const& e)
+    {
+        IFR(e.code());
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void RawVideoSource::OnStarting(
+    MediaStreamSourceStartingEventArgs const& args)
+{
+    auto request = args.Request();
+    auto start = request.StartPosition();
+
+    // resuming from pause has no position, the next frame is where it left off
+    if (start == nullptr)
+    {
+        return;
+    }
+
+    uint32_t frameCount = m_reader->GetFormat().frameCount;
+    int64_t frame = std::max<int64_t>(0, start.Value().count() / m_frameDuration);
+
+    uint32_t nextFrame = static_cast<uint32_t>(std::min<int64_t>(frame, frameCount - 1));
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        m_nextFrame = nextFrame;
+
+        for (auto& inFlight : m_inFlight)
+        {
+            inFlight.timestamp = -1;
+        }
+    }
+
+    request.SetActualStartPosition(TimeSpan{ static_cast<int64_t>(nextFrame) * m_frameDuration });
+}
+
+_Use_decl_annotations_
+void RawVideoSource::OnSampleRequested(
+    MediaStreamSourceSampleRequestedEventArgs const& args)
+{
+    auto requested = std::chrono::steady_clock::now();
+
+    auto const& format = m_reader->GetFormat();
+
+    uint32_t index = 0;
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        // no sample is the end of the stream
+        if (m_nextFrame >= format.frameCount)
+        {
+            return;
+        }
+
+        index = m_nextFrame++;
+    }
+
+    // a decoding reader can make this wait, the request is on a media foundation worker
+    RawFrameReader::FrameData frame{};
+    if (FAILED(m_reader->Frame(index, frame)))
+    {
+        return;
+    }
+
+    int64_t timestamp = static_cast<int64_t>(index) * m_frameDuration;
+
+    try
+    {
+        auto buffer = make_self<FrameBuffer>(frame, format.frameSize);
+
+        auto sample = MediaStreamSample::CreateFromBuffer(buffer.as<Windows::Storage::Streams::IBuffer>(), TimeSpan{ timestamp });
+        sample.Duration(TimeSpan{ m_frameDuration });
+        sample.KeyFrame(true);
+
+        // the pipeline can keep samples alive well after it has used them, a reader with a
+        // fixed pool of frames would run out waiting for them to be released
+        sample.Processed([buffer](MediaStreamSample const&, IInspectable const&)
+        {
+            buffer->ReleaseFrame();
+        });
+
+        args.Request().Sample(sample);
+    }
+    catch (hresult_error const&)
+    {
+        return;
+    }
+
+    auto handedOut = std::chrono::steady_clock::now();
+    double requestUs = std::chrono::duration<double, std::micro>(handedOut - requested).count();
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (m_framesDelivered == 0)
+    {
+        m_firstSample = handedOut;
+    }
+    m_lastSample = handedOut;
+
+    ++m_framesDelivered;
+    m_requestUs += requestUs;
+    m_maxRequestUs = std::max(m_maxRequestUs, requestUs);
+
+    m_inFlight[m_inFlightNext] = InFlight{ timestamp, handedOut };
+    m_inFlightNext = (m_inFlightNext + 1) % InFlightSize;
+}
+
+_Use_decl_annotations_
+void RawVideoSource::OnFrameAvailable(
+    int64_t timestamp)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    // the session position is close to, not exactly, the sample time
+    InFlight* match = nullptr;
+    for (auto& inFlight : m_inFlight)
+    {
+        if (inFlight.timestamp >= 0
+            && std::abs(inFlight.timestamp - timestamp) <= m_frameDuration / 2
+            && (match == nullptr || inFlight.handedOut > match->handedOut))
+        {
+            match = &inFlight;
+        }
+    }
+
+    if (match == nullptr)
+    {
+        return;
+    }
+
+    double latencyMs = std::chrono::duration<double, std::milli>(now - match->handedOut).count();
+    match->timestamp = -1;
+
+    ++m_framesShown;
+    m_latencyMs += latencyMs;
+    m_maxLatencyMs = std::max(m_maxLatencyMs, latencyMs);
+}
+
+_Use_decl_annotations_
+void RawVideoSource::GetStats(
+    RAW_SOURCE_STATS* stats)
+{
+    ZeroMemory(stats, sizeof(RAW_SOURCE_STATS));
+
+    auto const& format = m_reader->GetFormat();
+    stats->width = format.width;
+    stats->height = format.height;
+    stats->frameCount = format.frameCount;
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    stats->framesDelivered = m_framesDelivered;
+    stats->framesShown = m_framesShown;
+
+    double seconds = std::chrono::duration<double>(m_lastSample - m_firstSample).count();
+    if (m_framesDelivered > 1 && seconds > 0.0)
+    {
+        stats->framesPerSecond = static_cast<float>((m_framesDelivered - 1) / seconds);
+    }
+
+    if (m_framesDelivered > 0)
+    {
+        stats->requestUs = static_cast<float>(m_requestUs / m_framesDelivered);
+        stats->maxRequestUs = static_cast<float>(m_maxRequestUs);
+    }
+
+    if (m_framesShown > 0)
+    {
+        stats->latencyMs = static_cast<float>(m_latencyMs / m_framesShown);
+        stats->maxLatencyMs = static_cast<float>(m_maxLatencyMs);
+    }
+}
@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <winrt/Windows.Media.Core.h>
+
+#include <chrono>
+
+// frames that need no video decoder, 8 bit 4:2:0 planar (i420) or 32 bit bgra, addressed by
+// index. a frame's memory stays valid for as long as its owner is held
+struct RawFrameReader : std::enable_shared_from_this<RawFrameReader>
+{
+    enum class PixelFormat : uint32_t
+    {
+        I420 = 0,
+        Bgra,       // top down, no padding between rows
+    };
+
+    struct Format
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t frameRateNumerator;
+        uint32_t frameRateDenominator;
+        uint32_t frameCount;
+        uint32_t frameSize;     // bytes
+        PixelFormat pixelFormat;
+    };
+
+    struct FrameData
+    {
+        uint8_t const* data;
+        std::shared_ptr<void const> owner;
+    };
+
+    // picks the reader from the file extension, a directory is an image sequence,
+    // MF_E_UNSUPPORTED_FORMAT when none takes it
+    static HRESULT Open(
+        _In_ winrt::hstring const& location,
+        _Out_ std::shared_ptr<RawFrameReader>& reader);
+
+    static bool IsSupported(_In_ winrt::hstring const& location);
+
+    virtual ~RawFrameReader() = default;
+
+    virtual Format const& GetFormat() const = 0;
+
+    // frames are asked for in playback order, a reader can use that to read ahead. may
+    // block until the frame is ready
+    virtual HRESULT Frame(_In_ uint32_t index, _Out_ FrameData& frame) = 0;
+
+private:
+    static HRESULT ToPath(_In_ winrt::hstring const& location, _Out_ std::wstring& path);
+};
+
+// hands the frames of a RawFrameReader to the media player through a MediaStreamSource,
+// every sample's buffer points straight at the reader's frame, nothing is copied on the
+// way in. measures how fast it is drained and how long a frame takes from being handed
+// out to being copied by the frame server
+struct RawVideoSource : std::enable_shared_from_this<RawVideoSource>
+{
+    static HRESULT Create(
+        _In_ std::shared_ptr<RawFrameReader> const& reader,
+        _Out_ std::shared_ptr<RawVideoSource>& source);
+
+    RawVideoSource(_In_ std::shared_ptr<RawFrameReader> const& reader);
+    ~RawVideoSource();
+
+    winrt::Windows::Media::Core::MediaStreamSource StreamSource() const { return m_streamSource; }
+
+    // the frame server copied the frame for timestamp
+    void OnFrameAvailable(_In_ int64_t timestamp);
+
+    void GetStats(_Out_ RAW_SOURCE_STATS* stats);
+
+private:
+    HRESULT Initialize();
+
+    void OnStarting(_In_ winrt::Windows::Media::Core::MediaStreamSourceStartingEventArgs const& args);
+    void OnSampleRequested(_In_ winrt::Windows::Media::Core::MediaStreamSourceSampleRequestedEventArgs const& args);
+
+private:
+    // samples recently handed out, matched against the frames the player shows
+    static constexpr uint32_t InFlightSize = 32;
+
+    struct InFlight
+    {
+        int64_t timestamp;
+        std::chrono::steady_clock::time_point handedOut;
+    };
+
+    std::shared_ptr<RawFrameReader> const m_reader;
+    int64_t m_frameDuration;
+
+    winrt::Windows::Media::Core::MediaStreamSource m_streamSource;
+    winrt::event_token m_startingToken;
+    winrt::event_token m_sampleRequestedToken;
+
+    winrt::slim_mutex m_mutex;
+    uint32_t m_nextFrame;
+    InFlight m_inFlight[InFlightSize];
+    uint32_t m_inFlightNext;
+
+    std::chrono::steady_clock::time_point m_firstSample;
+    std::chrono::steady_clock::time_point m_lastSample;
+    uint64_t m_framesDelivered;
+    uint64_t m_framesShown;
+    double m_requestUs;
+    double m_maxRequestUs;
+    double m_latencyMs;
+    double m_maxLatencyMs;
+};
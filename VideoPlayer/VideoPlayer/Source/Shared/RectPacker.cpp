@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "RectPacker.h"
+
+#include <algorithm>
+
+RectPacker::RectPacker()
+    : m_width(0)
+    , m_height(0)
+    , m_nextId(1)
+{
+}
+
+_Use_decl_annotations_
+void RectPacker::Reset(
+    uint32_t width,
+    uint32_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_nextId = 1;
+    m_shelves.clear();
+    m_rects.clear();
+}
+
+_Use_decl_annotations_
+bool RectPacker::Allocate(
+    uint32_t width,
+    uint32_t height,
+    uint32_t* id,
+    Rect* rect)
+{
+    *id = 0;
+    *rect = Rect{};
+
+    if (width == 0 || height == 0)
+    {
+        return false;
+    }
+
+    Rect placed{};
+    if (!Place(width, height, &placed))
+    {
+        return false;
+    }
+
+    *id = m_nextId++;
+    *rect = placed;
+    m_rects[*id] = placed;
+
+    return true;
+}
+
+_Use_decl_annotations_
+void RectPacker::Free(
+    uint32_t id)
+{
+    auto it = m_rects.find(id);
+    if (it == m_rects.end())
+    {
+        return;
+    }
+
+    Release(it->second);
+
+    m_rects.erase(it);
+}
+
+_Use_decl_annotations_
+bool RectPacker::Get(
+    uint32_t id,
+    Rect* rect) const
+{
+    auto it = m_rects.find(id);
+    if (it == m_rects.end())
+    {
+        *rect = Rect{};
+
+        return false;
+    }
+
+    *rect = it->second;
+
+    return true;
+}
+
+std::vector<RectPacker::Move> RectPacker::Defragment()
+{
+    std::vector<std::pair<uint32_t, Rect>> order(m_rects.begin(), m_rects.end());
+    std::sort(order.begin(), order.end(), [](auto const& a, auto const& b)
+    {
+        if (a.second.height != b.second.height)
+        {
+            return a.second.height > b.second.height;
+        }
+
+        if (a.second.width != b.second.width)
+        {
+            return a.second.width > b.second.width;
+        }
+
+        return a.first < b.first;
+    });
+
+    auto shelves = std::move(m_shelves);
+    m_shelves.clear();
+
+    std::vector<Move> moves;
+    std::map<uint32_t, Rect> rects;
+    for (auto const& entry : order)
+    {
+        Rect placed{};
+        if (!Place(entry.second.width, entry.second.height, &placed))
+        {
+            m_shelves = std::move(shelves);
+
+            return std::vector<Move>();
+        }
+
+        rects[entry.first] = placed;
+
+        if (placed.x != entry.second.x || placed.y != entry.second.y)
+        {
+            moves.push_back(Move{ entry.first, entry.second, placed });
+        }
+    }
+
+    m_rects.swap(rects);
+
+    return moves;
+}
+
+uint64_t RectPacker::UsedArea() const
+{
+    uint64_t area = 0;
+    for (auto const& entry : m_rects)
+    {
+        area += static_cast<uint64_t>(entry.second.width) * entry.second.height;
+    }
+
+    return area;
+}
+
+_Use_decl_annotations_
+bool RectPacker::Place(
+    uint32_t width,
+    uint32_t height,
+    Rect* rect)
+{
+    if (width > m_width || height > m_height)
+    {
+        return false;
+    }
+
+    // the existing shelf that wastes the least height
+    Shelf* best = nullptr;
+    size_t bestSpan = 0;
+    for (auto& shelf : m_shelves)
+    {
+        if (shelf.height < height || (best != nullptr && shelf.height >= best->height))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < shelf.free.size(); ++i)
+        {
+            if (shelf.free[i].width >= width)
+            {
+                best = &shelf;
+                bestSpan = i;
+                break;
+            }
+        }
+    }
+
+    uint32_t top = m_shelves.empty() ? 0 : m_shelves.back().y + m_shelves.back().height;
+    bool canOpen = m_height - top >= height;
+
+    // a shelf more than half again as tall is only used when a new one will not fit
+    if (canOpen && (best == nullptr || best->height > height + height / 2))
+    {
+        m_shelves.push_back(Shelf{ top, height, { Span{ 0, m_width } } });
+
+        best = &m_shelves.back();
+        bestSpan = 0;
+    }
+
+    if (best == nullptr)
+    {
+        return false;
+    }
+
+    auto& span = best->free[bestSpan];
+
+    *rect = Rect{ span.x, best->y, width, height };
+
+    span.x += width;
+    span.width -= width;
+    if (span.width == 0)
+    {
+        best->free.erase(best->free.begin() + bestSpan);
+    }
+
+    return true;
+}
+
+_Use_decl_annotations_
+void RectPacker::Release(
+    Rect const& rect)
+{
+    auto shelf = std::find_if(m_shelves.begin(), m_shelves.end(), [&](Shelf const& s) { return s.y == rect.y; });
+    if (shelf == m_shelves.end())
+    {
+        return;
+    }
+
+    auto& free = shelf->free;
+
+    auto next = std::find_if(free.begin(), free.end(), [&](Span const& s) { return s.x > rect.x; });
+    auto inserted = free.insert(next, Span{ rect.x, rect.width });
+
+    // merge with the neighbours
+    if (inserted + 1 != free.end() && inserted->x + inserted->width == (inserted + 1)->x)
+    {
+        inserted->width += (inserted + 1)->width;
+        free.erase(inserted + 1);
+    }
+
+    if (inserted != free.begin() && (inserted - 1)->x + (inserted - 1)->width == inserted->x)
+    {
+        (inserted - 1)->width += inserted->width;
+        free.erase(inserted);
+    }
+
+    // empty shelves at the top go back to the unused height
+    while (!m_shelves.empty()
+        && m_shelves.back().free.size() == 1
+        && m_shelves.back().free[0].width == m_width)
+    {
+        m_shelves.pop_back();
+    }
+}
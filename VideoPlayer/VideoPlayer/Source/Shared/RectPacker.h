@@ -0,0 +1,69 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <map>
+#include <vector>
+
+// shelf allocator for sub-rectangles of a fixed size texture. rects of similar height
+// share a shelf, freed space goes back to the shelf it came from and can be reused by
+// anything that fits. holes left behind by mixed sizes are only recovered by Defragment
+struct RectPacker
+{
+    struct Rect
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    struct Move
+    {
+        uint32_t id;
+        Rect from;
+        Rect to;
+    };
+
+    RectPacker();
+
+    // drops every allocation
+    void Reset(_In_ uint32_t width, _In_ uint32_t height);
+
+    // false when there is no room, Defragment and try again
+    bool Allocate(_In_ uint32_t width, _In_ uint32_t height, _Out_ uint32_t* id, _Out_ Rect* rect);
+
+    void Free(_In_ uint32_t id);
+
+    bool Get(_In_ uint32_t id, _Out_ Rect* rect) const;
+
+    // repacks every allocation tallest first and returns the ones that moved,
+    // nothing changes if the repack would not fit
+    std::vector<Move> Defragment();
+
+    uint64_t UsedArea() const;
+
+private:
+    struct Span
+    {
+        uint32_t x;
+        uint32_t width;
+    };
+
+    struct Shelf
+    {
+        uint32_t y;
+        uint32_t height;
+        std::vector<Span> free;  // sorted by x, never adjacent
+    };
+
+    bool Place(_In_ uint32_t width, _In_ uint32_t height, _Out_ Rect* rect);
+    void Release(_In_ Rect const& rect);
+
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_nextId;
+    std::vector<Shelf> m_shelves;  // sorted by y
+    std::map<uint32_t, Rect> m_rects;
+};
@@ -0,0 +1,149 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// weights are 2.14, the horizontal pass keeps 8.8 so the vertical sum of a full weight
+// of 255s (255 << 8 << 14) still fits in 32 bits
+static constexpr uint32_t c_weightBits = 14;
+static constexpr uint32_t c_weightOne = 1u << c_weightBits;
+static constexpr uint32_t c_rowShift = c_weightBits - 8;
+static constexpr uint32_t c_outputShift = c_weightBits + 8;
+
+Resampler::Resampler()
+    : m_horizontal{}
+    , m_vertical{}
+{
+}
+
+_Use_decl_annotations_
+void Resampler::BuildAxis(
+    uint32_t sourceSize,
+    uint32_t size,
+    Axis& axis)
+{
+    if (axis.sourceSize == sourceSize && axis.size == size)
+    {
+        return;
+    }
+
+    axis.sourceSize = sourceSize;
+    axis.size = size;
+    axis.first.resize(size);
+    axis.count.resize(size);
+    axis.offset.resize(size);
+    axis.weights.clear();
+
+    double scale = static_cast<double>(sourceSize) / size;
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        // the source span output i covers
+        double start = i * scale;
+        double end = std::min(static_cast<double>(sourceSize), (i + 1) * scale);
+
+        uint32_t first = std::min(sourceSize - 1, static_cast<uint32_t>(start));
+        uint32_t last = std::max(first + 1, std::min(sourceSize, static_cast<uint32_t>(std::ceil(end))));
+
+        axis.first[i] = first;
+        axis.count[i] = last - first;
+        axis.offset[i] = static_cast<uint32_t>(axis.weights.size());
+
+        // rounded as running totals, so the taps always sum to exactly one and flat areas stay exact
+        uint32_t previous = 0;
+        for (uint32_t j = first; j < last; ++j)
+        {
+            double covered = std::min(end, j + 1.0) - start;
+            uint32_t total = (j + 1 == last) ? c_weightOne : static_cast<uint32_t>(std::lround(std::max(0.0, covered) / (end - start) * c_weightOne));
+
+            axis.weights.push_back(static_cast<uint16_t>(total - previous));
+            previous = total;
+        }
+    }
+}
+
+_Use_decl_annotations_
+void Resampler::Resample(
+    uint8_t const* source,
+    uint32_t sourceWidth,
+    uint32_t sourceHeight,
+    int32_t sourcePitch,
+    uint8_t* destination,
+    uint32_t width,
+    uint32_t height,
+    uint32_t pitch)
+{
+    if (sourceWidth == 0 || sourceHeight == 0 || width == 0 || height == 0)
+    {
+        return;
+    }
+
+    BuildAxis(sourceWidth, width, m_horizontal);
+    BuildAxis(sourceHeight, height, m_vertical);
+
+    size_t rowSize = static_cast<size_t>(width) * 4;
+    m_rows.resize(rowSize * sourceHeight);
+    m_accumulator.resize(rowSize);
+
+    // horizontal, every source row down to the output width
+    for (uint32_t y = 0; y < sourceHeight; ++y)
+    {
+        uint8_t const* in = source + static_cast<ptrdiff_t>(y) * sourcePitch;
+        uint16_t* out = m_rows.data() + rowSize * y;
+
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint8_t const* pixel = in + static_cast<size_t>(m_horizontal.first[x]) * 4;
+            uint16_t const* weight = m_horizontal.weights.data() + m_horizontal.offset[x];
+
+            uint32_t b = 0, g = 0, r = 0;
+            for (uint32_t k = 0; k < m_horizontal.count[x]; ++k, pixel += 4)
+            {
+                b += pixel[0] * weight[k];
+                g += pixel[1] * weight[k];
+                r += pixel[2] * weight[k];
+            }
+
+            uint32_t constexpr half = 1u << (c_rowShift - 1);
+            out[x * 4 + 0] = static_cast<uint16_t>((b + half) >> c_rowShift);
+            out[x * 4 + 1] = static_cast<uint16_t>((g + half) >> c_rowShift);
+            out[x * 4 + 2] = static_cast<uint16_t>((r + half) >> c_rowShift);
+            out[x * 4 + 3] = 0;
+        }
+    }
+
+    // vertical, a weighted sum of whole rows
+    uint32_t* accumulator = m_accumulator.data();
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        std::fill(m_accumulator.begin(), m_accumulator.end(), 0u);
+
+        uint16_t const* weight = m_vertical.weights.data() + m_vertical.offset[y];
+        for (uint32_t k = 0; k < m_vertical.count[y]; ++k)
+        {
+            uint16_t const* row = m_rows.data() + rowSize * (m_vertical.first[y] + k);
+            uint32_t w = weight[k];
+
+            for (size_t i = 0; i < rowSize; ++i)
+            {
+                accumulator[i] += row[i] * w;
+            }
+        }
+
+        uint8_t* out = destination + static_cast<size_t>(y) * pitch;
+
+        uint32_t constexpr half = 1u << (c_outputShift - 1);
+        for (size_t i = 0; i < rowSize; ++i)
+        {
+            out[i] = static_cast<uint8_t>((accumulator[i] + half) >> c_outputShift);
+        }
+
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            out[x * 4 + 3] = 0xff;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <vector>
+
+// area-averaging resize of 32bpp bgra, every output pixel is the coverage weighted mean of
+// the source pixels under it, enlarging degrades to nearest. separable with fixed point
+// weights, the vertical pass is a flat multiply-add over the row so the compiler vectorizes
+// it. the weights are kept while the sizes match, one instance per thread
+struct Resampler
+{
+    Resampler();
+
+    // a negative sourcePitch is a bottom up image, alpha is written opaque since
+    // decoded rgb32 leaves it undefined
+    void Resample(
+        _In_reads_bytes_(sourceHeight * abs(sourcePitch)) uint8_t const* source,
+        _In_ uint32_t sourceWidth,
+        _In_ uint32_t sourceHeight,
+        _In_ int32_t sourcePitch,
+        _Out_writes_bytes_(height * pitch) uint8_t* destination,
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _In_ uint32_t pitch);
+
+private:
+    // weights of one axis, output i takes count[i] source pixels from first[i] on
+    struct Axis
+    {
+        uint32_t sourceSize;
+        uint32_t size;
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> count;
+        std::vector<uint32_t> offset;   // into weights
+        std::vector<uint16_t> weights;  // each output sums to 1 << 14
+    };
+
+    static void BuildAxis(_In_ uint32_t sourceSize, _In_ uint32_t size, _Inout_ Axis& axis);
+
+    Axis m_horizontal;
+    Axis m_vertical;
+
+    // horizontal pass, one row of width * 4 per source row, 8.8 fixed point
+    std::vector<uint16_t> m_rows;
+    std::vector<uint32_t> m_accumulator;
+};
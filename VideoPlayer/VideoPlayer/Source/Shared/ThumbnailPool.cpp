@@ -0,0 +1,381 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "ThumbnailPool.h"
+
+#include <mferror.h>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace winrt;
+
+ThumbnailPool::ThumbnailPool()
+    : m_isShutdown(false)
+    , m_workAvailable(nullptr)
+    , m_nextBatchId(1)
+    , m_maxPending(0)
+    , m_createDecoder(nullptr)
+    , m_extracted(nullptr)
+    , m_stats{}
+    , m_busyTime(0)
+    , m_decodeMs(0.0)
+    , m_resampleMs(0.0)
+{
+}
+
+ThumbnailPool::~ThumbnailPool()
+{
+    Shutdown();
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailPool::Start(
+    uint32_t workerCount,
+    uint32_t maxPending,
+    DecoderFactory const& createDecoder,
+    ExtractedHandler const& extracted)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    if (m_isShutdown)
+    {
+        IFR(MF_E_SHUTDOWN);
+    }
+
+    if (!m_workers.empty())
+    {
+        return S_OK;
+    }
+
+    NULL_CHK_HR(createDecoder, E_INVALIDARG);
+    NULL_CHK_HR(extracted, E_INVALIDARG);
+
+    if (maxPending == 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    // 0 picks half the cores, leaving the rest to unity and to playback
+    if (workerCount == 0)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+    workerCount = std::min(workerCount, MaxWorkerCount);
+
+    m_workAvailable.attach(CreateSemaphoreEx(nullptr, 0, MAXLONG, nullptr, 0, SEMAPHORE_ALL_ACCESS));
+    NULL_CHK_HR(m_workAvailable.get(), HRESULT_FROM_WIN32(GetLastError()));
+
+    m_maxPending = maxPending;
+    m_createDecoder = createDecoder;
+    m_extracted = extracted;
+
+    auto strong = shared_from_this();
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_workers.emplace_back([strong]() { strong->ThreadProc(); });
+    }
+
+    std::lock_guard<slim_mutex> statsGuard(m_statsMutex);
+
+    m_stats.workerCount = workerCount;
+
+    return S_OK;
+}
+
+void ThumbnailPool::Shutdown()
+{
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_isShutdown)
+        {
+            return;
+        }
+        m_isShutdown = true;
+
+        m_batches.clear();
+
+        workers.swap(m_workers);
+    }
+
+    if (m_workAvailable)
+    {
+        ReleaseSemaphore(m_workAvailable.get(), static_cast<LONG>(workers.size()), nullptr);
+    }
+
+    auto currentThread = std::this_thread::get_id();
+    for (auto& worker : workers)
+    {
+        // released from a completion callback
+        if (worker.get_id() == currentThread)
+        {
+            worker.detach();
+        }
+        else
+        {
+            worker.join();
+        }
+    }
+}
+
+_Use_decl_annotations_
+HRESULT ThumbnailPool::Add(
+    Batch&& batch,
+    uint32_t* batchId)
+{
+    *batchId = 0;
+
+    uint32_t count = static_cast<uint32_t>(batch.timestamps.size());
+    if (count == 0)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    {
+        std::lock_guard<slim_mutex> guard(m_mutex);
+
+        if (m_isShutdown || m_workers.empty())
+        {
+            IFR(MF_E_SHUTDOWN);
+        }
+
+        {
+            std::lock_guard<slim_mutex> statsGuard(m_statsMutex);
+
+            if (m_stats.pending > 0 && static_cast<uint64_t>(m_stats.pending) + count > m_maxPending)
+            {
+                IFR(MF_E_NOTACCEPTING);
+            }
+        }
+
+        BeginWork(count);
+
+        batch.id = m_nextBatchId++;
+        *batchId = batch.id;
+
+        m_batches.push_back(std::move(batch));
+    }
+
+    ReleaseSemaphore(m_workAvailable.get(), 1, nullptr);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void ThumbnailPool::Complete(
+    THUMBNAIL_STATE const& state)
+{
+    {
+        std::lock_guard<slim_mutex> guard(m_statsMutex);
+
+        if (SUCCEEDED(state.hresult))
+        {
+            ++m_stats.completed;
+        }
+        else
+        {
+            ++m_stats.failed;
+        }
+    }
+
+    EndWork(1);
+}
+
+_Use_decl_annotations_
+void ThumbnailPool::GetStats(
+    THUMBNAIL_STATS* stats)
+{
+    std::lock_guard<slim_mutex> guard(m_statsMutex);
+
+    *stats = m_stats;
+
+    auto busy = m_busyTime;
+    if (m_stats.pending > 0)
+    {
+        busy += std::chrono::steady_clock::now() - m_busySince;
+    }
+
+    double seconds = std::chrono::duration<double>(busy).count();
+    if (seconds > 0.0)
+    {
+        stats->thumbnailsPerSecond = static_cast<float>((m_stats.completed + m_stats.failed) / seconds);
+    }
+
+    stats->decodeMs = m_stats.decoded > 0 ? static_cast<float>(m_decodeMs / m_stats.decoded) : 0.0f;
+    stats->resampleMs = m_stats.completed > 0 ? static_cast<float>(m_resampleMs / m_stats.completed) : 0.0f;
+}
+
+void ThumbnailPool::ThreadProc()
+{
+    // m_createDecoder is set before the workers start and never changes
+    std::unique_ptr<ThumbnailDecoder> decoder = m_createDecoder();
+
+    // keeps its weights and scratch rows for as long as the sizes repeat
+    Resampler resampler;
+
+    for (;;)
+    {
+        WaitForSingleObject(m_workAvailable.get(), INFINITE);
+
+        Batch batch{};
+        {
+            std::lock_guard<slim_mutex> guard(m_mutex);
+
+            if (m_isShutdown)
+            {
+                break;
+            }
+
+            if (m_batches.empty())
+            {
+                continue;
+            }
+
+            batch = std::move(m_batches.front());
+            m_batches.pop_front();
+        }
+
+        if (decoder == nullptr)
+        {
+            uint32_t count = static_cast<uint32_t>(batch.timestamps.size());
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                m_extracted(batch, THUMBNAIL_STATE{ batch.id, i, E_OUTOFMEMORY, count - i - 1, batch.timestamps[i], 0 }, std::vector<uint8_t>());
+            }
+
+            continue;
+        }
+
+        Extract(batch, *decoder, resampler);
+    }
+
+    // released on the thread that created it
+    decoder = nullptr;
+}
+
+_Use_decl_annotations_
+void ThumbnailPool::Extract(
+    Batch const& batch,
+    ThumbnailDecoder& decoder,
+    Resampler& resampler)
+{
+    uint32_t count = static_cast<uint32_t>(batch.timestamps.size());
+    uint32_t remaining = count;
+    size_t thumbnailSize = static_cast<size_t>(batch.width) * batch.height * 4;
+
+    HRESULT openResult = decoder.Open(batch.location);
+
+    // forward through the file, the decoder never has to seek back
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&batch](uint32_t a, uint32_t b) { return batch.timestamps[a] < batch.timestamps[b]; });
+
+    // the last keyframe scaled, timestamps that land on it again are copied instead of scaled
+    int64_t lastKeyframe = -1;
+    uint8_t const* lastThumbnail = nullptr;
+    std::vector<uint8_t> lastPixels;
+
+    for (uint32_t index : order)
+    {
+        THUMBNAIL_STATE state{ batch.id, index, openResult, --remaining, batch.timestamps[index], 0 };
+
+        {
+            std::shared_lock<slim_mutex> slock(m_mutex);
+
+            if (m_isShutdown)
+            {
+                return;
+            }
+        }
+
+        std::vector<uint8_t> pixels;
+        uint8_t* destination = batch.buffer;
+        if (destination != nullptr)
+        {
+            destination += thumbnailSize * index;
+        }
+        else
+        {
+            pixels.resize(thumbnailSize);
+            destination = pixels.data();
+        }
+
+        ThumbnailDecoder::Frame frame{};
+        if (SUCCEEDED(state.hresult))
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            state.hresult = decoder.DecodeKeyframe(state.requested, &state.timestamp, &frame);
+
+            if (SUCCEEDED(state.hresult) && state.timestamp != lastKeyframe)
+            {
+                std::lock_guard<slim_mutex> guard(m_statsMutex);
+
+                ++m_stats.decoded;
+                m_decodeMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        }
+
+        if (SUCCEEDED(state.hresult) && state.timestamp == lastKeyframe && lastThumbnail != nullptr)
+        {
+            memcpy(destination, lastThumbnail, thumbnailSize);
+        }
+        else if (SUCCEEDED(state.hresult))
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            resampler.Resample(frame.scanline0, frame.width, frame.height, frame.pitch, destination, batch.width, batch.height, batch.width * 4);
+
+            {
+                std::lock_guard<slim_mutex> guard(m_statsMutex);
+
+                m_resampleMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+
+            // the caller's buffer is not read back, handed over pixels keep a copy
+            lastKeyframe = state.timestamp;
+            if (batch.buffer != nullptr)
+            {
+                lastThumbnail = destination;
+            }
+            else
+            {
+                lastPixels = pixels;
+                lastThumbnail = lastPixels.data();
+            }
+        }
+
+        m_extracted(batch, state, std::move(pixels));
+    }
+}
+
+_Use_decl_annotations_
+void ThumbnailPool::BeginWork(
+    uint32_t count)
+{
+    std::lock_guard<slim_mutex> guard(m_statsMutex);
+
+    if (m_stats.pending == 0)
+    {
+        m_busySince = std::chrono::steady_clock::now();
+    }
+
+    m_stats.pending += count;
+}
+
+_Use_decl_annotations_
+void ThumbnailPool::EndWork(
+    uint32_t count)
+{
+    std::lock_guard<slim_mutex> guard(m_statsMutex);
+
+    m_stats.pending -= std::min(count, m_stats.pending);
+
+    if (m_stats.pending == 0)
+    {
+        m_busyTime += std::chrono::steady_clock::now() - m_busySince;
+    }
+}
@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "Resampler.h"
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// the decode side of a ThumbnailPool worker, each worker creates its own on its own thread
+// and destroys it there, so it can hold thread affine state
+struct ThumbnailDecoder
+{
+    struct Frame
+    {
+        uint8_t const* scanline0;
+        int32_t pitch;      // negative for a bottom up frame
+        uint32_t width;
+        uint32_t height;
+    };
+
+    virtual ~ThumbnailDecoder() = default;
+
+    virtual HRESULT Open(
+        _In_ winrt::hstring const& location) = 0;
+
+    // the keyframe at or before position and its time, the frame stays valid until the
+    // next call
+    virtual HRESULT DecodeKeyframe(
+        _In_ int64_t position,
+        _Out_ int64_t* timestamp,
+        _Out_ Frame* frame) = 0;
+};
+
+// the bounded workers behind ThumbnailExtractor. a batch is one file and a list of
+// timestamps, a worker opens the file, visits the timestamps in time order, decodes the
+// keyframe each one lands on once and scales it into the batch's buffer, or hands the
+// pixels over when the batch has none. at most maxPending thumbnails are queued, being
+// extracted or waiting to be reported
+struct ThumbnailPool : std::enable_shared_from_this<ThumbnailPool>
+{
+    struct Batch
+    {
+        uint32_t id;
+        winrt::hstring location;
+        std::vector<int64_t> timestamps;
+        uint32_t width;
+        uint32_t height;
+        uint8_t* buffer;        // width * height * 4 per timestamp, packed, or null
+        uint32_t firstSlice;
+    };
+
+    typedef std::function<std::unique_ptr<ThumbnailDecoder>()> DecoderFactory;
+
+    // every thumbnail of a batch comes through here once, from a worker. pixels is empty
+    // when they went into the batch's buffer. the handler reports it with Complete(), now
+    // or later, until then it counts as pending
+    typedef std::function<void(Batch const& batch, THUMBNAIL_STATE const& state, std::vector<uint8_t>&& pixels)> ExtractedHandler;
+
+    static constexpr uint32_t MaxWorkerCount = 8;
+
+    ThumbnailPool();
+    ~ThumbnailPool();
+
+    // 0 workers picks half the cores, more than MaxWorkerCount only compete for them
+    HRESULT Start(
+        _In_ uint32_t workerCount,
+        _In_ uint32_t maxPending,
+        _In_ DecoderFactory const& createDecoder,
+        _In_ ExtractedHandler const& extracted);
+
+    // queued batches are dropped and a running one stops at its next timestamp, no
+    // handler runs once this returns
+    void Shutdown();
+
+    // MF_E_NOTACCEPTING while the batch would take pending past maxPending, a batch larger
+    // than that is only taken when nothing else is pending
+    HRESULT Add(
+        _Inout_ Batch&& batch,
+        _Out_ uint32_t* batchId);
+
+    // the thumbnail was reported, it is counted and no longer pending
+    void Complete(
+        _In_ THUMBNAIL_STATE const& state);
+
+    void GetStats(
+        _Out_ THUMBNAIL_STATS* stats);
+
+private:
+    void ThreadProc();
+
+    void Extract(
+        _In_ Batch const& batch,
+        _Inout_ ThumbnailDecoder& decoder,
+        _Inout_ Resampler& resampler);
+
+    void BeginWork(_In_ uint32_t count);
+    void EndWork(_In_ uint32_t count);
+
+private:
+    winrt::slim_mutex m_mutex;
+    bool m_isShutdown;
+    winrt::handle m_workAvailable;
+    std::vector<std::thread> m_workers;
+    std::deque<Batch> m_batches;
+    uint32_t m_nextBatchId;
+    uint32_t m_maxPending;
+    DecoderFactory m_createDecoder;
+    ExtractedHandler m_extracted;
+
+    // throughput only counts time with work pending, so an idle browser does not dilute it
+    winrt::slim_mutex m_statsMutex;
+    THUMBNAIL_STATS m_stats;
+    std::chrono::steady_clock::duration m_busyTime;
+    std::chrono::steady_clock::time_point m_busySince;
+    double m_decodeMs;
+    double m_resampleMs;
+};
@@ -0,0 +1,582 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr uint32_t c_maxColumns = 64;
+static constexpr uint32_t c_maxRows = 32;
+
+// a frustum wider than this is treated as this, the tangent runs away at 90
+static constexpr float c_maxHalfAngle = 85.0f;
+
+// samples across the frustum per axis, at least two per tile
+static constexpr uint32_t c_minSamples = 3;
+static constexpr uint32_t c_maxSamples = 65;
+
+static constexpr float c_pi = 3.14159265358979f;
+static constexpr float c_radians = c_pi / 180.0f;
+static constexpr float c_degrees = 180.0f / c_pi;
+
+// -180 to 180
+static float WrapDegrees(float angle)
+{
+    angle = std::fmod(angle + 180.0f, 360.0f);
+    if (angle < 0.0f)
+    {
+        angle += 360.0f;
+    }
+
+    return angle - 180.0f;
+}
+
+TileScheduler::Settings TileScheduler::DefaultSettings()
+{
+    Settings settings{};
+    settings.marginDegrees = 10.0f;
+    settings.lookahead = 5000000;       // 0.5s, opening a stream and decoding to its first frame
+    settings.velocityWindow = 1000000;  // 100ms
+    settings.minSpeed = 20.0f;
+    settings.maxSpeed = 300.0f;
+    settings.maxActiveTiles = 12;
+    settings.linger = 10000000;         // 1s
+    settings.retryDelay = 20000000;     // 2s
+
+    return settings;
+}
+
+TileScheduler::TileScheduler()
+    : m_columns(0)
+    , m_rows(0)
+    , m_settings(DefaultSettings())
+    , m_activeCount(0)
+    , m_predicted{}
+    , m_visibleCount(0)
+    , m_updates(0)
+    , m_started(0)
+    , m_stopped(0)
+    , m_prefetched(0)
+    , m_prefetchHits(0)
+    , m_prefetchWasted(0)
+    , m_missed(0)
+    , m_visibleSum(0)
+    , m_visibleReadySum(0)
+{
+}
+
+_Use_decl_annotations_
+HRESULT TileScheduler::Reset(
+    uint32_t columns,
+    uint32_t rows,
+    Settings const& settings)
+{
+    if (columns < 1 || columns > c_maxColumns || rows < 1 || rows > c_maxRows || settings.maxActiveTiles < 1)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_columns = columns;
+    m_rows = rows;
+    m_settings = settings;
+
+    m_tiles.assign(static_cast<size_t>(columns) * rows, Tile{});
+    for (uint32_t row = 0; row < rows; ++row)
+    {
+        for (uint32_t column = 0; column < columns; ++column)
+        {
+            Tile& tile = m_tiles[row * columns + column];
+            tile.need = Need::None;
+            tile.unwantedSince = -1;
+            tile.failedAt = -1;
+            tile.longitude = (column + 0.5f) * 360.0f / columns - 180.0f;
+            tile.latitude = 90.0f - (row + 0.5f) * 180.0f / rows;
+        }
+    }
+
+    m_activeCount = 0;
+    m_history.clear();
+    m_predicted = View{};
+    m_visibleCount = 0;
+
+    m_updates = 0;
+    m_started = 0;
+    m_stopped = 0;
+    m_prefetched = 0;
+    m_prefetchHits = 0;
+    m_prefetchWasted = 0;
+    m_missed = 0;
+    m_visibleSum = 0;
+    m_visibleReadySum = 0;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void TileScheduler::Update(
+    View const& view,
+    std::vector<uint32_t>& start,
+    std::vector<uint32_t>& stop)
+{
+    if (m_tiles.empty())
+    {
+        return;
+    }
+
+    ++m_updates;
+
+    for (auto& tile : m_tiles)
+    {
+        tile.need = Need::None;
+    }
+
+    m_predicted = Predict(view);
+
+    float halfH = view.fovH * 0.5f;
+    float halfV = view.fovV * 0.5f;
+    float margin = m_settings.marginDegrees;
+
+    Mark(view.yaw, view.pitch, halfH, halfV, Need::Visible);
+    Mark(view.yaw, view.pitch, halfH + margin, halfV + margin, Need::Margin);
+    Mark(m_predicted.yaw, m_predicted.pitch, halfH + margin, halfV + margin, Need::Predicted);
+
+    // closest to the center of the view first, or of the predicted view for a tile only wanted there
+    auto closeness = [](Tile const& tile, View const& center)
+    {
+        float latitude = tile.latitude * c_radians;
+        float pitch = center.pitch * c_radians;
+
+        return std::sin(latitude) * std::sin(pitch)
+            + std::cos(latitude) * std::cos(pitch) * std::cos((tile.longitude - center.yaw) * c_radians);
+    };
+
+    std::vector<std::pair<float, uint32_t>> order;
+    for (uint32_t index = 0; index < TileCount(); ++index)
+    {
+        Tile const& tile = m_tiles[index];
+        if (tile.need == Need::None)
+        {
+            continue;
+        }
+
+        // a tile that just failed leaves its place in the budget to the next one
+        if (tile.failedAt >= 0 && view.time - tile.failedAt < m_settings.retryDelay)
+        {
+            continue;
+        }
+
+        float key = static_cast<float>(tile.need) * 4.0f - closeness(tile, tile.need == Need::Predicted ? m_predicted : view);
+        order.emplace_back(key, index);
+    }
+
+    std::sort(order.begin(), order.end());
+    if (order.size() > m_settings.maxActiveTiles)
+    {
+        order.resize(m_settings.maxActiveTiles);
+    }
+
+    for (auto& tile : m_tiles)
+    {
+        if (tile.active && tile.unwantedSince < 0)
+        {
+            tile.unwantedSince = view.time;
+        }
+    }
+
+    for (auto const& entry : order)
+    {
+        m_tiles[entry.second].unwantedSince = -1;
+    }
+
+    for (uint32_t index = 0; index < TileCount(); ++index)
+    {
+        Tile const& tile = m_tiles[index];
+        if (tile.active && tile.unwantedSince >= 0 && view.time - tile.unwantedSince >= m_settings.linger)
+        {
+            StopTile(index, stop);
+        }
+    }
+
+    // the budget was lowered, whatever is past it was not wanted above
+    while (m_activeCount > m_settings.maxActiveTiles)
+    {
+        uint32_t evict = Evictable();
+        if (evict == UINT32_MAX)
+        {
+            break;
+        }
+
+        StopTile(evict, stop);
+    }
+
+    for (auto const& entry : order)
+    {
+        Tile& tile = m_tiles[entry.second];
+        if (tile.active)
+        {
+            continue;
+        }
+
+        // the decoder that has been unwanted the longest makes room
+        if (m_activeCount >= m_settings.maxActiveTiles)
+        {
+            uint32_t evict = Evictable();
+            if (evict == UINT32_MAX)
+            {
+                break;
+            }
+
+            if (tile.need == Need::Predicted && view.time - m_tiles[evict].unwantedSince < m_settings.lookahead)
+            {
+                continue;
+            }
+
+            StopTile(evict, stop);
+        }
+
+        tile.active = true;
+        tile.ready = false;
+        tile.prefetched = tile.need != Need::Visible;
+        tile.unwantedSince = -1;
+        tile.failedAt = -1;
+
+        ++m_activeCount;
+        ++m_started;
+        if (tile.prefetched)
+        {
+            ++m_prefetched;
+        }
+
+        start.push_back(entry.second);
+    }
+
+    uint32_t visibleReady = 0;
+    m_visibleCount = 0;
+    for (auto& tile : m_tiles)
+    {
+        if (tile.need != Need::Visible)
+        {
+            continue;
+        }
+
+        ++m_visibleCount;
+
+        if (tile.ready)
+        {
+            ++visibleReady;
+        }
+        else
+        {
+            ++m_missed;
+        }
+
+        // a prefetch counts once, on the first update that sees the tile
+        if (tile.prefetched)
+        {
+            if (tile.ready)
+            {
+                ++m_prefetchHits;
+            }
+
+            tile.prefetched = false;
+        }
+    }
+
+    m_visibleSum += m_visibleCount;
+    m_visibleReadySum += visibleReady;
+}
+
+_Use_decl_annotations_
+void TileScheduler::OnReady(
+    uint32_t tile)
+{
+    if (tile < TileCount() && m_tiles[tile].active)
+    {
+        m_tiles[tile].ready = true;
+    }
+}
+
+_Use_decl_annotations_
+void TileScheduler::OnFailed(
+    uint32_t tile,
+    int64_t time)
+{
+    if (tile >= TileCount() || !m_tiles[tile].active)
+    {
+        return;
+    }
+
+    Tile& failed = m_tiles[tile];
+    failed.active = false;
+    failed.ready = false;
+    failed.prefetched = false;
+    failed.unwantedSince = -1;
+    failed.failedAt = time;
+
+    --m_activeCount;
+}
+
+_Use_decl_annotations_
+void TileScheduler::SetMaxActiveTiles(
+    uint32_t maxActiveTiles)
+{
+    m_settings.maxActiveTiles = maxActiveTiles;
+}
+
+_Use_decl_annotations_
+bool TileScheduler::IsActive(
+    uint32_t tile) const
+{
+    return tile < TileCount() && m_tiles[tile].active;
+}
+
+_Use_decl_annotations_
+bool TileScheduler::IsReady(
+    uint32_t tile) const
+{
+    return tile < TileCount() && m_tiles[tile].ready;
+}
+
+_Use_decl_annotations_
+bool TileScheduler::IsVisible(
+    uint32_t tile) const
+{
+    return tile < TileCount() && m_tiles[tile].need == Need::Visible;
+}
+
+_Use_decl_annotations_
+void TileScheduler::GetStats(
+    TILED_STATS* stats) const
+{
+    stats->columns = m_columns;
+    stats->rows = m_rows;
+    stats->maxActiveTiles = m_settings.maxActiveTiles;
+    stats->visibleTiles = m_visibleCount;
+    stats->activeTiles = m_activeCount;
+    stats->readyTiles = static_cast<uint32_t>(std::count_if(m_tiles.begin(), m_tiles.end(), [](Tile const& tile) { return tile.ready; }));
+    stats->updates = m_updates;
+    stats->tilesStarted = m_started;
+    stats->tilesStopped = m_stopped;
+    stats->prefetched = m_prefetched;
+    stats->prefetchHits = m_prefetchHits;
+    stats->prefetchWasted = m_prefetchWasted;
+    stats->missedTiles = m_missed;
+    stats->visibleReadyRatio = m_visibleSum > 0 ? static_cast<float>(static_cast<double>(m_visibleReadySum) / m_visibleSum) : 1.0f;
+    stats->predictedYaw = m_predicted.yaw;
+    stats->predictedPitch = m_predicted.pitch;
+}
+
+_Use_decl_annotations_
+TileScheduler::View TileScheduler::Predict(
+    View const& view)
+{
+    // time going backwards is a new trace
+    if (!m_history.empty() && view.time < m_history.back().time)
+    {
+        m_history.clear();
+    }
+
+    m_history.push_back(view);
+
+    // one view at or past the edge of the window stays as the reference
+    while (m_history.size() > 2 && view.time - m_history[1].time >= m_settings.velocityWindow)
+    {
+        m_history.pop_front();
+    }
+
+    View predicted = view;
+
+    View const& oldest = m_history.front();
+    double seconds = (view.time - oldest.time) / 1e7;
+    if (seconds <= 0.0)
+    {
+        return predicted;
+    }
+
+    float yawSpeed = static_cast<float>(WrapDegrees(view.yaw - oldest.yaw) / seconds);
+    float pitchSpeed = static_cast<float>((view.pitch - oldest.pitch) / seconds);
+
+    float speed = std::hypot(yawSpeed, pitchSpeed);
+    if (speed < m_settings.minSpeed)
+    {
+        return predicted;
+    }
+
+    if (speed > m_settings.maxSpeed)
+    {
+        yawSpeed *= m_settings.maxSpeed / speed;
+        pitchSpeed *= m_settings.maxSpeed / speed;
+    }
+
+    float lookahead = static_cast<float>(m_settings.lookahead / 1e7);
+    predicted.time = view.time + m_settings.lookahead;
+    predicted.yaw = WrapDegrees(view.yaw + yawSpeed * lookahead);
+    predicted.pitch = std::clamp(view.pitch + pitchSpeed * lookahead, -90.0f, 90.0f);
+
+    return predicted;
+}
+
+_Use_decl_annotations_
+void TileScheduler::Mark(
+    float yaw,
+    float pitch,
+    float halfH,
+    float halfV,
+    Need need)
+{
+    halfH = std::clamp(halfH, 0.0f, c_maxHalfAngle);
+    halfV = std::clamp(halfV, 0.0f, c_maxHalfAngle);
+
+    // dense enough that a tile can not fall between two samples, except towards the poles
+    // where a row of tiles narrows and neighbouring samples fill the columns between them
+    float tileAngle = std::min(360.0f / m_columns, 180.0f / m_rows);
+    auto samples = [tileAngle](float half)
+    {
+        return std::clamp(static_cast<uint32_t>(std::ceil(4.0f * half / tileAngle)) + 1, c_minSamples, c_maxSamples);
+    };
+
+    uint32_t samplesH = samples(halfH);
+    uint32_t samplesV = samples(halfV);
+
+    float sinYaw = std::sin(yaw * c_radians);
+    float cosYaw = std::cos(yaw * c_radians);
+    float sinPitch = std::sin(pitch * c_radians);
+    float cosPitch = std::cos(pitch * c_radians);
+
+    for (uint32_t j = 0; j < samplesV; ++j)
+    {
+        float y = std::tan((-halfV + 2.0f * halfV * j / (samplesV - 1)) * c_radians);
+
+        uint32_t previousColumn = 0;
+        uint32_t previousRow = 0;
+        for (uint32_t i = 0; i < samplesH; ++i)
+        {
+            float x = std::tan((-halfH + 2.0f * halfH * i / (samplesH - 1)) * c_radians);
+
+            // the view looks down z with y up, pitched around x and then turned around y
+            float pitchedY = y * cosPitch + sinPitch;
+            float pitchedZ = cosPitch - y * sinPitch;
+            float worldX = x * cosYaw + pitchedZ * sinYaw;
+            float worldZ = pitchedZ * cosYaw - x * sinYaw;
+
+            float longitude = std::atan2(worldX, worldZ) * c_degrees;
+            float latitude = std::atan2(pitchedY, std::hypot(worldX, worldZ)) * c_degrees;
+
+            uint32_t column = Column(longitude);
+            uint32_t row = Row(latitude);
+
+            if (i == 0)
+            {
+                MarkColumns(row, column, column, need);
+            }
+            else
+            {
+                MarkColumns(row, previousColumn, column, need);
+                if (row != previousRow)
+                {
+                    MarkColumns(previousRow, previousColumn, column, need);
+                }
+            }
+
+            previousColumn = column;
+            previousRow = row;
+        }
+    }
+
+    // a pole inside the frustum sees its whole row
+    float tanHalfV = std::tan(halfV * c_radians);
+    if (std::abs(sinPitch) > 1e-6f && std::abs(cosPitch / sinPitch) <= tanHalfV)
+    {
+        uint32_t row = sinPitch > 0.0f ? 0 : m_rows - 1;
+        for (uint32_t column = 0; column < m_columns; ++column)
+        {
+            MarkColumns(row, column, column, need);
+        }
+    }
+}
+
+_Use_decl_annotations_
+void TileScheduler::MarkColumns(
+    uint32_t row,
+    uint32_t from,
+    uint32_t to,
+    Need need)
+{
+    // the shorter way around
+    uint32_t forward = (to + m_columns - from) % m_columns;
+    int32_t step = forward <= m_columns / 2 ? 1 : -1;
+    uint32_t count = step > 0 ? forward : m_columns - forward;
+
+    uint32_t column = from;
+    for (uint32_t k = 0; k <= count; ++k)
+    {
+        Tile& tile = m_tiles[row * m_columns + column];
+        tile.need = std::min(tile.need, need);
+
+        column = (column + m_columns + step) % m_columns;
+    }
+}
+
+_Use_decl_annotations_
+uint32_t TileScheduler::Column(
+    float longitude) const
+{
+    float u = (longitude + 180.0f) / 360.0f;
+
+    return std::min(static_cast<uint32_t>(std::max(0.0f, u * m_columns)), m_columns - 1);
+}
+
+_Use_decl_annotations_
+uint32_t TileScheduler::Row(
+    float latitude) const
+{
+    float v = (90.0f - latitude) / 180.0f;
+
+    return std::min(static_cast<uint32_t>(std::max(0.0f, v * m_rows)), m_rows - 1);
+}
+
+uint32_t TileScheduler::Evictable() const
+{
+    uint32_t evict = UINT32_MAX;
+    for (uint32_t index = 0; index < TileCount(); ++index)
+    {
+        Tile const& candidate = m_tiles[index];
+        if (candidate.active && candidate.unwantedSince >= 0
+            && (evict == UINT32_MAX || candidate.unwantedSince < m_tiles[evict].unwantedSince))
+        {
+            evict = index;
+        }
+    }
+
+    return evict;
+}
+
+_Use_decl_annotations_
+void TileScheduler::StopTile(
+    uint32_t index,
+    std::vector<uint32_t>& stop)
+{
+    Tile& tile = m_tiles[index];
+    if (!tile.active)
+    {
+        return;
+    }
+
+    // started for a view that never came
+    if (tile.prefetched)
+    {
+        ++m_prefetchWasted;
+    }
+
+    tile.active = false;
+    tile.ready = false;
+    tile.prefetched = false;
+    tile.unwantedSince = -1;
+
+    --m_activeCount;
+    ++m_stopped;
+
+    stop.push_back(index);
+}
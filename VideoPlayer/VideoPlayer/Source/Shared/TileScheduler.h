@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+// which tiles of a 360 video to decode. the equirectangular frame is split into columns x
+// rows tiles, each its own stream, row 0 at the top and column 0 at the left edge, which is
+// straight behind the viewer. only a budget of them decodes at once
+//
+// every view update marks the tiles the view frustum touches, then the ones inside a margin
+// around it, then the ones around where the head is heading. recent views give the angular
+// velocity and the frustum is moved ahead by the lookahead, which is roughly how long a tile
+// needs from starting its decoder to its first frame. the tiles are taken in that order and
+// by their distance from the center of the view until the budget is full. a tile that drops
+// out keeps decoding for a while in case the view swings back, and is the first to go when
+// its decoder is needed for a tile in or around the view. a tile only wanted for the
+// prediction takes a decoder that has been unwanted for at least the lookahead, otherwise
+// an estimate that wanders would churn the decoders it started itself
+//
+// orientations are degrees, times 100ns. there is no platform dependency in here so recorded
+// head traces can be replayed against it with decoders that report ready after some latency.
+// not thread safe, the caller serializes
+struct TileScheduler
+{
+    struct Settings
+    {
+        float marginDegrees;        // around the view on every side, also covers head roll
+        int64_t lookahead;          // how far ahead head motion is extrapolated
+        int64_t velocityWindow;     // the views the velocity is estimated over
+        float minSpeed;             // degrees per second, slower is jitter and not extrapolated
+        float maxSpeed;             // a faster estimate is clamped
+        uint32_t maxActiveTiles;    // decoders running at once
+        int64_t linger;             // an unwanted tile keeps decoding this long
+        int64_t retryDelay;         // a tile whose decoder failed is not started again before
+    };
+
+    // yaw to the right of the frame's center, pitch up, fov are full angles
+    struct View
+    {
+        int64_t time;
+        float yaw;
+        float pitch;
+        float fovH;
+        float fovV;
+    };
+
+    static Settings DefaultSettings();
+
+    TileScheduler();
+
+    HRESULT Reset(_In_ uint32_t columns, _In_ uint32_t rows, _In_ Settings const& settings);
+
+    uint32_t Columns() const { return m_columns; }
+    uint32_t Rows() const { return m_rows; }
+    uint32_t TileCount() const { return m_columns * m_rows; }
+
+    // moves the active set towards the view, start and stop get the tiles that changed,
+    // stops first. the caller starts and stops the decoders
+    void Update(
+        _In_ View const& view,
+        _Inout_ std::vector<uint32_t>& start,
+        _Inout_ std::vector<uint32_t>& stop);
+
+    // the tile's decoder delivered its first frame
+    void OnReady(_In_ uint32_t tile);
+
+    // the tile's decoder would not open or found no room for its frames, its slot is free
+    // for another tile and it is not started again for the retry delay
+    void OnFailed(_In_ uint32_t tile, _In_ int64_t time);
+
+    // lowers or raises the budget once the caller knows what fits, a tile active past it
+    // is stopped by the next update. 0 starts nothing
+    void SetMaxActiveTiles(_In_ uint32_t maxActiveTiles);
+
+    bool IsActive(_In_ uint32_t tile) const;
+    bool IsReady(_In_ uint32_t tile) const;
+    bool IsVisible(_In_ uint32_t tile) const;
+
+    // the scheduler's share of the stats
+    void GetStats(_Inout_ TILED_STATS* stats) const;
+
+private:
+    // what a tile is wanted for, most urgent first
+    enum class Need : uint8_t
+    {
+        Visible = 0,
+        Margin,
+        Predicted,
+        None,
+    };
+
+    struct Tile
+    {
+        Need need;
+        bool active;
+        bool ready;
+        bool prefetched;        // started before it was visible, until it is
+        int64_t unwantedSince;  // -1 while wanted
+        int64_t failedAt;       // -1 unless its decoder failed
+        float longitude;        // center, degrees
+        float latitude;
+    };
+
+    View Predict(_In_ View const& view);
+
+    // marks every tile the frustum touches that needs less
+    void Mark(
+        _In_ float yaw,
+        _In_ float pitch,
+        _In_ float halfH,
+        _In_ float halfV,
+        _In_ Need need);
+
+    void MarkColumns(_In_ uint32_t row, _In_ uint32_t from, _In_ uint32_t to, _In_ Need need);
+
+    uint32_t Column(_In_ float longitude) const;
+    uint32_t Row(_In_ float latitude) const;
+
+    // the active tile unwanted the longest, UINT32_MAX when every one is wanted
+    uint32_t Evictable() const;
+
+    void StopTile(_In_ uint32_t tile, _Inout_ std::vector<uint32_t>& stop);
+
+private:
+    uint32_t m_columns;
+    uint32_t m_rows;
+    Settings m_settings;
+
+    std::vector<Tile> m_tiles;
+    uint32_t m_activeCount;
+
+    std::deque<View> m_history;
+    View m_predicted;
+
+    // last update
+    uint32_t m_visibleCount;
+
+    uint64_t m_updates;
+    uint64_t m_started;
+    uint64_t m_stopped;
+    uint64_t m_prefetched;
+    uint64_t m_prefetchHits;
+    uint64_t m_prefetchWasted;
+    uint64_t m_missed;
+    uint64_t m_visibleSum;
+    uint64_t m_visibleReadySum;
+};
@@ -0,0 +1,206 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "VideoAtlas.h"
+
+using namespace winrt;
+
+// texels around every tile so bilinear filtering does not pick up the neighbours
+static constexpr uint32_t c_padding = 2;
+
+static slim_mutex s_instanceMutex;
+static std::weak_ptr<VideoAtlas> s_instance;
+
+_Use_decl_annotations_
+HRESULT VideoAtlas::Acquire(
+    ID3D11Device* unityDevice,
+    std::shared_ptr<VideoAtlas>& atlas)
+{
+    atlas = nullptr;
+
+    NULL_CHK_HR(unityDevice, E_INVALIDARG);
+
+    std::lock_guard<slim_mutex> guard(s_instanceMutex);
+
+    auto existing = s_instance.lock();
+    if (existing != nullptr && existing->m_unityDevice == unityDevice)
+    {
+        atlas = existing;
+
+        return S_OK;
+    }
+
+    std::shared_ptr<VideoAtlas> created(new VideoAtlas());
+    created->m_unityDevice = unityDevice;
+
+    auto textureDesc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_B8G8R8A8_UNORM, Size, Size);
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    textureDesc.MipLevels = 1;
+    textureDesc.Usage = D3D11_USAGE_DEFAULT;
+
+    IFR(unityDevice->CreateTexture2D(&textureDesc, nullptr, created->m_texture.put()));
+
+    auto srvDesc = CD3D11_SHADER_RESOURCE_VIEW_DESC(created->m_texture.get(), D3D11_SRV_DIMENSION_TEXTURE2D);
+    IFR(unityDevice->CreateShaderResourceView(created->m_texture.get(), &srvDesc, created->m_textureSRV.put()));
+
+    created->m_packer.Reset(Size, Size);
+
+    s_instance = created;
+    atlas = created;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+uint32_t VideoAtlas::Capacity(
+    uint32_t width,
+    uint32_t height,
+    uint32_t otherWidth,
+    uint32_t otherHeight,
+    uint32_t limit)
+{
+    if (width < 1 || height < 1)
+    {
+        return 0;
+    }
+
+    RectPacker packer;
+    packer.Reset(Size, Size);
+
+    // one at a time and defragmented when one does not fit, like Allocate
+    auto allocate = [&packer](uint32_t allocateWidth, uint32_t allocateHeight)
+    {
+        uint32_t id = 0;
+        RectPacker::Rect rect{};
+        if (packer.Allocate(allocateWidth + 2 * c_padding, allocateHeight + 2 * c_padding, &id, &rect))
+        {
+            return true;
+        }
+
+        packer.Defragment();
+
+        return packer.Allocate(allocateWidth + 2 * c_padding, allocateHeight + 2 * c_padding, &id, &rect);
+    };
+
+    if (otherWidth > 0 && otherHeight > 0 && !allocate(otherWidth, otherHeight))
+    {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    while (count < limit && allocate(width, height))
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+VideoAtlas::VideoAtlas()
+    : m_unityDevice(nullptr)
+    , m_texture(nullptr)
+    , m_textureSRV(nullptr)
+{
+}
+
+_Use_decl_annotations_
+HRESULT VideoAtlas::Allocate(
+    uint32_t width,
+    uint32_t height,
+    uint32_t* id)
+{
+    NULL_CHK_HR(id, E_INVALIDARG);
+
+    *id = 0;
+
+    if (width < 1 || height < 1 || width + 2 * c_padding > Size || height + 2 * c_padding > Size)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    RectPacker::Rect rect{};
+    if (m_packer.Allocate(width + 2 * c_padding, height + 2 * c_padding, id, &rect))
+    {
+        return S_OK;
+    }
+
+    for (auto const& move : m_packer.Defragment())
+    {
+        m_moved.insert(move.id);
+    }
+
+    if (!m_packer.Allocate(width + 2 * c_padding, height + 2 * c_padding, id, &rect))
+    {
+        IFR(E_OUTOFMEMORY);
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+void VideoAtlas::Free(
+    uint32_t id)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    m_packer.Free(id);
+    m_moved.erase(id);
+}
+
+_Use_decl_annotations_
+bool VideoAtlas::GetRect(
+    uint32_t id,
+    ATLAS_RECT* rect)
+{
+    ZeroMemory(rect, sizeof(ATLAS_RECT));
+
+    RectPacker::Rect allocated{};
+    {
+        std::shared_lock<slim_mutex> slock(m_mutex);
+
+        if (!m_packer.Get(id, &allocated))
+        {
+            return false;
+        }
+    }
+
+    rect->x = allocated.x + c_padding;
+    rect->y = allocated.y + c_padding;
+    rect->width = allocated.width - 2 * c_padding;
+    rect->height = allocated.height - 2 * c_padding;
+    rect->u = static_cast<float>(rect->x) / Size;
+    rect->v = static_cast<float>(rect->y) / Size;
+    rect->uWidth = static_cast<float>(rect->width) / Size;
+    rect->vHeight = static_cast<float>(rect->height) / Size;
+
+    return true;
+}
+
+_Use_decl_annotations_
+bool VideoAtlas::TakeMoved(
+    uint32_t id)
+{
+    std::lock_guard<slim_mutex> guard(m_mutex);
+
+    return m_moved.erase(id) != 0;
+}
+
+_Use_decl_annotations_
+void VideoAtlas::Copy(
+    ID3D11DeviceContext* context,
+    uint32_t id,
+    ID3D11Texture2D* source)
+{
+    std::shared_lock<slim_mutex> slock(m_mutex);
+
+    RectPacker::Rect allocated{};
+    if (!m_packer.Get(id, &allocated))
+    {
+        return;
+    }
+
+    context->CopySubresourceRegion(m_texture.get(), 0, allocated.x + c_padding, allocated.y + c_padding, 0, source, 0, nullptr);
+}
@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "RectPacker.h"
+
+#include <d3d11_1.h>
+#include <set>
+
+// one large texture on unity's device that players in atlas mode copy their frames
+// into, so unity can batch every tile into a single material. shared dll wide like
+// MediaDevice, the last player to release it frees the texture
+//
+// when an allocation does not fit the atlas is defragmented, players whose rect moved
+// find out on their next render event and repaint at the new position
+struct VideoAtlas
+{
+    static constexpr uint32_t Size = 4096;
+
+    static HRESULT Acquire(
+        _In_ ID3D11Device* unityDevice,
+        _Out_ std::shared_ptr<VideoAtlas>& atlas);
+
+    // how many frames of one size fit into an empty atlas after one of another size, up
+    // to limit, allocated in that order. other players' rects are not counted
+    static uint32_t Capacity(
+        _In_ uint32_t width,
+        _In_ uint32_t height,
+        _In_ uint32_t otherWidth,
+        _In_ uint32_t otherHeight,
+        _In_ uint32_t limit);
+
+    ID3D11ShaderResourceView* ShaderResourceView() const { return m_textureSRV.get(); }
+
+    HRESULT Allocate(_In_ uint32_t width, _In_ uint32_t height, _Out_ uint32_t* id);
+
+    void Free(_In_ uint32_t id);
+
+    bool GetRect(_In_ uint32_t id, _Out_ ATLAS_RECT* rect);
+
+    // true once after a defragment moved the rect
+    bool TakeMoved(_In_ uint32_t id);
+
+    // render thread, the source has to be the size that was allocated
+    void Copy(_In_ ID3D11DeviceContext* context, _In_ uint32_t id, _In_ ID3D11Texture2D* source);
+
+private:
+    VideoAtlas();
+
+private:
+    ID3D11Device* m_unityDevice;  // identity only, the texture holds the reference
+    winrt::com_ptr<ID3D11Texture2D> m_texture;
+    winrt::com_ptr<ID3D11ShaderResourceView> m_textureSRV;
+
+    winrt::slim_mutex m_mutex;
+    RectPacker m_packer;
+    std::set<uint32_t> m_moved;
+};
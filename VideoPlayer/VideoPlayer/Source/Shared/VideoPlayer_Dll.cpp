@@ -6,8 +6,11 @@
 #include "Unity/IUnityGraphics.h"
 #include "PlatformBase.h"
 #include "UnityDeviceResource.h"
+#include "InstanceTable.h"
 
 #include "Plugin.PlaybackManager.h"
+#include "Plugin.ThumbnailExtractor.h"
+#include "Plugin.TiledPlayer.h"
 
 namespace impl
 {
@@ -19,26 +22,11 @@ namespace winrt
     using namespace winrt::VideoPlayer::Plugin;
 }
 
-static INSTANCE_HANDLE s_lastPluginHandleIndex = INSTANCE_HANDLE_INVALID;
-static std::unordered_map<INSTANCE_HANDLE, winrt::IModule> s_instances;
+// looked up from the render thread as well, see InstanceTable
+static InstanceTable<winrt::IModule> s_instances;
 HRESULT GetModule(INSTANCE_HANDLE id, _Out_ winrt::IModule& module)
 {
-    if (id < INSTANCE_HANDLE_START)
-    {
-        IFR(E_INVALIDARG);
-    }
-
-    auto it = s_instances.find(id);
-    if (it == s_instances.end())
-    {
-        IFR(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
-    }
-
-    module = it->second;
-
-    NULL_CHK_HR(module, E_POINTER);
-
-    return S_OK;
+    return s_instances.Get(id, module);
 }
 
 static std::shared_ptr<IUnityDeviceResource> s_deviceResource;
@@ -48,18 +36,7 @@ static IUnityGraphics* s_unityGraphics = nullptr;
 
 HRESULT TrackModule(winrt::IModule &module, INSTANCE_HANDLE * handleId)
 {
-    // get the last index value;
-    auto handle = s_lastPluginHandleIndex;
-
-    // add to map
-    auto success = s_instances.emplace(handle, module);
-    if (success.second)
-    {
-        *handleId = handle++;
-        s_lastPluginHandleIndex = handle;
-    }
-
-    return (success.second ? S_OK : E_UNEXPECTED);
+    return s_instances.Add(module, handleId);
 }
 
 // --------------------------------------------------------------------------
@@ -68,9 +45,6 @@ static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType ev
 
 extern "C" void	UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
 {
-    s_lastPluginHandleIndex = INSTANCE_HANDLE_START;
-    s_instances.clear();
-
     s_unityInterfaces = unityInterfaces;
     s_unityGraphics = s_unityInterfaces->Get<IUnityGraphics>();
     s_unityGraphics->RegisterDeviceEventCallback(OnGraphicsDeviceEvent);
@@ -81,14 +55,11 @@ extern "C" void	UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnit
 
 extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginUnload()
 {
-    for (auto&& kv : s_instances)
+    for (auto&& module : s_instances.Clear())
     {
-        kv.second.Shutdown();
-        kv.second = nullptr;
+        module.Shutdown();
+        module = nullptr;
     }
-    s_instances.clear();
-
-    s_lastPluginHandleIndex = INSTANCE_HANDLE_INVALID;
 
     s_unityGraphics->UnregisterDeviceEventCallback(OnGraphicsDeviceEvent);
 }
@@ -157,9 +128,8 @@ extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ReleaseInstance(
     _In_ INSTANCE_HANDLE id)
 {
     winrt::IModule module = nullptr;
-    if (SUCCEEDED(GetModule(id, module)))
+    if (SUCCEEDED(s_instances.Remove(id, module)))
     {
-        s_instances.erase(id);
         module.Shutdown();
         module = nullptr;
     }
@@ -269,3 +239,602 @@ extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerStop(
 
     return hr;
 }
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetFrameBufferCount(
+    _In_ INSTANCE_HANDLE id,
+    _In_ uint32_t count)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetFrameBufferCount(count);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetPacing(
+    _In_ INSTANCE_HANDLE id,
+    _In_ PacingMode mode,
+    _In_ uint32_t latencyFrames)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetPacing(mode, latencyFrames);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerEnqueue(
+    _In_ INSTANCE_HANDLE id,
+    _In_ LPCWSTR contentLocation)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->Enqueue(contentLocation);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetPreloadCount(
+    _In_ INSTANCE_HANDLE id,
+    _In_ uint32_t count)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetPreloadCount(count);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerGetResourceStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ RESOURCE_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->GetResourceStats(stats);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerCreateAtlasTexture(
+    _In_ INSTANCE_HANDLE id,
+    _In_ int32_t width,
+    _In_ int32_t height,
+    _In_ void** atlasTexture,
+    _Out_ ATLAS_RECT* rect)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->CreateAtlasTexture(static_cast<uint32_t>(width), static_cast<uint32_t>(height), atlasTexture, rect);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerGetAtlasRect(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ ATLAS_RECT* rect)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->GetAtlasRect(rect);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSeek(
+    _In_ INSTANCE_HANDLE id,
+    _In_ int64_t position,
+    _In_ SeekMode mode)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->Seek(position, mode);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerStep(
+    _In_ INSTANCE_HANDLE id,
+    _In_ int32_t frames)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->Step(frames);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetRate(
+    _In_ INSTANCE_HANDLE id,
+    _In_ double rate)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetRate(rate);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetFrameCacheBudget(
+    _In_ INSTANCE_HANDLE id,
+    _In_ uint64_t bytes)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetFrameCacheBudget(bytes);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerGetFrameCacheStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ FRAME_CACHE_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->GetFrameCacheStats(stats);
+    }
+
+    return hr;
+}
+
+
+// the current item's stats when it is a .y4m file, E_NOT_VALID_STATE otherwise
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerGetRawSourceStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ RAW_SOURCE_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->GetRawSourceStats(stats);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerGetStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ PLAYBACK_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->GetStats(stats);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetAdaptiveResolution(
+    _In_ INSTANCE_HANDLE id,
+    _In_ uint32_t levels,
+    _In_ float minScale)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetAdaptiveResolution(levels, minScale);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerSetAudioTap(
+    _In_ INSTANCE_HANDLE id,
+    _In_ uint32_t sampleRate,
+    _In_ uint32_t channels,
+    _In_ uint32_t bufferMs)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->SetAudioTap(sampleRate, channels, bufferMs);
+    }
+
+    return hr;
+}
+
+// called from unity's audio thread, buffer holds frames * channels interleaved floats
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerReadAudio(
+    _In_ INSTANCE_HANDLE id,
+    _Out_writes_(frames * channels) float* buffer,
+    _In_ uint32_t frames,
+    _In_ uint32_t channels,
+    _Out_ int64_t* timestamp,
+    _Out_ uint32_t* framesRead)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->ReadAudio(buffer, frames, channels, timestamp, framesRead);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API MediaPlayerGetAudioTapStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ AUDIO_TAP_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto mediaPlayer = module.as<IPlaybackManagerPriv>();
+
+        NULL_CHK_HR(mediaPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = mediaPlayer->GetAudioTapStats(stats);
+    }
+
+    return hr;
+}
+
+// Thumbnails
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateThumbnailExtractor(
+    _In_ StateChangedCallback fnCallback,
+    _In_ void* managedObject,
+    _In_ uint32_t workerCount,
+    _Out_ INSTANCE_HANDLE* handleId)
+{
+    if (managedObject == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    winrt::IModule module = impl::ThumbnailExtractor::Create(s_deviceResource, fnCallback, managedObject, workerCount);
+    NULL_CHK_HR(module, E_FAIL);
+
+    return TrackModule(module, handleId);
+}
+
+// unity's Texture2DArray, bgra32
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ThumbnailSetTextureArray(
+    _In_ INSTANCE_HANDLE id,
+    _In_ void* texture)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto extractor = module.as<IThumbnailExtractorPriv>();
+
+        NULL_CHK_HR(extractor, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = extractor->SetTextureArray(texture);
+    }
+
+    return hr;
+}
+
+// buffer has to stay valid until the batch's last thumbnail is reported or the instance is released,
+// MF_E_NOTACCEPTING while too many thumbnails are pending, queue again once some are reported
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ThumbnailQueue(
+    _In_ INSTANCE_HANDLE id,
+    _In_ LPCWSTR contentLocation,
+    _In_reads_(count) int64_t const* timestamps,
+    _In_ uint32_t count,
+    _In_ uint32_t width,
+    _In_ uint32_t height,
+    _In_ uint8_t* buffer,
+    _In_ uint32_t bufferSize,
+    _Out_ uint32_t* batchId)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto extractor = module.as<IThumbnailExtractorPriv>();
+
+        NULL_CHK_HR(extractor, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = extractor->Queue(contentLocation, timestamps, count, width, height, buffer, bufferSize, batchId);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ThumbnailQueueToTextureArray(
+    _In_ INSTANCE_HANDLE id,
+    _In_ LPCWSTR contentLocation,
+    _In_reads_(count) int64_t const* timestamps,
+    _In_ uint32_t count,
+    _In_ uint32_t firstSlice,
+    _Out_ uint32_t* batchId)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto extractor = module.as<IThumbnailExtractorPriv>();
+
+        NULL_CHK_HR(extractor, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = extractor->QueueToTextureArray(contentLocation, timestamps, count, firstSlice, batchId);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API ThumbnailGetStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ THUMBNAIL_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto extractor = module.as<IThumbnailExtractorPriv>();
+
+        NULL_CHK_HR(extractor, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = extractor->GetStats(stats);
+    }
+
+    return hr;
+}
+
+// Tiled playback
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API CreateTiledPlayer(
+    _In_ StateChangedCallback fnCallback,
+    _In_ void* managedObject,
+    _Out_ INSTANCE_HANDLE* handleId)
+{
+    if (managedObject == nullptr)
+    {
+        return E_INVALIDARG;
+    }
+
+    winrt::IModule module = impl::TiledPlayer::Create(s_deviceResource, fnCallback, managedObject);
+    NULL_CHK_HR(module, E_FAIL);
+
+    return TrackModule(module, handleId);
+}
+
+// tilePattern names a tile's stream with {column}, {row} or {index}, baseLocation is optional
+// and always plays. atlasTexture is the shared atlas every tile is copied into
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerOpen(
+    _In_ INSTANCE_HANDLE id,
+    _In_ LPCWSTR tilePattern,
+    _In_ uint32_t columns,
+    _In_ uint32_t rows,
+    _In_ LPCWSTR baseLocation,
+    _In_ uint32_t maxActiveTiles,
+    _In_ uint32_t loop,
+    _In_ void** atlasTexture)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->Open(tilePattern, columns, rows, baseLocation == nullptr ? L"" : baseLocation, maxActiveTiles, loop != 0, atlasTexture);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerPlay(
+    _In_ INSTANCE_HANDLE id)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->Play();
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerPause(
+    _In_ INSTANCE_HANDLE id)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->Pause();
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerSeek(
+    _In_ INSTANCE_HANDLE id,
+    _In_ int64_t position)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->Seek(position);
+    }
+
+    return hr;
+}
+
+// degrees, yaw to the right of the frame's center and pitch up, fov are full angles
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerSetView(
+    _In_ INSTANCE_HANDLE id,
+    _In_ float yaw,
+    _In_ float pitch,
+    _In_ float fovH,
+    _In_ float fovV)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->SetView(yaw, pitch, fovH, fovV);
+    }
+
+    return hr;
+}
+
+// a rect per tile, row by row, then the base. a zero size rect is a tile without a frame
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerGetTileMap(
+    _In_ INSTANCE_HANDLE id,
+    _Out_writes_(count) ATLAS_RECT* rects,
+    _In_ uint32_t count,
+    _Out_ uint32_t* version)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->GetTileMap(rects, count, version);
+    }
+
+    return hr;
+}
+
+extern "C" int32_t UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API TiledPlayerGetStats(
+    _In_ INSTANCE_HANDLE id,
+    _Out_ TILED_STATS* stats)
+{
+    winrt::IModule module = nullptr;
+    HRESULT hr = GetModule(id, module);
+    if (SUCCEEDED(hr))
+    {
+        auto tiledPlayer = module.as<ITiledPlayerPriv>();
+
+        NULL_CHK_HR(tiledPlayer, HRESULT_FROM_WIN32(ERROR_INVALID_INDEX));
+
+        hr = tiledPlayer->GetStats(stats);
+    }
+
+    return hr;
+}
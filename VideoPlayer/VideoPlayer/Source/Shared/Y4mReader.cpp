@@ -0,0 +1,256 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Y4mReader.h"
+
+#include <mferror.h>
+
+#include <algorithm>
+#include <string>
+
+using namespace winrt;
+
+static constexpr char c_streamMagic[] = "YUV4MPEG2 ";
+static constexpr char c_frameMagic[] = "FRAME";
+
+// header and frame lines are short, anything longer is not a y4m file
+static constexpr uint64_t c_maxLineLength = 4096;
+
+_Use_decl_annotations_
+HRESULT Y4mReader::Open(
+    hstring const& path,
+    std::shared_ptr<RawFrameReader>& reader)
+{
+    reader = nullptr;
+
+    auto y4m = std::make_shared<Y4mReader>();
+
+    IFR(y4m->Map(path));
+    IFR(Parse(y4m->m_view, y4m->m_size, y4m->m_format, y4m->m_frames));
+
+    reader = y4m;
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT Y4mReader::Open(
+    std::shared_ptr<std::vector<uint8_t> const> const& buffer,
+    std::shared_ptr<RawFrameReader>& reader)
+{
+    reader = nullptr;
+
+    NULL_CHK_HR(buffer, E_INVALIDARG);
+
+    auto y4m = std::make_shared<Y4mReader>();
+
+    y4m->m_buffer = buffer;
+    y4m->m_view = buffer->data();
+    y4m->m_size = buffer->size();
+    IFR(Parse(y4m->m_view, y4m->m_size, y4m->m_format, y4m->m_frames));
+
+    reader = y4m;
+
+    return S_OK;
+}
+
+Y4mReader::Y4mReader()
+    : m_view(nullptr)
+    , m_size(0)
+    , m_format{}
+{
+}
+
+Y4mReader::~Y4mReader()
+{
+    if (m_view != nullptr && m_buffer == nullptr)
+    {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT Y4mReader::Frame(
+    uint32_t index,
+    FrameData& frame)
+{
+    frame = FrameData{};
+
+    if (index >= m_frames.size())
+    {
+        IFR(E_BOUNDS);
+    }
+
+    frame.data = m_view + m_frames[index];
+    frame.owner = shared_from_this();
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT Y4mReader::Map(
+    hstring const& path)
+{
+    m_file.attach(CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr));
+    if (!m_file)
+    {
+        IFR(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(m_file.get(), &size))
+    {
+        IFR(HRESULT_FROM_WIN32(GetLastError()));
+    }
+
+    if (size.QuadPart == 0)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    if (static_cast<uint64_t>(size.QuadPart) > SIZE_MAX)
+    {
+        IFR(HRESULT_FROM_WIN32(ERROR_FILE_TOO_LARGE));
+    }
+
+    // the FromApp variants work from both the desktop and the uwp build
+    m_mapping.attach(CreateFileMappingFromApp(m_file.get(), nullptr, PAGE_READONLY, 0, nullptr));
+    NULL_CHK_HR(m_mapping.get(), HRESULT_FROM_WIN32(GetLastError()));
+
+    m_view = static_cast<uint8_t const*>(MapViewOfFileFromApp(m_mapping.get(), FILE_MAP_READ, 0, 0));
+    NULL_CHK_HR(m_view, HRESULT_FROM_WIN32(GetLastError()));
+
+    m_size = static_cast<uint64_t>(size.QuadPart);
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT Y4mReader::Parse(
+    uint8_t const* data,
+    uint64_t size,
+    Format& format,
+    std::vector<uint64_t>& frames)
+{
+    format = Format{};
+    frames.clear();
+
+    auto lineEnd = [data, size](uint64_t start) -> uint64_t
+    {
+        uint64_t limit = std::min(size, start + c_maxLineLength);
+        for (uint64_t i = start; i < limit; ++i)
+        {
+            if (data[i] == '\n')
+            {
+                return i;
+            }
+        }
+
+        return UINT64_MAX;
+    };
+
+    uint64_t headerEnd = lineEnd(0);
+    if (headerEnd == UINT64_MAX
+        || headerEnd < sizeof(c_streamMagic) - 1
+        || memcmp(data, c_streamMagic, sizeof(c_streamMagic) - 1) != 0)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    // space separated parameters, each a tag letter and its value
+    std::string header(reinterpret_cast<char const*>(data) + sizeof(c_streamMagic) - 1, reinterpret_cast<char const*>(data) + headerEnd);
+    std::string colorspace = "420jpeg";
+
+    size_t position = 0;
+    while (position < header.size())
+    {
+        size_t next = header.find(' ', position);
+        if (next == std::string::npos)
+        {
+            next = header.size();
+        }
+
+        std::string token = header.substr(position, next - position);
+        position = next + 1;
+
+        if (token.size() < 2)
+        {
+            continue;
+        }
+
+        std::string value = token.substr(1);
+        switch (token[0])
+        {
+        case 'W':
+            format.width = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 10));
+            break;
+        case 'H':
+            format.height = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 10));
+            break;
+        case 'F':
+        {
+            size_t colon = value.find(':');
+            if (colon != std::string::npos)
+            {
+                format.frameRateNumerator = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 10));
+                format.frameRateDenominator = static_cast<uint32_t>(strtoul(value.c_str() + colon + 1, nullptr, 10));
+            }
+            break;
+        }
+        case 'C':
+            colorspace = value;
+            break;
+        default:
+            // interlacing, aspect and extensions do not change the layout
+            break;
+        }
+    }
+
+    if (colorspace != "420" && colorspace != "420jpeg" && colorspace != "420paldv" && colorspace != "420mpeg2")
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    // i420 needs whole chroma samples
+    if (format.width == 0 || format.height == 0
+        || (format.width & 1) != 0 || (format.height & 1) != 0
+        || format.frameRateNumerator == 0 || format.frameRateDenominator == 0)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+
+    uint64_t frameSize = static_cast<uint64_t>(format.width) * format.height * 3 / 2;
+    if (frameSize > UINT32_MAX)
+    {
+        IFR(MF_E_INVALIDMEDIATYPE);
+    }
+    format.frameSize = static_cast<uint32_t>(frameSize);
+    format.pixelFormat = PixelFormat::I420;
+
+    // frame lines can carry their own parameters, so every marker has to be visited,
+    // a truncated last frame is dropped
+    uint64_t offset = headerEnd + 1;
+    while (offset + sizeof(c_frameMagic) - 1 <= size
+        && memcmp(data + offset, c_frameMagic, sizeof(c_frameMagic) - 1) == 0)
+    {
+        uint64_t frameLineEnd = lineEnd(offset);
+        if (frameLineEnd == UINT64_MAX || frameLineEnd + 1 + frameSize > size)
+        {
+            break;
+        }
+
+        frames.push_back(frameLineEnd + 1);
+        offset = frameLineEnd + 1 + frameSize;
+    }
+
+    if (frames.empty() || frames.size() > UINT32_MAX)
+    {
+        IFR(MF_E_INVALID_FILE_FORMAT);
+    }
+
+    format.frameCount = static_cast<uint32_t>(frames.size());
+
+    return S_OK;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include "RawVideoSource.h"
+
+#include <vector>
+
+// yuv4mpeg2, a text header followed by FRAME markers and raw planes. only 8 bit 4:2:0
+// (C420, C420jpeg, C420paldv, C420mpeg2) is taken. the whole file is mapped read only and
+// the frames are indexed once on open, a 32 bit process runs out of address space long
+// before a 4k clip of any length does
+struct Y4mReader : RawFrameReader
+{
+    static HRESULT Open(
+        _In_ winrt::hstring const& path,
+        _Out_ std::shared_ptr<RawFrameReader>& reader);
+
+    // a whole file already in memory, the frames point into buffer
+    static HRESULT Open(
+        _In_ std::shared_ptr<std::vector<uint8_t> const> const& buffer,
+        _Out_ std::shared_ptr<RawFrameReader>& reader);
+
+    // the header and the offset of every complete frame's planes, a truncated last frame
+    // is dropped
+    static HRESULT Parse(
+        _In_reads_bytes_(size) uint8_t const* data,
+        _In_ uint64_t size,
+        _Out_ Format& format,
+        _Out_ std::vector<uint64_t>& frames);
+
+    Y4mReader();
+    virtual ~Y4mReader();
+
+    virtual Format const& GetFormat() const override { return m_format; }
+
+    virtual HRESULT Frame(_In_ uint32_t index, _Out_ FrameData& frame) override;
+
+private:
+    HRESULT Map(_In_ winrt::hstring const& path);
+
+    winrt::file_handle m_file;
+    winrt::handle m_mapping;
+    std::shared_ptr<std::vector<uint8_t> const> m_buffer;
+    uint8_t const* m_view;
+    uint64_t m_size;
+
+    Format m_format;
+    std::vector<uint64_t> m_frames;     // offset of each frame's planes
+};
@@ -42,7 +42,12 @@ typedef enum class _CallbackType : int32_t
 {
     None = 0,
     Failed,
-    VideoPlayer
+    VideoPlayer,
+    Playlist,
+    AtlasRect,
+    Seek,
+    Thumbnail,
+    Resolution
 } CallbackType;
 
 typedef struct _FAILED_STATE
@@ -61,6 +66,22 @@ typedef enum class _MediaPlayerState : int32_t
     Ended,
 } MediaPlayerState;
 
+// how OnRenderEvent picks from the decoded frames that are queued. a frame's timestamp is
+// the playback position when the frame server handed it out, it has no access to the
+// sample times, so this smooths delivery against the display rather than matching pts
+typedef enum class _PacingMode : int32_t
+{
+    Latest = 0,     // newest decoded frame, no pacing
+    Nearest,        // timestamp closest to when the frame reaches the display
+    Floor,          // newest timestamp not after that, never shows a frame early
+} PacingMode;
+
+typedef enum class _SeekMode : int32_t
+{
+    Exact = 0,      // decodes forward from the previous keyframe to the requested frame
+    Keyframe,       // lands on the closest keyframe, exact until the source is indexed
+} SeekMode;
+
 typedef struct _PLAYBACK_STATE
 {
     MediaPlayerState state;
@@ -70,6 +91,166 @@ typedef struct _PLAYBACK_STATE
     int64_t duration;
 } PLAYBACK_STATE;
 
+// raised when the first frame of the next playlist item is decoded
+typedef struct _PLAYLIST_STATE
+{
+    uint32_t itemIndex;
+    uint32_t itemCount;
+    float transitionGapMs;  // last frame of the previous item to the first of this one, -1 when started directly
+} PLAYLIST_STATE;
+
+// raised when a MediaPlayerSeek, or a MediaPlayerStep of more than one frame, completes
+typedef struct _SEEK_STATE
+{
+    int64_t requested;  // 100ns
+    int64_t position;   // where the seek was sent, the keyframe for Keyframe seeks
+    float latencyMs;    // call to SeekCompleted, or to the cached frame being queued
+    SeekMode mode;
+    uint32_t cached;    // served from the frame cache, the decoder catches up on play
+} SEEK_STATE;
+
+typedef struct _FRAME_CACHE_STATS
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t bytes;
+    uint64_t budget;
+    uint32_t frames;
+} FRAME_CACHE_STATS;
+
+// where a player in atlas mode draws, raised again when defragmenting moves it
+typedef struct _ATLAS_RECT
+{
+    uint32_t x;         // texels, without the padding
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    float u;            // the same normalized to the atlas
+    float v;
+    float uWidth;
+    float vHeight;
+} ATLAS_RECT;
+
+// raised on the render thread when adaptive resolution changes the size of the frame shown,
+// the picture fills the top left width x height of the playback texture
+typedef struct _RESOLUTION_STATE
+{
+    uint32_t level;     // 0 is full size
+    uint32_t width;
+    uint32_t height;
+    float uWidth;       // the same normalized to the texture
+    float vHeight;
+} RESOLUTION_STATE;
+
+// raised once per thumbnail, for a texture array after the slice has been updated on the render thread
+typedef struct _THUMBNAIL_STATE
+{
+    uint32_t batchId;
+    uint32_t index;         // into the batch's timestamps, and its buffer or slice
+    int32_t hresult;
+    uint32_t remaining;     // still to come from this batch
+    int64_t requested;      // 100ns
+    int64_t timestamp;      // the keyframe that was decoded
+} THUMBNAIL_STATE;
+
+typedef struct _THUMBNAIL_STATS
+{
+    uint32_t workerCount;
+    uint32_t pending;               // queued, decoding or waiting for the render thread
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t decoded;               // keyframes, timestamps sharing one are decoded once
+    float thumbnailsPerSecond;      // over the time there was work queued
+    float decodeMs;                 // average seek and decode of one keyframe
+    float resampleMs;               // average scale of one thumbnail
+} THUMBNAIL_STATS;
+
+#define PLAYBACK_STATS_COPY_BUCKETS 8
+
+// frame server counters of one player since the last LoadContent
+typedef struct _PLAYBACK_STATS
+{
+    uint64_t framesAvailable;   // VideoFrameAvailable raised
+    uint64_t framesCopied;      // CopyFrameToVideoSurface succeeded
+    uint64_t framesFailed;      // CopyFrameToVideoSurface threw
+    uint64_t framesStalled;     // no buffer free to copy into, the frame was skipped
+    uint64_t framesDropped;     // copied, but replaced before unity showed them
+    uint64_t framesPresented;
+    uint64_t framesRepeated;    // render events that kept the frame on screen
+    float effectiveFps;         // copied over the last full second
+    float copyMsAverage;
+    float copyMsMax;
+    uint32_t copyHistogram[PLAYBACK_STATS_COPY_BUCKETS];   // < 0.25, 0.5, 1, 2, 4, 8, 16ms and the rest
+} PLAYBACK_STATS;
+
+// the decoded audio of one player since its tap was set up
+typedef struct _AUDIO_TAP_STATS
+{
+    uint32_t sampleRate;        // what MediaPlayerReadAudio delivers
+    uint32_t channels;
+    uint32_t sourceSampleRate;  // the current item, 0 while it has no audio the tap can decode
+    uint32_t sourceChannels;
+    uint64_t framesDecoded;     // converted and queued
+    uint64_t framesRead;
+    uint64_t framesSkipped;     // queued too late for the video and dropped
+    uint64_t framesSilence;     // asked for while playing with nothing queued in time
+    uint32_t resyncs;           // the decoder sought to follow a seek, loop or stall
+    uint32_t bufferedFrames;
+} AUDIO_TAP_STATS;
+
+// a tiled player's decoders and how well they kept up with the view, counted since TiledPlayerOpen
+typedef struct _TILED_STATS
+{
+    uint32_t columns;
+    uint32_t rows;
+    uint32_t maxActiveTiles;    // capped to what fits the atlas once a tile has opened
+    uint32_t visibleTiles;      // in the view at the last update, without the margin
+    uint32_t activeTiles;       // decoding
+    uint32_t readyTiles;        // decoding with a frame in the atlas
+    uint64_t updates;           // TiledPlayerSetView calls
+    uint64_t tilesStarted;
+    uint64_t tilesStopped;
+    uint64_t prefetched;        // started before they were visible
+    uint64_t prefetchHits;      // of those, ready by the time they were
+    uint64_t prefetchWasted;    // of those, stopped without ever being visible
+    uint64_t missedTiles;       // visible without a frame, summed over updates, the base showed instead
+    float visibleReadyRatio;    // visible tiles that were ready, over every update
+    float predictedYaw;         // where the last prefetch looked, degrees
+    float predictedPitch;
+    uint64_t framesCopied;      // tile frames copied out by the frame server
+    uint64_t framesFailed;
+    uint32_t tilesFailed;       // would not open, or found no room in the atlas
+} TILED_STATS;
+
+// a .y4m item, how fast the player drains it and how long a frame takes to reach unity
+typedef struct _RAW_SOURCE_STATS
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameCount;
+    uint64_t framesDelivered;   // handed to the player
+    uint64_t framesShown;       // copied out by the frame server
+    float framesPerSecond;      // delivered, first sample to the latest
+    float requestUs;            // answering a sample request, average
+    float maxRequestUs;
+    float latencyMs;            // handed out to copied by the frame server, average
+    float maxLatencyMs;
+} RAW_SOURCE_STATS;
+
+// texture memory is counted as width * height * 4 per buffer
+typedef struct _RESOURCE_STATS
+{
+    uint32_t playerCount;       // players sharing the decode device
+    uint32_t frameBufferCount;  // this player
+    uint64_t frameBufferBytes;  // this player, ring and display texture
+    uint32_t buffersInUse;      // every player
+    uint32_t buffersPooled;     // released, kept for reuse
+    uint64_t bytesInUse;
+    uint64_t bytesPooled;
+    float createTextureMs;      // last MediaPlayerCreateTexture of this player
+} RESOURCE_STATS;
+
 #pragma pack(push, 4)
 typedef struct _CALLBACK_STATE
 {
@@ -78,6 +259,11 @@ typedef struct _CALLBACK_STATE
     {
         FAILED_STATE failedState;
         PLAYBACK_STATE playbackState;
+        PLAYLIST_STATE playlistState;
+        ATLAS_RECT atlasRect;
+        SEEK_STATE seekState;
+        THUMBNAIL_STATE thumbnailState;
+        RESOLUTION_STATE resolutionState;
     } value;
 } CALLBACK_STATE;
 #pragma pack(pop)
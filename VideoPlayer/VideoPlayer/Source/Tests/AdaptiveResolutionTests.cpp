@@ -0,0 +1,285 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "AdaptiveResolution.h"
+
+// small numbers so a trace reads like the rules, a window is 4 frames 3 ticks apart
+// unless a trace asks for more
+static AdaptiveResolution::Settings TestSettings()
+{
+    AdaptiveResolution::Settings settings{};
+    settings.window = 10;
+    settings.minWindowFrames = 4;
+    settings.copyHigh = 100;
+    settings.copyLow = 40;
+    settings.lostHigh = 0.2f;
+    settings.lostLow = 0.02f;
+    settings.calmWindows = 3;
+    settings.maxCalmWindows = 12;
+
+    return settings;
+}
+
+// feeds whole windows, the level may only change on the frame that closes one
+struct Trace
+{
+    explicit Trace(std::vector<float> const& scales, uint64_t initialLost = 0)
+        : time(1000)
+        , lost(initialLost)
+        , changedMidWindow(false)
+    {
+        resolution.Reset(scales, TestSettings());
+
+        // the first frame only opens the window
+        resolution.OnFrame(time, 0, lost);
+    }
+
+    // lostFrames are added to the running total on the first frame, the first failures
+    // frames fail their copy. the frames are spaced so the last one closes the window,
+    // true when it ended with a new level
+    bool Window(int64_t copyTime, uint32_t lostFrames = 0, uint32_t failures = 0, uint32_t frames = 4)
+    {
+        int64_t step = (TestSettings().window + frames - 1) / frames;
+
+        lost += lostFrames;
+
+        bool changed = false;
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            time += step;
+            changed = resolution.OnFrame(time, i < failures ? -1 : copyTime, lost);
+            changedMidWindow = changedMidWindow || (changed && i + 1 < frames);
+        }
+
+        return changed;
+    }
+
+    // count calm windows, false if any of them changed the level
+    bool Calm(uint32_t count, int64_t copyTime)
+    {
+        bool changed = false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            changed = Window(copyTime) || changed;
+        }
+
+        return !changed;
+    }
+
+    AdaptiveResolution resolution;
+    int64_t time;
+    uint64_t lost;
+    bool changedMidWindow;
+};
+
+TEST(AdaptiveResolutionStepsDownUnderCopyPressure)
+{
+    Trace trace({ 1.0f, 0.5f, 0.25f });
+    CHECK(trace.resolution.LevelCount() == 3);
+
+    // copyHigh itself is not pressure
+    CHECK(!trace.Window(100));
+    CHECK(trace.resolution.Level() == 0);
+
+    // one slow window is enough, every time
+    CHECK(trace.Window(101));
+    CHECK(trace.resolution.Level() == 1);
+    CHECK(trace.Window(500));
+    CHECK(trace.resolution.Level() == 2);
+
+    // nothing smaller to go to
+    CHECK(!trace.Window(500));
+    CHECK(trace.resolution.Level() == 2);
+
+    CHECK(!trace.changedMidWindow);
+}
+
+TEST(AdaptiveResolutionStepsDownUnderLostFrames)
+{
+    Trace trace({ 1.0f, 0.5f, 0.25f });
+
+    // one stall in four frames, the copies themselves are fast
+    CHECK(trace.Window(10, 1));
+    CHECK(trace.resolution.Level() == 1);
+
+    // a failed copy counts as lost and is left out of the copy average
+    CHECK(trace.Window(10, 0, 1));
+    CHECK(trace.resolution.Level() == 2);
+
+    // one in ten is under lostHigh
+    Trace light({ 1.0f, 0.5f });
+    CHECK(!light.Window(10, 1, 0, 10));
+    CHECK(light.resolution.Level() == 0);
+
+    CHECK(!trace.changedMidWindow);
+}
+
+TEST(AdaptiveResolutionStepsUpAfterCalmWindows)
+{
+    Trace trace({ 1.0f, 0.8f, 0.4f });
+
+    CHECK(trace.Window(200));
+    CHECK(trace.Window(200));
+    CHECK(trace.resolution.Level() == 2);
+
+    // at half the size the copy is four times cheaper above, 10 costs 40 there, just calm
+    CHECK(trace.Calm(2, 10));
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 1);
+
+    // 0.8 to 1.0 is 1.5625 times the pixels, 30 is under copyLow here but not above, and
+    // it starts the count again
+    CHECK(trace.Calm(2, 25));
+    CHECK(!trace.Window(30));
+    CHECK(trace.Calm(2, 25));
+    CHECK(trace.resolution.Level() == 1);
+    CHECK(trace.Window(25));
+    CHECK(trace.resolution.Level() == 0);
+
+    CHECK(!trace.changedMidWindow);
+
+    // a lost rate over lostLow is not calm either, even with cheap copies
+    Trace lossy({ 1.0f, 0.5f });
+    CHECK(lossy.Window(200));
+    CHECK(lossy.Calm(2, 10));
+    CHECK(!lossy.Window(10, 1, 0, 10));
+    CHECK(lossy.Calm(2, 10));
+    CHECK(lossy.resolution.Level() == 1);
+    CHECK(lossy.Window(10));
+    CHECK(lossy.resolution.Level() == 0);
+}
+
+TEST(AdaptiveResolutionBacksOffFailedStepUps)
+{
+    Trace trace({ 1.0f, 0.5f });
+
+    CHECK(trace.Window(200));
+    CHECK(trace.Calm(2, 10));
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 0);
+
+    // undone in the next window, the next step up needs twice the calm windows
+    CHECK(trace.Window(200));
+    CHECK(trace.Calm(5, 10));
+    CHECK(trace.resolution.Level() == 1);
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 0);
+
+    // undone again within c_failedStepUpWindows (2), twice again, up to maxCalmWindows
+    CHECK(!trace.Window(10));
+    CHECK(trace.Window(200));
+    CHECK(trace.Calm(11, 10));
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 0);
+
+    // the cap holds
+    CHECK(trace.Window(200));
+    CHECK(trace.Calm(11, 10));
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 0);
+
+    // a step down later than that leaves the count needed where it was
+    CHECK(trace.Calm(2, 10));
+    CHECK(trace.Window(200));
+    CHECK(trace.Calm(11, 10));
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 0);
+
+    // held for maxCalmWindows windows the back off is forgiven
+    CHECK(trace.Calm(12, 10));
+    CHECK(trace.Window(200));
+    CHECK(trace.Calm(2, 10));
+    CHECK(trace.Window(10));
+    CHECK(trace.resolution.Level() == 0);
+
+    CHECK(!trace.changedMidWindow);
+}
+
+TEST(AdaptiveResolutionRestartsTheWindowWhenLostGoesBack)
+{
+    Trace trace({ 1.0f, 0.5f }, 100);
+
+    CHECK(trace.Calm(2, 10));
+
+    // the ring was reset mid window, its running count starts over below where the window
+    // started. that frame opens a new window instead of reading as billions of lost frames
+    trace.time += 3;
+    CHECK(!trace.resolution.OnFrame(trace.time, 10, trace.lost));
+    trace.time += 3;
+    trace.lost = 0;
+    CHECK(!trace.resolution.OnFrame(trace.time, 10, trace.lost));
+
+    // the new window counts from there, it closes on its own fourth frame and is calm
+    for (int i = 0; i < 4; ++i)
+    {
+        trace.time += 5;
+        CHECK(!trace.resolution.OnFrame(trace.time, 10, trace.lost));
+    }
+    CHECK(trace.resolution.Level() == 0);
+
+    // and stalls after the reset count as usual
+    CHECK(trace.Window(10, 1));
+    CHECK(trace.resolution.Level() == 1);
+}
+
+TEST(AdaptiveResolutionIgnoresReplacedFrames)
+{
+    AdaptiveResolution resolution;
+    resolution.Reset({ 1.0f, 0.5f }, TestSettings());
+
+    // a 60fps video on a 30Hz display, unity shows every other frame and the one before it
+    // is replaced in the ring. copies are fast
+    FrameRing ring;
+    ring.Reset(3);
+
+    int64_t time = 1000;
+    for (uint32_t frame = 0; frame < 64; ++frame)
+    {
+        int32_t slot = ring.BeginWrite();
+        CHECK(slot != -1);
+        ring.EndWrite(slot, true, frame * 166666);
+
+        if ((frame & 1) != 0)
+        {
+            ring.Present(PacingMode::Latest, 0);
+        }
+
+        time += 3;
+        CHECK(!resolution.OnFrame(time, 10, AdaptiveResolution::LostFrames(ring.GetStats())));
+    }
+
+    auto stats = ring.GetStats();
+    CHECK(stats.dropped >= 30);
+    CHECK(stats.stalled == 0);
+    CHECK(resolution.Level() == 0);
+
+    // the producer finding no slot is pressure. unity holds one slot and the frame being
+    // written the other, the playback manager returns before OnFrame for the stall and the
+    // next frame carries it in the running count
+    AdaptiveResolution stalled;
+    stalled.Reset({ 1.0f, 0.5f }, TestSettings());
+
+    FrameRing busyRing;
+    busyRing.Reset(2);
+    busyRing.EndWrite(busyRing.BeginWrite(), true, 0);
+    busyRing.Present(PacingMode::Latest, 0);
+
+    bool changed = false;
+    for (uint32_t frame = 1; frame <= 8 && !changed; ++frame)
+    {
+        int32_t slot = busyRing.BeginWrite();
+        CHECK(slot != -1);
+        CHECK(busyRing.BeginWrite() == -1);
+        busyRing.EndWrite(slot, true, frame * 166666);
+        busyRing.Present(PacingMode::Latest, 0);
+
+        time += 3;
+        changed = stalled.OnFrame(time, 10, AdaptiveResolution::LostFrames(busyRing.GetStats()));
+    }
+
+    CHECK(changed);
+    CHECK(stalled.Level() == 1);
+    CHECK(busyRing.GetStats().dropped == 0);
+}
@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "AudioConverter.h"
+
+#include <algorithm>
+#include <cmath>
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+static bool Near(float a, float b)
+{
+    return std::fabs(a - b) <= 1e-5f * std::max(1.0f, std::fabs(b));
+}
+
+// a single frame through a converter with the same rate in and out
+static std::vector<float> MixFrame(uint32_t inputChannels, uint32_t outputChannels, std::vector<float> const& frame)
+{
+    AudioConverter converter;
+    converter.Reset(48000, inputChannels, 48000, outputChannels);
+
+    std::vector<float> output;
+    converter.Convert(frame.data(), 1, output);
+
+    return output;
+}
+
+// frames of a ramp, every channel of frame i is i
+static std::vector<float> Ramp(uint32_t frames, uint32_t channels)
+{
+    std::vector<float> ramp(static_cast<size_t>(frames) * channels);
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        std::fill_n(ramp.begin() + static_cast<size_t>(i) * channels, channels, static_cast<float>(i));
+    }
+
+    return ramp;
+}
+
+TEST(AudioConverterRejectsEmptyFormats)
+{
+    AudioConverter converter;
+    CHECK(converter.Reset(0, 2, 48000, 2) == E_INVALIDARG);
+    CHECK(converter.Reset(48000, 0, 48000, 2) == E_INVALIDARG);
+    CHECK(converter.Reset(48000, 2, 0, 2) == E_INVALIDARG);
+    CHECK(converter.Reset(48000, 2, 48000, 0) == E_INVALIDARG);
+
+    // and converts nothing until it has one
+    std::vector<float> output;
+    float frame[2] = { 1.0f, 1.0f };
+    CHECK(converter.Convert(frame, 1, output) == 0);
+    CHECK(output.empty());
+}
+
+TEST(AudioConverterPassesMatchingFormatsThrough)
+{
+    AudioConverter converter;
+    CHECK(SUCCEEDED(converter.Reset(44100, 2, 44100, 2)));
+
+    std::vector<float> input = { 0.5f, -0.5f, 1.0f, -1.0f, 0.25f, 0.0f };
+    std::vector<float> output = { 9.0f, 9.0f };
+    CHECK(converter.Convert(input.data(), 3, output) == 3);
+
+    // appended, bit for bit
+    CHECK(output.size() == 8);
+    CHECK(std::equal(input.begin(), input.end(), output.begin() + 2));
+}
+
+TEST(AudioConverterMixesChannels)
+{
+    // mono goes to every channel
+    auto output = MixFrame(1, 2, { 0.5f });
+    CHECK(output.size() == 2 && output[0] == 0.5f && output[1] == 0.5f);
+    output = MixFrame(1, 6, { -0.25f });
+    CHECK(output.size() == 6 && std::all_of(output.begin(), output.end(), [](float value) { return value == -0.25f; }));
+
+    // stereo to mono averages
+    output = MixFrame(2, 1, { 1.0f, 0.5f });
+    CHECK(output.size() == 1 && Near(output[0], 0.75f));
+
+    // 5.1 folds down with the center and surrounds at -3dB and no LFE, the row normalized
+    float const fold = 0.70710678f;
+    float const row = 1.0f + 2 * fold;
+    output = MixFrame(6, 2, { 0.1f, 0.2f, 0.3f, 1.0f, 0.4f, 0.5f });
+    CHECK(output.size() == 2);
+    CHECK(Near(output[0], (0.1f + fold * 0.3f + fold * 0.4f) / row));
+    CHECK(Near(output[1], (0.2f + fold * 0.3f + fold * 0.5f) / row));
+
+    // 7.1 adds the side pair to the fold down
+    float const sideRow = 1.0f + 3 * fold;
+    output = MixFrame(8, 2, { 0.1f, 0.2f, 0.3f, 1.0f, 0.4f, 0.5f, 0.6f, 0.7f });
+    CHECK(output.size() == 2);
+    CHECK(Near(output[0], (0.1f + fold * (0.3f + 0.4f + 0.6f)) / sideRow));
+    CHECK(Near(output[1], (0.2f + fold * (0.3f + 0.5f + 0.7f)) / sideRow));
+
+    // 5.1 to mono is both sides of the fold down
+    output = MixFrame(6, 1, { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f });
+    CHECK(output.size() == 1 && Near(output[0], 1.0f));
+
+    // other layouts split into even and odd channels
+    output = MixFrame(4, 2, { 0.2f, 0.4f, 0.6f, 0.8f });
+    CHECK(Near(output[0], 0.4f) && Near(output[1], 0.6f));
+
+    // to more channels the shared ones are kept and the rest are silent
+    output = MixFrame(2, 6, { 0.3f, -0.3f });
+    CHECK(output.size() == 6);
+    CHECK(output[0] == 0.3f && output[1] == -0.3f);
+    CHECK(std::all_of(output.begin() + 2, output.end(), [](float value) { return value == 0.0f; }));
+}
+
+TEST(AudioConverterMixesFullScaleWithoutClipping)
+{
+    for (uint32_t inputChannels : { 1u, 2u, 3u, 6u, 8u })
+    {
+        for (uint32_t outputChannels : { 1u, 2u, 6u })
+        {
+            for (float level : { 1.0f, -1.0f })
+            {
+                auto output = MixFrame(inputChannels, outputChannels, std::vector<float>(inputChannels, level));
+                CHECK(output.size() == outputChannels);
+                CHECK(std::all_of(output.begin(), output.end(), [](float value) { return std::fabs(value) <= 1.0f + 1e-6f; }));
+            }
+        }
+    }
+}
+
+TEST(AudioConverterResamplesLinearly)
+{
+    // a ramp is a straight line, linear interpolation lands on it exactly wherever it samples
+    struct Case { uint32_t inputRate, outputRate; };
+    for (auto const& c : { Case{ 44100, 48000 }, Case{ 48000, 44100 }, Case{ 22050, 48000 }, Case{ 96000, 48000 } })
+    {
+        AudioConverter converter;
+        CHECK(SUCCEEDED(converter.Reset(c.inputRate, 2, c.outputRate, 2)));
+
+        // one second in blocks of uneven size, the position carries across them
+        auto input = Ramp(c.inputRate, 2);
+        std::vector<float> output;
+        uint32_t consumed = 0;
+        uint32_t produced = 0;
+        for (uint32_t block = 1; consumed < c.inputRate; block = block * 7 % 1031 + 1)
+        {
+            uint32_t frames = std::min(block, c.inputRate - consumed);
+            produced += converter.Convert(input.data() + static_cast<size_t>(consumed) * 2, frames, output);
+            consumed += frames;
+        }
+
+        // one second out, less the frames past the last input one, they wait for its right
+        // neighbour
+        CHECK(produced == output.size() / 2);
+        CHECK(produced + c.outputRate / c.inputRate + 1 >= c.outputRate && produced <= c.outputRate);
+
+        double step = static_cast<double>(c.inputRate) / c.outputRate;
+        bool onTheLine = true;
+        for (uint32_t i = 0; i < produced; ++i)
+        {
+            float expected = static_cast<float>(i * step);
+            onTheLine = onTheLine && std::fabs(output[i * 2] - expected) < 0.02f && output[i * 2] == output[i * 2 + 1];
+        }
+        CHECK(onTheLine);
+    }
+}
+
+TEST(AudioConverterJoinsBlocksAndFlushes)
+{
+    // the same input in one call or frame by frame comes out the same, mixed and resampled
+    std::vector<float> input(2000 * 6);
+    for (uint32_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = std::sin(static_cast<float>(i) * 0.01f);
+    }
+
+    AudioConverter whole;
+    CHECK(SUCCEEDED(whole.Reset(44100, 6, 48000, 2)));
+    std::vector<float> expected;
+    whole.Convert(input.data(), 2000, expected);
+
+    AudioConverter pieces;
+    CHECK(SUCCEEDED(pieces.Reset(44100, 6, 48000, 2)));
+    std::vector<float> output;
+    for (uint32_t frame = 0; frame < 2000; ++frame)
+    {
+        pieces.Convert(input.data() + frame * 6, 1, output);
+    }
+
+    CHECK(output.size() == expected.size());
+    bool same = true;
+    for (size_t i = 0; i < output.size() && i < expected.size(); ++i)
+    {
+        same = same && Near(output[i], expected[i]);
+    }
+    CHECK(same);
+
+    // after a flush the next block starts over on its own first frame, as a new converter
+    // would, without one it carries on from where the last block left off
+    std::vector<float> after;
+    pieces.Flush();
+    pieces.Convert(input.data() + 1000 * 6, 1000, after);
+
+    AudioConverter fresh;
+    CHECK(SUCCEEDED(fresh.Reset(44100, 6, 48000, 2)));
+    expected.clear();
+    fresh.Convert(input.data() + 1000 * 6, 1000, expected);
+    CHECK(after == expected);
+
+    after.clear();
+    whole.Convert(input.data() + 1000 * 6, 1000, after);
+    CHECK(after != expected);
+}
+
+BENCHMARK(AudioConverterThroughput)
+{
+    // the decode thread converts what the source reader hands it, about 10ms at a time, the
+    // budget is that 10ms for the whole pipeline
+    struct Case { char const* name; uint32_t inputRate, inputChannels, outputRate, outputChannels; };
+    Case const cases[] =
+    {
+        { "2ch 48k to 2ch 48k (copy)", 48000, 2, 48000, 2 },
+        { "1ch 48k to 2ch 48k", 48000, 1, 48000, 2 },
+        { "6ch 48k to 2ch 48k", 48000, 6, 48000, 2 },
+        { "8ch 48k to 2ch 48k", 48000, 8, 48000, 2 },
+        { "2ch 44.1k to 2ch 48k", 44100, 2, 48000, 2 },
+        { "6ch 44.1k to 2ch 48k", 44100, 6, 48000, 2 },
+        { "6ch 48k to 6ch 44.1k", 48000, 6, 44100, 6 },
+    };
+
+    constexpr uint32_t c_block = 480;
+    constexpr uint32_t c_blocks = 20000;
+    for (auto const& c : cases)
+    {
+        std::vector<float> input(static_cast<size_t>(c_block) * c.inputChannels);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            input[i] = std::sin(static_cast<float>(i) * 0.001f);
+        }
+
+        AudioConverter converter;
+        CHECK(SUCCEEDED(converter.Reset(c.inputRate, c.inputChannels, c.outputRate, c.outputChannels)));
+
+        std::vector<float> output;
+        output.reserve(static_cast<size_t>(c_block) * 2 * c.outputChannels);
+
+        uint64_t produced = 0;
+        int64_t start = Ticks();
+        for (uint32_t i = 0; i < c_blocks; ++i)
+        {
+            output.clear();
+            produced += converter.Convert(input.data(), c_block, output);
+        }
+        double ns = TicksToNs(Ticks() - start);
+
+        printf("  %-26s  %5.2f ns per input frame   %7.0f ns per 10ms block   %6.0fx real time\n",
+            c.name,
+            ns / (static_cast<double>(c_block) * c_blocks),
+            ns / c_blocks,
+            static_cast<double>(c_block) * c_blocks / c.inputRate * 1e9 / ns);
+
+        CHECK(produced > 0);
+    }
+}
@@ -0,0 +1,263 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "AudioRing.h"
+
+#include <atomic>
+#include <thread>
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+// count stereo frames numbered from first, both channels of a frame carry its number
+static std::vector<float> Numbered(uint32_t first, uint32_t count)
+{
+    std::vector<float> frames(static_cast<size_t>(count) * 2);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        frames[i * 2] = frames[i * 2 + 1] = static_cast<float>(first + i);
+    }
+
+    return frames;
+}
+
+// true if frames holds count frames numbered from first
+static bool IsNumbered(std::vector<float> const& frames, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (frames[i * 2] != static_cast<float>(first + i) || frames[i * 2 + 1] != static_cast<float>(first + i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+TEST(AudioRingWrapsAround)
+{
+    AudioRing ring;
+    ring.Reset(8, 2, 48000);
+    CHECK(ring.Space() == 8);
+    CHECK(ring.Available() == 0);
+
+    // 6 in, 4 out, then 6 more run off the end of the buffer and carry on at its start
+    CHECK(ring.Write(Numbered(0, 6).data(), 6) == 6);
+    std::vector<float> read(16 * 2);
+    CHECK(ring.Read(read.data(), 4) == 4);
+    CHECK(IsNumbered(read, 0, 4));
+
+    CHECK(ring.Space() == 6);
+    CHECK(ring.Write(Numbered(6, 6).data(), 6) == 6);
+    CHECK(ring.Space() == 0);
+    CHECK(ring.Available() == 8);
+
+    // full, nothing more goes in
+    CHECK(ring.Write(Numbered(12, 1).data(), 1) == 0);
+
+    // the read wraps the same way, and takes no more than is there
+    CHECK(ring.Read(read.data(), 16) == 8);
+    CHECK(IsNumbered(read, 4, 8));
+    CHECK(ring.Available() == 0);
+    CHECK(ring.Read(read.data(), 1) == 0);
+
+    // a write bigger than the space is cut to it, around the end again
+    CHECK(ring.Write(Numbered(12, 10).data(), 10) == 8);
+    CHECK(ring.Skip(3) == 3);
+    CHECK(ring.Read(read.data(), 5) == 5);
+    CHECK(IsNumbered(read, 15, 5));
+    CHECK(ring.Skip(1) == 0);
+
+    // positions keep counting, many times round the buffer
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        CHECK(ring.Write(Numbered(i * 5, 5).data(), 5) == 5);
+        CHECK(ring.Read(read.data(), 5) == 5);
+        CHECK(IsNumbered(read, i * 5, 5));
+    }
+}
+
+TEST(AudioRingFlushDropsUnreadFrames)
+{
+    AudioRing ring;
+    ring.Reset(16, 2, 48000);
+    CHECK(ring.Flushed());
+
+    CHECK(ring.Write(Numbered(0, 10).data(), 10) == 10);
+
+    // requested by the producer, which writes nothing until the consumer has carried it out
+    ring.RequestFlush(5000000);
+    CHECK(!ring.Flushed());
+    CHECK(ring.Write(Numbered(100, 4).data(), 4) == 0);
+
+    // a second request before the first is acknowledged only moves the timestamp
+    ring.RequestFlush(7000000);
+
+    // the consumer's next Available() drops the 10 unread frames and acknowledges both
+    CHECK(ring.Available() == 0);
+    CHECK(ring.Flushed());
+    CHECK(ring.Space() == 16);
+    CHECK(ring.Timestamp() == 7000000);
+
+    std::vector<float> read(16 * 2);
+    CHECK(ring.Read(read.data(), 16) == 0);
+
+    // the frames after it are the new timeline
+    CHECK(ring.Write(Numbered(100, 12).data(), 12) == 12);
+    CHECK(ring.Available() == 12);
+    CHECK(ring.Read(read.data(), 4) == 4);
+    CHECK(IsNumbered(read, 100, 4));
+}
+
+TEST(AudioRingTimestampFollowsTheReadPosition)
+{
+    AudioRing ring;
+    ring.Reset(4800, 2, 48000);
+
+    CHECK(ring.Timestamp() == 0);
+
+    ring.RequestFlush(10000000);
+    CHECK(ring.Available() == 0);
+    CHECK(ring.Timestamp() == 10000000);
+
+    // 480 frames at 48khz are 10ms, read or skipped
+    CHECK(ring.Write(Numbered(0, 1440).data(), 1440) == 1440);
+    CHECK(ring.Available() == 1440);
+    std::vector<float> read(480 * 2);
+    CHECK(ring.Read(read.data(), 480) == 480);
+    CHECK(ring.Timestamp() == 10100000);
+    CHECK(ring.Skip(480) == 480);
+    CHECK(ring.Timestamp() == 10200000);
+
+    // a flush starts the count again from its own time, backwards for a seek back
+    ring.RequestFlush(2000000);
+    CHECK(ring.Timestamp() == 10200000);
+    CHECK(ring.Available() == 0);
+    CHECK(ring.Timestamp() == 2000000);
+
+    CHECK(ring.Write(Numbered(0, 48).data(), 48) == 48);
+    CHECK(ring.Available() == 48);
+    CHECK(ring.Read(read.data(), 48) == 48);
+    CHECK(ring.Timestamp() == 2010000);
+}
+
+TEST(AudioRingProducerAndConsumerThreads)
+{
+    // one frame per tick, so the timestamp of a frame is its number
+    AudioRing ring;
+    ring.Reset(257, 2, 10000000);
+
+    constexpr uint32_t c_frames = 1000000;
+    constexpr uint32_t c_flushEvery = 100000;
+    constexpr uint32_t c_flushJump = 1000;
+
+    std::atomic<bool> done = false;
+    std::thread producer([&]
+    {
+        uint32_t next = 0;
+        uint32_t sinceFlush = 0;
+        uint32_t block = 1;
+        while (next < c_frames)
+        {
+            // every so often jump ahead, as a seek would, and wait for the consumer to take it
+            if (sinceFlush >= c_flushEvery)
+            {
+                next += c_flushJump;
+                ring.RequestFlush(next);
+                while (!ring.Flushed())
+                {
+                    std::this_thread::yield();
+                }
+                sinceFlush = 0;
+            }
+
+            // odd sizes so the writes land everywhere in the buffer
+            block = block % 97 + 1;
+            auto frames = Numbered(next, block);
+            uint32_t written = ring.Write(frames.data(), block);
+            if (written == 0)
+            {
+                std::this_thread::yield();
+            }
+
+            next += written;
+            sinceFlush += written;
+        }
+
+        done = true;
+    });
+
+    // every read starts at the frame the timestamp says it should, and is in order
+    std::vector<float> read(64 * 2);
+    uint64_t total = 0;
+    uint32_t bad = 0;
+    uint32_t block = 1;
+    for (;;)
+    {
+        bool finished = done;
+        uint32_t available = ring.Available();
+        if (available == 0)
+        {
+            if (finished && ring.Flushed())
+            {
+                break;
+            }
+
+            std::this_thread::yield();
+            continue;
+        }
+
+        block = block % 63 + 1;
+        uint32_t first = static_cast<uint32_t>(ring.Timestamp());
+        uint32_t count = ring.Read(read.data(), block);
+        bad += IsNumbered(read, first, count) ? 0 : 1;
+        total += count;
+    }
+
+    producer.join();
+
+    CHECK(bad == 0);
+    CHECK(total > c_frames / 2);
+    CHECK(total <= c_frames);
+}
+
+BENCHMARK(AudioRingThroughput)
+{
+    // a 10ms block of 48khz stereo in and out, the tap's usual step, on one thread
+    AudioRing ring;
+    ring.Reset(4800, 2, 48000);
+
+    constexpr uint32_t c_block = 480;
+    constexpr uint32_t c_blocks = 100000;
+    auto frames = Numbered(0, c_block);
+    std::vector<float> read(c_block * 2);
+
+    int64_t start = Ticks();
+    for (uint32_t i = 0; i < c_blocks; ++i)
+    {
+        ring.Write(frames.data(), c_block);
+        ring.Available();
+        ring.Read(read.data(), c_block);
+    }
+    double ns = TicksToNs(Ticks() - start);
+
+    printf("  write + read  %6.1f ns per 480 frame block   %7.1f M frames/s\n",
+        ns / c_blocks,
+        static_cast<double>(c_block) * c_blocks * 1e3 / ns);
+
+    CHECK(IsNumbered(read, 0, c_block));
+}
@@ -0,0 +1,136 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "FrameCache.h"
+
+#pragma comment(lib, "d3d11")
+
+using namespace winrt;
+
+static constexpr uint32_t c_frameSize = 64;
+static constexpr uint64_t c_frameBytes = c_frameSize * c_frameSize * 4;
+
+// a WARP device and a frame sized texture to copy from and to
+struct CacheDevice
+{
+    CacheDevice()
+    {
+        D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0, D3D11_SDK_VERSION, device.put(), nullptr, context.put());
+
+        frame = CreateFrame(c_frameSize);
+    }
+
+    com_ptr<ID3D11Texture2D> CreateFrame(uint32_t size)
+    {
+        com_ptr<ID3D11Texture2D> texture = nullptr;
+        if (device != nullptr)
+        {
+            auto desc = CD3D11_TEXTURE2D_DESC(DXGI_FORMAT_B8G8R8A8_UNORM, size, size, 1, 1);
+            device->CreateTexture2D(&desc, nullptr, texture.put());
+        }
+
+        return texture;
+    }
+
+    com_ptr<ID3D11Device> device;
+    com_ptr<ID3D11DeviceContext> context;
+    com_ptr<ID3D11Texture2D> frame;
+};
+
+TEST(FrameCacheIsOffWithoutABudget)
+{
+    CacheDevice d3d;
+    CHECK(d3d.frame != nullptr);
+
+    FrameCache cache;
+    CHECK(!cache.Enabled());
+
+    CHECK(SUCCEEDED(cache.Insert(d3d.context.get(), 0, d3d.frame.get())));
+    CHECK(cache.GetStats().frames == 0);
+
+    int64_t timestamp = -1;
+    CHECK(!cache.CopyTo(d3d.context.get(), 0, 1000, d3d.frame.get(), &timestamp));
+    CHECK(timestamp == 0);
+    CHECK(cache.GetStats().misses == 1);
+
+    CHECK(cache.Insert(nullptr, 0, d3d.frame.get()) == E_INVALIDARG);
+}
+
+TEST(FrameCacheFindsTheNewestFrameAtOrBefore)
+{
+    CacheDevice d3d;
+
+    FrameCache cache;
+    cache.SetBudget(10 * c_frameBytes);
+    CHECK(cache.Enabled());
+
+    CHECK(SUCCEEDED(cache.Insert(d3d.context.get(), 0, d3d.frame.get())));
+    CHECK(SUCCEEDED(cache.Insert(d3d.context.get(), 333, d3d.frame.get())));
+    CHECK(SUCCEEDED(cache.Insert(d3d.context.get(), 666, d3d.frame.get())));
+
+    // the same position again is not a second frame
+    CHECK(SUCCEEDED(cache.Insert(d3d.context.get(), 333, d3d.frame.get())));
+    CHECK(cache.GetStats().frames == 3);
+    CHECK(cache.GetStats().bytes == 3 * c_frameBytes);
+
+    int64_t timestamp = 0;
+    CHECK(cache.CopyTo(d3d.context.get(), 500, 400, d3d.frame.get(), &timestamp) && timestamp == 333);
+    CHECK(cache.CopyTo(d3d.context.get(), 332, 400, d3d.frame.get(), &timestamp) && timestamp == 0);
+    CHECK(cache.CopyTo(d3d.context.get(), 666, 400, d3d.frame.get(), &timestamp) && timestamp == 666);
+    CHECK(cache.CopyTo(d3d.context.get(), 1000, 400, d3d.frame.get(), &timestamp) && timestamp == 666);
+
+    // never a frame from after the position, nor one too far before it
+    CHECK(!cache.CopyTo(d3d.context.get(), -1, 400, d3d.frame.get(), &timestamp));
+    CHECK(!cache.CopyTo(d3d.context.get(), 1066, 400, d3d.frame.get(), &timestamp));
+
+    auto stats = cache.GetStats();
+    CHECK(stats.hits == 4);
+    CHECK(stats.misses == 2);
+
+    // a new source
+    cache.Clear();
+    CHECK(!cache.CopyTo(d3d.context.get(), 333, 400, d3d.frame.get(), &timestamp));
+    CHECK(cache.GetStats().frames == 0);
+    CHECK(cache.GetStats().bytes == 0);
+}
+
+TEST(FrameCacheEvictsLeastRecentlyUsed)
+{
+    CacheDevice d3d;
+
+    FrameCache cache;
+    cache.SetBudget(3 * c_frameBytes);
+
+    cache.Insert(d3d.context.get(), 0, d3d.frame.get());
+    cache.Insert(d3d.context.get(), 100, d3d.frame.get());
+    cache.Insert(d3d.context.get(), 200, d3d.frame.get());
+
+    // the first frame is used again, the second is now the oldest
+    int64_t timestamp = 0;
+    CHECK(cache.CopyTo(d3d.context.get(), 0, 50, d3d.frame.get(), &timestamp));
+
+    cache.Insert(d3d.context.get(), 300, d3d.frame.get());
+
+    auto stats = cache.GetStats();
+    CHECK(stats.frames == 3);
+    CHECK(stats.evictions == 1);
+    CHECK(stats.bytes <= stats.budget);
+
+    CHECK(!cache.CopyTo(d3d.context.get(), 100, 50, d3d.frame.get(), &timestamp));
+    CHECK(cache.CopyTo(d3d.context.get(), 0, 50, d3d.frame.get(), &timestamp) && timestamp == 0);
+
+    // a lower budget evicts straight away, the most recently used stays
+    cache.SetBudget(c_frameBytes);
+    stats = cache.GetStats();
+    CHECK(stats.frames == 1);
+    CHECK(stats.evictions == 3);
+    CHECK(cache.CopyTo(d3d.context.get(), 0, 50, d3d.frame.get(), &timestamp) && timestamp == 0);
+
+    // a frame larger than the whole budget is not cached and evicts nothing
+    auto large = d3d.CreateFrame(2 * c_frameSize);
+    CHECK(SUCCEEDED(cache.Insert(d3d.context.get(), 400, large.get())));
+    CHECK(cache.GetStats().frames == 1);
+    CHECK(cache.GetStats().evictions == 3);
+}
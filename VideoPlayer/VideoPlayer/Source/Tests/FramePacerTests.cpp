@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "FramePacer.h"
+
+#include <cstdlib>
+#include <random>
+
+static constexpr int64_t c_second = 10000000;
+static constexpr int64_t c_frameInterval = 333333;  // 30fps
+
+TEST(FramePacerFollowsTheNewestFrameUntilAnchored)
+{
+    FramePacer pacer;
+    CHECK(!pacer.HasClock());
+    CHECK(pacer.DisplayTime(5 * c_second, 2) == 0);
+
+    pacer.OnFrame(c_second, 5 * c_second, 1.0);
+    CHECK(pacer.HasClock());
+
+    // media time runs with system time from the anchor
+    CHECK(pacer.DisplayTime(5 * c_second, 0) == c_second);
+    CHECK(pacer.DisplayTime(5 * c_second + 100000, 0) == c_second + 100000);
+
+    // and is asked for a number of vsyncs ahead, 60Hz until unity has rendered
+    CHECK(pacer.DisplayTime(5 * c_second, 1) == c_second + pacer.VsyncInterval());
+    CHECK(std::abs(pacer.VsyncInterval() - 166667) <= 1);
+
+    pacer.Reset();
+    CHECK(!pacer.HasClock());
+}
+
+TEST(FramePacerEstimatesTheRefreshRate)
+{
+    FramePacer pacer;
+
+    // 90Hz
+    int64_t time = c_second;
+    for (int i = 0; i < 200; ++i, time += 111111)
+    {
+        pacer.OnVsync(time);
+    }
+    CHECK(std::abs(pacer.VsyncInterval() - 111111) < 1000);
+
+    // a hitch is not a refresh rate
+    time += 2 * c_second;
+    pacer.OnVsync(time);
+    CHECK(std::abs(pacer.VsyncInterval() - 111111) < 1000);
+
+    // nor is unity rendering twice in one frame, the estimate stays in range
+    for (int i = 0; i < 200; ++i, time += 1000)
+    {
+        pacer.OnVsync(time);
+    }
+    CHECK(pacer.VsyncInterval() >= 40000);
+
+    // a reset is a new clip, the display has not changed
+    int64_t interval = pacer.VsyncInterval();
+    pacer.Reset();
+    CHECK(pacer.VsyncInterval() == interval);
+}
+
+// frames reach the pacer late by a jittered amount, the smoothed clock has to stay much
+// closer to the true media time than the jitter
+TEST(FramePacerSmoothsLateCallbacks)
+{
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int64_t> lateness(0, 80000);
+
+    FramePacer pacer;
+
+    int64_t start = 3 * c_second;
+    int64_t maxError = 0;
+    for (int frame = 0; frame < 300; ++frame)
+    {
+        int64_t timestamp = frame * c_frameInterval;
+        pacer.OnFrame(timestamp, start + timestamp + lateness(random), 1.0);
+
+        // after the first second, ask where the clock is half a frame on
+        if (frame >= 30)
+        {
+            int64_t system = start + timestamp + c_frameInterval / 2;
+            maxError = (std::max)(maxError, std::abs(pacer.DisplayTime(system, 0) - (timestamp + c_frameInterval / 2)));
+        }
+    }
+
+    printf("  max clock error %.2fms\n", maxError / 10000.0);
+
+    // late by 4ms on average, the clock runs that far behind, but jitters much less
+    CHECK(maxError < 80000);
+}
+
+TEST(FramePacerReanchorsOnSeekAndRateChange)
+{
+    FramePacer pacer;
+
+    pacer.OnFrame(0, c_second, 1.0);
+    pacer.OnFrame(c_frameInterval, c_second + c_frameInterval + 50000, 1.0);
+
+    // smoothed, not moved all the way
+    int64_t smoothed = pacer.DisplayTime(c_second + c_frameInterval + 50000, 0);
+    CHECK(smoothed > c_frameInterval);
+    CHECK(smoothed < c_frameInterval + 50000);
+
+    // a seek lands exactly
+    pacer.OnFrame(60 * c_second, 2 * c_second, 1.0);
+    CHECK(pacer.DisplayTime(2 * c_second, 0) == 60 * c_second);
+
+    // double speed, media time runs twice as fast from the new anchor
+    pacer.OnFrame(60 * c_second + c_frameInterval, 2 * c_second + c_frameInterval, 2.0);
+    CHECK(pacer.DisplayTime(2 * c_second + c_frameInterval + c_second, 0) == 60 * c_second + c_frameInterval + 2 * c_second);
+}
@@ -0,0 +1,233 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "FrameRing.h"
+
+#include <atomic>
+#include <thread>
+
+// writes one frame, the slot it got or -1
+static int32_t Write(FrameRing& ring, int64_t timestamp)
+{
+    int32_t slot = ring.BeginWrite();
+    if (slot != -1)
+    {
+        ring.EndWrite(slot, true, timestamp);
+    }
+
+    return slot;
+}
+
+TEST(FrameRingCyclesSlotOwnership)
+{
+    FrameRing ring;
+    ring.Reset(3);
+    CHECK(ring.Capacity() == 3);
+    CHECK(ring.Presented() == -1);
+
+    CHECK(Write(ring, 100) == 0);
+    CHECK(Write(ring, 200) == 1);
+
+    // the newest is shown, the one queued before it never will be
+    CHECK(ring.Present(PacingMode::Latest, 0) == 1);
+    CHECK(ring.Presented() == 1);
+
+    CHECK(Write(ring, 300) == 0);
+    CHECK(Write(ring, 400) == 2);
+
+    // every slot busy, the oldest ready one is overwritten, never the one unity shows
+    CHECK(Write(ring, 500) == 0);
+
+    // presenting releases the previous frame
+    CHECK(ring.Present(PacingMode::Latest, 0) == 0);
+    CHECK(ring.Presented() == 0);
+    CHECK(Write(ring, 600) == 1);
+
+    auto stats = ring.GetStats();
+    CHECK(stats.written == 6);
+    CHECK(stats.presented == 2);
+    CHECK(stats.dropped == 3);
+    CHECK(stats.stalled == 0);
+}
+
+TEST(FrameRingStallsWhenUnityHoldsEverySlot)
+{
+    FrameRing ring;
+    ring.Reset(1);
+
+    CHECK(Write(ring, 100) == 0);
+    CHECK(ring.Present(PacingMode::Latest, 0) == 0);
+
+    CHECK(ring.BeginWrite() == -1);
+    CHECK(ring.GetStats().stalled == 1);
+    CHECK(ring.Presented() == 0);
+}
+
+TEST(FrameRingFailedWriteFreesTheSlot)
+{
+    FrameRing ring;
+    ring.Reset(1);
+
+    int32_t slot = ring.BeginWrite();
+    CHECK(slot == 0);
+    ring.EndWrite(slot, false, 100);
+
+    CHECK(ring.Present(PacingMode::Latest, 0) == -1);
+    CHECK(ring.BeginWrite() == 0);
+    CHECK(ring.GetStats().written == 0);
+
+    // a slot that is not being written is left alone
+    ring.EndWrite(3, true, 100);
+    ring.EndWrite(-1, true, 100);
+    CHECK(ring.GetStats().written == 0);
+}
+
+TEST(FrameRingPacesAgainstTheDisplayTime)
+{
+    FrameRing ring;
+    ring.Reset(4);
+
+    Write(ring, 0);
+    Write(ring, 333);
+    Write(ring, 666);
+
+    // closest to the display time, the one before it is dropped
+    CHECK(ring.Present(PacingMode::Nearest, 400) == 1);
+    CHECK(ring.GetStats().dropped == 1);
+
+    // still the best match, kept on screen
+    CHECK(ring.Present(PacingMode::Nearest, 450) == -1);
+    CHECK(ring.Presented() == 1);
+
+    // floor never shows a frame before its time
+    CHECK(ring.Present(PacingMode::Floor, 600) == -1);
+    CHECK(ring.Present(PacingMode::Floor, 700) == 2);
+
+    auto stats = ring.GetStats();
+    CHECK(stats.repeated == 2);
+    CHECK(stats.presented == 2);
+
+    // nothing new, latest has nothing to present
+    CHECK(ring.Present(PacingMode::Latest, 0) == -1);
+    CHECK(ring.Presented() == 2);
+}
+
+TEST(FrameRingFloorWaitsForTheFirstFrame)
+{
+    FrameRing ring;
+    ring.Reset(2);
+
+    Write(ring, 1000);
+
+    CHECK(ring.Present(PacingMode::Floor, 500) == -1);
+    CHECK(ring.Presented() == -1);
+    CHECK(ring.Present(PacingMode::Floor, 1000) == 0);
+}
+
+TEST(FrameRingDropsTheOldTimelineOnSeek)
+{
+    FrameRing ring;
+    ring.Reset(4);
+
+    Write(ring, 100);
+    Write(ring, 200);
+    CHECK(ring.Present(PacingMode::Latest, 0) == 1);
+    Write(ring, 300);
+
+    // a seek back, the frame queued from before it goes, and the one on screen is no
+    // longer a candidate even though it is closer to the display time
+    int32_t seeked = Write(ring, 50);
+    CHECK(ring.GetStats().dropped == 2);
+    CHECK(ring.Present(PacingMode::Nearest, 200) == seeked);
+}
+
+// the CPU stand-in for the shared textures. the producer fills a whole buffer with the frame
+// number, unity reads the one it was handed while the producer keeps going. a torn frame is
+// a buffer that does not hold one number
+TEST(FrameRingNeverWritesWhatUnityReads)
+{
+    constexpr uint32_t c_frames = 20000;
+    constexpr size_t c_bufferSize = 4096;
+
+    FrameRing ring;
+    ring.Reset(3);
+
+    std::vector<std::vector<uint32_t>> buffers(3, std::vector<uint32_t>(c_bufferSize, 0));
+
+    std::atomic<bool> done = false;
+    std::thread producer([&]
+        {
+            for (uint32_t frame = 1; frame <= c_frames; )
+            {
+                int32_t slot = ring.BeginWrite();
+                if (slot == -1)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                auto& buffer = buffers[slot];
+                for (size_t i = 0; i < buffer.size(); ++i)
+                {
+                    buffer[i] = frame;
+                }
+
+                ring.EndWrite(slot, true, static_cast<int64_t>(frame) * 10);
+                ++frame;
+
+                // let unity in between frames, even on one core
+                std::this_thread::yield();
+            }
+
+            done = true;
+        });
+
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    uint32_t reads = 0;
+    uint32_t last = 0;
+    while (!done)
+    {
+        ring.Present(PacingMode::Latest, 0);
+
+        int32_t slot = ring.Presented();
+        if (slot == -1)
+        {
+            continue;
+        }
+
+        auto const& buffer = buffers[slot];
+        uint32_t frame = buffer[0];
+        for (size_t i = 1; i < buffer.size(); ++i)
+        {
+            if (buffer[i] != frame)
+            {
+                ++torn;
+                break;
+            }
+        }
+
+        if (frame < last)
+        {
+            ++backwards;
+        }
+        last = frame;
+        ++reads;
+    }
+
+    producer.join();
+
+    auto stats = ring.GetStats();
+    printf("  %u reads, %llu presented, %llu dropped, %llu stalled\n",
+        reads,
+        static_cast<unsigned long long>(stats.presented),
+        static_cast<unsigned long long>(stats.dropped),
+        static_cast<unsigned long long>(stats.stalled));
+
+    CHECK(stats.presented > 100);
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+    CHECK(stats.written == c_frames);
+}
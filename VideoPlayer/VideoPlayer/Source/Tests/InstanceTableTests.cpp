@@ -0,0 +1,296 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "InstanceTable.h"
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+// the module is the handle it was added under, so a lookup can tell it got the right one
+using TestModule = std::shared_ptr<INSTANCE_HANDLE>;
+using SmallTable = InstanceTable<TestModule, 4>;
+
+static INSTANCE_HANDLE AddModule(SmallTable& table)
+{
+    auto module = std::make_shared<INSTANCE_HANDLE>(INSTANCE_HANDLE_INVALID);
+
+    INSTANCE_HANDLE handle = INSTANCE_HANDLE_INVALID;
+    if (FAILED(table.Add(module, &handle)))
+    {
+        return INSTANCE_HANDLE_INVALID;
+    }
+
+    *module = handle;
+
+    return handle;
+}
+
+TEST(InstanceTableAddsLooksUpAndRemoves)
+{
+    SmallTable table;
+
+    INSTANCE_HANDLE handle = AddModule(table);
+    CHECK(handle >= INSTANCE_HANDLE_START);
+
+    TestModule module;
+    CHECK(SUCCEEDED(table.Get(handle, module)));
+    CHECK(module != nullptr && *module == handle);
+
+    TestModule removed;
+    CHECK(SUCCEEDED(table.Remove(handle, removed)));
+    CHECK(removed == module);
+
+    CHECK(table.Get(handle, module) == HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+    CHECK(module == nullptr);
+    CHECK(table.Remove(handle, removed) == HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+
+    // handles outside the table and empty modules
+    CHECK(table.Get(INSTANCE_HANDLE_INVALID, module) == E_INVALIDARG);
+    CHECK(table.Get(0x10000, module) == E_INVALIDARG);
+
+    INSTANCE_HANDLE added = 0;
+    CHECK(table.Add(nullptr, &added) == E_INVALIDARG);
+}
+
+TEST(InstanceTableRejectsStaleHandles)
+{
+    SmallTable table;
+
+    INSTANCE_HANDLE handles[4] = {};
+    for (auto& handle : handles)
+    {
+        handle = AddModule(table);
+        CHECK(handle != INSTANCE_HANDLE_INVALID);
+    }
+
+    // full
+    TestModule module = std::make_shared<INSTANCE_HANDLE>(0);
+    INSTANCE_HANDLE handle = 0;
+    CHECK(table.Add(module, &handle) == HRESULT_FROM_WIN32(ERROR_NO_MORE_ITEMS));
+
+    // the only free slot is reused, under a handle the old one does not match
+    TestModule removed;
+    CHECK(SUCCEEDED(table.Remove(handles[1], removed)));
+
+    INSTANCE_HANDLE reused = AddModule(table);
+    CHECK(reused != INSTANCE_HANDLE_INVALID);
+    CHECK(reused != handles[1]);
+    CHECK((reused - INSTANCE_HANDLE_START) % 4 == (handles[1] - INSTANCE_HANDLE_START) % 4);
+
+    CHECK(table.Get(handles[1], module) == HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+    CHECK(SUCCEEDED(table.Get(reused, module)) && *module == reused);
+}
+
+// the handle has to fit the render event, the generations wrap before it would not
+TEST(InstanceTableHandlesFitTheRenderEvent)
+{
+    SmallTable table;
+
+    INSTANCE_HANDLE first = AddModule(table);
+
+    bool fits = true;
+    uint32_t reuses = 0;
+    INSTANCE_HANDLE handle = first;
+    for (uint32_t i = 0; i < SmallTable::Generations; ++i)
+    {
+        TestModule removed;
+        table.Remove(handle, removed);
+
+        handle = AddModule(table);
+        fits = fits && handle >= INSTANCE_HANDLE_START && handle < 0x10000;
+
+        // the one slot in use comes back only after the other three have been used
+        if ((handle - INSTANCE_HANDLE_START) % 4 == (first - INSTANCE_HANDLE_START) % 4)
+        {
+            ++reuses;
+        }
+    }
+
+    CHECK(fits);
+    CHECK(reuses == SmallTable::Generations / 4);
+}
+
+TEST(InstanceTableClearHandsBackEveryModule)
+{
+    SmallTable table;
+
+    INSTANCE_HANDLE first = AddModule(table);
+    INSTANCE_HANDLE second = AddModule(table);
+    INSTANCE_HANDLE third = AddModule(table);
+
+    TestModule removed;
+    table.Remove(second, removed);
+
+    auto modules = table.Clear();
+    CHECK(modules.size() == 2);
+    CHECK(*modules[0] == first && *modules[1] == third);
+
+    TestModule module;
+    CHECK(FAILED(table.Get(first, module)));
+    CHECK(FAILED(table.Get(third, module)));
+    CHECK(table.Clear().empty());
+
+    // and every slot is free again
+    for (int i = 0; i < 4; ++i)
+    {
+        CHECK(AddModule(table) != INSTANCE_HANDLE_INVALID);
+    }
+}
+
+// the render thread looking modules up while the main thread adds and removes them, a lookup
+// either fails or gets the module of the handle it asked for
+TEST(InstanceTableLookupsRaceAddAndRemove)
+{
+    constexpr uint32_t c_readers = 3;
+    constexpr uint32_t c_rounds = 20000;
+
+    SmallTable table;
+
+    std::atomic<INSTANCE_HANDLE> live[4];
+    for (auto& handle : live)
+    {
+        handle = AddModule(table);
+    }
+
+    std::atomic<bool> done = false;
+    std::atomic<uint64_t> found = 0;
+    std::atomic<uint64_t> wrong = 0;
+
+    std::vector<std::thread> readers;
+    for (uint32_t r = 0; r < c_readers; ++r)
+    {
+        readers.emplace_back([&]
+            {
+                uint32_t i = 0;
+                while (!done)
+                {
+                    INSTANCE_HANDLE handle = live[i++ % 4].load();
+
+                    TestModule module;
+                    if (SUCCEEDED(table.Get(handle, module)))
+                    {
+                        ++found;
+                        if (*module != handle)
+                        {
+                            ++wrong;
+                        }
+                    }
+                }
+            });
+    }
+
+    for (uint32_t round = 0; round < c_rounds; ++round)
+    {
+        auto& handle = live[round % 4];
+
+        TestModule removed;
+        table.Remove(handle.load(), removed);
+        handle = AddModule(table);
+
+        if (round % 64 == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    done = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    printf("  %llu lookups found their module\n", static_cast<unsigned long long>(found.load()));
+
+    CHECK(found > 0);
+    CHECK(wrong == 0);
+}
+
+// the unordered_map lookup the plugins used before the table, for comparison
+static HRESULT MapGet(std::unordered_map<INSTANCE_HANDLE, TestModule> const& map, INSTANCE_HANDLE handle, TestModule& module)
+{
+    if (handle < INSTANCE_HANDLE_START)
+    {
+        IFR(E_INVALIDARG);
+    }
+
+    auto it = map.find(handle);
+    if (it == map.end())
+    {
+        IFR(HRESULT_FROM_WIN32(ERROR_NOT_FOUND));
+    }
+
+    module = it->second;
+
+    NULL_CHK_HR(module, E_POINTER);
+
+    return S_OK;
+}
+
+BENCHMARK(InstanceTableLookup)
+{
+    constexpr uint32_t c_lookups = 10000000;
+
+    // a scene with a few players, and one with a table's worth
+    for (uint32_t count : { 4u, 128u })
+    {
+        InstanceTable<TestModule> table;
+        std::unordered_map<INSTANCE_HANDLE, TestModule> map;
+        std::vector<INSTANCE_HANDLE> handles;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            auto module = std::make_shared<INSTANCE_HANDLE>(INSTANCE_HANDLE_INVALID);
+
+            INSTANCE_HANDLE handle = INSTANCE_HANDLE_INVALID;
+            CHECK(SUCCEEDED(table.Add(module, &handle)));
+            *module = handle;
+
+            map.emplace(handle, module);
+            handles.push_back(handle);
+        }
+
+        // the same handles in the same order through both, the module copied out each time
+        uint64_t tableSum = 0;
+        int64_t start = Ticks();
+        for (uint32_t i = 0; i < c_lookups; ++i)
+        {
+            TestModule module;
+            table.Get(handles[i % count], module);
+            tableSum += *module;
+        }
+        double tableNs = TicksToNs(Ticks() - start);
+
+        uint64_t mapSum = 0;
+        start = Ticks();
+        for (uint32_t i = 0; i < c_lookups; ++i)
+        {
+            TestModule module;
+            MapGet(map, handles[i % count], module);
+            mapSum += *module;
+        }
+        double mapNs = TicksToNs(Ticks() - start);
+
+        printf("  %3u modules  InstanceTable::Get %5.1f ns   unordered_map find %5.1f ns\n",
+            count,
+            tableNs / c_lookups,
+            mapNs / c_lookups);
+
+        CHECK(tableSum == mapSum);
+    }
+}
@@ -0,0 +1,216 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "KeyframeIndex.h"
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+// samples handed to Build in the order given, like a source reader in decode order
+struct StubSampleSource : KeyframeIndex::SampleSource
+{
+    struct Sample
+    {
+        int64_t timestamp;
+        int64_t duration;
+        bool keyframe;
+    };
+
+    explicit StubSampleSource(std::vector<Sample> const& samples)
+        : samples(samples)
+        , next(0)
+        , failure(S_OK)
+        , onSample(nullptr)
+    {
+    }
+
+    HRESULT Next(
+        _Out_ int64_t* timestamp,
+        _Out_ int64_t* duration,
+        _Out_ bool* keyframe) override
+    {
+        *timestamp = 0;
+        *duration = 0;
+        *keyframe = false;
+
+        if (next == samples.size())
+        {
+            return FAILED(failure) ? failure : S_FALSE;
+        }
+
+        if (onSample != nullptr)
+        {
+            onSample(next);
+        }
+
+        auto const& sample = samples[next++];
+        *timestamp = sample.timestamp;
+        *duration = sample.duration;
+        *keyframe = sample.keyframe;
+
+        return S_OK;
+    }
+
+    std::vector<Sample> samples;
+    size_t next;
+    HRESULT failure;  // returned instead of the end of the stream
+    std::function<void(size_t)> onSample;
+};
+
+// waits for the background scan, false if it never finished
+static bool WaitForBuild(KeyframeIndex& index)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (index.GetState() != KeyframeIndex::State::Building)
+        {
+            return true;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return false;
+}
+
+TEST(KeyframeIndexClosestPicksTheNearest)
+{
+    std::vector<int64_t> keyframes = { 0, 100, 250 };
+
+    // clamped to the ends
+    CHECK(KeyframeIndex::Closest(keyframes, -5) == 0);
+    CHECK(KeyframeIndex::Closest(keyframes, 1000) == 250);
+
+    CHECK(KeyframeIndex::Closest(keyframes, 0) == 0);
+    CHECK(KeyframeIndex::Closest(keyframes, 40) == 0);
+    CHECK(KeyframeIndex::Closest(keyframes, 60) == 100);
+    CHECK(KeyframeIndex::Closest(keyframes, 176) == 250);
+    CHECK(KeyframeIndex::Closest(keyframes, 250) == 250);
+
+    // halfway goes back, a seek never lands after the position it was asked for
+    CHECK(KeyframeIndex::Closest(keyframes, 50) == 0);
+    CHECK(KeyframeIndex::Closest(keyframes, 175) == 100);
+
+    CHECK(KeyframeIndex::Closest({ 42 }, 0) == 42);
+    CHECK(KeyframeIndex::Closest({ 42 }, 100) == 42);
+}
+
+TEST(KeyframeIndexBuildSortsKeyframesFromDecodeOrder)
+{
+    auto owner = std::make_shared<KeyframeIndex>(L"stub");
+
+    // a b-frame stream, presentation times jump back and forth, the keyframes among them
+    // don't come in order either
+    StubSampleSource source({
+        { 0, 0, true },
+        { 300, 100, false },
+        { 100, 100, false },
+        { 200, 100, false },
+        { 900, 100, true },
+        { 600, 100, true },
+        { 400, 100, false },
+        { 500, 100, false },
+        { 700, 100, false },
+    });
+
+    std::vector<int64_t> keyframes = { 1, 2, 3 };
+    int64_t frameDuration = -1;
+    CHECK(SUCCEEDED(KeyframeIndex::Build(source, owner, keyframes, &frameDuration)));
+    CHECK(source.next == source.samples.size());
+    CHECK((keyframes == std::vector<int64_t>{ 0, 600, 900 }));
+
+    // the first sample had no duration, the first one that does is used
+    CHECK(frameDuration == 100);
+
+    CHECK(KeyframeIndex::Closest(keyframes, 700) == 600);
+    CHECK(KeyframeIndex::Closest(keyframes, 800) == 900);
+}
+
+TEST(KeyframeIndexBuildHandlesEmptySources)
+{
+    auto owner = std::make_shared<KeyframeIndex>(L"stub");
+
+    // nothing at all
+    StubSampleSource empty({});
+    std::vector<int64_t> keyframes = { 1 };
+    int64_t frameDuration = -1;
+    CHECK(SUCCEEDED(KeyframeIndex::Build(empty, owner, keyframes, &frameDuration)));
+    CHECK(keyframes.empty());
+    CHECK(frameDuration == 0);
+
+    // samples, but no sync sample among them
+    StubSampleSource noKeyframes({ { 0, 333, false }, { 333, 333, false } });
+    CHECK(SUCCEEDED(KeyframeIndex::Build(noKeyframes, owner, keyframes, &frameDuration)));
+    CHECK(keyframes.empty());
+    CHECK(frameDuration == 333);
+}
+
+TEST(KeyframeIndexBuildStopsOnFailureAndRelease)
+{
+    auto owner = std::make_shared<KeyframeIndex>(L"stub");
+
+    // a read error ends the scan with that error
+    StubSampleSource failing({ { 0, 100, true }, { 100, 100, false } });
+    failing.failure = E_UNEXPECTED;
+
+    std::vector<int64_t> keyframes;
+    int64_t frameDuration = 0;
+    CHECK(KeyframeIndex::Build(failing, owner, keyframes, &frameDuration) == E_UNEXPECTED);
+
+    // the index going away stops the scan before the next sample
+    StubSampleSource released({ { 0, 100, true }, { 100, 100, false }, { 200, 100, true }, { 300, 100, false } });
+    released.onSample = [&owner](size_t sample)
+    {
+        if (sample == 1)
+        {
+            owner = nullptr;
+        }
+    };
+
+    std::weak_ptr<KeyframeIndex> weak = owner;
+    CHECK(KeyframeIndex::Build(released, weak, keyframes, &frameDuration) == E_ABORT);
+    CHECK(released.next == 2);
+}
+
+TEST(KeyframeIndexFailsForASourceThatDoesNotOpen)
+{
+    auto index = std::make_shared<KeyframeIndex>(L"C:\\KeyframeIndexTests\\missing.mp4");
+    CHECK(index->GetState() == KeyframeIndex::State::NotStarted);
+
+    // nothing until the scan is done, the position is handed back unchanged
+    int64_t keyframe = 0;
+    CHECK(!index->Nearest(12345, &keyframe));
+    CHECK(keyframe == 12345);
+
+    index->BuildAsync();
+    CHECK(WaitForBuild(*index));
+    CHECK(index->GetState() == KeyframeIndex::State::Failed);
+
+    // built once, a failed index is not retried
+    index->BuildAsync();
+    CHECK(index->GetState() == KeyframeIndex::State::Failed);
+
+    CHECK(!index->Nearest(12345, &keyframe));
+    CHECK(keyframe == 12345);
+    CHECK(index->FrameDuration() == 0);
+}
+
+// the scan only holds a weak reference, the player can go away while it runs
+TEST(KeyframeIndexCanBeReleasedWhileBuilding)
+{
+    std::weak_ptr<KeyframeIndex> weak;
+    {
+        auto index = std::make_shared<KeyframeIndex>(L"C:\\KeyframeIndexTests\\missing.mp4");
+        weak = index;
+
+        index->BuildAsync();
+    }
+
+    CHECK(weak.expired());
+
+    // let the thread finish against the released index
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+}
@@ -0,0 +1,294 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "PackedSequence.h"
+
+#include <mferror.h>
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+static constexpr uint64_t c_headerSize = 32;
+static constexpr uint64_t c_entrySize = 16;
+
+static void Append32(std::vector<uint8_t>& file, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        file.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+}
+
+static void Append64(std::vector<uint8_t>& file, uint64_t value)
+{
+    Append32(file, static_cast<uint32_t>(value));
+    Append32(file, static_cast<uint32_t>(value >> 32));
+}
+
+// what goes in a file's header
+struct Header
+{
+    uint32_t width = 4;
+    uint32_t height = 2;
+    uint32_t frameRateNumerator = 30;
+    uint32_t frameRateDenominator = 1;
+    uint32_t frameCount = 3;
+    uint32_t encoding = 0;
+    uint32_t version = 1;
+    char const* magic = "FSEQ";
+};
+
+// the header, an index of frameCount entries and then the frames back to back, every byte of
+// frame i is i. frameSize of 0 is a whole raw frame
+static std::vector<uint8_t> MakePacked(Header const& header, uint32_t frameSize = 0)
+{
+    if (frameSize == 0)
+    {
+        frameSize = header.width * header.height * 4;
+    }
+
+    std::vector<uint8_t> file(header.magic, header.magic + 4);
+    Append32(file, header.version);
+    Append32(file, header.width);
+    Append32(file, header.height);
+    Append32(file, header.frameRateNumerator);
+    Append32(file, header.frameRateDenominator);
+    Append32(file, header.frameCount);
+    Append32(file, header.encoding);
+
+    uint64_t indexEnd = c_headerSize + static_cast<uint64_t>(header.frameCount) * c_entrySize;
+    for (uint32_t i = 0; i < header.frameCount; ++i)
+    {
+        Append64(file, indexEnd + static_cast<uint64_t>(i) * frameSize);
+        Append32(file, frameSize);
+        Append32(file, 0);
+    }
+
+    for (uint32_t i = 0; i < header.frameCount; ++i)
+    {
+        file.insert(file.end(), frameSize, static_cast<uint8_t>(i));
+    }
+
+    return file;
+}
+
+// rewrites entry index of a file
+static void SetEntry(std::vector<uint8_t>& file, uint32_t index, uint64_t offset, uint32_t size)
+{
+    std::vector<uint8_t> entry;
+    Append64(entry, offset);
+    Append32(entry, size);
+    memcpy(file.data() + c_headerSize + index * c_entrySize, entry.data(), 12);
+}
+
+static HRESULT Parse(std::vector<uint8_t> const& file, std::vector<PackedSequence::Frame>& frames)
+{
+    RawFrameReader::Format format{};
+    PackedSequence::Encoding encoding = PackedSequence::Encoding::Bgra;
+    return PackedSequence::Parse(file.data(), file.size(), format, &encoding, frames);
+}
+
+TEST(PackedSequenceParsesRawAndPngFiles)
+{
+    Header header;
+    header.frameRateNumerator = 30000;
+    header.frameRateDenominator = 1001;
+    auto file = MakePacked(header);
+
+    RawFrameReader::Format format{};
+    PackedSequence::Encoding encoding = PackedSequence::Encoding::Png;
+    std::vector<PackedSequence::Frame> frames;
+    CHECK(SUCCEEDED(PackedSequence::Parse(file.data(), file.size(), format, &encoding, frames)));
+    CHECK(encoding == PackedSequence::Encoding::Bgra);
+    CHECK(format.width == 4 && format.height == 2);
+    CHECK(format.frameSize == 4 * 2 * 4);
+    CHECK(format.pixelFormat == RawFrameReader::PixelFormat::Bgra);
+    CHECK(format.frameRateNumerator == 30000 && format.frameRateDenominator == 1001);
+    CHECK(format.frameCount == 3);
+
+    CHECK(frames.size() == 3);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        CHECK(frames[i].size == format.frameSize);
+        CHECK(file[frames[i].offset] == i && file[frames[i].offset + frames[i].size - 1] == i);
+    }
+
+    // png frames can be any size, and in any order after the index
+    header.encoding = 1;
+    file = MakePacked(header, 7);
+    SetEntry(file, 0, file.size() - 7, 7);
+    SetEntry(file, 2, c_headerSize + 3 * c_entrySize, 14);
+    CHECK(SUCCEEDED(PackedSequence::Parse(file.data(), file.size(), format, &encoding, frames)));
+    CHECK(encoding == PackedSequence::Encoding::Png);
+    CHECK(format.frameSize == 4 * 2 * 4);
+    CHECK(frames[0].offset == file.size() - 7 && frames[2].size == 14);
+}
+
+TEST(PackedSequenceRejectsBadHeaders)
+{
+    std::vector<PackedSequence::Frame> frames;
+
+    Header header;
+    header.magic = "FSEX";
+    CHECK(Parse(MakePacked(header), frames) == MF_E_INVALID_FILE_FORMAT);
+
+    header = Header();
+    header.version = 2;
+    CHECK(Parse(MakePacked(header), frames) == MF_E_INVALID_FILE_FORMAT);
+
+    header = Header();
+    header.encoding = 2;
+    CHECK(Parse(MakePacked(header), frames) == MF_E_INVALIDMEDIATYPE);
+
+    // no frames, or a rate with a zero in it
+    for (int field = 0; field < 3; ++field)
+    {
+        header = Header();
+        (field == 0 ? header.frameCount : field == 1 ? header.frameRateNumerator : header.frameRateDenominator) = 0;
+        CHECK(Parse(MakePacked(header, 1), frames) == MF_E_INVALID_FILE_FORMAT);
+    }
+
+    // no pixels, or a frame past 4 gb
+    header = Header();
+    header.encoding = 1;
+    header.width = 0;
+    CHECK(Parse(MakePacked(header, 1), frames) == MF_E_INVALIDMEDIATYPE);
+    header.width = 65536;
+    header.height = 16384;
+    CHECK(Parse(MakePacked(header, 1), frames) == MF_E_INVALIDMEDIATYPE);
+    header.height = 16383;
+    CHECK(SUCCEEDED(Parse(MakePacked(header, 1), frames)));
+}
+
+TEST(PackedSequenceRejectsATruncatedIndex)
+{
+    std::vector<PackedSequence::Frame> frames;
+
+    Header header;
+    header.encoding = 1;
+    header.frameCount = 4;
+    auto file = MakePacked(header, 8);
+
+    // cut in the header, in the index, or the index only just fits with no room for frames
+    for (uint64_t size : { uint64_t(0), c_headerSize - 1, c_headerSize, c_headerSize + 4 * c_entrySize - 1, c_headerSize + 4 * c_entrySize })
+    {
+        std::vector<uint8_t> truncated(file.begin(), file.begin() + size);
+        CHECK(Parse(truncated, frames) == MF_E_INVALID_FILE_FORMAT);
+        CHECK(frames.empty());
+    }
+
+    // a count that promises more entries than the file holds
+    header.frameCount = UINT32_MAX;
+    file = MakePacked(Header(), 0);
+    memcpy(file.data() + 24, &header.frameCount, 4);
+    CHECK(Parse(file, frames) == MF_E_INVALID_FILE_FORMAT);
+
+    // the whole file minus the last byte of the last frame
+    file = MakePacked(Header());
+    file.pop_back();
+    CHECK(Parse(file, frames) == MF_E_INVALID_FILE_FORMAT);
+}
+
+TEST(PackedSequenceKeepsFramesInsideTheFile)
+{
+    std::vector<PackedSequence::Frame> frames;
+
+    Header header;
+    header.encoding = 1;
+    auto valid = MakePacked(header, 8);
+    uint64_t indexEnd = c_headerSize + 3 * c_entrySize;
+    uint64_t size = valid.size();
+
+    // a frame may end exactly at the end of the file, and start right after the index
+    auto file = valid;
+    SetEntry(file, 1, size - 8, 8);
+    SetEntry(file, 2, indexEnd, 1);
+    CHECK(SUCCEEDED(Parse(file, frames)));
+    CHECK(frames.size() == 3);
+
+    struct Case { uint64_t offset; uint32_t size; };
+    Case const corrupt[] =
+    {
+        { size - 8, 9 },                    // one byte past the end
+        { size, 1 },                        // starts at the end
+        { size + 1, 0 },                    // past the end with nothing to read
+        { indexEnd - 1, 8 },                // overlaps the index
+        { 0, 8 },                           // the header
+        { indexEnd, 0 },                    // empty
+        { UINT64_MAX - 3, 8 },              // offset + size wraps to 4, inside the file
+        { UINT64_MAX, UINT32_MAX },
+        { 1ull << 63, 8 },
+    };
+
+    // any one bad entry fails the whole file, wherever it is in the index
+    for (auto const& entry : corrupt)
+    {
+        for (uint32_t index = 0; index < 3; ++index)
+        {
+            file = valid;
+            SetEntry(file, index, entry.offset, entry.size);
+            CHECK(Parse(file, frames) == MF_E_INVALID_FILE_FORMAT);
+            CHECK(frames.empty());
+        }
+    }
+}
+
+TEST(PackedSequenceNeedsWholeRawFrames)
+{
+    std::vector<PackedSequence::Frame> frames;
+
+    // raw frames are handed out as they are, shorter or longer than width * height * 4 is corrupt
+    for (uint32_t frameSize : { 4u * 2 * 4 - 1, 4u * 2 * 4 + 1 })
+    {
+        CHECK(Parse(MakePacked(Header(), frameSize), frames) == MF_E_INVALID_FILE_FORMAT);
+    }
+
+    auto file = MakePacked(Header());
+    SetEntry(file, 2, c_headerSize + 3 * c_entrySize, 4 * 2 * 4 - 4);
+    CHECK(Parse(file, frames) == MF_E_INVALID_FILE_FORMAT);
+}
+
+BENCHMARK(PackedSequenceParseThroughput)
+{
+    // what opening a packed file costs before the first frame, the index is the whole of it
+    for (uint32_t frameCount : { 1000u, 100000u })
+    {
+        Header header;
+        header.width = 16;
+        header.height = 16;
+        header.frameCount = frameCount;
+        auto file = MakePacked(header);
+
+        uint32_t parses = 20000000 / frameCount;
+        RawFrameReader::Format format{};
+        PackedSequence::Encoding encoding = PackedSequence::Encoding::Png;
+        std::vector<PackedSequence::Frame> frames;
+
+        int64_t start = Ticks();
+        for (uint32_t i = 0; i < parses; ++i)
+        {
+            CHECK(SUCCEEDED(PackedSequence::Parse(file.data(), file.size(), format, &encoding, frames)));
+        }
+        double ns = TicksToNs(Ticks() - start);
+
+        printf("  %6u frames  %8.1f us per index   %6.1f M entries/s\n",
+            frameCount,
+            ns / parses / 1000.0,
+            static_cast<double>(frameCount) * parses * 1e3 / ns);
+
+        CHECK(frames.size() == frameCount);
+    }
+}
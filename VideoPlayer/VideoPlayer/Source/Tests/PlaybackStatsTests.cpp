@@ -0,0 +1,222 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "PlaybackStats.h"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+static constexpr int64_t c_second = 10000000;
+static constexpr int64_t c_frameInterval = 333333;  // 30fps
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+// what VideoFrameAvailable records for a frame that was copied, time runs at 60fps so the
+// rate window is crossed once a second like in playback
+static void RecordFrames(PlaybackStats& stats, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; ++i)
+    {
+        stats.OnFrameAvailable();
+        stats.OnCopied((i % 64) * 500, c_second + static_cast<int64_t>(i) * 166666);
+    }
+}
+
+TEST(PlaybackStatsCountsAndBucketsCopies)
+{
+    PlaybackStats stats;
+
+    PLAYBACK_STATS result{};
+    stats.Get(&result);
+    CHECK(result.framesCopied == 0);
+    CHECK(result.copyMsAverage == 0.0f);
+
+    stats.OnFrameAvailable();
+    stats.OnFrameAvailable();
+    stats.OnFrameAvailable();
+    stats.OnCopyFailed();
+
+    // the bucket limits are exclusive, 0.25ms is the second bucket
+    stats.OnCopied(0, c_second);
+    stats.OnCopied(2500, c_second);
+    stats.OnCopied(4999, c_second);
+    stats.OnCopied(160000, c_second);
+    stats.OnCopied(1000000, c_second);
+
+    stats.Get(&result);
+    CHECK(result.framesAvailable == 3);
+    CHECK(result.framesCopied == 5);
+    CHECK(result.framesFailed == 1);
+    CHECK(result.copyHistogram[0] == 1);
+    CHECK(result.copyHistogram[1] == 2);
+    CHECK(result.copyHistogram[2] == 0);
+    CHECK(result.copyHistogram[PLAYBACK_STATS_COPY_BUCKETS - 1] == 2);
+    CHECK(std::abs(result.copyMsMax - 100.0f) < 0.001f);
+    CHECK(std::abs(result.copyMsAverage - (2500 + 4999 + 160000 + 1000000) / 10000.0f / 5) < 0.001f);
+
+    // the ring counters are not ours to fill
+    CHECK(result.framesDropped == 0);
+    CHECK(result.framesStalled == 0);
+
+    stats.Reset();
+    stats.Get(&result);
+    CHECK(result.framesAvailable == 0);
+    CHECK(result.framesCopied == 0);
+    CHECK(result.framesFailed == 0);
+    CHECK(result.copyMsMax == 0.0f);
+    CHECK(result.copyHistogram[PLAYBACK_STATS_COPY_BUCKETS - 1] == 0);
+}
+
+TEST(PlaybackStatsMeasuresTheRateOverFullSeconds)
+{
+    PlaybackStats stats;
+
+    PLAYBACK_STATS result{};
+
+    int64_t time = 5 * c_second;
+    stats.OnCopied(0, time);
+
+    // nothing until a whole second has gone by
+    for (int i = 0; i < 30; ++i)
+    {
+        time += c_frameInterval;
+        stats.OnCopied(0, time);
+    }
+    stats.Get(&result);
+    CHECK(result.effectiveFps == 0.0f);
+
+    time += c_frameInterval;
+    stats.OnCopied(0, time);
+    stats.Get(&result);
+    CHECK(std::abs(result.effectiveFps - 30.0f) < 0.1f);
+
+    // the next second at half the rate
+    for (int i = 0; i < 16; ++i)
+    {
+        time += 2 * c_frameInterval;
+        stats.OnCopied(0, time);
+    }
+    stats.Get(&result);
+    CHECK(std::abs(result.effectiveFps - 15.0f) < 0.1f);
+}
+
+// producers update without a lock, nothing may be lost
+TEST(PlaybackStatsLosesNothingUnderContention)
+{
+    constexpr uint32_t c_threads = 4;
+    constexpr uint32_t c_frames = 20000;
+
+    PlaybackStats stats;
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < c_threads; ++t)
+    {
+        threads.emplace_back([&stats, t]
+            {
+                for (uint32_t i = 0; i < c_frames; ++i)
+                {
+                    stats.OnFrameAvailable();
+                    stats.OnCopied((i % 200) * 1000 + t, c_second + i * 1000);
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    PLAYBACK_STATS result{};
+    stats.Get(&result);
+
+    uint64_t histogram = 0;
+    for (auto bucket : result.copyHistogram)
+    {
+        histogram += bucket;
+    }
+
+    CHECK(result.framesAvailable == c_threads * c_frames);
+    CHECK(result.framesCopied == c_threads * c_frames);
+    CHECK(histogram == c_threads * c_frames);
+    CHECK(std::abs(result.copyMsMax - (199000 + c_threads - 1) / 10000.0f) < 0.001f);
+}
+
+BENCHMARK(PlaybackStatsRecordFrame)
+{
+    constexpr uint32_t c_frames = 2000000;
+
+    // the frame server thread alone
+    {
+        PlaybackStats stats;
+
+        int64_t start = Ticks();
+        RecordFrames(stats, c_frames);
+        int64_t elapsed = Ticks() - start;
+
+        PLAYBACK_STATS result{};
+        stats.Get(&result);
+        CHECK(result.framesCopied == c_frames);
+
+        printf("  alone                %6.1f ns per frame\n", TicksToNs(elapsed) / c_frames);
+    }
+
+    // with MediaPlayerGetStats polled as fast as it goes from another thread, the cache
+    // lines the reader pulls over are what the producer pays for
+    {
+        PlaybackStats stats;
+
+        std::atomic<bool> done = false;
+        std::atomic<bool> started = false;
+        uint64_t reads = 0;
+        int64_t readTicks = 0;
+        std::thread reader([&]
+            {
+                started = true;
+
+                PLAYBACK_STATS result{};
+                while (!done)
+                {
+                    int64_t readStart = Ticks();
+                    stats.Get(&result);
+                    readTicks += Ticks() - readStart;
+                    ++reads;
+                }
+            });
+
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+
+        int64_t start = Ticks();
+        RecordFrames(stats, c_frames);
+        int64_t elapsed = Ticks() - start;
+
+        done = true;
+        reader.join();
+
+        PLAYBACK_STATS result{};
+        stats.Get(&result);
+        CHECK(result.framesCopied == c_frames);
+
+        printf("  with a Get() reader  %6.1f ns per frame   %llu reads, %6.1f ns per Get()\n",
+            TicksToNs(elapsed) / c_frames,
+            static_cast<unsigned long long>(reads),
+            reads > 0 ? TicksToNs(readTicks) / reads : 0.0);
+    }
+}
@@ -0,0 +1,341 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "RectPacker.h"
+
+#include <random>
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+static bool Overlaps(RectPacker::Rect const& a, RectPacker::Rect const& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static bool Equal(RectPacker::Rect const& rect, uint32_t x, uint32_t y)
+{
+    return rect.x == x && rect.y == y;
+}
+
+TEST(RectPackerFillsShelvesAndReusesFreedSpace)
+{
+    RectPacker packer;
+    packer.Reset(100, 100);
+
+    uint32_t id = 0;
+    RectPacker::Rect rect{};
+    CHECK(packer.Allocate(40, 20, &id, &rect) && id == 1 && Equal(rect, 0, 0));
+    CHECK(packer.Allocate(40, 20, &id, &rect) && id == 2 && Equal(rect, 40, 0));
+
+    // the rest of the first shelf is too narrow, a new one opens above it
+    CHECK(packer.Allocate(40, 20, &id, &rect) && Equal(rect, 0, 20));
+
+    // much shorter than any shelf, gets its own instead of wasting height
+    CHECK(packer.Allocate(30, 10, &id, &rect) && Equal(rect, 0, 40));
+    CHECK(packer.UsedArea() == 3 * 40 * 20 + 30 * 10);
+
+    // freed space merges with the free span next to it
+    packer.Free(2);
+    CHECK(!packer.Get(2, &rect));
+    CHECK(packer.Allocate(60, 20, &id, &rect) && id == 5 && Equal(rect, 40, 0));
+
+    CHECK(packer.Get(1, &rect) && Equal(rect, 0, 0) && rect.width == 40 && rect.height == 20);
+}
+
+TEST(RectPackerRejectsWhatCannotFit)
+{
+    RectPacker packer;
+    packer.Reset(64, 64);
+
+    uint32_t id = 7;
+    RectPacker::Rect rect{ 1, 1, 1, 1 };
+    CHECK(!packer.Allocate(0, 5, &id, &rect));
+    CHECK(id == 0 && rect.width == 0);
+    CHECK(!packer.Allocate(65, 1, &id, &rect));
+
+    uint32_t full = 0;
+    CHECK(packer.Allocate(64, 64, &full, &rect));
+    CHECK(!packer.Allocate(1, 1, &id, &rect));
+
+    // an empty shelf at the top gives its height back
+    packer.Free(full);
+    CHECK(packer.UsedArea() == 0);
+    CHECK(packer.Allocate(64, 64, &id, &rect) && Equal(rect, 0, 0));
+
+    // unknown ids are ignored
+    packer.Free(1234);
+    CHECK(packer.UsedArea() == 64 * 64);
+
+    packer.Reset(64, 64);
+    CHECK(packer.UsedArea() == 0);
+    CHECK(!packer.Get(id, &rect));
+}
+
+TEST(RectPackerDefragmentRecoversHoles)
+{
+    RectPacker packer;
+    packer.Reset(100, 100);
+
+    uint32_t ids[4] = {};
+    RectPacker::Rect rect{};
+    for (auto& id : ids)
+    {
+        CHECK(packer.Allocate(50, 50, &id, &rect));
+    }
+
+    // two holes of the right total size, neither wide enough
+    packer.Free(ids[0]);
+    packer.Free(ids[3]);
+
+    uint32_t id = 0;
+    CHECK(!packer.Allocate(100, 50, &id, &rect));
+
+    auto moves = packer.Defragment();
+    CHECK(moves.size() == 2);
+    CHECK(moves[0].id == ids[1] && Equal(moves[0].from, 50, 0) && Equal(moves[0].to, 0, 0));
+    CHECK(moves[1].id == ids[2] && Equal(moves[1].from, 0, 50) && Equal(moves[1].to, 50, 0));
+
+    // the ids stay valid at their new place
+    CHECK(packer.Get(ids[2], &rect) && Equal(rect, 50, 0));
+    CHECK(packer.Allocate(100, 50, &id, &rect) && Equal(rect, 0, 50));
+
+    // repacked widest first, after that the layout is stable
+    CHECK(!packer.Defragment().empty());
+    CHECK(packer.Defragment().empty());
+    CHECK(packer.UsedArea() == 100 * 100);
+}
+
+// random sizes allocated and freed, whatever is allocated stays inside the texture and never
+// overlaps anything else, before and after defragmenting
+TEST(RectPackerNeverOverlaps)
+{
+    constexpr uint32_t c_size = 1024;
+
+    std::mt19937 random(5);
+    std::uniform_int_distribution<uint32_t> side(8, 300);
+    std::uniform_int_distribution<uint32_t> action(0, 9);
+
+    RectPacker packer;
+    packer.Reset(c_size, c_size);
+
+    std::vector<uint32_t> live;
+    uint32_t failures = 0;
+    uint32_t broken = 0;
+
+    auto verify = [&]
+    {
+        uint64_t area = 0;
+        std::vector<RectPacker::Rect> rects;
+        for (auto id : live)
+        {
+            RectPacker::Rect rect{};
+            if (!packer.Get(id, &rect) || rect.x + rect.width > c_size || rect.y + rect.height > c_size)
+            {
+                ++broken;
+                continue;
+            }
+
+            for (auto const& other : rects)
+            {
+                if (Overlaps(rect, other))
+                {
+                    ++broken;
+                }
+            }
+
+            rects.push_back(rect);
+            area += static_cast<uint64_t>(rect.width) * rect.height;
+        }
+
+        if (area != packer.UsedArea())
+        {
+            ++broken;
+        }
+    };
+
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        if (action(random) < 4 && !live.empty())
+        {
+            size_t index = random() % live.size();
+            packer.Free(live[index]);
+            live.erase(live.begin() + index);
+        }
+        else
+        {
+            uint32_t id = 0;
+            RectPacker::Rect rect{};
+            if (!packer.Allocate(side(random), side(random), &id, &rect))
+            {
+                ++failures;
+                packer.Defragment();
+                verify();
+                continue;
+            }
+
+            live.push_back(id);
+        }
+
+        if (i % 50 == 0)
+        {
+            verify();
+        }
+    }
+
+    verify();
+
+    printf("  %zu live, %u failed allocations, %.0f%% used\n", live.size(), failures, 100.0 * packer.UsedArea() / (c_size * c_size));
+
+    CHECK(failures > 0);
+    CHECK(broken == 0);
+}
+
+// tile sized rects in an atlas sized packer, the mix of video sizes a tiled player sees
+static void RandomTile(std::mt19937& random, uint32_t* width, uint32_t* height)
+{
+    static uint32_t const c_sizes[][2] = { { 256, 144 }, { 320, 180 }, { 480, 270 }, { 640, 360 }, { 200, 200 } };
+
+    auto const& size = c_sizes[random() % _countof(c_sizes)];
+    *width = size[0];
+    *height = size[1];
+}
+
+// fills to the first failure, then frees one random tile and allocates another, what
+// tiles coming and going cost once the atlas is busy. a failed allocation defragments and
+// tries again like VideoAtlas does, that is part of the allocate time
+BENCHMARK(RectPackerChurn)
+{
+    constexpr uint32_t c_size = 4096;
+    constexpr uint32_t c_rounds = 200000;
+
+    std::mt19937 random(7);
+
+    RectPacker packer;
+    packer.Reset(c_size, c_size);
+
+    std::vector<uint32_t> live;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t id = 0;
+    RectPacker::Rect rect{};
+    for (RandomTile(random, &width, &height); packer.Allocate(width, height, &id, &rect); RandomTile(random, &width, &height))
+    {
+        live.push_back(id);
+    }
+
+    printf("  %zu tiles, %.0f%% used\n", live.size(), 100.0 * packer.UsedArea() / (static_cast<double>(c_size) * c_size));
+
+    int64_t freeTicks = 0;
+    int64_t allocateTicks = 0;
+    uint32_t defragments = 0;
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < c_rounds; ++i)
+    {
+        size_t index = random() % live.size();
+        RandomTile(random, &width, &height);
+
+        int64_t start = Ticks();
+        packer.Free(live[index]);
+        int64_t freed = Ticks();
+        bool allocated = packer.Allocate(width, height, &id, &rect);
+        if (!allocated)
+        {
+            ++defragments;
+            packer.Defragment();
+            allocated = packer.Allocate(width, height, &id, &rect);
+        }
+        int64_t end = Ticks();
+
+        freeTicks += freed - start;
+        allocateTicks += end - freed;
+
+        if (allocated)
+        {
+            live[index] = id;
+        }
+        else
+        {
+            ++failures;
+            live.erase(live.begin() + index);
+        }
+    }
+
+    printf("  Free %7.1f ns   Allocate %7.1f ns   %u defragments, %u of %u allocations failed\n",
+        TicksToNs(freeTicks) / c_rounds,
+        TicksToNs(allocateTicks) / c_rounds,
+        defragments,
+        failures,
+        c_rounds);
+    printf("  %zu tiles, %.0f%% used after churn\n", live.size(), 100.0 * packer.UsedArea() / (static_cast<double>(c_size) * c_size));
+
+    CHECK(!live.empty());
+}
+
+// a full atlas with every other tile freed, the holes are there but mostly too small,
+// only the Defragment call is timed
+BENCHMARK(RectPackerDefragment)
+{
+    constexpr uint32_t c_size = 4096;
+    constexpr uint32_t c_runs = 50;
+
+    std::mt19937 random(11);
+
+    int64_t ticks = 0;
+    size_t moves = 0;
+    size_t tiles = 0;
+    uint32_t recovered = 0;
+    for (uint32_t run = 0; run < c_runs; ++run)
+    {
+        RectPacker packer;
+        packer.Reset(c_size, c_size);
+
+        std::vector<uint32_t> live;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t id = 0;
+        RectPacker::Rect rect{};
+        for (RandomTile(random, &width, &height); packer.Allocate(width, height, &id, &rect); RandomTile(random, &width, &height))
+        {
+            live.push_back(id);
+        }
+
+        for (size_t i = 0; i < live.size(); i += 2)
+        {
+            packer.Free(live[i]);
+        }
+        tiles += live.size() / 2;
+
+        int64_t start = Ticks();
+        moves += packer.Defragment().size();
+        ticks += Ticks() - start;
+
+        // the largest tile fits again once the holes are joined
+        if (packer.Allocate(640, 360, &id, &rect))
+        {
+            ++recovered;
+        }
+    }
+
+    printf("  %7.1f us per Defragment of %zu tiles, %zu moves, %u of %u runs fit a 640x360 after\n",
+        TicksToNs(ticks) / 1000.0 / c_runs,
+        tiles / c_runs,
+        moves / c_runs,
+        recovered,
+        c_runs);
+
+    CHECK(recovered == c_runs);
+}
@@ -0,0 +1,196 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Resampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// a bgra image of noise, the same one for the same seed
+static std::vector<uint8_t> NoiseImage(uint32_t width, uint32_t height, uint32_t seed)
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (auto& value : pixels)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        value = static_cast<uint8_t>(seed >> 24);
+    }
+
+    return pixels;
+}
+
+// the same area average in doubles, every source pixel weighted by how much of the output
+// pixel it covers
+static std::vector<uint8_t> ReferenceResample(std::vector<uint8_t> const& source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4);
+
+    double scaleX = static_cast<double>(sourceWidth) / width;
+    double scaleY = static_cast<double>(sourceHeight) / height;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        double top = y * scaleY;
+        double bottom = (y + 1) * scaleY;
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            double left = x * scaleX;
+            double right = (x + 1) * scaleX;
+
+            double sum[3] = {};
+            double area = 0.0;
+            for (uint32_t sy = static_cast<uint32_t>(top); sy < std::min<double>(sourceHeight, std::ceil(bottom)); ++sy)
+            {
+                double coverY = std::min(bottom, sy + 1.0) - std::max(top, static_cast<double>(sy));
+                for (uint32_t sx = static_cast<uint32_t>(left); sx < std::min<double>(sourceWidth, std::ceil(right)); ++sx)
+                {
+                    double cover = coverY * (std::min(right, sx + 1.0) - std::max(left, static_cast<double>(sx)));
+                    uint8_t const* pixel = source.data() + (static_cast<size_t>(sy) * sourceWidth + sx) * 4;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        sum[c] += pixel[c] * cover;
+                    }
+                    area += cover;
+                }
+            }
+
+            uint8_t* out = result.data() + (static_cast<size_t>(y) * width + x) * 4;
+            for (int c = 0; c < 3; ++c)
+            {
+                out[c] = static_cast<uint8_t>(std::lround(sum[c] / area));
+            }
+            out[3] = 0xff;
+        }
+    }
+
+    return result;
+}
+
+// largest difference of any channel
+static int MaxDifference(std::vector<uint8_t> const& a, std::vector<uint8_t> const& b)
+{
+    int difference = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        difference = std::max(difference, std::abs(a[i] - b[i]));
+    }
+
+    return difference;
+}
+
+static std::vector<uint8_t> Resample(Resampler& resampler, std::vector<uint8_t> const& source, uint32_t sourceWidth, uint32_t sourceHeight, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> result(static_cast<size_t>(width) * height * 4, 0xcd);
+    resampler.Resample(source.data(), sourceWidth, sourceHeight, sourceWidth * 4, result.data(), width, height, width * 4);
+
+    return result;
+}
+
+TEST(ResamplerKeepsFlatImagesExact)
+{
+    Resampler resampler;
+
+    // the weights of every output sum to exactly one, whatever the ratio
+    for (auto size : { std::make_pair(1920u, 1080u), std::make_pair(101u, 67u), std::make_pair(3u, 7u) })
+    {
+        std::vector<uint8_t> source(static_cast<size_t>(size.first) * size.second * 4);
+        for (size_t i = 0; i < source.size(); i += 4)
+        {
+            source[i + 0] = 255;
+            source[i + 1] = 17;
+            source[i + 2] = 128;
+            source[i + 3] = 3;
+        }
+
+        for (auto target : { std::make_pair(160u, 90u), std::make_pair(37u, 29u), std::make_pair(size.first * 2, size.second * 2) })
+        {
+            auto result = Resample(resampler, source, size.first, size.second, target.first, target.second);
+
+            bool exact = true;
+            for (size_t i = 0; i < result.size(); i += 4)
+            {
+                exact = exact && result[i + 0] == 255 && result[i + 1] == 17 && result[i + 2] == 128 && result[i + 3] == 0xff;
+            }
+            CHECK(exact);
+        }
+    }
+}
+
+TEST(ResamplerMatchesTheAreaAverage)
+{
+    Resampler resampler;
+
+    // fixed point rounding is at most one step off the exact mean
+    struct Case { uint32_t sourceWidth, sourceHeight, width, height; };
+    for (auto const& c : { Case{ 640, 360, 160, 90 }, Case{ 333, 197, 64, 48 }, Case{ 97, 61, 41, 59 }, Case{ 16, 16, 5, 3 } })
+    {
+        auto source = NoiseImage(c.sourceWidth, c.sourceHeight, c.sourceWidth);
+
+        auto result = Resample(resampler, source, c.sourceWidth, c.sourceHeight, c.width, c.height);
+        CHECK(MaxDifference(result, ReferenceResample(source, c.sourceWidth, c.sourceHeight, c.width, c.height)) <= 1);
+    }
+}
+
+TEST(ResamplerHandlesSingleRowsAndColumns)
+{
+    Resampler resampler;
+
+    // 1xN and Nx1 in and out, one axis averages while the other is a single tap
+    struct Case { uint32_t sourceWidth, sourceHeight, width, height; };
+    for (auto const& c : { Case{ 1, 300, 1, 40 }, Case{ 300, 1, 40, 1 }, Case{ 1, 300, 8, 8 }, Case{ 300, 1, 8, 8 }, Case{ 64, 64, 1, 1 }, Case{ 1, 1, 3, 2 } })
+    {
+        auto source = NoiseImage(c.sourceWidth, c.sourceHeight, 7);
+
+        auto result = Resample(resampler, source, c.sourceWidth, c.sourceHeight, c.width, c.height);
+        CHECK(MaxDifference(result, ReferenceResample(source, c.sourceWidth, c.sourceHeight, c.width, c.height)) <= 1);
+    }
+}
+
+TEST(ResamplerUpscales)
+{
+    Resampler resampler;
+
+    // a whole ratio repeats every source pixel exactly
+    auto source = NoiseImage(5, 4, 11);
+    auto result = Resample(resampler, source, 5, 4, 15, 8);
+
+    bool exact = true;
+    for (uint32_t y = 0; y < 8; ++y)
+    {
+        for (uint32_t x = 0; x < 15; ++x)
+        {
+            uint8_t const* in = source.data() + ((y / 2) * 5 + x / 3) * 4;
+            uint8_t const* out = result.data() + (y * 15 + x) * 4;
+            exact = exact && in[0] == out[0] && in[1] == out[1] && in[2] == out[2] && out[3] == 0xff;
+        }
+    }
+    CHECK(exact);
+
+    // any other blends the pixels the output straddles
+    result = Resample(resampler, source, 5, 4, 7, 9);
+    CHECK(MaxDifference(result, ReferenceResample(source, 5, 4, 7, 9)) <= 1);
+}
+
+TEST(ResamplerReadsBottomUpImages)
+{
+    constexpr uint32_t c_width = 123;
+    constexpr uint32_t c_height = 77;
+    constexpr uint32_t c_stride = c_width * 4 + 20;
+
+    auto topDown = NoiseImage(c_width, c_height, 5);
+
+    // the same rows stored last first with padding, scanline 0 is the last row in memory
+    std::vector<uint8_t> bottomUp(static_cast<size_t>(c_stride) * c_height, 0xee);
+    for (uint32_t y = 0; y < c_height; ++y)
+    {
+        memcpy(bottomUp.data() + static_cast<size_t>(c_height - 1 - y) * c_stride, topDown.data() + static_cast<size_t>(y) * c_width * 4, c_width * 4);
+    }
+
+    Resampler resampler;
+    auto expected = Resample(resampler, topDown, c_width, c_height, 40, 30);
+
+    std::vector<uint8_t> result(40 * 30 * 4);
+    resampler.Resample(bottomUp.data() + static_cast<size_t>(c_height - 1) * c_stride, c_width, c_height, -static_cast<int32_t>(c_stride), result.data(), 40, 30, 40 * 4);
+    CHECK(result == expected);
+}
@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// just enough of a test runner for the classes in Shared with no platform dependency.
+// TEST bodies register themselves and run in file order, a failed CHECK is reported and the
+// test carries on. BENCHMARK bodies only run with -bench and print their own numbers
+struct TestCase
+{
+    char const* name;
+    void (*run)();
+    bool benchmark;
+};
+
+std::vector<TestCase>& TestCases();
+
+void TestFailed(
+    _In_z_ char const* file,
+    _In_ int line,
+    _In_z_ char const* expression);
+
+struct TestRegistration
+{
+    TestRegistration(char const* name, void (*run)(), bool benchmark)
+    {
+        TestCases().push_back({ name, run, benchmark });
+    }
+};
+
+#define TEST(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name, false); \
+    static void name()
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static TestRegistration name##Registration(#name, name, true); \
+    static void name()
+
+#define CHECK(expression) \
+    do { if (!(expression)) { TestFailed(__FILE__, __LINE__, #expression); } } while (false)
@@ -0,0 +1,314 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "ThumbnailPool.h"
+
+#include <mferror.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// what every StubDecoder of a pool shares, so a test can see and hold up its workers
+struct StubDecoderState
+{
+    std::atomic<uint32_t> opened = 0;
+    std::atomic<uint32_t> decoded = 0;
+    std::atomic<uint32_t> destroyed = 0;
+
+    // DecodeKeyframe() waits here while the gate is shut
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool gateOpen = true;
+    uint32_t waiting = 0;
+};
+
+// a file with a keyframe every 10 ticks, every pixel of a keyframe is its number. a location
+// of "missing" does not open
+struct StubDecoder : ThumbnailDecoder
+{
+    static constexpr uint32_t c_width = 64;
+    static constexpr uint32_t c_height = 36;
+
+    explicit StubDecoder(std::shared_ptr<StubDecoderState> const& state)
+        : m_state(state)
+        , m_pixels(c_width * c_height * 4)
+    {
+    }
+
+    ~StubDecoder()
+    {
+        ++m_state->destroyed;
+    }
+
+    HRESULT Open(
+        _In_ winrt::hstring const& location) override
+    {
+        ++m_state->opened;
+
+        return location == L"missing" ? E_ACCESSDENIED : S_OK;
+    }
+
+    HRESULT DecodeKeyframe(
+        _In_ int64_t position,
+        _Out_ int64_t* timestamp,
+        _Out_ Frame* frame) override
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_state->mutex);
+
+            ++m_state->waiting;
+            m_state->changed.notify_all();
+            m_state->changed.wait(lock, [this] { return m_state->gateOpen; });
+            --m_state->waiting;
+        }
+
+        ++m_state->decoded;
+
+        *timestamp = position - position % 10;
+        std::fill(m_pixels.begin(), m_pixels.end(), static_cast<uint8_t>(*timestamp / 10));
+        *frame = Frame{ m_pixels.data(), static_cast<int32_t>(c_width * 4), c_width, c_height };
+
+        return S_OK;
+    }
+
+private:
+    std::shared_ptr<StubDecoderState> m_state;
+    std::vector<uint8_t> m_pixels;
+};
+
+// what the handler saw, in the order it saw it
+struct Reports
+{
+    std::mutex mutex;
+    std::vector<THUMBNAIL_STATE> states;
+    std::vector<std::vector<uint8_t>> pixels;
+
+    size_t Count()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return states.size();
+    }
+
+    // false if they never all came
+    bool WaitFor(size_t count)
+    {
+        for (int i = 0; i < 1000 && Count() < count; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        return Count() == count;
+    }
+};
+
+static std::shared_ptr<ThumbnailPool> StartPool(
+    uint32_t maxPending,
+    std::shared_ptr<StubDecoderState> const& decoderState,
+    Reports& reports,
+    bool complete)
+{
+    auto pool = std::make_shared<ThumbnailPool>();
+    std::weak_ptr<ThumbnailPool> weakPool = pool;
+
+    HRESULT hr = pool->Start(
+        1,
+        maxPending,
+        [decoderState]() { return std::unique_ptr<ThumbnailDecoder>(new StubDecoder(decoderState)); },
+        [&reports, weakPool, complete](ThumbnailPool::Batch const&, THUMBNAIL_STATE const& state, std::vector<uint8_t>&& pixels)
+        {
+            {
+                std::lock_guard<std::mutex> lock(reports.mutex);
+                reports.states.push_back(state);
+                reports.pixels.push_back(std::move(pixels));
+            }
+
+            auto strongPool = weakPool.lock();
+            if (complete && strongPool != nullptr)
+            {
+                strongPool->Complete(state);
+            }
+        });
+
+    return SUCCEEDED(hr) ? pool : nullptr;
+}
+
+static ThumbnailPool::Batch MakeBatch(wchar_t const* location, std::vector<int64_t> const& timestamps, uint8_t* buffer)
+{
+    return ThumbnailPool::Batch{ 0, location, timestamps, 8, 6, buffer, 0 };
+}
+
+TEST(ThumbnailPoolExtractsInTimeOrderAndReusesKeyframes)
+{
+    auto decoderState = std::make_shared<StubDecoderState>();
+    Reports reports;
+    auto pool = StartPool(64, decoderState, reports, true);
+    CHECK(pool != nullptr);
+
+    // 35, 31 and 38 land on the same keyframe, it is scaled once and copied twice
+    std::vector<int64_t> timestamps = { 35, 5, 31, 12, 38 };
+    std::vector<uint8_t> buffer(8 * 6 * 4 * timestamps.size());
+
+    uint32_t batchId = 0;
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", timestamps, buffer.data()), &batchId)));
+    CHECK(batchId == 1);
+    CHECK(reports.WaitFor(timestamps.size()));
+
+    uint32_t const expectedOrder[] = { 1, 3, 2, 0, 4 };
+    for (uint32_t i = 0; i < timestamps.size(); ++i)
+    {
+        auto const& state = reports.states[i];
+        CHECK(state.batchId == batchId);
+        CHECK(state.index == expectedOrder[i]);
+        CHECK(state.hresult == S_OK);
+        CHECK(state.remaining == timestamps.size() - i - 1);
+        CHECK(state.requested == timestamps[state.index]);
+        CHECK(state.timestamp == state.requested - state.requested % 10);
+
+        // written into the batch's buffer, nothing handed over
+        CHECK(reports.pixels[i].empty());
+        uint8_t const* thumbnail = buffer.data() + 8 * 6 * 4 * state.index;
+        CHECK(thumbnail[0] == state.timestamp / 10 && thumbnail[8 * 6 * 4 - 1] == 0xff);
+    }
+
+    THUMBNAIL_STATS stats{};
+    pool->GetStats(&stats);
+    CHECK(stats.workerCount == 1);
+    CHECK(stats.pending == 0);
+    CHECK(stats.completed == timestamps.size());
+    CHECK(stats.failed == 0);
+    CHECK(stats.decoded == 3);
+
+    // without a buffer the pixels are handed to the handler
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 21, 27 }, nullptr), &batchId)));
+    CHECK(batchId == 2);
+    CHECK(reports.WaitFor(timestamps.size() + 2));
+    for (size_t i = timestamps.size(); i < reports.states.size(); ++i)
+    {
+        CHECK(reports.pixels[i].size() == 8 * 6 * 4);
+        CHECK(reports.pixels[i][0] == 2);
+    }
+
+    pool->Shutdown();
+    CHECK(decoderState->opened == 2);
+    CHECK(decoderState->destroyed == 1);
+}
+
+TEST(ThumbnailPoolBoundsPendingThumbnails)
+{
+    auto decoderState = std::make_shared<StubDecoderState>();
+    Reports reports;
+
+    // nothing is completed by the handler, extracted thumbnails stay pending until the test says
+    auto pool = StartPool(4, decoderState, reports, false);
+    CHECK(pool != nullptr);
+
+    uint32_t batchId = 0;
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 1, 2, 3 }, nullptr), &batchId)));
+    CHECK(pool->Add(MakeBatch(L"clip", { 4, 5 }, nullptr), &batchId) == MF_E_NOTACCEPTING);
+    CHECK(batchId == 0);
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 6 }, nullptr), &batchId)));
+
+    // extracted is not reported, the pool stays full
+    CHECK(reports.WaitFor(4));
+    CHECK(pool->Add(MakeBatch(L"clip", { 7 }, nullptr), &batchId) == MF_E_NOTACCEPTING);
+
+    pool->Complete(reports.states[0]);
+    pool->Complete(reports.states[1]);
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 8, 9 }, nullptr), &batchId)));
+    CHECK(reports.WaitFor(6));
+
+    THUMBNAIL_STATS stats{};
+    pool->GetStats(&stats);
+    CHECK(stats.pending == 4);
+
+    // larger than the bound is only taken once nothing else is pending
+    CHECK(pool->Add(MakeBatch(L"clip", { 1, 2, 3, 4, 5, 6 }, nullptr), &batchId) == MF_E_NOTACCEPTING);
+    for (size_t i = 2; i < 6; ++i)
+    {
+        pool->Complete(reports.states[i]);
+    }
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 1, 2, 3, 4, 5, 6 }, nullptr), &batchId)));
+    CHECK(reports.WaitFor(12));
+
+    pool->Shutdown();
+    CHECK(pool->Add(MakeBatch(L"clip", { 1 }, nullptr), &batchId) == MF_E_SHUTDOWN);
+}
+
+TEST(ThumbnailPoolShutdownCancelsQueuedAndRunningBatches)
+{
+    auto decoderState = std::make_shared<StubDecoderState>();
+    decoderState->gateOpen = false;
+
+    Reports reports;
+    auto pool = StartPool(64, decoderState, reports, true);
+    CHECK(pool != nullptr);
+
+    // the worker is held in the first batch's first decode, the second batch is queued
+    uint32_t batchId = 0;
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 10, 20, 30 }, nullptr), &batchId)));
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 40, 50 }, nullptr), &batchId)));
+    {
+        std::unique_lock<std::mutex> lock(decoderState->mutex);
+        decoderState->changed.wait(lock, [&] { return decoderState->waiting == 1; });
+    }
+
+    std::thread shutdown([&] { pool->Shutdown(); });
+
+    // Add() is turned away as soon as Shutdown() has started, then the decode is let go
+    while (pool->Add(MakeBatch(L"clip", { 1 }, nullptr), &batchId) != MF_E_SHUTDOWN)
+    {
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(decoderState->mutex);
+        decoderState->gateOpen = true;
+        decoderState->changed.notify_all();
+    }
+    shutdown.join();
+
+    // the running thumbnail finishes, the rest of its batch and the queued one never start
+    CHECK(reports.Count() == 1);
+    CHECK(reports.states[0].requested == 10);
+    CHECK(decoderState->opened == 1);
+    CHECK(decoderState->decoded == 1);
+    CHECK(decoderState->destroyed == 1);
+}
+
+TEST(ThumbnailPoolFailsEveryThumbnailOfAFileThatDoesNotOpen)
+{
+    auto decoderState = std::make_shared<StubDecoderState>();
+    Reports reports;
+    auto pool = StartPool(64, decoderState, reports, true);
+    CHECK(pool != nullptr);
+
+    std::vector<uint8_t> buffer(8 * 6 * 4 * 3);
+
+    uint32_t batchId = 0;
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"missing", { 30, 10, 20 }, buffer.data()), &batchId)));
+    CHECK(reports.WaitFor(3));
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        CHECK(reports.states[i].hresult == E_ACCESSDENIED);
+        CHECK(reports.states[i].remaining == 2 - i);
+    }
+    CHECK(decoderState->decoded == 0);
+
+    // the worker goes on with the next file
+    CHECK(SUCCEEDED(pool->Add(MakeBatch(L"clip", { 10 }, buffer.data()), &batchId)));
+    CHECK(reports.WaitFor(4));
+    CHECK(reports.states[3].hresult == S_OK);
+
+    THUMBNAIL_STATS stats{};
+    pool->GetStats(&stats);
+    CHECK(stats.failed == 3);
+    CHECK(stats.completed == 1);
+    CHECK(stats.pending == 0);
+
+    pool->Shutdown();
+}
@@ -0,0 +1,325 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+static constexpr int64_t c_second = 10000000;
+
+// 8x4 tiles of 45 degrees, the one right of the frame's center and above the horizon, and
+// the one at the left edge of the same row
+static constexpr uint32_t c_columns = 8;
+static constexpr uint32_t c_rows = 4;
+static constexpr uint32_t c_centerTile = 12;
+static constexpr uint32_t c_edgeTile = 8;
+
+// no margin and no prediction unless a test asks for them, the view alone picks the tiles
+static TileScheduler::Settings TestSettings(uint32_t maxActiveTiles)
+{
+    auto settings = TileScheduler::DefaultSettings();
+    settings.marginDegrees = 0.0f;
+    settings.lookahead = 0;
+    settings.maxActiveTiles = maxActiveTiles;
+
+    return settings;
+}
+
+// a 10 degree view inside one tile
+static TileScheduler::View TileView(int64_t time, uint32_t tile)
+{
+    float yaw = ((tile % c_columns) + 0.5f) * 360.0f / c_columns - 180.0f;
+    float pitch = 90.0f - ((tile / c_columns) + 0.5f) * 180.0f / c_rows;
+
+    return TileScheduler::View{ time, yaw, pitch, 10.0f, 10.0f };
+}
+
+static TILED_STATS Stats(TileScheduler const& scheduler)
+{
+    TILED_STATS stats{};
+    scheduler.GetStats(&stats);
+
+    return stats;
+}
+
+TEST(TileSchedulerRejectsBadLayouts)
+{
+    TileScheduler scheduler;
+
+    CHECK(scheduler.Reset(0, c_rows, TestSettings(4)) == E_INVALIDARG);
+    CHECK(scheduler.Reset(65, c_rows, TestSettings(4)) == E_INVALIDARG);
+    CHECK(scheduler.Reset(c_columns, 33, TestSettings(4)) == E_INVALIDARG);
+    CHECK(scheduler.Reset(c_columns, c_rows, TestSettings(0)) == E_INVALIDARG);
+
+    // not reset, an update has nothing to schedule
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(TileView(0, c_centerTile), start, stop);
+    CHECK(start.empty() && stop.empty());
+
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, TestSettings(4))));
+    CHECK(scheduler.TileCount() == 32);
+    CHECK(!scheduler.IsActive(scheduler.TileCount()));
+}
+
+TEST(TileSchedulerStartsTheViewWithinTheBudget)
+{
+    TileScheduler scheduler;
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, TestSettings(3))));
+
+    // straight ahead, the corners of four tiles meet in the middle of the view
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(TileScheduler::View{ c_second, 0.0f, 0.0f, 20.0f, 20.0f }, start, stop);
+
+    CHECK(start.size() == 3);
+    CHECK(stop.empty());
+
+    for (uint32_t tile : { 11u, 12u, 19u, 20u })
+    {
+        CHECK(scheduler.IsVisible(tile));
+    }
+
+    for (uint32_t tile : start)
+    {
+        CHECK(scheduler.IsVisible(tile));
+        CHECK(scheduler.IsActive(tile));
+        CHECK(!scheduler.IsReady(tile));
+    }
+
+    auto stats = Stats(scheduler);
+    CHECK(stats.visibleTiles == 4);
+    CHECK(stats.activeTiles == 3);
+    CHECK(stats.tilesStarted == 3);
+    CHECK(stats.missedTiles == 4);
+    CHECK(stats.visibleReadyRatio == 0.0f);
+
+    // nothing changed, nothing to do
+    start.clear();
+    scheduler.Update(TileScheduler::View{ c_second, 0.0f, 0.0f, 20.0f, 20.0f }, start, stop);
+    CHECK(start.empty() && stop.empty());
+}
+
+TEST(TileSchedulerCountsReadyTiles)
+{
+    TileScheduler scheduler;
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, TestSettings(4))));
+
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(TileView(0, c_centerTile), start, stop);
+    CHECK(start.size() == 1 && start[0] == c_centerTile);
+
+    // only a decoder that is running can be ready
+    scheduler.OnReady(c_edgeTile);
+    scheduler.OnReady(scheduler.TileCount());
+    CHECK(!scheduler.IsReady(c_edgeTile));
+
+    scheduler.OnReady(c_centerTile);
+    CHECK(scheduler.IsReady(c_centerTile));
+
+    scheduler.Update(TileView(c_second / 10, c_centerTile), start, stop);
+
+    auto stats = Stats(scheduler);
+    CHECK(stats.readyTiles == 1);
+    CHECK(stats.missedTiles == 1);
+    CHECK(stats.updates == 2);
+    CHECK(stats.visibleReadyRatio == 0.5f);
+}
+
+TEST(TileSchedulerLingersBeforeStopping)
+{
+    TileScheduler scheduler;
+    auto settings = TestSettings(32);
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, settings)));
+
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(TileView(0, c_centerTile), start, stop);
+
+    // looked away, with decoders to spare the old tile keeps going in case the view comes back
+    start.clear();
+    scheduler.Update(TileView(c_second / 10, c_edgeTile), start, stop);
+    CHECK(start.size() == 1 && start[0] == c_edgeTile);
+    CHECK(stop.empty());
+    CHECK(scheduler.IsActive(c_centerTile));
+    CHECK(!scheduler.IsVisible(c_centerTile));
+
+    start.clear();
+    scheduler.Update(TileView(c_second / 10 + settings.linger - 1, c_edgeTile), start, stop);
+    CHECK(stop.empty());
+
+    scheduler.Update(TileView(c_second / 10 + settings.linger, c_edgeTile), start, stop);
+    CHECK(stop.size() == 1 && stop[0] == c_centerTile);
+    CHECK(start.empty());
+    CHECK(!scheduler.IsActive(c_centerTile));
+
+    auto stats = Stats(scheduler);
+    CHECK(stats.activeTiles == 1);
+    CHECK(stats.tilesStopped == 1);
+}
+
+TEST(TileSchedulerEvictsTheLongestUnwanted)
+{
+    TileScheduler scheduler;
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, TestSettings(2))));
+
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(TileView(0, 0), start, stop);
+    scheduler.Update(TileView(c_second / 10, 1), start, stop);
+    scheduler.Update(TileView(2 * c_second / 10, c_centerTile), start, stop);
+
+    // the budget is full, the tile left first makes room well before its linger is up
+    CHECK(start.size() == 3 && start[2] == c_centerTile);
+    CHECK(stop.size() == 1 && stop[0] == 0);
+    CHECK(scheduler.IsActive(1));
+
+    auto stats = Stats(scheduler);
+    CHECK(stats.activeTiles == 2);
+    CHECK(stats.tilesStarted == 3);
+    CHECK(stats.tilesStopped == 1);
+}
+
+// the head turns right at 90 degrees a second, the tile it is heading for starts before it
+// is in the view and is ready when the view gets there
+TEST(TileSchedulerPrefetchesWhereTheHeadIsTurning)
+{
+    TileScheduler scheduler;
+    auto settings = TestSettings(32);
+    settings.lookahead = 5000000;
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, settings)));
+
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    for (int64_t step = 0; step <= 5; ++step)
+    {
+        int64_t time = step * c_second / 50;
+        scheduler.Update(TileScheduler::View{ time, 90.0f * time / c_second, 22.5f, 10.0f, 10.0f }, start, stop);
+    }
+
+    // 9 degrees with half a second of 90 degrees a second ahead
+    auto stats = Stats(scheduler);
+    CHECK(std::abs(stats.predictedYaw - 54.0f) < 0.5f);
+    CHECK(std::abs(stats.predictedPitch - 22.5f) < 0.01f);
+
+    uint32_t ahead = c_centerTile + 1;
+    CHECK(scheduler.IsActive(ahead));
+    CHECK(!scheduler.IsVisible(ahead));
+    CHECK(stats.prefetched == 1);
+    CHECK(stop.empty());
+
+    scheduler.OnReady(ahead);
+    scheduler.Update(TileScheduler::View{ 6 * c_second / 50, 67.5f, 22.5f, 10.0f, 10.0f }, start, stop);
+    CHECK(scheduler.IsVisible(ahead));
+
+    stats = Stats(scheduler);
+    CHECK(stats.prefetchHits == 1);
+    CHECK(stats.prefetchWasted == 0);
+
+    // a still head is not extrapolated
+    scheduler.Reset(c_columns, c_rows, settings);
+    for (int64_t step = 0; step <= 5; ++step)
+    {
+        scheduler.Update(TileView(step * c_second / 50, c_centerTile), start, stop);
+    }
+
+    stats = Stats(scheduler);
+    CHECK(stats.prefetched == 0);
+    CHECK(stats.activeTiles == 1);
+}
+
+// a tile whose decoder failed does not hold a slot, another tile takes it until the retry
+TEST(TileSchedulerFailedTileFreesItsSlot)
+{
+    TileScheduler scheduler;
+    auto settings = TestSettings(1);
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, settings)));
+
+    // four tiles in the view, one decoder
+    TileScheduler::View view{ 0, 0.0f, 0.0f, 20.0f, 20.0f };
+
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(view, start, stop);
+    CHECK(start.size() == 1);
+
+    uint32_t failed = start[0];
+    scheduler.OnFailed(failed, view.time);
+    CHECK(!scheduler.IsActive(failed));
+    CHECK(Stats(scheduler).activeTiles == 0);
+
+    // not a tile that is not running
+    scheduler.OnFailed(c_edgeTile, view.time);
+    scheduler.OnFailed(scheduler.TileCount(), view.time);
+    CHECK(Stats(scheduler).activeTiles == 0);
+
+    start.clear();
+    view.time = c_second / 10;
+    scheduler.Update(view, start, stop);
+    CHECK(start.size() == 1 && start[0] != failed);
+    CHECK(stop.empty());
+
+    // the only tile in the view waits for the retry delay
+    start.clear();
+    scheduler.Reset(c_columns, c_rows, settings);
+    scheduler.Update(TileView(0, c_centerTile), start, stop);
+    CHECK(start.size() == 1 && start[0] == c_centerTile);
+
+    scheduler.OnFailed(c_centerTile, 0);
+
+    start.clear();
+    scheduler.Update(TileView(settings.retryDelay - 1, c_centerTile), start, stop);
+    CHECK(start.empty());
+
+    scheduler.Update(TileView(settings.retryDelay, c_centerTile), start, stop);
+    CHECK(start.size() == 1 && start[0] == c_centerTile);
+
+    // a failure is not a stop, the decoder is already gone
+    auto stats = Stats(scheduler);
+    CHECK(stats.tilesStarted == 2);
+    CHECK(stats.tilesStopped == 0);
+    CHECK(stats.activeTiles == 1);
+}
+
+TEST(TileSchedulerStopsTilesPastALoweredBudget)
+{
+    TileScheduler scheduler;
+    CHECK(SUCCEEDED(scheduler.Reset(c_columns, c_rows, TestSettings(12))));
+
+    TileScheduler::View view{ 0, 0.0f, 0.0f, 100.0f, 80.0f };
+
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> stop;
+    scheduler.Update(view, start, stop);
+    CHECK(start.size() > 4);
+
+    // what fits the atlas turned out to be less than was asked for
+    scheduler.SetMaxActiveTiles(4);
+
+    start.clear();
+    view.time = c_second / 10;
+    scheduler.Update(view, start, stop);
+
+    auto stats = Stats(scheduler);
+    CHECK(start.empty());
+    CHECK(stop.size() == stats.tilesStarted - 4);
+    CHECK(stats.activeTiles == 4);
+    CHECK(stats.maxActiveTiles == 4);
+
+    // the ones kept are the ones closest to the center
+    CHECK(std::none_of(stop.begin(), stop.end(), [](uint32_t tile) { return tile == 11 || tile == 12 || tile == 19 || tile == 20; }));
+
+    // nothing fits
+    scheduler.SetMaxActiveTiles(0);
+
+    stop.clear();
+    view.time = 2 * c_second / 10;
+    scheduler.Update(view, start, stop);
+    CHECK(start.empty());
+    CHECK(stop.size() == 4);
+    CHECK(Stats(scheduler).activeTiles == 0);
+}
@@ -0,0 +1,150 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "VideoAtlas.h"
+
+#pragma comment(lib, "d3d11")
+
+using namespace winrt;
+
+// the atlas only needs a device to create its texture on, WARP runs anywhere
+static com_ptr<ID3D11Device> CreateDevice()
+{
+    com_ptr<ID3D11Device> device = nullptr;
+    D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, D3D11_CREATE_DEVICE_BGRA_SUPPORT, nullptr, 0, D3D11_SDK_VERSION, device.put(), nullptr, nullptr);
+
+    return device;
+}
+
+TEST(VideoAtlasIsSharedPerDevice)
+{
+    auto device = CreateDevice();
+    CHECK(device != nullptr);
+
+    std::shared_ptr<VideoAtlas> atlas;
+    CHECK(VideoAtlas::Acquire(nullptr, atlas) == E_INVALIDARG);
+    CHECK(atlas == nullptr);
+
+    CHECK(SUCCEEDED(VideoAtlas::Acquire(device.get(), atlas)));
+    CHECK(atlas->ShaderResourceView() != nullptr);
+
+    std::shared_ptr<VideoAtlas> second;
+    CHECK(SUCCEEDED(VideoAtlas::Acquire(device.get(), second)));
+    CHECK(second == atlas);
+
+    // a new unity device gets a new texture
+    auto other = CreateDevice();
+    CHECK(SUCCEEDED(VideoAtlas::Acquire(other.get(), second)));
+    CHECK(second != atlas);
+}
+
+TEST(VideoAtlasPadsEveryRect)
+{
+    auto device = CreateDevice();
+
+    std::shared_ptr<VideoAtlas> atlas;
+    CHECK(SUCCEEDED(VideoAtlas::Acquire(device.get(), atlas)));
+
+    uint32_t first = 0;
+    uint32_t second = 0;
+    CHECK(SUCCEEDED(atlas->Allocate(1020, 510, &first)));
+    CHECK(SUCCEEDED(atlas->Allocate(1020, 510, &second)));
+
+    ATLAS_RECT rect{};
+    CHECK(atlas->GetRect(first, &rect));
+    CHECK(rect.x == 2 && rect.y == 2 && rect.width == 1020 && rect.height == 510);
+    CHECK(rect.u == 2.0f / VideoAtlas::Size && rect.uWidth == 1020.0f / VideoAtlas::Size);
+
+    // the padding of both sides sits between neighbours
+    CHECK(atlas->GetRect(second, &rect));
+    CHECK(rect.x == 1020 + 3 * 2 && rect.y == 2);
+
+    // the padding has to fit too
+    uint32_t id = 0;
+    CHECK(atlas->Allocate(VideoAtlas::Size - 3, 16, &id) == E_INVALIDARG);
+    CHECK(atlas->Allocate(0, 16, &id) == E_INVALIDARG);
+
+    atlas->Free(first);
+    CHECK(!atlas->GetRect(first, &rect));
+    CHECK(rect.width == 0);
+
+    atlas->Free(second);
+}
+
+TEST(VideoAtlasDefragmentsAndReportsMovedRects)
+{
+    constexpr uint32_t c_quarter = VideoAtlas::Size / 2 - 4;
+
+    auto device = CreateDevice();
+
+    std::shared_ptr<VideoAtlas> atlas;
+    CHECK(SUCCEEDED(VideoAtlas::Acquire(device.get(), atlas)));
+
+    uint32_t ids[4] = {};
+    for (auto& id : ids)
+    {
+        CHECK(SUCCEEDED(atlas->Allocate(c_quarter, c_quarter, &id)));
+    }
+
+    // half the atlas free in two diagonal holes, a half wide tile only fits after a defragment
+    atlas->Free(ids[0]);
+    atlas->Free(ids[3]);
+
+    uint32_t wide = 0;
+    CHECK(SUCCEEDED(atlas->Allocate(VideoAtlas::Size - 4, c_quarter, &wide)));
+
+    ATLAS_RECT rect{};
+    CHECK(atlas->GetRect(ids[1], &rect) && rect.x == 2 && rect.y == 2);
+    CHECK(atlas->GetRect(wide, &rect) && rect.y == VideoAtlas::Size / 2 + 2);
+
+    // the players that moved find out once
+    CHECK(atlas->TakeMoved(ids[1]));
+    CHECK(!atlas->TakeMoved(ids[1]));
+    CHECK(atlas->TakeMoved(ids[2]));
+    CHECK(!atlas->TakeMoved(wide));
+
+    // full
+    uint32_t id = 0;
+    CHECK(atlas->Allocate(16, 16, &id) == E_OUTOFMEMORY);
+    CHECK(id == 0);
+
+    atlas->Free(ids[2]);
+    CHECK(SUCCEEDED(atlas->Allocate(16, 16, &id)));
+}
+
+// an 8K video as 8x4 tiles, with and without a base next to them
+TEST(VideoAtlasCapacityMatchesAllocate)
+{
+    constexpr uint32_t c_tileWidth = 964;
+    constexpr uint32_t c_tileHeight = 1084;
+    constexpr uint32_t c_baseWidth = 1920;
+    constexpr uint32_t c_baseHeight = 960;
+
+    CHECK(VideoAtlas::Capacity(c_tileWidth, c_tileHeight, 0, 0, 32) == 12);
+    CHECK(VideoAtlas::Capacity(c_tileWidth, c_tileHeight, 0, 0, 8) == 8);
+    CHECK(VideoAtlas::Capacity(0, c_tileHeight, 0, 0, 32) == 0);
+    CHECK(VideoAtlas::Capacity(VideoAtlas::Size, 16, 0, 0, 32) == 0);
+
+    uint32_t capacity = VideoAtlas::Capacity(c_tileWidth, c_tileHeight, c_baseWidth, c_baseHeight, 32);
+    // the base opens a shelf lower than a tile's, the one that would be left for a third row of tiles
+    CHECK(capacity == 8);
+
+    auto device = CreateDevice();
+    std::shared_ptr<VideoAtlas> atlas;
+    CHECK(SUCCEEDED(VideoAtlas::Acquire(device.get(), atlas)));
+
+    // the base first, the way the tiled player opens them
+    uint32_t base = 0;
+    CHECK(SUCCEEDED(atlas->Allocate(c_baseWidth, c_baseHeight, &base)));
+
+    std::vector<uint32_t> ids(capacity, 0);
+    for (auto& id : ids)
+    {
+        CHECK(SUCCEEDED(atlas->Allocate(c_tileWidth, c_tileHeight, &id)));
+    }
+
+    uint32_t id = 0;
+    CHECK(atlas->Allocate(c_tileWidth, c_tileHeight, &id) == E_OUTOFMEMORY);
+}
@@ -0,0 +1,257 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+#include "Y4mReader.h"
+
+#include <mferror.h>
+
+#include <algorithm>
+#include <string>
+
+static int64_t Ticks()
+{
+    LARGE_INTEGER counter{};
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+static double TicksToNs(int64_t ticks)
+{
+    LARGE_INTEGER frequency{};
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(ticks) * 1e9 / static_cast<double>(frequency.QuadPart);
+}
+
+static void Append(std::vector<uint8_t>& file, std::string const& text)
+{
+    file.insert(file.end(), text.begin(), text.end());
+}
+
+// a header line then frameCount frames of frameSize bytes, every byte of frame i is i
+static std::vector<uint8_t> MakeY4m(std::string const& header, uint32_t frameCount, size_t frameSize)
+{
+    std::vector<uint8_t> file;
+    file.reserve(header.size() + 1 + frameCount * (frameSize + 6));
+
+    Append(file, header + "\n");
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        Append(file, "FRAME\n");
+        file.insert(file.end(), frameSize, static_cast<uint8_t>(i));
+    }
+
+    return file;
+}
+
+static HRESULT Parse(std::vector<uint8_t> const& file, RawFrameReader::Format& format, std::vector<uint64_t>& frames)
+{
+    return Y4mReader::Parse(file.data(), file.size(), format, frames);
+}
+
+TEST(Y4mReaderParsesTheHeaderTags)
+{
+    auto file = MakeY4m("YUV4MPEG2 W64 H36 F30000:1001 Ip A1:1 C420jpeg XYSCSS=420JPEG", 3, 64 * 36 * 3 / 2);
+
+    RawFrameReader::Format format{};
+    std::vector<uint64_t> frames;
+    CHECK(SUCCEEDED(Parse(file, format, frames)));
+    CHECK(format.width == 64);
+    CHECK(format.height == 36);
+    CHECK(format.frameRateNumerator == 30000);
+    CHECK(format.frameRateDenominator == 1001);
+    CHECK(format.frameSize == 64 * 36 * 3 / 2);
+    CHECK(format.frameCount == 3);
+    CHECK(format.pixelFormat == RawFrameReader::PixelFormat::I420);
+
+    // each frame starts right after its marker line
+    uint64_t headerSize = std::string("YUV4MPEG2 W64 H36 F30000:1001 Ip A1:1 C420jpeg XYSCSS=420JPEG\n").size();
+    CHECK(frames.size() == 3);
+    CHECK(frames[0] == headerSize + 6);
+    CHECK(frames[2] == headerSize + 3 * 6 + 2 * format.frameSize);
+
+    // every 8 bit 4:2:0 siting is taken, and no C at all means 420jpeg
+    for (auto colorspace : { " C420", " C420paldv", " C420mpeg2", "" })
+    {
+        file = MakeY4m(std::string("YUV4MPEG2 W64 H36 F25:1") + colorspace, 1, 64 * 36 * 3 / 2);
+        CHECK(SUCCEEDED(Parse(file, format, frames)));
+    }
+
+    // anything else changes the plane layout
+    for (auto colorspace : { " C444", " C422", " Cmono", " C420p10" })
+    {
+        file = MakeY4m(std::string("YUV4MPEG2 W64 H36 F25:1") + colorspace, 1, 64 * 36 * 3 / 2);
+        CHECK(Parse(file, format, frames) == MF_E_INVALIDMEDIATYPE);
+    }
+}
+
+TEST(Y4mReaderRejectsBadSizesAndRates)
+{
+    RawFrameReader::Format format{};
+    std::vector<uint64_t> frames;
+
+    // odd sizes have no whole chroma sample for the last row or column
+    for (auto header : { "YUV4MPEG2 W63 H36 F25:1", "YUV4MPEG2 W64 H35 F25:1", "YUV4MPEG2 W0 H36 F25:1", "YUV4MPEG2 H36 F25:1" })
+    {
+        auto file = MakeY4m(header, 1, 64 * 36 * 3 / 2);
+        CHECK(Parse(file, format, frames) == MF_E_INVALIDMEDIATYPE);
+    }
+
+    // a rate needs both halves
+    for (auto header : { "YUV4MPEG2 W64 H36 F25", "YUV4MPEG2 W64 H36 F25:0", "YUV4MPEG2 W64 H36" })
+    {
+        auto file = MakeY4m(header, 1, 64 * 36 * 3 / 2);
+        CHECK(Parse(file, format, frames) == MF_E_INVALIDMEDIATYPE);
+    }
+
+    // a frame past 4 gb does not fit the format
+    auto file = MakeY4m("YUV4MPEG2 W65536 H65536 F25:1", 0, 0);
+    CHECK(Parse(file, format, frames) == MF_E_INVALIDMEDIATYPE);
+
+    // not a y4m file at all, or a header line that never ends
+    file = MakeY4m("YUV4MPEG W64 H36 F25:1", 1, 64 * 36 * 3 / 2);
+    CHECK(Parse(file, format, frames) == MF_E_INVALID_FILE_FORMAT);
+    file.assign(5000, 'W');
+    memcpy(file.data(), "YUV4MPEG2 ", 10);
+    CHECK(Parse(file, format, frames) == MF_E_INVALID_FILE_FORMAT);
+}
+
+TEST(Y4mReaderDropsATruncatedLastFrame)
+{
+    constexpr size_t c_frameSize = 16 * 8 * 3 / 2;
+
+    auto file = MakeY4m("YUV4MPEG2 W16 H8 F25:1", 4, c_frameSize);
+
+    RawFrameReader::Format format{};
+    std::vector<uint64_t> frames;
+
+    // one byte short of the last frame, or only its marker, leaves three
+    for (size_t cut : { size_t(1), c_frameSize, c_frameSize + 3 })
+    {
+        std::vector<uint8_t> truncated(file.begin(), file.end() - cut);
+        CHECK(SUCCEEDED(Parse(truncated, format, frames)));
+        CHECK(format.frameCount == 3);
+    }
+
+    // nothing but a header and a partial frame is not a clip
+    std::vector<uint8_t> partial(file.begin(), file.begin() + file.size() - 3 * (c_frameSize + 6) - 1);
+    CHECK(Parse(partial, format, frames) == MF_E_INVALID_FILE_FORMAT);
+}
+
+TEST(Y4mReaderStopsAtAMissingFrameMarker)
+{
+    constexpr size_t c_frameSize = 16 * 8 * 3 / 2;
+
+    RawFrameReader::Format format{};
+    std::vector<uint64_t> frames;
+
+    // raw planes straight after the header are not frames
+    auto file = MakeY4m("YUV4MPEG2 W16 H8 F25:1", 0, 0);
+    file.insert(file.end(), c_frameSize * 2, 0x80);
+    CHECK(Parse(file, format, frames) == MF_E_INVALID_FILE_FORMAT);
+
+    // a marker that is not where the previous frame ends stops the index there
+    file = MakeY4m("YUV4MPEG2 W16 H8 F25:1", 2, c_frameSize);
+    Append(file, "FRAMX\n");
+    file.insert(file.end(), c_frameSize, 2);
+    Append(file, "FRAME\n");
+    file.insert(file.end(), c_frameSize, 3);
+    CHECK(SUCCEEDED(Parse(file, format, frames)));
+    CHECK(format.frameCount == 2);
+
+    // frame lines may carry their own parameters
+    file = MakeY4m("YUV4MPEG2 W16 H8 F25:1", 1, c_frameSize);
+    Append(file, "FRAME Ib XFOO=1\n");
+    file.insert(file.end(), c_frameSize, 1);
+    CHECK(SUCCEEDED(Parse(file, format, frames)));
+    CHECK(format.frameCount == 2);
+    CHECK(file[frames[1]] == 1 && file[frames[1] - 1] == '\n');
+}
+
+TEST(Y4mReaderHandsOutFramesFromMemory)
+{
+    constexpr size_t c_frameSize = 16 * 8 * 3 / 2;
+
+    auto buffer = std::make_shared<std::vector<uint8_t>>(MakeY4m("YUV4MPEG2 W16 H8 F25:1", 5, c_frameSize));
+
+    std::shared_ptr<RawFrameReader> reader = nullptr;
+    CHECK(SUCCEEDED(Y4mReader::Open(std::shared_ptr<std::vector<uint8_t> const>(buffer), reader)));
+    CHECK(reader != nullptr);
+    CHECK(reader->GetFormat().frameCount == 5);
+
+    RawFrameReader::FrameData frame{};
+    for (uint32_t i = 0; i < 5; ++i)
+    {
+        CHECK(SUCCEEDED(reader->Frame(i, frame)));
+        CHECK(frame.data[0] == i && frame.data[c_frameSize - 1] == i);
+    }
+
+    CHECK(reader->Frame(5, frame) == E_BOUNDS);
+    CHECK(frame.data == nullptr && frame.owner == nullptr);
+
+    // a frame keeps the reader, and with it the buffer, alive
+    CHECK(SUCCEEDED(reader->Frame(4, frame)));
+    reader = nullptr;
+    buffer = nullptr;
+    CHECK(frame.data[0] == 4);
+}
+
+BENCHMARK(Y4mReaderThroughput)
+{
+    struct Size { char const* name; uint32_t width; uint32_t height; uint32_t frames; };
+    for (auto const& size : { Size{ "1080p", 1920, 1080, 32 }, Size{ "4k", 3840, 2160, 8 } })
+    {
+        size_t frameSize = static_cast<size_t>(size.width) * size.height * 3 / 2;
+        auto buffer = std::make_shared<std::vector<uint8_t>>(
+            MakeY4m("YUV4MPEG2 W" + std::to_string(size.width) + " H" + std::to_string(size.height) + " F60:1 Ip C420jpeg", size.frames, frameSize));
+
+        // indexing on open, every marker is visited
+        constexpr uint32_t c_parses = 200;
+        RawFrameReader::Format format{};
+        std::vector<uint64_t> frames;
+        int64_t start = Ticks();
+        for (uint32_t i = 0; i < c_parses; ++i)
+        {
+            CHECK(SUCCEEDED(Y4mReader::Parse(buffer->data(), buffer->size(), format, frames)));
+        }
+        double parseNs = TicksToNs(Ticks() - start);
+
+        std::shared_ptr<RawFrameReader> reader = nullptr;
+        CHECK(SUCCEEDED(Y4mReader::Open(std::shared_ptr<std::vector<uint8_t> const>(buffer), reader)));
+
+        // what the sample requested callback pays for a frame, then the frame server's copy
+        constexpr uint32_t c_loops = 8;
+        std::vector<uint8_t> copy(frameSize);
+        int64_t callbackTicks = 0;
+        int64_t maxCallbackTicks = 0;
+        start = Ticks();
+        for (uint32_t loop = 0; loop < c_loops; ++loop)
+        {
+            for (uint32_t i = 0; i < size.frames; ++i)
+            {
+                RawFrameReader::FrameData frame{};
+                int64_t callbackStart = Ticks();
+                reader->Frame(i, frame);
+                int64_t callback = Ticks() - callbackStart;
+
+                callbackTicks += callback;
+                maxCallbackTicks = std::max(maxCallbackTicks, callback);
+
+                memcpy(copy.data(), frame.data, frameSize);
+            }
+        }
+        double playbackNs = TicksToNs(Ticks() - start);
+
+        uint32_t delivered = c_loops * size.frames;
+        printf("  %-5s  index %9.0f frames/s   Frame() %6.1f ns, max %7.1f ns   with the copy %6.1f frames/s\n",
+            size.name,
+            size.frames * c_parses * 1e9 / parseNs,
+            TicksToNs(callbackTicks) / delivered,
+            TicksToNs(maxCallbackTicks),
+            delivered * 1e9 / playbackNs);
+
+        CHECK(format.frameCount == size.frames);
+        CHECK(copy[0] == static_cast<uint8_t>(size.frames - 1));
+    }
+}
@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License. See LICENSE in the project root for license information.
+
+#include "pch.h"
+#include "Test.h"
+
+#include <cstring>
+
+static uint32_t s_failures = 0;
+
+std::vector<TestCase>& TestCases()
+{
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+_Use_decl_annotations_
+void TestFailed(
+    char const* file,
+    int line,
+    char const* expression)
+{
+    ++s_failures;
+
+    printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+}
+
+// Tests.exe [-bench] [name]
+// runs the tests, or the benchmarks, whose names contain name
+int main(int argc, char* argv[])
+{
+    bool benchmarks = false;
+    char const* filter = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-bench") == 0)
+        {
+            benchmarks = true;
+        }
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    uint32_t run = 0;
+    uint32_t failed = 0;
+    for (auto const& test : TestCases())
+    {
+        if (test.benchmark != benchmarks || (filter != nullptr && strstr(test.name, filter) == nullptr))
+        {
+            continue;
+        }
+
+        printf("%s\n", test.name);
+
+        uint32_t before = s_failures;
+        test.run();
+
+        ++run;
+        if (s_failures != before)
+        {
+            ++failed;
+        }
+    }
+
+    printf("%u run, %u failed\n", run, failed);
+
+    return failed == 0 ? 0 : 1;
+}
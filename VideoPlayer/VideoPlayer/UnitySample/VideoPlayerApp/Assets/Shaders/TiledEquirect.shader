@@ -0,0 +1,89 @@
+﻿Shader "VideoPlayer/TiledEquirect"
+{
+    // the inside of a sphere around the camera, every direction is looked up in the
+    // equirectangular frame, then in the tile map for where that tile sits in the atlas.
+    // a tile without a rect falls back to the base stream, the last row's first texel
+    Properties
+    {
+        _MainTex("Atlas", 2D) = "black" {}
+        _TileMap("Tile Map", 2D) = "black" {}
+        _Grid("Columns, Rows", Vector) = (8, 4, 0, 0)
+    }
+
+    SubShader
+    {
+        Tags { "RenderType" = "Opaque" "Queue" = "Background" }
+        LOD 100
+        Cull Front
+        ZWrite Off
+
+        Pass
+        {
+            CGPROGRAM
+            #pragma vertex vert
+            #pragma fragment frag
+            #pragma target 3.0
+
+            #include "UnityCG.cginc"
+
+            struct appdata
+            {
+                float3 vertex : POSITION;
+            };
+
+            struct v2f
+            {
+                float3 direction : TEXCOORD0;
+                float4 vertex : SV_POSITION;
+            };
+
+            sampler2D _MainTex;
+            sampler2D _TileMap;
+            float4 _Grid;
+
+            v2f vert(appdata v)
+            {
+                v2f o;
+                o.vertex = UnityObjectToClipPos(v.vertex);
+                o.direction = v.vertex;
+                return o;
+            }
+
+            float4 TileRect(float column, float row)
+            {
+                float2 texel = float2((column + 0.5) / _Grid.x, (row + 0.5) / (_Grid.y + 1.0));
+                return tex2Dlod(_TileMap, float4(texel, 0, 0));
+            }
+
+            fixed4 frag(v2f i) : SV_Target
+            {
+                float3 direction = normalize(i.direction);
+
+                // the frame from its top left, yaw 0 looks at its center
+                float2 frame = float2(
+                    atan2(direction.x, direction.z) / (2.0 * UNITY_PI) + 0.5,
+                    0.5 - asin(clamp(direction.y, -1.0, 1.0)) / UNITY_PI);
+
+                float2 cell = min(floor(frame * _Grid.xy), _Grid.xy - 1.0);
+                float2 inTile = frame * _Grid.xy - cell;
+
+                float4 rect = TileRect(cell.x, cell.y);
+                if (rect.z <= 0.0)
+                {
+                    rect = TileRect(0.0, _Grid.y);
+                    inTile = frame;
+                }
+
+                if (rect.z <= 0.0)
+                {
+                    return fixed4(0, 0, 0, 1);
+                }
+
+                // atlas rects count v from the top like the frame. lod 0, the derivatives jump
+                // at the seam behind the viewer and at tile edges
+                return tex2Dlod(_MainTex, float4(rect.xy + inTile * rect.zw, 0, 0));
+            }
+            ENDCG
+        }
+    }
+}
@@ -21,6 +21,11 @@ namespace VideoPlayer
             None = 0,
             Failed,
             MediaPlayer,
+            Playlist,
+            AtlasRect,
+            Seek,
+            Thumbnail,
+            Resolution,
         };
 
         internal enum MediaPlayerState : Int32
@@ -34,6 +39,21 @@ namespace VideoPlayer
             Ended,
         };
 
+        // matches SeekMode in pch.h
+        internal enum SeekMode : Int32
+        {
+            Exact = 0,
+            Keyframe,
+        };
+
+        // matches PacingMode in pch.h
+        internal enum PacingMode : Int32
+        {
+            Latest = 0,
+            Nearest,
+            Floor,
+        };
+
         [StructLayout(LayoutKind.Sequential)]
         internal struct FailedState
         {
@@ -68,6 +88,310 @@ namespace VideoPlayer
             }
         }
 
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct PlaylistState
+        {
+            [MarshalAs(UnmanagedType.U4)] public UInt32 itemIndex;
+            [MarshalAs(UnmanagedType.U4)] public UInt32 itemCount;
+            [MarshalAs(UnmanagedType.R4)] public Single transitionGapMs;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("itemIndex: " + itemIndex);
+                sb.AppendLine("itemCount: " + itemCount);
+                sb.AppendLine("transitionGapMs: " + transitionGapMs);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct SeekState
+        {
+            public Int64 requested;
+            public Int64 position;
+            public Single latencyMs;
+            public SeekMode mode;
+            public UInt32 cached;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("mode: " + mode);
+                sb.AppendLine("requested: " + requested);
+                sb.AppendLine("position: " + position);
+                sb.AppendLine("latencyMs: " + latencyMs);
+                sb.AppendLine("cached: " + cached);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct ThumbnailState
+        {
+            public UInt32 batchId;
+            public UInt32 index;
+            public Int32 hresult;
+            public UInt32 remaining;
+            public Int64 requested;
+            public Int64 timestamp;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("batchId: " + batchId);
+                sb.AppendLine("index: " + index);
+                sb.AppendLine("hresult: 0x" + hresult.ToString("X", System.Globalization.NumberFormatInfo.InvariantInfo));
+                sb.AppendLine("remaining: " + remaining);
+                sb.AppendLine("requested: " + requested);
+                sb.AppendLine("timestamp: " + timestamp);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct ResolutionState
+        {
+            public UInt32 level;
+            public UInt32 width;
+            public UInt32 height;
+            public Single uWidth;
+            public Single vHeight;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("level: " + level);
+                sb.AppendLine("size: " + width + "x" + height);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct ThumbnailStats
+        {
+            public UInt32 workerCount;
+            public UInt32 pending;
+            public UInt64 completed;
+            public UInt64 failed;
+            public UInt64 decoded;
+            public Single thumbnailsPerSecond;
+            public Single decodeMs;
+            public Single resampleMs;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("workerCount: " + workerCount);
+                sb.AppendLine("pending: " + pending);
+                sb.AppendLine("completed: " + completed);
+                sb.AppendLine("failed: " + failed);
+                sb.AppendLine("decoded: " + decoded);
+                sb.AppendLine("thumbnailsPerSecond: " + thumbnailsPerSecond);
+                sb.AppendLine("decodeMs: " + decodeMs);
+                sb.AppendLine("resampleMs: " + resampleMs);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct FrameCacheStats
+        {
+            public UInt64 hits;
+            public UInt64 misses;
+            public UInt64 evictions;
+            public UInt64 bytes;
+            public UInt64 budget;
+            public UInt32 frames;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("hits: " + hits);
+                sb.AppendLine("misses: " + misses);
+                sb.AppendLine("evictions: " + evictions);
+                sb.AppendLine("bytes: " + bytes + " / " + budget);
+                sb.AppendLine("frames: " + frames);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct AtlasRect
+        {
+            public UInt32 x;
+            public UInt32 y;
+            public UInt32 width;
+            public UInt32 height;
+            public Single u;
+            public Single v;
+            public Single uWidth;
+            public Single vHeight;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("x: " + x);
+                sb.AppendLine("y: " + y);
+                sb.AppendLine("width: " + width);
+                sb.AppendLine("height: " + height);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct RawSourceStats
+        {
+            public UInt32 width;
+            public UInt32 height;
+            public UInt32 frameCount;
+            public UInt64 framesDelivered;
+            public UInt64 framesShown;
+            public Single framesPerSecond;
+            public Single requestUs;
+            public Single maxRequestUs;
+            public Single latencyMs;
+            public Single maxLatencyMs;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("size: " + width + "x" + height + ", " + frameCount + " frames");
+                sb.AppendLine("framesDelivered: " + framesDelivered);
+                sb.AppendLine("framesShown: " + framesShown);
+                sb.AppendLine("framesPerSecond: " + framesPerSecond);
+                sb.AppendLine("requestUs: " + requestUs + " (max " + maxRequestUs + ")");
+                sb.AppendLine("latencyMs: " + latencyMs + " (max " + maxLatencyMs + ")");
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct PlaybackStats
+        {
+            public UInt64 framesAvailable;
+            public UInt64 framesCopied;
+            public UInt64 framesFailed;
+            public UInt64 framesStalled;
+            public UInt64 framesDropped;
+            public UInt64 framesPresented;
+            public UInt64 framesRepeated;
+            public Single effectiveFps;
+            public Single copyMsAverage;
+            public Single copyMsMax;
+            [MarshalAs(UnmanagedType.ByValArray, SizeConst = 8)]
+            public UInt32[] copyHistogram;   // < 0.25, 0.5, 1, 2, 4, 8, 16ms and the rest
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("framesAvailable: " + framesAvailable);
+                sb.AppendLine("framesCopied: " + framesCopied + " (failed " + framesFailed + ", stalled " + framesStalled + ")");
+                sb.AppendLine("framesPresented: " + framesPresented + " (dropped " + framesDropped + ", repeated " + framesRepeated + ")");
+                sb.AppendLine("effectiveFps: " + effectiveFps);
+                sb.AppendLine("copyMs: " + copyMsAverage + " (max " + copyMsMax + ")");
+                sb.Append("copyHistogram:");
+                for (int i = 0; copyHistogram != null && i < copyHistogram.Length; ++i)
+                {
+                    sb.Append(" " + copyHistogram[i]);
+                }
+                sb.AppendLine();
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct AudioTapStats
+        {
+            public UInt32 sampleRate;
+            public UInt32 channels;
+            public UInt32 sourceSampleRate;
+            public UInt32 sourceChannels;
+            public UInt64 framesDecoded;
+            public UInt64 framesRead;
+            public UInt64 framesSkipped;
+            public UInt64 framesSilence;
+            public UInt32 resyncs;
+            public UInt32 bufferedFrames;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("format: " + sampleRate + "Hz " + channels + "ch (source " + sourceSampleRate + "Hz " + sourceChannels + "ch)");
+                sb.AppendLine("framesDecoded: " + framesDecoded);
+                sb.AppendLine("framesRead: " + framesRead + " (skipped " + framesSkipped + ", silence " + framesSilence + ")");
+                sb.AppendLine("resyncs: " + resyncs);
+                sb.AppendLine("bufferedFrames: " + bufferedFrames);
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct TiledStats
+        {
+            public UInt32 columns;
+            public UInt32 rows;
+            public UInt32 maxActiveTiles;
+            public UInt32 visibleTiles;
+            public UInt32 activeTiles;
+            public UInt32 readyTiles;
+            public UInt64 updates;
+            public UInt64 tilesStarted;
+            public UInt64 tilesStopped;
+            public UInt64 prefetched;
+            public UInt64 prefetchHits;
+            public UInt64 prefetchWasted;
+            public UInt64 missedTiles;
+            public Single visibleReadyRatio;
+            public Single predictedYaw;
+            public Single predictedPitch;
+            public UInt64 framesCopied;
+            public UInt64 framesFailed;
+            public UInt32 tilesFailed;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("grid: " + columns + "x" + rows + ", up to " + maxActiveTiles + " decoding");
+                sb.AppendLine("tiles: " + visibleTiles + " visible, " + activeTiles + " active, " + readyTiles + " ready");
+                sb.AppendLine("updates: " + updates);
+                sb.AppendLine("tilesStarted: " + tilesStarted + " (stopped " + tilesStopped + ", failed " + tilesFailed + ")");
+                sb.AppendLine("prefetched: " + prefetched + " (hits " + prefetchHits + ", wasted " + prefetchWasted + ")");
+                sb.AppendLine("missedTiles: " + missedTiles);
+                sb.AppendLine("visibleReadyRatio: " + visibleReadyRatio);
+                sb.AppendLine("predicted: " + predictedYaw + ", " + predictedPitch);
+                sb.AppendLine("framesCopied: " + framesCopied + " (failed " + framesFailed + ")");
+                return sb.ToString();
+            }
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct ResourceStats
+        {
+            public UInt32 playerCount;
+            public UInt32 frameBufferCount;
+            public UInt64 frameBufferBytes;
+            public UInt32 buffersInUse;
+            public UInt32 buffersPooled;
+            public UInt64 bytesInUse;
+            public UInt64 bytesPooled;
+            public Single createTextureMs;
+
+            public override string ToString()
+            {
+                StringBuilder sb = new StringBuilder();
+                sb.AppendLine("playerCount: " + playerCount);
+                sb.AppendLine("frameBufferCount: " + frameBufferCount);
+                sb.AppendLine("frameBufferBytes: " + frameBufferBytes);
+                sb.AppendLine("buffersInUse: " + buffersInUse);
+                sb.AppendLine("buffersPooled: " + buffersPooled);
+                sb.AppendLine("bytesInUse: " + bytesInUse);
+                sb.AppendLine("bytesPooled: " + bytesPooled);
+                sb.AppendLine("createTextureMs: " + createTextureMs);
+                return sb.ToString();
+            }
+        }
+
         [StructLayout(LayoutKind.Explicit, Pack = 4)]
         internal struct CallbackState
         {
@@ -79,6 +403,21 @@ namespace VideoPlayer
 
             [FieldOffset(4)]
             public PlaybackState PlaybackState;
+
+            [FieldOffset(4)]
+            public PlaylistState PlaylistState;
+
+            [FieldOffset(4)]
+            public AtlasRect AtlasRect;
+
+            [FieldOffset(4)]
+            public SeekState SeekState;
+
+            [FieldOffset(4)]
+            public ThumbnailState ThumbnailState;
+
+            [FieldOffset(4)]
+            public ResolutionState ResolutionState;
         };
 
         [UnmanagedFunctionPointer(CallingConvention.StdCall)]
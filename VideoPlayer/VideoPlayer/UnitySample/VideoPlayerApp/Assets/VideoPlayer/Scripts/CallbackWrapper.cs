@@ -35,34 +35,39 @@ namespace VideoPlayer
 
             // check if this is of correct type
             //if (!(handle.Target is T))
-            if (!(handle.Target is PlaybackEngine))
+            Action<Wrapper.CallbackState> onStateChanged = null;
+            if (handle.Target is PlaybackEngine)
+            {
+                onStateChanged = ((PlaybackEngine)handle.Target).OnStateChanged;
+            }
+            else if (handle.Target is ThumbnailExtractor)
+            {
+                onStateChanged = ((ThumbnailExtractor)handle.Target).OnStateChanged;
+            }
+            else
             {
                 Debug.LogError("OnCallback: senderPtr is not null, but not of correct type.");
 
                 return;
             }
 
-            // cast to type
-            //var thisObject = (T)handle.Target;
-            var thisObject = (PlaybackEngine)handle.Target;
-
             // complete callback
 #if UNITY_WSA_10_0
             if (!UnityEngine.WSA.Application.RunningOnAppThread())
             {
                 UnityEngine.WSA.Application.InvokeOnAppThread(() =>
                 {
-                    thisObject.OnStateChanged(args);
+                    onStateChanged(args);
                 }, false);
             }
             else
             {
-                thisObject.OnStateChanged(args);
+                onStateChanged(args);
             }
 #else
             // there is still a chance the callback is on a non AppThread(callbacks genereated from WaitForEndOfFrame are not)
             // this will process the callback on AppThread on a FixedUpdate
-            thisObject.OnStateChanged(args);
+            onStateChanged(args);
 #endif
         }
     }
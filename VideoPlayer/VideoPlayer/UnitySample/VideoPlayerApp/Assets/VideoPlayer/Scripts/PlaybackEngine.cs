@@ -12,10 +12,47 @@ namespace VideoPlayer
         public String RootVideoFolder;
         public String VideoPath;
 
+        // played after VideoPath without a gap, the next preloadCount are opened ahead of time
+        public String[] PlaylistPaths;
+        public UInt32 preloadCount = 1;
+
+        // decoded frames kept for scrubbing, in megabytes, 0 turns the cache off
+        public UInt32 frameCacheMegabytes = 0;
+
         // texture size
         public Int32 textureWidth = 1920;
         public Int32 textureHeight = 1080;
 
+        // decoded frames in flight between the player and the render thread, 2 - 8
+        public UInt32 frameBufferCount = 3;
+
+        // how a frame is picked from the queue each render, and how many vsyncs ahead it aims, 0 - 4
+        public Wrapper.PacingMode pacingMode = Wrapper.PacingMode.Nearest;
+        public UInt32 pacingLatencyFrames = 1;
+
+        // drops to smaller copies of the video while the gpu cannot keep up, 1 keeps it at
+        // the texture size, up to 4 sizes down to minScale of it. not used with the atlas
+        public UInt32 adaptiveResolutionLevels = 1;
+        public Single adaptiveResolutionMinScale = 0.5f;
+
+        // plays the video's own audio through an AudioSource on this object instead of the
+        // player's output, bufferMs is how far the decoder may run ahead, 50 - 2000
+        public bool audioTap = false;
+        public UInt32 audioTapBufferMs = 500;
+
+        // media time of the audio last handed to unity in 100ns units, -1 while there is none
+        internal Int64 audioTimestamp = -1;
+
+        private volatile bool audioTapEnabled = false;
+        private Int32 audioTapChannels = 0;
+
+        // draw into a rect of one texture shared by every player, so tiles can batch
+        public bool useAtlas = false;
+
+        // matches VideoAtlas::Size
+        private const Int32 AtlasSize = 4096;
+        private static Texture2D atlasTexture = null;
+
         private Texture2D playbackTexture = null;
 
         protected override void Awake()
@@ -49,27 +86,88 @@ namespace VideoPlayer
 
             CreateMediaPlayer();
 
+            CheckHR(Native.SetFrameBufferCount(instanceId, frameBufferCount));
+
+            CheckHR(Native.SetPacing(instanceId, pacingMode, pacingLatencyFrames));
+
+            CheckHR(Native.SetFrameCacheBudget(instanceId, (UInt64)frameCacheMegabytes * 1024 * 1024));
+
+            CheckHR(Native.SetAdaptiveResolution(instanceId, adaptiveResolutionLevels, adaptiveResolutionMinScale));
+
+            if (audioTap)
+            {
+                audioTapChannels = SpeakerModeChannels(AudioSettings.speakerMode);
+                audioTapEnabled = CheckHR(Native.SetAudioTap(instanceId, (UInt32)AudioSettings.outputSampleRate, (UInt32)audioTapChannels, audioTapBufferMs)) == 0;
+            }
+
             // create native texture for playback
             IntPtr nativeTexture = IntPtr.Zero;
-            CheckHR(Native.CreatePlaybackTexture(instanceId, textureWidth, textureHeight, out nativeTexture));
+            Wrapper.AtlasRect atlasRect = default(Wrapper.AtlasRect);
+            if (useAtlas)
+            {
+                CheckHR(Native.CreateAtlasTexture(instanceId, textureWidth, textureHeight, out nativeTexture, out atlasRect));
+            }
+            else
+            {
+                CheckHR(Native.CreatePlaybackTexture(instanceId, textureWidth, textureHeight, out nativeTexture));
+            }
+
+            // memory and setup cost as more players share the decode device
+            Wrapper.ResourceStats resourceStats;
+            if (CheckHR(Native.GetResourceStats(instanceId, out resourceStats)) == 0)
+            {
+                Debug.Log(resourceStats);
+            }
+
+            if (useAtlas)
+            {
+                // the atlas is recreated once every player using it has gone
+                if (atlasTexture == null || atlasTexture.GetNativeTexturePtr() != nativeTexture)
+                {
+                    atlasTexture = Texture2D.CreateExternalTexture(AtlasSize, AtlasSize, TextureFormat.BGRA32, false, false, nativeTexture);
+                }
 
-            // create the unity texture2d 
-            this.playbackTexture = Texture2D.CreateExternalTexture(textureWidth, textureWidth, TextureFormat.BGRA32, false, false, nativeTexture);
+                this.playbackTexture = atlasTexture;
 
-            // set texture for the shader
-            if (playbackRenderer != null)
+                if (playbackRenderer != null)
+                {
+                    playbackRenderer.sharedMaterial.SetTexture("_MainTex", this.playbackTexture);
+                }
+
+                ApplyAtlasRect(atlasRect);
+            }
+            else
             {
-                playbackRenderer.material.SetTexture("_MainTex", this.playbackTexture);
-                playbackRenderer.material.SetTextureScale("_MainTex", new Vector2(1, -1));
+                // create the unity texture2d 
+                this.playbackTexture = Texture2D.CreateExternalTexture(textureWidth, textureWidth, TextureFormat.BGRA32, false, false, nativeTexture);
+
+                // set texture for the shader
+                if (playbackRenderer != null)
+                {
+                    playbackRenderer.material.SetTexture("_MainTex", this.playbackTexture);
+                    playbackRenderer.material.SetTextureScale("_MainTex", new Vector2(1, -1));
+                }
             }
 
+            CheckHR(Native.SetPreloadCount(instanceId, preloadCount));
+
             CheckHR(Native.LoadContent(instanceId, VideoPath));
 
+            if (PlaylistPaths != null)
+            {
+                foreach (var path in PlaylistPaths)
+                {
+                    CheckHR(Native.Enqueue(instanceId, path));
+                }
+            }
+
             CheckHR(Native.Play(instanceId));
         }
 
         protected override void OnDisable()
         {
+            audioTapEnabled = false;
+
             CheckHR(Native.Stop(instanceId));
 
             base.OnDisable();
@@ -77,9 +175,137 @@ namespace VideoPlayer
 
         protected override void OnCallback(Wrapper.CallbackType type, Wrapper.CallbackState args)
         {
+            if (type == Wrapper.CallbackType.Playlist)
+            {
+                Debug.Log(args.PlaylistState);
+                return;
+            }
+
+            if (type == Wrapper.CallbackType.Seek)
+            {
+                Debug.Log(args.SeekState);
+                return;
+            }
+
+            if (type == Wrapper.CallbackType.AtlasRect)
+            {
+                ApplyAtlasRect(args.AtlasRect);
+                return;
+            }
+
+            if (type == Wrapper.CallbackType.Resolution)
+            {
+                Debug.Log(args.ResolutionState);
+                ApplyResolution(args.ResolutionState);
+                return;
+            }
+
             Debug.Log(args.PlaybackState);
+
+            if (args.PlaybackState.state == Wrapper.MediaPlayerState.Ended)
+            {
+                Debug.Log(GetStats());
+            }
+
+            Wrapper.AudioTapStats audioTapStats;
+            if (args.PlaybackState.state == Wrapper.MediaPlayerState.Ended && audioTapEnabled && Native.GetAudioTapStats(instanceId, out audioTapStats) == 0)
+            {
+                Debug.Log(audioTapStats);
+            }
+
+            // a .y4m or image sequence item plays without a video decoder, what is left is the pipeline itself
+            Wrapper.RawSourceStats rawSourceStats;
+            if (args.PlaybackState.state == Wrapper.MediaPlayerState.Ended && Native.GetRawSourceStats(instanceId, out rawSourceStats) == 0)
+            {
+                Debug.Log(rawSourceStats);
+            }
         }
 		
+        // per renderer scale and offset, so every tile keeps sharing the material
+        private void ApplyAtlasRect(Wrapper.AtlasRect rect)
+        {
+            if (playbackRenderer == null)
+            {
+                return;
+            }
+
+            var properties = new MaterialPropertyBlock();
+            playbackRenderer.GetPropertyBlock(properties);
+            properties.SetVector("_MainTex_ST", new Vector4(rect.uWidth, -rect.vHeight, rect.u, rect.v + rect.vHeight));
+            playbackRenderer.SetPropertyBlock(properties);
+        }
+
+        // the smaller sizes fill the top left of the texture, flipped like the full one
+        private void ApplyResolution(Wrapper.ResolutionState state)
+        {
+            if (playbackRenderer == null)
+            {
+                return;
+            }
+
+            playbackRenderer.material.SetTextureScale("_MainTex", new Vector2(state.uWidth, -state.vHeight));
+            playbackRenderer.material.SetTextureOffset("_MainTex", new Vector2(0, state.vHeight));
+        }
+
+        // unity's audio thread, overwrites whatever the AudioSource played with the video's audio
+        private void OnAudioFilterRead(float[] data, int channels)
+        {
+            if (!audioTapEnabled || channels != audioTapChannels)
+            {
+                return;
+            }
+
+            Int64 timestamp;
+            UInt32 framesRead;
+            if (Native.ReadAudio(instanceId, data, (UInt32)(data.Length / channels), (UInt32)channels, out timestamp, out framesRead) == 0)
+            {
+                audioTimestamp = timestamp;
+            }
+        }
+
+        private static Int32 SpeakerModeChannels(AudioSpeakerMode mode)
+        {
+            switch (mode)
+            {
+                case AudioSpeakerMode.Mono: return 1;
+                case AudioSpeakerMode.Quad: return 4;
+                case AudioSpeakerMode.Surround: return 5;
+                case AudioSpeakerMode.Mode5point1: return 6;
+                case AudioSpeakerMode.Mode7point1: return 8;
+                default: return 2;
+            }
+        }
+
+        // position in seconds
+        public void Seek(double position, Wrapper.SeekMode mode)
+        {
+            CheckHR(Native.Seek(instanceId, (Int64)(position * 10000000.0), mode));
+        }
+
+        public void Step(Int32 frames)
+        {
+            CheckHR(Native.Step(instanceId, frames));
+        }
+
+        public void SetRate(double rate)
+        {
+            CheckHR(Native.SetRate(instanceId, rate));
+        }
+
+        internal Wrapper.FrameCacheStats GetFrameCacheStats()
+        {
+            Wrapper.FrameCacheStats stats;
+            CheckHR(Native.GetFrameCacheStats(instanceId, out stats));
+            return stats;
+        }
+
+        internal Wrapper.PlaybackStats GetStats()
+        {
+            Wrapper.PlaybackStats stats;
+            CheckHR(Native.GetStats(instanceId, out stats));
+            return stats;
+        }
+
         private void CreateMediaPlayer()
         {
             IntPtr thisObjectPtr = GCHandle.ToIntPtr(thisObject);
@@ -91,9 +317,21 @@ namespace VideoPlayer
             [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerCreateTexture")]
             internal static extern Int32 CreatePlaybackTexture(Int32 instanceId, Int32 width, Int32 height, out System.IntPtr playbackTexture);
 
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerCreateAtlasTexture")]
+            internal static extern Int32 CreateAtlasTexture(Int32 instanceId, Int32 width, Int32 height, out System.IntPtr atlasTexture, out Wrapper.AtlasRect rect);
+
             [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerLoadContent")]
             internal static extern Int32 LoadContent(Int32 instanceId, [MarshalAs(UnmanagedType.BStr)] String contentLocation);
 
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerEnqueue")]
+            internal static extern Int32 Enqueue(Int32 instanceId, [MarshalAs(UnmanagedType.BStr)] String contentLocation);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetPreloadCount")]
+            internal static extern Int32 SetPreloadCount(Int32 instanceId, UInt32 count);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerGetResourceStats")]
+            internal static extern Int32 GetResourceStats(Int32 instanceId, out Wrapper.ResourceStats stats);
+
             [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerPlay")]
             internal static extern Int32 Play(Int32 instanceId);
 
@@ -102,6 +340,45 @@ namespace VideoPlayer
 
             [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerStop")]
             internal static extern Int32 Stop(Int32 instanceId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSeek")]
+            internal static extern Int32 Seek(Int32 instanceId, Int64 position, Wrapper.SeekMode mode);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerStep")]
+            internal static extern Int32 Step(Int32 instanceId, Int32 frames);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetRate")]
+            internal static extern Int32 SetRate(Int32 instanceId, double rate);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetFrameCacheBudget")]
+            internal static extern Int32 SetFrameCacheBudget(Int32 instanceId, UInt64 bytes);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerGetFrameCacheStats")]
+            internal static extern Int32 GetFrameCacheStats(Int32 instanceId, out Wrapper.FrameCacheStats stats);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerGetRawSourceStats")]
+            internal static extern Int32 GetRawSourceStats(Int32 instanceId, out Wrapper.RawSourceStats stats);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerGetStats")]
+            internal static extern Int32 GetStats(Int32 instanceId, out Wrapper.PlaybackStats stats);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetAdaptiveResolution")]
+            internal static extern Int32 SetAdaptiveResolution(Int32 instanceId, UInt32 levels, Single minScale);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetAudioTap")]
+            internal static extern Int32 SetAudioTap(Int32 instanceId, UInt32 sampleRate, UInt32 channels, UInt32 bufferMs);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerReadAudio")]
+            internal static extern Int32 ReadAudio(Int32 instanceId, [Out] Single[] buffer, UInt32 frames, UInt32 channels, out Int64 timestamp, out UInt32 framesRead);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerGetAudioTapStats")]
+            internal static extern Int32 GetAudioTapStats(Int32 instanceId, out Wrapper.AudioTapStats stats);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetFrameBufferCount")]
+            internal static extern Int32 SetFrameBufferCount(Int32 instanceId, UInt32 count);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "MediaPlayerSetPacing")]
+            internal static extern Int32 SetPacing(Int32 instanceId, Wrapper.PacingMode mode, UInt32 latencyFrames);
         }
     }
 }
\ No newline at end of file
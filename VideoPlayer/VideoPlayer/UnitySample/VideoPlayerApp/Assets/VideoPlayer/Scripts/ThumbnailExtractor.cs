@@ -0,0 +1,155 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace VideoPlayer
+{
+    // poster frame and evenly spaced thumbnails for a list of videos, decoded on the plugin's
+    // worker pool without a player per file
+    internal class ThumbnailExtractor : BasePlugin<ThumbnailExtractor>
+    {
+        public String[] VideoPaths;
+
+        // the first is the poster frame at 0
+        public UInt32 thumbnailsPerVideo = 8;
+        public Single thumbnailIntervalSeconds = 10.0f;
+
+        public Int32 thumbnailWidth = 256;
+        public Int32 thumbnailHeight = 144;
+
+        // 0 lets the plugin pick from the core count
+        public UInt32 workerCount = 0;
+
+        // one slice per thumbnail, video i starts at slice i * thumbnailsPerVideo,
+        // otherwise the pixels land in Thumbnails as raw bgra32
+        public bool useTextureArray = true;
+
+        public Texture2DArray ThumbnailArray { get; private set; }
+        public readonly Dictionary<String, byte[]> Thumbnails = new Dictionary<String, byte[]>();
+
+        // the plugin writes into these until the batch reports its last thumbnail
+        private readonly Dictionary<UInt32, GCHandle> pinnedBuffers = new Dictionary<UInt32, GCHandle>();
+        private Int32 pendingBatches = 0;
+
+        protected override void OnEnable()
+        {
+            base.OnEnable();
+
+            IntPtr thisObjectPtr = GCHandle.ToIntPtr(thisObject);
+            if (CheckHR(Native.CreateThumbnailExtractor(stateChangedCallback, thisObjectPtr, workerCount, out instanceId)) != 0 || VideoPaths == null)
+            {
+                return;
+            }
+
+            if (useTextureArray)
+            {
+                ThumbnailArray = new Texture2DArray(thumbnailWidth, thumbnailHeight, (Int32)(VideoPaths.Length * thumbnailsPerVideo), TextureFormat.BGRA32, false);
+                ThumbnailArray.Apply(false, true);
+
+                CheckHR(Native.SetTextureArray(instanceId, ThumbnailArray.GetNativeTexturePtr()));
+            }
+
+            var timestamps = new Int64[thumbnailsPerVideo];
+            for (int i = 0; i < timestamps.Length; ++i)
+            {
+                timestamps[i] = (Int64)(i * thumbnailIntervalSeconds * 10000000.0);
+            }
+
+            for (int i = 0; i < VideoPaths.Length; ++i)
+            {
+                UInt32 batchId = 0;
+                if (useTextureArray)
+                {
+                    if (CheckHR(Native.QueueToTextureArray(instanceId, VideoPaths[i], timestamps, thumbnailsPerVideo, (UInt32)i * thumbnailsPerVideo, out batchId)) == 0)
+                    {
+                        ++pendingBatches;
+                    }
+
+                    continue;
+                }
+
+                var pixels = new byte[thumbnailWidth * thumbnailHeight * 4 * thumbnailsPerVideo];
+                var pinned = GCHandle.Alloc(pixels, GCHandleType.Pinned);
+                if (CheckHR(Native.Queue(instanceId, VideoPaths[i], timestamps, thumbnailsPerVideo, (UInt32)thumbnailWidth, (UInt32)thumbnailHeight, pinned.AddrOfPinnedObject(), (UInt32)pixels.Length, out batchId)) != 0)
+                {
+                    pinned.Free();
+                    continue;
+                }
+
+                Thumbnails[VideoPaths[i]] = pixels;
+                pinnedBuffers[batchId] = pinned;
+                ++pendingBatches;
+            }
+        }
+
+        protected override void OnDisable()
+        {
+            // stops the workers, after this nothing writes into the buffers
+            base.OnDisable();
+
+            foreach (var pinned in pinnedBuffers.Values)
+            {
+                pinned.Free();
+            }
+            pinnedBuffers.Clear();
+            pendingBatches = 0;
+        }
+
+        protected override void OnCallback(Wrapper.CallbackType type, Wrapper.CallbackState args)
+        {
+            if (type != Wrapper.CallbackType.Thumbnail)
+            {
+                return;
+            }
+
+            var state = args.ThumbnailState;
+            if (state.hresult != 0)
+            {
+                Debug.LogWarning(state);
+            }
+
+            if (state.remaining != 0)
+            {
+                return;
+            }
+
+            GCHandle pinned;
+            if (pinnedBuffers.TryGetValue(state.batchId, out pinned))
+            {
+                pinned.Free();
+                pinnedBuffers.Remove(state.batchId);
+            }
+
+            if (--pendingBatches == 0)
+            {
+                Debug.Log(GetStats());
+            }
+        }
+
+        internal Wrapper.ThumbnailStats GetStats()
+        {
+            Wrapper.ThumbnailStats stats;
+            CheckHR(Native.GetStats(instanceId, out stats));
+            return stats;
+        }
+
+        private static class Native
+        {
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CreateThumbnailExtractor")]
+            internal static extern Int32 CreateThumbnailExtractor([MarshalAs(UnmanagedType.FunctionPtr)]Wrapper.StateChangedCallback callback, IntPtr objectPtr, UInt32 workerCount, out Int32 instanceId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "ThumbnailSetTextureArray")]
+            internal static extern Int32 SetTextureArray(Int32 instanceId, IntPtr texture);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "ThumbnailQueue")]
+            internal static extern Int32 Queue(Int32 instanceId, [MarshalAs(UnmanagedType.LPWStr)] String contentLocation, Int64[] timestamps, UInt32 count, UInt32 width, UInt32 height, IntPtr buffer, UInt32 bufferSize, out UInt32 batchId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "ThumbnailQueueToTextureArray")]
+            internal static extern Int32 QueueToTextureArray(Int32 instanceId, [MarshalAs(UnmanagedType.LPWStr)] String contentLocation, Int64[] timestamps, UInt32 count, UInt32 firstSlice, out UInt32 batchId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "ThumbnailGetStats")]
+            internal static extern Int32 GetStats(Int32 instanceId, out Wrapper.ThumbnailStats stats);
+        }
+    }
+}
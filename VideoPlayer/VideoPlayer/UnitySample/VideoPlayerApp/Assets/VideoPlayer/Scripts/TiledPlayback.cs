@@ -0,0 +1,209 @@
+﻿using System;
+using System.Runtime.InteropServices;
+using UnityEngine;
+
+namespace VideoPlayer
+{
+    // a 360 video too large to decode whole, pre split into a stream per tile of the
+    // equirectangular frame. the plugin decodes the tiles around where the camera looks into
+    // the shared atlas, the renderer's material (VideoPlayer/TiledEquirect on a sphere around
+    // the camera) finds each tile through a small texture of atlas rects and shows the base
+    // stream where a tile has no frame yet
+    internal class TiledPlayback : BasePlugin<TiledPlayback>
+    {
+        // {column}, {row} and {index} are replaced per tile, row 0 is the top of the frame
+        public String tilePattern;
+        public UInt32 columns = 8;
+        public UInt32 rows = 4;
+
+        // the whole frame at a low resolution, plays throughout and carries the audio
+        public String baseLocation;
+
+        // decoders at once, 0 is the plugin's default
+        public UInt32 maxActiveTiles = 0;
+        public bool loop = true;
+
+        // the main camera when not set
+        public Camera viewCamera;
+
+        // the sphere, its rotation turns the video
+        public Renderer targetRenderer;
+
+        private const Int32 AtlasSize = 4096;
+
+        private Texture2D atlasTexture;
+
+        // a texel per tile, row by row, then one for the base. rgba is the tile's u, v, width
+        // and height in the atlas
+        private Texture2D tileMapTexture;
+        private Wrapper.AtlasRect[] tileMap;
+        private Color[] tileMapColors;
+        private UInt32 tileMapVersion = UInt32.MaxValue;
+
+        protected override void OnEnable()
+        {
+            base.OnEnable();
+
+            IntPtr thisObjectPtr = GCHandle.ToIntPtr(thisObject);
+            if (CheckHR(Native.CreateTiledPlayer(stateChangedCallback, thisObjectPtr, out instanceId)) != 0 || String.IsNullOrEmpty(tilePattern))
+            {
+                return;
+            }
+
+            IntPtr nativeTexture = IntPtr.Zero;
+            if (CheckHR(Native.Open(instanceId, tilePattern, columns, rows, baseLocation ?? String.Empty, maxActiveTiles, loop ? 1u : 0u, out nativeTexture)) != 0)
+            {
+                return;
+            }
+
+            atlasTexture = Texture2D.CreateExternalTexture(AtlasSize, AtlasSize, TextureFormat.BGRA32, false, false, nativeTexture);
+
+            tileMap = new Wrapper.AtlasRect[columns * rows + 1];
+            tileMapColors = new Color[columns * (rows + 1)];
+            tileMapTexture = new Texture2D((Int32)columns, (Int32)rows + 1, TextureFormat.RGBAFloat, false, true);
+            tileMapTexture.filterMode = FilterMode.Point;
+            tileMapTexture.wrapMode = TextureWrapMode.Clamp;
+            tileMapVersion = UInt32.MaxValue;
+
+            if (targetRenderer != null)
+            {
+                var material = targetRenderer.material;
+                material.SetTexture("_MainTex", atlasTexture);
+                material.SetTexture("_TileMap", tileMapTexture);
+                material.SetVector("_Grid", new Vector4(columns, rows, 0, 0));
+            }
+
+            // the base reports when it has opened, tiles just join the running timeline
+            if (String.IsNullOrEmpty(baseLocation))
+            {
+                Play();
+            }
+        }
+
+        protected override void OnDisable()
+        {
+            base.OnDisable();
+
+            if (tileMapTexture != null)
+            {
+                Destroy(tileMapTexture);
+                tileMapTexture = null;
+            }
+
+            atlasTexture = null;
+            tileMap = null;
+        }
+
+        private void Update()
+        {
+            if (instanceId == Wrapper.InvalidHandle || tileMap == null)
+            {
+                return;
+            }
+
+            var view = viewCamera != null ? viewCamera : Camera.main;
+            if (view != null)
+            {
+                // in the sphere's space, the shader maps the same direction to the frame
+                Vector3 forward = view.transform.forward;
+                if (targetRenderer != null)
+                {
+                    forward = Quaternion.Inverse(targetRenderer.transform.rotation) * forward;
+                }
+
+                Single yaw = Mathf.Atan2(forward.x, forward.z) * Mathf.Rad2Deg;
+                Single pitch = Mathf.Asin(Mathf.Clamp(forward.y, -1.0f, 1.0f)) * Mathf.Rad2Deg;
+                Single fovV = view.fieldOfView;
+                Single fovH = Camera.VerticalToHorizontalFieldOfView(fovV, view.aspect);
+
+                Native.SetView(instanceId, yaw, pitch, Mathf.Min(fovH, 179.0f), Mathf.Min(fovV, 179.0f));
+            }
+
+            UInt32 version = 0;
+            if (Native.GetTileMap(instanceId, tileMap, (UInt32)tileMap.Length, out version) != 0 || version == tileMapVersion)
+            {
+                return;
+            }
+
+            tileMapVersion = version;
+
+            // the base lands on the first texel of the last row, the rest of it stays clear
+            for (int i = 0; i < tileMap.Length; ++i)
+            {
+                var rect = tileMap[i];
+                tileMapColors[i] = new Color(rect.u, rect.v, rect.uWidth, rect.vHeight);
+            }
+
+            tileMapTexture.SetPixels(tileMapColors);
+            tileMapTexture.Apply(false);
+        }
+
+        protected override void OnCallback(Wrapper.CallbackType type, Wrapper.CallbackState args)
+        {
+            if (type != Wrapper.CallbackType.VideoPlayer)
+            {
+                return;
+            }
+
+            Debug.Log(args.PlaybackState);
+
+            if (args.PlaybackState.state == Wrapper.MediaPlayerState.Opened)
+            {
+                Play();
+            }
+            else if (args.PlaybackState.state == Wrapper.MediaPlayerState.Ended)
+            {
+                Debug.Log(GetStats());
+            }
+        }
+
+        public void Play()
+        {
+            CheckHR(Native.Play(instanceId));
+        }
+
+        public void Pause()
+        {
+            CheckHR(Native.Pause(instanceId));
+        }
+
+        public void Seek(TimeSpan position)
+        {
+            CheckHR(Native.Seek(instanceId, position.Ticks));
+        }
+
+        internal Wrapper.TiledStats GetStats()
+        {
+            Wrapper.TiledStats stats;
+            CheckHR(Native.GetStats(instanceId, out stats));
+            return stats;
+        }
+
+        private static class Native
+        {
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "CreateTiledPlayer")]
+            internal static extern Int32 CreateTiledPlayer([MarshalAs(UnmanagedType.FunctionPtr)]Wrapper.StateChangedCallback callback, IntPtr objectPtr, out Int32 instanceId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerOpen")]
+            internal static extern Int32 Open(Int32 instanceId, [MarshalAs(UnmanagedType.LPWStr)] String tilePattern, UInt32 columns, UInt32 rows, [MarshalAs(UnmanagedType.LPWStr)] String baseLocation, UInt32 maxActiveTiles, UInt32 loop, out IntPtr atlasTexture);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerPlay")]
+            internal static extern Int32 Play(Int32 instanceId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerPause")]
+            internal static extern Int32 Pause(Int32 instanceId);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerSeek")]
+            internal static extern Int32 Seek(Int32 instanceId, Int64 position);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerSetView")]
+            internal static extern Int32 SetView(Int32 instanceId, Single yaw, Single pitch, Single fovH, Single fovV);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerGetTileMap")]
+            internal static extern Int32 GetTileMap(Int32 instanceId, [Out] Wrapper.AtlasRect[] rects, UInt32 count, out UInt32 version);
+
+            [DllImport(Wrapper.ModuleName, CallingConvention = CallingConvention.StdCall, EntryPoint = "TiledPlayerGetStats")]
+            internal static extern Int32 GetStats(Int32 instanceId, out Wrapper.TiledStats stats);
+        }
+    }
+}